@@ -271,7 +271,7 @@ void ofApp::update(){
 
 		// get the current time to use the same time for all the streams
 		// to have a more accurate syncing
-		GstClockTime now = rtp.getServer().getTimeStamp();
+		GstClockTime now = rtp.getServer().getFrameTimeStamp();
 
 		// if there's a new RGB frame from the kinect, load it on a texture
 		// to draw it locally and send it to the other peer through the
@@ -0,0 +1,176 @@
+/*
+ * ofApp.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "ofApp.h"
+
+static const int WIDTH = 640;
+static const int HEIGHT = 480;
+static const int FPS = 30;
+static const int SERVER_PORT = 7000;
+static const int CLIENT_PORT = 5000;
+static const float RANDOM_LOSS = 0.01;
+static const int WARMUP_MS = 3000;
+static const int PHASE_MS = 90000;
+
+// capacity of the link in each phase in kbps: start over the initial
+// bitrate, drop to a lower one and recover
+static const int CAPACITIES[] = {1500, 600, 2000};
+static const int NUM_PHASES = sizeof(CAPACITIES)/sizeof(CAPACITIES[0]);
+
+// the target has converged once it stays in this range of the capacity,
+// and has to do so before the deadline of the phase
+static const float CONVERGED_MIN = 0.6;
+static const float CONVERGED_MAX = 1.15;
+static const int CONVERGENCE_DEADLINE_S = 60;
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	ofSetFrameRate(FPS);
+	frame.allocate(WIDTH,HEIGHT,OF_PIXELS_RGB);
+	finished = false;
+	passed = 0;
+	results = "video " + ofToString(WIDTH) + "x" + ofToString(HEIGHT) + "@" + ofToString(FPS) + " through loopback with "
+			+ ofToString(RANDOM_LOSS*100,0) + "% random loss and a policed capacity\n\n";
+
+	// the relay polices the link to the capacity of each phase, rtcp goes
+	// through untouched so the receiver reports always arrive
+	relay.setCapacity(CAPACITIES[0]);
+	relay.setup(SERVER_PORT,CLIENT_PORT,RANDOM_LOSS);
+
+	server.reset(new ofxGstRTPServer);
+	// the receiver reports arrive every few seconds, starting close to the
+	// capacity keeps the phases short
+	server->adaptiveBitrate = true;
+	server->videoBitrate = 1000;
+	server->setup("127.0.0.1");
+	server->addVideoChannel(SERVER_PORT,WIDTH,HEIGHT,FPS);
+
+	client.reset(new ofxGstRTPClient);
+	client->setup("127.0.0.1",200);
+	client->addVideoChannel(CLIENT_PORT,OFX_GST_RTP_X264);
+
+	client->play();
+	server->play();
+
+	start = ofGetElapsedTimeMillis();
+	phase = -1;
+}
+
+void ofApp::startPhase(int phase){
+	this->phase = phase;
+	relay.setCapacity(CAPACITIES[phase]);
+	phaseStart = ofGetElapsedTimeMillis();
+	lastSample = phaseStart;
+	lastBytesSent = relay.getBytesSent();
+	lastBytesRelayed = relay.getBytesRelayed();
+	targets.clear();
+	losses.clear();
+}
+
+void ofApp::measurePhase(){
+	int capacityKbps = CAPACITIES[phase];
+
+	// first second from which the target stays converged until the end
+	int converged = -1;
+	for(int i=targets.size()-1;i>=0;i--){
+		if(targets[i]<capacityKbps*CONVERGED_MIN || targets[i]>capacityKbps*CONVERGED_MAX){
+			break;
+		}
+		converged = i + 1;
+	}
+
+	// where it settles, the last 10 seconds
+	size_t n = min<size_t>(10,targets.size());
+	double settled = 0, loss = 0;
+	for(size_t i=targets.size()-n;i<targets.size();i++){
+		settled += targets[i];
+		loss += losses[i];
+	}
+	if(n){
+		settled /= n;
+		loss /= n;
+	}
+
+	bool ok = converged>=0 && converged<=CONVERGENCE_DEADLINE_S;
+	passed += ok;
+	results += "capacity " + ofToString(capacityKbps) + "kbps: ";
+	results += (converged>=0 ? "converged in " + ofToString(converged) + "s" : string("didn't converge"));
+	results += ", settled at " + ofToString(settled,0) + "kbps (" + ofToString(settled*100/capacityKbps,0) + "%)";
+	results += ", link loss " + ofToString(loss*100,1) + "%";
+	results += ok ? "  PASS\n" : "  FAIL\n";
+	ofLogNotice() << results;
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+	if(finished) return;
+
+	// 8x8 blocks of noise that change every frame so the encoder always
+	// has more to send than the link can take
+	for(int y=0;y<HEIGHT;y+=8){
+		for(int x=0;x<WIDTH;x+=8){
+			unsigned char value = ofRandom(255);
+			for(int by=y;by<y+8;by++){
+				memset(frame.getPixels() + (by*WIDTH + x)*3, value, 8*3);
+			}
+		}
+	}
+	server->newFrame(frame);
+	client->update();
+
+	unsigned long long now = ofGetElapsedTimeMillis();
+	if(phase<0){
+		if(now - start > WARMUP_MS){
+			startPhase(0);
+		}
+		return;
+	}
+
+	if(now - lastSample >= 1000){
+		lastSample += 1000;
+		uint64_t sent = relay.getBytesSent() - lastBytesSent;
+		uint64_t relayed = relay.getBytesRelayed() - lastBytesRelayed;
+		lastBytesSent += sent;
+		lastBytesRelayed += relayed;
+		targets.push_back(server->videoBitrate);
+		losses.push_back(sent ? 1 - double(relayed)/sent : 0);
+	}
+
+	if(now - phaseStart > PHASE_MS){
+		measurePhase();
+		if(phase+1<NUM_PHASES){
+			startPhase(phase+1);
+		}else{
+			results += ofToString(passed) + " of " + ofToString(NUM_PHASES) + " phases passed\n";
+			ofLogNotice() << results;
+			closeLink();
+			finished = true;
+		}
+	}
+}
+
+void ofApp::closeLink(){
+	client->close();
+	server->close();
+	relay.close();
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	ofBackground(0);
+	ofSetColor(255);
+	ofDrawBitmapString(results,20,20);
+	if(!finished && phase>=0){
+		ofDrawBitmapString("capacity " + ofToString(CAPACITIES[phase]) + "kbps, target " + ofToString(server->videoBitrate.get()) + "kbps",20,200);
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::exit(){
+	if(relay.isSetup()){
+		closeLink();
+	}
+}
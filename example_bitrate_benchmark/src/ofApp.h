@@ -0,0 +1,47 @@
+/*
+ * ofApp.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGstRTPServer.h"
+#include "ofxGstRTPClient.h"
+#include "ofxGstLossyRelay.h"
+
+/// sends a video channel with adaptive bitrate to a client in the same app
+/// through a relay that drops 1% of the packets randomly and polices the
+/// rest to a capacity that changes every phase, like the bottleneck of a
+/// real link. For each phase it reports how long the target bitrate of the
+/// controller takes to converge to the capacity, where it settles and the
+/// loss seen by the receiver, and whether it passed
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+		void exit();
+
+		void startPhase(int phase);
+		void measurePhase();
+		void closeLink();
+
+		shared_ptr<ofxGstRTPServer> server;
+		shared_ptr<ofxGstRTPClient> client;
+		ofxGstLossyRelay relay;
+		ofPixels frame;
+
+		int phase;
+		unsigned long long start, phaseStart, lastSample;
+		bool finished;
+		int passed;
+
+		// one sample per second of the current phase
+		vector<int> targets;
+		vector<float> losses;
+		uint64_t lastBytesSent, lastBytesRelayed;
+		string results;
+};
@@ -0,0 +1,121 @@
+/*
+ * ofApp.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofApp.h"
+
+// each report simulates a second of the link
+static const double REPORT_INTERVAL = 1;
+static const size_t HISTORY_SIZE = 500;
+static const int MAX_BITRATE = 6000;
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	ofBackground(255);
+	ofSetFrameRate(30);
+	capacity = 1500;
+	baseRoundTrip = 0.04;
+	randomLoss = true;
+	restart();
+}
+
+void ofApp::restart(){
+	controller.setup(300,100,MAX_BITRATE);
+	queued = 0;
+	seq = 0;
+	capacityHistory.clear();
+	targetHistory.clear();
+	actionHistory.clear();
+}
+
+//--------------------------------------------------------------
+ofxGstRTPReceiverReport ofApp::simulateLink(double bitrate){
+	ofxGstRTPReceiverReport report;
+
+	// whatever goes over the capacity waits in the queue of the
+	// bottleneck and is dropped once the queue is full
+	queued = max(0.0, queued + (bitrate - capacity) * REPORT_INTERVAL);
+	double queueLimit = capacity * 0.2;
+	double dropped = 0;
+	if(queued > queueLimit){
+		dropped = queued - queueLimit;
+		queued = queueLimit;
+	}
+
+	report.fractionLost = dropped / (bitrate * REPORT_INTERVAL);
+	if(randomLoss){
+		report.fractionLost += ofRandom(0.01);
+	}
+	report.fractionLost = ofClamp(report.fractionLost,0,1);
+	report.roundTrip = baseRoundTrip + queued / capacity;
+	report.jitter = ofRandom(0.005);
+	report.extHighestSeq = ++seq;
+	return report;
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+	ofxGstRTPReceiverReport report = simulateLink(controller.getTargetBitrate());
+	controller.update(report);
+
+	capacityHistory.push_back(capacity);
+	targetHistory.push_back(controller.getTargetBitrate());
+	actionHistory.push_back(controller.getLastAction());
+	if(capacityHistory.size()>HISTORY_SIZE){
+		capacityHistory.pop_front();
+		targetHistory.pop_front();
+		actionHistory.pop_front();
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	float graphH = ofGetHeight() - 100;
+	float stepX = ofGetWidth() / float(HISTORY_SIZE);
+
+	ofPolyline capacityLine, targetLine;
+	for(size_t i=0;i<targetHistory.size();i++){
+		capacityLine.addVertex(i*stepX, graphH - capacityHistory[i] / MAX_BITRATE * graphH);
+		targetLine.addVertex(i*stepX, graphH - targetHistory[i] / MAX_BITRATE * graphH);
+		if(actionHistory[i]==OFX_GST_RTP_BITRATE_DECREASE){
+			ofSetColor(255,0,0,60);
+			ofDrawLine(i*stepX,graphH,i*stepX,graphH-10);
+		}
+	}
+	ofSetColor(0,0,255);
+	capacityLine.draw();
+	ofSetColor(0);
+	targetLine.draw();
+
+	// average error over the last 30 reports to show convergence
+	double error = 0;
+	size_t n = min<size_t>(30,targetHistory.size());
+	for(size_t i=targetHistory.size()-n;i<targetHistory.size();i++){
+		error += fabs(targetHistory[i] - capacityHistory[i]) / capacityHistory[i];
+	}
+	if(n) error /= n;
+
+	ofDrawBitmapString("capacity: " + ofToString(capacity,0) + "kbps (up/down)   random loss: " + (randomLoss?string("on"):string("off")) + " (l)   restart (r)", 20, graphH + 30);
+	ofDrawBitmapString("target: " + ofToString(controller.getTargetBitrate()) + "kbps   error: " + ofToString(error*100,1) + "%", 20, graphH + 50);
+	ofDrawBitmapString("reason: " + controller.getReason(), 20, graphH + 70);
+}
+
+//--------------------------------------------------------------
+void ofApp::keyPressed(int key){
+	switch(key){
+	case OF_KEY_UP:
+		capacity = min<double>(capacity + 250, MAX_BITRATE);
+		break;
+	case OF_KEY_DOWN:
+		capacity = max<double>(capacity - 250, 250);
+		break;
+	case 'l':
+		randomLoss = !randomLoss;
+		break;
+	case 'r':
+		restart();
+		break;
+	}
+}
@@ -0,0 +1,40 @@
+/*
+ * ofApp.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGstRTPBitrateController.h"
+
+/// drives an ofxGstRTPBitrateController with the receiver reports of a
+/// simulated network link with a bottleneck, a limited queue and some
+/// random loss, and plots how the target bitrate converges to the
+/// capacity of the link when it changes.
+/// up/down change the capacity, l toggles random loss, r restarts
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+		void keyPressed(int key);
+
+		ofxGstRTPReceiverReport simulateLink(double bitrate);
+		void restart();
+
+		ofxGstRTPBitrateController controller;
+
+		// simulated link, all in kbps and seconds
+		double capacity;
+		double queued;
+		double baseRoundTrip;
+		bool randomLoss;
+		unsigned int seq;
+
+		deque<float> capacityHistory;
+		deque<float> targetHistory;
+		deque<ofxGstRTPBitrateAction> actionHistory;
+};
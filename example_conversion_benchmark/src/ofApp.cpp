@@ -0,0 +1,111 @@
+#include "ofApp.h"
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+static const int NUM_FRAMES = 200;
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	gst_init(NULL,NULL);
+
+	int sizes[][2] = {{640,480},{1280,720},{1920,1080}};
+	int numThreads;
+	{
+		ofxGstVideoConverter converter;
+		converter.setup(2,2);
+		numThreads = converter.getNumThreads();
+	}
+
+	results = "average ms per frame, " + ofToString(NUM_FRAMES) + " frames\n\n";
+	for(int i=0;i<3;i++){
+		int w = sizes[i][0];
+		int h = sizes[i][1];
+		results += ofToString(w) + "x" + ofToString(h) + "\n";
+		results += "  videoconvert 1 thread:       " + ofToString(benchmarkVideoConvert(w,h,1),3) + "\n";
+		results += "  videoconvert " + ofToString(numThreads) + " threads:      " + ofToString(benchmarkVideoConvert(w,h,numThreads),3) + "\n";
+		results += "  addon scalar 1 thread:       " + ofToString(benchmarkConverter(w,h,1,OFX_GST_SIMD_NONE),3) + "\n";
+		results += "  addon simd 1 thread:         " + ofToString(benchmarkConverter(w,h,1,ofxGstGetSimdLevel()),3) + "\n";
+		results += "  addon simd " + ofToString(numThreads) + " threads:        " + ofToString(benchmarkConverter(w,h,numThreads,ofxGstGetSimdLevel()),3) + "\n";
+	}
+	ofLogNotice() << results;
+}
+
+static void randomFrame(ofPixels & pixels, int w, int h){
+	pixels.allocate(w,h,OF_PIXELS_RGB);
+	for(size_t i=0;i<pixels.size();i++){
+		pixels[i] = ofRandom(255);
+	}
+}
+
+double ofApp::benchmarkConverter(int w, int h, int numThreads, ofxGstSimdLevel simdLevel){
+	ofPixels rgb, i420;
+	randomFrame(rgb,w,h);
+	i420.allocate(w,h,OF_PIXELS_I420);
+
+	ofxGstVideoConverter converter;
+	converter.setup(w,h,numThreads);
+	converter.setSimdLevel(simdLevel);
+	if(converter.getNumThreads()!=numThreads){
+		ofLogWarning() << "converter using " << converter.getNumThreads() << " threads instead of " << numThreads;
+	}
+
+	unsigned long long start = ofGetElapsedTimeMicros();
+	for(int i=0;i<NUM_FRAMES;i++){
+		converter.convert(rgb,i420);
+	}
+	return (ofGetElapsedTimeMicros() - start) / 1000. / NUM_FRAMES;
+}
+
+// includes the cost of passing each buffer through appsrc and appsink
+// which is what the server pays when using videoconvert
+double ofApp::benchmarkVideoConvert(int w, int h, int numThreads){
+	ofPixels rgb;
+	randomFrame(rgb,w,h);
+
+	string pipelineStr = "appsrc name=src format=time caps=video/x-raw,format=RGB,width=" + ofToString(w) + ",height=" + ofToString(h) + ",framerate=30/1 "
+			"! videoconvert n-threads=" + ofToString(numThreads) + " ! video/x-raw,format=I420,colorimetry=bt601 "
+			"! appsink name=sink sync=false";
+	GError * error = NULL;
+	GstElement * pipeline = gst_parse_launch(pipelineStr.c_str(),&error);
+	if(!pipeline){
+		ofLogError() << "couldn't create pipeline: " << (error ? error->message : "");
+		if(error) g_error_free(error);
+		return 0;
+	}
+	GstElement * src = gst_bin_get_by_name(GST_BIN(pipeline),"src");
+	GstElement * sink = gst_bin_get_by_name(GST_BIN(pipeline),"sink");
+	gst_element_set_state(pipeline,GST_STATE_PLAYING);
+
+	unsigned long long start = ofGetElapsedTimeMicros();
+	for(int i=0;i<NUM_FRAMES;i++){
+		GstBuffer * buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,rgb.getPixels(),rgb.size(),0,rgb.size(),NULL,NULL);
+		GST_BUFFER_PTS(buffer) = i * GST_SECOND / 30;
+		gst_app_src_push_buffer(GST_APP_SRC(src),buffer);
+		GstSample * sample = gst_app_sink_pull_sample(GST_APP_SINK(sink));
+		if(!sample){
+			ofLogError() << "videoconvert pipeline stopped";
+			break;
+		}
+		gst_sample_unref(sample);
+	}
+	double ms = (ofGetElapsedTimeMicros() - start) / 1000. / NUM_FRAMES;
+
+	gst_element_set_state(pipeline,GST_STATE_NULL);
+	gst_object_unref(src);
+	gst_object_unref(sink);
+	gst_object_unref(pipeline);
+	return ms;
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	ofBackground(0);
+	ofSetColor(255);
+	ofDrawBitmapString(results,20,20);
+}
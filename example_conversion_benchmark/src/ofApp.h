@@ -0,0 +1,25 @@
+/*
+ * ofApp.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGstVideoConverter.h"
+
+/// compares the RGB to I420 conversion done by ofxGstRTPServer with
+/// the one done by videoconvert at different resolutions
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+
+		double benchmarkConverter(int w, int h, int numThreads, ofxGstSimdLevel simdLevel);
+		double benchmarkVideoConvert(int w, int h, int numThreads);
+
+		string results;
+};
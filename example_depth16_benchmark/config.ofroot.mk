@@ -0,0 +1 @@
+OF_ROOT=../../..
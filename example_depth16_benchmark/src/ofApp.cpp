@@ -0,0 +1,153 @@
+/*
+ * ofApp.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofApp.h"
+
+static const int NUM_FRAMES = 300;
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	int sizes[][2] = {{160,120},{320,240},{640,480}};
+	int numThreads;
+	{
+		ofxGstDepth16Compressor compressor;
+		compressor.setup(2,2);
+		numThreads = compressor.getNumThreads();
+	}
+
+	results = "average ms per frame, " + ofToString(NUM_FRAMES) + " frames, key frame every " + ofToString(ofxGstDepth16Compressor::DEFAULT_KEYFRAME_INTERVAL) + "\n\n";
+	for(int i=0;i<3;i++){
+		int w = sizes[i][0];
+		int h = sizes[i][1];
+		results += ofToString(w) + "x" + ofToString(h) + "\n";
+		int threads[] = {1, numThreads};
+		for(int j=0;j<2;j++){
+			double compressMs, decompressMs, ratio;
+			benchmark(w,h,threads[j],compressMs,decompressMs,ratio);
+			results += "  " + ofToString(threads[j]) + (threads[j]==1 ? " thread:  " : " threads: ");
+			results += "compress " + ofToString(compressMs,3) + "  decompress " + ofToString(decompressMs,3) + "  ratio " + ofToString(ratio,1) + ":1\n";
+		}
+	}
+
+	results += "\ndecompression in 1 thread, average ms per key frame / difference frame\n\n";
+	string levelNames[] = {"scalar","ssse3","avx2"};
+	for(int i=0;i<3;i++){
+		int w = sizes[i][0];
+		int h = sizes[i][1];
+		results += ofToString(w) + "x" + ofToString(h) + "\n";
+		for(int level=OFX_GST_SIMD_NONE;level<=ofxGstGetSimdLevel();level++){
+			double keyFrameMs, deltaMs;
+			benchmarkReconstruction(w,h,(ofxGstSimdLevel)level,keyFrameMs,deltaMs);
+			results += "  " + levelNames[level] + ":\t" + ofToString(keyFrameMs,3) + " / " + ofToString(deltaMs,3) + "\n";
+		}
+	}
+	ofLogNotice() << results;
+}
+
+// depth like frames: a background plane with some noise and a sphere
+// moving in front of it so the differences are not all zeros
+static void depthFrame(ofShortPixels & pixels, int w, int h, int frame){
+	float cx = w/2 + cos(frame*0.05) * w/4;
+	float cy = h/2 + sin(frame*0.05) * h/4;
+	float radius = h/4;
+	for(int y=0;y<h;y++){
+		for(int x=0;x<w;x++){
+			float dx = x - cx, dy = y - cy;
+			float d2 = dx*dx + dy*dy;
+			unsigned short depth = 3000 + y*2 + (ofRandom(1)<0.1 ? ofRandom(8) : 0);
+			if(d2<radius*radius){
+				depth = 1000 + sqrt(d2) * 4;
+			}
+			pixels[y*w+x] = depth;
+		}
+	}
+}
+
+void ofApp::benchmark(int w, int h, int numThreads, double & compressMs, double & decompressMs, double & ratio){
+	// frames are generated before measuring since that's slower
+	// than compressing them
+	vector<ofShortPixels> frames(ofxGstDepth16Compressor::DEFAULT_KEYFRAME_INTERVAL*2);
+	for(size_t i=0;i<frames.size();i++){
+		frames[i].allocate(w,h,1);
+		depthFrame(frames[i],w,h,i);
+	}
+
+	ofxGstDepth16Compressor compressor;
+	compressor.setup(w,h,ofxGstDepth16Compressor::DEFAULT_KEYFRAME_INTERVAL,numThreads);
+	ofxGstDepth16Decompressor decompressor;
+	decompressor.setup(numThreads);
+
+	vector<vector<unsigned char> > compressed(NUM_FRAMES,vector<unsigned char>(compressor.getMaxCompressedSize()));
+	vector<size_t> sizes(NUM_FRAMES);
+	size_t totalSize = 0;
+	unsigned long long start = ofGetElapsedTimeMicros();
+	for(int i=0;i<NUM_FRAMES;i++){
+		sizes[i] = compressor.compress(frames[i%frames.size()],1,1,&compressed[i][0]);
+		totalSize += sizes[i];
+	}
+	compressMs = (ofGetElapsedTimeMicros() - start) / 1000. / NUM_FRAMES;
+	ratio = double(w*h*sizeof(unsigned short)*NUM_FRAMES) / totalSize;
+
+	ofShortPixels decompressed;
+	start = ofGetElapsedTimeMicros();
+	for(int i=0;i<NUM_FRAMES;i++){
+		decompressor.decompress(&compressed[i][0],sizes[i],decompressed);
+	}
+	decompressMs = (ofGetElapsedTimeMicros() - start) / 1000. / NUM_FRAMES;
+
+	if(memcmp(decompressed.getPixels(),frames[(NUM_FRAMES-1)%frames.size()].getPixels(),w*h*sizeof(unsigned short))!=0){
+		ofLogError() << "decompressed frame doesn't match the original";
+	}
+}
+
+void ofApp::benchmarkReconstruction(int w, int h, ofxGstSimdLevel level, double & keyFrameMs, double & deltaMs){
+	ofxGstDepth16Compressor compressor;
+	compressor.setup(w,h,ofxGstDepth16Compressor::DEFAULT_KEYFRAME_INTERVAL,1);
+
+	// one key frame and the differences of the rest of the interval
+	ofShortPixels frame;
+	frame.allocate(w,h,1);
+	vector<vector<unsigned char> > compressed(ofxGstDepth16Compressor::DEFAULT_KEYFRAME_INTERVAL,vector<unsigned char>(compressor.getMaxCompressedSize()));
+	vector<size_t> sizes(compressed.size());
+	for(size_t i=0;i<compressed.size();i++){
+		depthFrame(frame,w,h,i);
+		sizes[i] = compressor.compress(frame,1,1,&compressed[i][0]);
+	}
+
+	ofxGstDepth16Decompressor decompressor;
+	decompressor.setup(1);
+	decompressor.setSimdLevel(level);
+	ofShortPixels decompressed;
+	unsigned long long keyFramesTime = 0, deltasTime = 0;
+	int numKeyFrames = 0, numDeltas = 0;
+	for(int i=0;i<NUM_FRAMES;i++){
+		size_t index = i%compressed.size();
+		unsigned long long start = ofGetElapsedTimeMicros();
+		decompressor.decompress(&compressed[index][0],sizes[index],decompressed);
+		unsigned long long time = ofGetElapsedTimeMicros() - start;
+		if(decompressor.isKeyFrame()){
+			keyFramesTime += time;
+			numKeyFrames++;
+		}else{
+			deltasTime += time;
+			numDeltas++;
+		}
+	}
+	keyFrameMs = keyFramesTime / 1000. / std::max(1,numKeyFrames);
+	deltaMs = deltasTime / 1000. / std::max(1,numDeltas);
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	ofBackground(0);
+	ofSetColor(255);
+	ofDrawBitmapString(results,20,20);
+}
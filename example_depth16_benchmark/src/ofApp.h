@@ -0,0 +1,28 @@
+/*
+ * ofApp.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGstDepth16Codec.h"
+
+/// measures the compression and decompression of 16bits depth frames as
+/// done by the depth16 channels, with one thread and with the tiles split
+/// among all the cores, at different resolutions. Then measures the
+/// decompression alone in one thread with each instruction set available
+/// to compare the reconstruction of the differences
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+
+		void benchmark(int w, int h, int numThreads, double & compressMs, double & decompressMs, double & ratio);
+		void benchmarkReconstruction(int w, int h, ofxGstSimdLevel level, double & keyFrameMs, double & deltaMs);
+
+		string results;
+};
@@ -0,0 +1,170 @@
+/*
+ * ofApp.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofApp.h"
+
+static const int WIDTH = 320;
+static const int HEIGHT = 240;
+static const int FPS = 30;
+static const int PORT = 5000;
+static const int WARMUP_MS = 2000;
+static const int RUN_MS = 10000;
+static const size_t SENT_HISTORY = 30;
+
+// the first run sends the depth losslessly, the rest packed with these bitrates
+static const int PACKED_BITRATES[] = {500, 1000, 2000};
+static const int NUM_RUNS = 4;
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	ofSetFrameRate(FPS);
+	results = "16bits depth " + ofToString(WIDTH) + "x" + ofToString(HEIGHT) + "@" + ofToString(FPS) + " in mm, max " + ofToString(ofxGstDepth16Packer::DEFAULT_MAX_DEPTH) + ", through loopback\n\n";
+	startRun(0);
+}
+
+void ofApp::startRun(int run){
+	this->run = run;
+	bool packed = run>0;
+
+	server.reset(new ofxGstRTPServer);
+	server->setDepth16Packing(packed);
+	if(packed){
+		server->depthBitrate = PACKED_BITRATES[run-1];
+	}
+	server->setup("127.0.0.1");
+	server->addDepthChannel(PORT,WIDTH,HEIGHT,FPS,true);
+	if(packed){
+		// fixed bitrate so the results of each run are comparable
+		server->getDepthBitrateController().setBounds(PACKED_BITRATES[run-1],PACKED_BITRATES[run-1]);
+	}
+
+	client.reset(new ofxGstRTPClient);
+	client->setDepth16Packing(packed);
+	client->setup("127.0.0.1",100);
+	client->addDepthChannel(PORT,true,OFX_GST_RTP_X264);
+
+	client->play();
+	server->play();
+
+	sent.clear();
+	runStart = ofGetElapsedTimeMillis();
+	measuring = false;
+	framesSent = 0;
+	framesReceived = 0;
+}
+
+void ofApp::measureRun(){
+	string name = run==0 ? "lossless rtpgstpay:  " : "packed x264 " + ofToString(PACKED_BITRATES[run-1]) + "kbps: ";
+	ofxGstRTPStats stats = server->getStats(OFX_GST_RTP_DEPTH);
+	results += name + ofToString(stats.bitrate/1000.,0) + "kbps";
+	results += "  mean error " + ofToString(pixelsCompared ? errorSum/pixelsCompared : 0.,2) + "mm  max " + ofToString(maxError) + "mm";
+	results += "  sent " + ofToString(framesSent) + " received " + ofToString(framesReceived) + " frames\n";
+	ofLogNotice() << results;
+}
+
+// sloped floor with a sphere moving in front of it
+static void depthFrame(ofShortPixels & pixels, int frame){
+	float cx = WIDTH/2 + cos(frame*0.05) * WIDTH/4;
+	float cy = HEIGHT/2 + sin(frame*0.05) * HEIGHT/4;
+	float radius = HEIGHT/5;
+	for(int y=0;y<HEIGHT;y++){
+		for(int x=0;x<WIDTH;x++){
+			float dx = x - cx, dy = y - cy;
+			float d2 = dx*dx + dy*dy;
+			unsigned short depth = 6000 - y*15;
+			if(d2<radius*radius){
+				depth = 1500 - sqrt(radius*radius - d2) * 4;
+			}
+			pixels[y*WIDTH+x] = depth;
+		}
+	}
+}
+
+void ofApp::compareFrame(const ofShortPixels & received){
+	if(received.getWidth()!=WIDTH || received.getHeight()!=HEIGHT || sent.empty()) return;
+
+	// the sent frame with the lowest error in a subset of pixels is the one
+	// that was received
+	size_t best = 0;
+	double bestError = std::numeric_limits<double>::max();
+	for(size_t i=0;i<sent.size();i++){
+		double error = 0;
+		for(size_t p=0;p<received.size();p+=17){
+			error += abs(int(received[p]) - int(sent[i][p]));
+		}
+		if(error<bestError){
+			bestError = error;
+			best = i;
+		}
+	}
+
+	for(size_t p=0;p<received.size();p++){
+		int error = abs(int(received[p]) - int(sent[best][p]));
+		errorSum += error;
+		maxError = max(maxError,error);
+	}
+	pixelsCompared += received.size();
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+	// all the runs finished
+	if(!server) return;
+
+	ofShortPixels frame;
+	frame.allocate(WIDTH,HEIGHT,1);
+	depthFrame(frame,ofGetFrameNum());
+	server->newFrameDepth(frame);
+	sent.push_back(frame);
+	if(sent.size()>SENT_HISTORY){
+		sent.pop_front();
+	}
+	framesSent++;
+
+	client->update();
+	if(client->isFrameNewDepth()){
+		framesReceived++;
+		if(measuring){
+			compareFrame(client->getPixelsDepth16());
+		}
+		remote.loadData(client->getPixelsDepth16());
+	}
+
+	// the pipelines start during the warmup so it's not measured
+	unsigned long long now = ofGetElapsedTimeMillis();
+	if(!measuring && now - runStart > WARMUP_MS){
+		measuring = true;
+		runStart = now;
+		framesSent = 0;
+		framesReceived = 0;
+		errorSum = 0;
+		maxError = 0;
+		pixelsCompared = 0;
+	}
+
+	if(measuring && run<NUM_RUNS && now - runStart > RUN_MS){
+		measureRun();
+		client->close();
+		server->close();
+		if(run+1<NUM_RUNS){
+			startRun(run+1);
+		}else{
+			run = NUM_RUNS;
+			server.reset();
+			client.reset();
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	ofBackground(0);
+	ofSetColor(255);
+	if(remote.isAllocated()){
+		remote.draw(20,140);
+	}
+	ofDrawBitmapString(results,20,20);
+}
@@ -0,0 +1,43 @@
+/*
+ * ofApp.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGstRTPServer.h"
+#include "ofxGstRTPClient.h"
+
+/// sends 16bits depth to a client in the same app through the loopback
+/// interface, first compressed losslessly and sent with rtpgstpay, then
+/// packed in 8bits planes and encoded with x264 at several bitrates, and
+/// measures the bandwidth used and the error of the received depth in each
+/// case. The received frames are matched with the most similar of the last
+/// frames sent
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+
+		void startRun(int run);
+		void measureRun();
+		void compareFrame(const ofShortPixels & received);
+
+		shared_ptr<ofxGstRTPServer> server;
+		shared_ptr<ofxGstRTPClient> client;
+		deque<ofShortPixels> sent;
+		ofTexture remote;
+
+		int run;
+		unsigned long long runStart;
+		bool measuring;
+		int framesSent, framesReceived;
+		double errorSum;
+		int maxError;
+		uint64_t pixelsCompared;
+		string results;
+};
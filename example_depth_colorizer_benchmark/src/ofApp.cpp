@@ -0,0 +1,96 @@
+/*
+ * ofApp.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofApp.h"
+
+static const int WIDTH = 640;
+static const int HEIGHT = 480;
+static const int MAX_DEPTH = 10000;
+static const int NUM_FRAMES = 100;
+
+// conversion done by ofxGstRTPUtils before ofxGstDepthColorizer, it used
+// the same colors but calculated the depth from the hsb of every pixel
+static void hsbToDepth(const ofPixels & colored, ofShortPixels & depth){
+	for(size_t i=0;i<depth.size();i++){
+		ofFloatColor f = ofColor(colored[i*3],colored[i*3+1],colored[i*3+2]);
+		swap(f.r,f.g);
+		float h,s,b;
+		f.getHsb(h,s,b);
+		depth[i] = ((h*MAX_DEPTH) + ((1-b)*MAX_DEPTH) + ((1-s)*MAX_DEPTH))/3.;
+	}
+}
+
+static double meanError(const ofShortPixels & a, const ofShortPixels & b){
+	double error = 0;
+	for(size_t i=0;i<a.size();i++){
+		error += abs(int(a[i]) - int(b[i]));
+	}
+	return error / a.size();
+}
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	unsigned long long start = ofGetElapsedTimeMicros();
+	ofxGstDepthColorizer colorizer;
+	colorizer.setup(MAX_DEPTH);
+	double setupMs = (ofGetElapsedTimeMicros() - start) / 1000.;
+
+	// a depth ramp with a sphere in front of it
+	ofShortPixels depth;
+	depth.allocate(WIDTH,HEIGHT,1);
+	for(int y=0;y<HEIGHT;y++){
+		for(int x=0;x<WIDTH;x++){
+			float dx = x - WIDTH/2, dy = y - HEIGHT/2;
+			float d = sqrt(dx*dx + dy*dy);
+			depth[y*WIDTH+x] = d<HEIGHT/4 ? 1000 + d*8 : 2000 + x*3000/WIDTH + y*3000/HEIGHT;
+		}
+	}
+
+	ofPixels colored;
+	ofShortPixels recovered;
+	recovered.allocate(WIDTH,HEIGHT,1);
+	results = "average ms per " + ofToString(WIDTH) + "x" + ofToString(HEIGHT) + " frame, max depth " + ofToString(MAX_DEPTH) + "\n";
+	results += "tables setup: " + ofToString(setupMs,2) + "ms\n\n";
+
+	colorizer.convertToColored(depth,colored);
+	start = ofGetElapsedTimeMicros();
+	for(int i=0;i<NUM_FRAMES;i++){
+		hsbToDepth(colored,recovered);
+	}
+	double hsbMs = (ofGetElapsedTimeMicros() - start) / 1000. / NUM_FRAMES;
+	results += "hsb per pixel:\tto depth " + ofToString(hsbMs,3) + "  mean error " + ofToString(meanError(depth,recovered),1) + "\n";
+
+	string levelNames[] = {"scalar","ssse3","avx2"};
+	for(int level=OFX_GST_SIMD_NONE;level<=ofxGstGetSimdLevel();level++){
+		// the colorizer only has scalar and avx2 versions
+		if(level==OFX_GST_SIMD_SSSE3) continue;
+		colorizer.setSimdLevel((ofxGstSimdLevel)level);
+		start = ofGetElapsedTimeMicros();
+		for(int i=0;i<NUM_FRAMES;i++){
+			colorizer.convertToColored(depth,colored);
+		}
+		double coloredMs = (ofGetElapsedTimeMicros() - start) / 1000. / NUM_FRAMES;
+		start = ofGetElapsedTimeMicros();
+		for(int i=0;i<NUM_FRAMES;i++){
+			colorizer.convertToDepth(colored,recovered);
+		}
+		double depthMs = (ofGetElapsedTimeMicros() - start) / 1000. / NUM_FRAMES;
+		results += "lut " + levelNames[colorizer.getSimdLevel()] + ":\tto colors " + ofToString(coloredMs,3) + "  to depth " + ofToString(depthMs,3) + "  mean error " + ofToString(meanError(depth,recovered),1) + "\n";
+	}
+	ofLogNotice() << results;
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	ofBackground(0);
+	ofSetColor(255);
+	ofDrawBitmapString(results,20,20);
+}
@@ -0,0 +1,24 @@
+/*
+ * ofApp.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGstDepthColorizer.h"
+
+/// measures the cost per frame of converting 640x480 depth to colors and
+/// back with ofxGstDepthColorizer in each instruction set available, against
+/// the per pixel hsb conversion it replaces, and the mean error of the
+/// depth recovered by each of them
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+
+		string results;
+};
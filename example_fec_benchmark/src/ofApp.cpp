@@ -0,0 +1,159 @@
+/*
+ * ofApp.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofApp.h"
+
+static const int WIDTH = 640;
+static const int HEIGHT = 480;
+static const int FPS = 30;
+static const int SERVER_PORT = 7000;
+static const int CLIENT_PORT = 5000;
+static const int WARMUP_MS = 3000;
+static const int RUN_MS = 10000;
+
+static const float LOSSES[] = {0.01, 0.05, 0.1};
+static const size_t NUM_LOSSES = sizeof(LOSSES)/sizeof(LOSSES[0]);
+
+// -1 adapts the overhead from the receiver reports
+static const int OVERHEADS[] = {10, 25, 50, -1};
+static const size_t NUM_OVERHEADS = sizeof(OVERHEADS)/sizeof(OVERHEADS[0]);
+
+static const int FEC_PAYLOAD_TYPE = ofxGstRTPCodecs::VIDEO_PAYLOAD_TYPE + ofxGstRTPCodecs::FEC_PAYLOAD_TYPE_OFFSET;
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	ofSetFrameRate(FPS);
+	frame.allocate(WIDTH,HEIGHT,OF_PIXELS_RGB);
+	finished = false;
+	currentLoss = 0;
+	currentOverhead = 0;
+	results = "video " + ofToString(WIDTH) + "x" + ofToString(HEIGHT) + "@" + ofToString(FPS) + " through loopback with FEC\n\n";
+	startRun();
+}
+
+void ofApp::startRun(){
+	float loss = LOSSES[currentLoss];
+	int overhead = OVERHEADS[currentOverhead];
+
+	// rtcp from the client goes through the relay untouched so the server
+	// can adapt the overhead to the loss
+	relay.setup(SERVER_PORT,CLIENT_PORT,loss);
+
+	server.reset(new ofxGstRTPServer);
+	server->setRetransmissionSettings(false);
+	if(overhead<0){
+		server->setFECSettings(true,10,true,5,50);
+	}else{
+		server->setFECSettings(true,overhead,false);
+	}
+	server->setup("127.0.0.1");
+	server->addVideoChannel(SERVER_PORT,WIDTH,HEIGHT,FPS);
+
+	client.reset(new ofxGstRTPClient);
+	client->setRetransmissionSettings(false);
+	client->setFECSettings(true);
+	client->setup("127.0.0.1",200);
+	client->addVideoChannel(CLIENT_PORT,OFX_GST_RTP_X264);
+
+	client->play();
+	server->play();
+
+	runStart = ofGetElapsedTimeMillis();
+	measuring = false;
+}
+
+void ofApp::stopRun(){
+	client->close();
+	server->close();
+	relay.close();
+}
+
+void ofApp::measureRun(){
+	ofxGstRTPStats stats = client->getStats(OFX_GST_RTP_VIDEO);
+	uint64_t recovered = stats.fecRecovered - statsStart.fecRecovered;
+	uint64_t unrecovered = stats.fecUnrecovered - statsStart.fecUnrecovered;
+	double recoveredRate = recovered+unrecovered>0 ? double(recovered) / (recovered+unrecovered) : 0;
+	// the bandwidth is counted before dropping so it's what the server sends
+	uint64_t fecBytes = relay.getBytesSent(FEC_PAYLOAD_TYPE);
+	uint64_t mediaBytes = relay.getBytesSent() - fecBytes;
+	double overheadRate = mediaBytes>0 ? double(fecBytes) / mediaBytes : 0;
+	int overhead = OVERHEADS[currentOverhead];
+
+	results += ofToString(LOSSES[currentLoss]*100,0) + "% loss, ";
+	if(overhead<0){
+		results += "adaptive (" + ofToString(server->getStats(OFX_GST_RTP_VIDEO).fecPercentage) + "%): ";
+	}else{
+		results += ofToString(overhead) + "% fec:      ";
+	}
+	results += "recovered " + ofToString(recoveredRate*100,1) + "% (" + ofToString(recovered) + " of " + ofToString(recovered+unrecovered) + ")";
+	results += "  bandwidth overhead " + ofToString(overheadRate*100,1) + "%\n";
+	ofLogNotice() << results;
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+	if(finished) return;
+
+	// a moving gradient so the encoder has some work to do every frame
+	int offset = ofGetFrameNum() * 4;
+	for(int y=0;y<HEIGHT;y++){
+		unsigned char * row = frame.getPixels() + y*WIDTH*3;
+		for(int x=0;x<WIDTH;x++){
+			row[x*3] = x + offset;
+			row[x*3+1] = y + offset;
+			row[x*3+2] = x + y;
+		}
+	}
+	server->newFrame(frame);
+
+	client->update();
+	if(client->isFrameNewVideo()){
+		remote.loadData(client->getPixelsVideo());
+	}
+
+	// the pipelines start during the warmup so it's not measured, it also
+	// gives time to the adaptive overhead to follow the first reports
+	unsigned long long now = ofGetElapsedTimeMillis();
+	if(!measuring && now - runStart > WARMUP_MS){
+		measuring = true;
+		measureStart = now;
+		relay.resetCounters();
+		statsStart = client->getStats(OFX_GST_RTP_VIDEO);
+	}
+
+	if(measuring && now - measureStart > RUN_MS){
+		measureRun();
+		stopRun();
+		currentOverhead++;
+		if(currentOverhead==NUM_OVERHEADS){
+			currentOverhead = 0;
+			currentLoss++;
+			results += "\n";
+		}
+		if(currentLoss<NUM_LOSSES){
+			startRun();
+		}else{
+			finished = true;
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	ofBackground(0);
+	ofSetColor(255);
+	if(remote.isAllocated()){
+		remote.draw(20,ofGetHeight()-remote.getHeight()/2-20,remote.getWidth()/2,remote.getHeight()/2);
+	}
+	ofDrawBitmapString(results,20,20);
+}
+
+//--------------------------------------------------------------
+void ofApp::exit(){
+	if(relay.isSetup()){
+		stopRun();
+	}
+}
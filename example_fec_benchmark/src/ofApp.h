@@ -0,0 +1,43 @@
+/*
+ * ofApp.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGstRTPServer.h"
+#include "ofxGstRTPClient.h"
+#include "ofxGstLossyRelay.h"
+
+/// sends a video channel with FEC to a client in the same app through a
+/// relay that drops 1%, 5% and 10% of the packets randomly. For every loss
+/// it runs with a fixed overhead of 10%, 25% and 50% and with the overhead
+/// adapted from the receiver reports, and reports the percentage of lost
+/// packets recovered against the bandwidth used by the FEC packets.
+/// Retransmission is disabled so only FEC recovers packets
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+		void exit();
+
+		void startRun();
+		void stopRun();
+		void measureRun();
+
+		shared_ptr<ofxGstRTPServer> server;
+		shared_ptr<ofxGstRTPClient> client;
+		ofxGstLossyRelay relay;
+		ofPixels frame;
+		ofTexture remote;
+
+		size_t currentLoss, currentOverhead;
+		unsigned long long runStart, measureStart;
+		bool measuring, finished;
+		ofxGstRTPStats statsStart;
+		string results;
+};
@@ -0,0 +1,127 @@
+/*
+ * ofApp.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofApp.h"
+
+static const int FPS = 60;
+static const int PORT = 5000;
+static const int WARMUP_MS = 2000;
+static const int RUN_MS = 10000;
+static const int MESSAGES_PER_SECOND = 5000;
+
+struct BundleRun{
+	string name;
+	bool bundled;
+	int windowUs;
+	int maxBytes;
+};
+
+static const BundleRun RUNS[] = {
+	{"one packet per message", false, 0, 0},
+	{"bundle per frame",       true,  0, ofxGstRTPServer::DEFAULT_OSC_BUNDLE_BYTES},
+	{"bundle per 2ms",         true,  2000, ofxGstRTPServer::MAX_OSC_BUNDLE_BYTES},
+	{"bundle per 512 bytes",   true,  1000000, 512},
+};
+static const int NUM_RUNS = sizeof(RUNS)/sizeof(RUNS[0]);
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	ofSetFrameRate(FPS);
+	results = ofToString(MESSAGES_PER_SECOND) + " osc messages per second @" + ofToString(FPS) + "fps through loopback\n\n";
+	startRun(0);
+}
+
+void ofApp::startRun(int run){
+	this->run = run;
+
+	server.reset(new ofxGstRTPServer);
+	server->setOscBundleSettings(RUNS[run].bundled,RUNS[run].windowUs,RUNS[run].maxBytes);
+	server->setup("127.0.0.1");
+	server->addOscChannel(PORT);
+
+	client.reset(new ofxGstRTPClient);
+	client->setup("127.0.0.1",100);
+	client->addOscChannel(PORT);
+
+	client->play();
+	server->play();
+
+	runStart = ofGetElapsedTimeMillis();
+	measuring = false;
+	messagesSent = 0;
+	messagesReceived = 0;
+	sendTimeUs = 0;
+	packetsAtStart = 0;
+	messagesToSend = 0;
+}
+
+void ofApp::measureRun(){
+	double seconds = RUN_MS / 1000.;
+	ofxGstRTPStats stats = server->getStats(OFX_GST_RTP_OSC);
+	results += RUNS[run].name + ":\n";
+	results += "    sent " + ofToString(messagesSent/seconds,0) + " msg/s, received " + ofToString(messagesReceived/seconds,0) + " msg/s\n";
+	results += "    " + ofToString((stats.packetsSent-packetsAtStart)/seconds,0) + " packets/s, " + ofToString(stats.bitrate/1000.,1) + "kbps, "
+			+ ofToString(messagesSent ? stats.bitrate/8./(messagesSent/seconds) : 0.,1) + " bytes/msg on the wire\n";
+	results += "    " + ofToString(messagesSent ? double(sendTimeUs)/messagesSent : 0.,2) + "us per newOscMsg\n";
+	ofLogNotice() << results;
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+	// all the runs finished
+	if(!server) return;
+
+	// a controller with 16 faders sending their values
+	messagesToSend += MESSAGES_PER_SECOND * ofGetLastFrameTime();
+	ofxOscMessage msg;
+	for(;messagesToSend>=1;messagesToSend-=1){
+		msg.clear();
+		msg.setAddress("/controller/fader");
+		msg.addIntArg(messagesSent%16);
+		msg.addFloatArg(ofNoise(messagesSent*0.01));
+		unsigned long long start = ofGetElapsedTimeMicros();
+		server->newOscMsg(msg);
+		sendTimeUs += ofGetElapsedTimeMicros() - start;
+		messagesSent++;
+	}
+
+	client->update();
+	if(client->isFrameNewOsc()){
+		client->getOscMessages(received);
+		messagesReceived += received.size();
+	}
+
+	// the pipelines start during the warmup so it's not measured
+	unsigned long long now = ofGetElapsedTimeMillis();
+	if(!measuring && now - runStart > WARMUP_MS){
+		measuring = true;
+		runStart = now;
+		messagesSent = 0;
+		messagesReceived = 0;
+		sendTimeUs = 0;
+		packetsAtStart = server->getStats(OFX_GST_RTP_OSC).packetsSent;
+	}
+
+	if(measuring && run<NUM_RUNS && now - runStart > RUN_MS){
+		measureRun();
+		client->close();
+		server->close();
+		if(run+1<NUM_RUNS){
+			startRun(run+1);
+		}else{
+			run = NUM_RUNS;
+			server.reset();
+			client.reset();
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	ofBackground(0);
+	ofSetColor(255);
+	ofDrawBitmapString(results,20,20);
+}
@@ -0,0 +1,40 @@
+/*
+ * ofApp.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGstRTPServer.h"
+#include "ofxGstRTPClient.h"
+
+/// sends osc messages at a fixed rate to a client in the same app through
+/// the loopback interface, first one packet per message and then bundled
+/// per frame, per time window and per byte budget, and measures the
+/// messages received per second, the packets and bytes on the wire and the
+/// time spent in newOscMsg for each case
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+
+		void startRun(int run);
+		void measureRun();
+
+		shared_ptr<ofxGstRTPServer> server;
+		shared_ptr<ofxGstRTPClient> client;
+		vector<ofxOscMessage> received;
+
+		int run;
+		unsigned long long runStart;
+		bool measuring;
+		uint64_t messagesSent, messagesReceived;
+		uint64_t sendTimeUs;
+		uint64_t packetsAtStart;
+		double messagesToSend;
+		string results;
+};
@@ -0,0 +1,166 @@
+/*
+ * ofApp.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "ofApp.h"
+#include "ofxGstOscParser.h"
+#include "OscOutboundPacketStream.h"
+
+static const int REPETITIONS = 20;
+static const int TRACE_FRAMES = 3000;
+// ip, udp and rtp headers of every packet
+static const int PACKET_OVERHEAD = 20 + 8 + 12;
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	string path = ofToDataPath("osc_trace.bin");
+	if(!loadTrace(path)){
+		generateTrace();
+		saveTrace(path);
+	}
+
+	numMessages = 0;
+	traceBytes = 0;
+	ofxGstOscParser parser;
+	for(size_t i=0;i<packets.size();i++){
+		parser.clear();
+		parser.parse(&packets[i][0],packets[i].size());
+		numMessages += parser.getMessages().size();
+		traceBytes += packets[i].size();
+	}
+
+	results = ofToString(packets.size()) + " packets, " + ofToString(numMessages) + " messages, "
+			+ ofToString(double(traceBytes)/numMessages,1) + " bytes/msg before encoding\n\n";
+	runMode("none",OFX_GST_OSC_COMPRESSION_NONE);
+	runMode("snappy",OFX_GST_OSC_COMPRESSION_SNAPPY);
+	runMode("adaptive",OFX_GST_OSC_COMPRESSION_ADAPTIVE);
+	ofLogNotice() << results;
+}
+
+bool ofApp::loadTrace(const string & path){
+	ofBuffer buffer = ofBufferFromFile(path,true);
+	const unsigned char * data = (const unsigned char*)buffer.getData();
+	size_t pos = 0;
+	while(pos+4<=buffer.size()){
+		size_t size = (size_t(data[pos]) << 24) | (size_t(data[pos+1]) << 16) | (size_t(data[pos+2]) << 8) | data[pos+3];
+		pos += 4;
+		if(size==0 || pos+size>buffer.size()){
+			ofLogError() << "corrupted trace " << path;
+			packets.clear();
+			return false;
+		}
+		packets.push_back(vector<char>(data+pos,data+pos+size));
+		pos += size;
+	}
+	return !packets.empty();
+}
+
+void ofApp::generateTrace(){
+	// per frame: a skeleton tracker sending one bundle with the position of
+	// its joints, a few faders sending one message each and every second a
+	// status message with strings
+	static const char * joints[] = {"head","neck","torso","left_shoulder","left_elbow","left_hand",
+			"right_shoulder","right_elbow","right_hand","left_hip","left_knee","left_foot",
+			"right_hip","right_knee","right_foot"};
+	static const int NUM_JOINTS = sizeof(joints)/sizeof(joints[0]);
+	vector<char> buffer(65536);
+	for(int frame=0;frame<TRACE_FRAMES;frame++){
+		float t = frame/60.f;
+		osc::OutboundPacketStream skeleton(&buffer[0],buffer.size());
+		skeleton << osc::BeginBundleImmediate;
+		for(int i=0;i<NUM_JOINTS;i++){
+			skeleton << osc::BeginMessage((string("/tracker/user/1/joint/") + joints[i]).c_str())
+					<< ofSignedNoise(i,t)*1000.f << ofSignedNoise(i+100,t)*1000.f << 2000.f+ofSignedNoise(i+200,t)*500.f
+					<< osc::EndMessage;
+		}
+		skeleton << osc::EndBundle;
+		packets.push_back(vector<char>(skeleton.Data(),skeleton.Data()+skeleton.Size()));
+
+		for(int i=0;i<4;i++){
+			osc::OutboundPacketStream fader(&buffer[0],buffer.size());
+			fader << osc::BeginMessage("/controller/fader") << (frame*4+i)%16 << ofNoise(i,t) << osc::EndMessage;
+			packets.push_back(vector<char>(fader.Data(),fader.Data()+fader.Size()));
+		}
+
+		if(frame%60==0){
+			osc::OutboundPacketStream status(&buffer[0],buffer.size());
+			status << osc::BeginMessage("/status") << "tracking" << "user 1 calibrated" << (frame/60) << osc::EndMessage;
+			packets.push_back(vector<char>(status.Data(),status.Data()+status.Size()));
+		}
+	}
+}
+
+void ofApp::saveTrace(const string & path){
+	ofBuffer buffer;
+	for(size_t i=0;i<packets.size();i++){
+		uint32_t size = packets[i].size();
+		char header[4] = {char(size>>24),char(size>>16),char(size>>8),char(size)};
+		buffer.append(header,4);
+		buffer.append(&packets[i][0],packets[i].size());
+	}
+	ofBufferToFile(path,buffer,true);
+}
+
+void ofApp::runMode(const string & name, ofxGstOscCompression compression){
+	// every packet is encoded and decoded in its own buffer, allocated
+	// before measuring. Each pass over the trace is timed as a whole since
+	// a single packet takes less than the timer resolution
+	vector<vector<char> > encoded(packets.size());
+	vector<size_t> encodedSizes(packets.size());
+	vector<vector<char> > decoded(packets.size());
+	for(size_t i=0;i<packets.size();i++){
+		encoded[i].resize(ofxGstOscEncoder::getMaxEncodedSize(packets[i].size()));
+		decoded[i].resize(packets[i].size());
+	}
+
+	// the counters of the encoder are the same for every repetition
+	uint64_t encodeUs = 0, decodeUs = 0;
+	uint64_t bytesOut = 0, packetsCompressed = 0;
+	for(int r=0;r<REPETITIONS;r++){
+		ofxGstOscEncoder encoder;
+		encoder.setup(compression);
+		unsigned long long start = ofGetElapsedTimeMicros();
+		for(size_t i=0;i<packets.size();i++){
+			encodedSizes[i] = encoder.encode(&packets[i][0],packets[i].size(),&encoded[i][0]);
+		}
+		encodeUs += ofGetElapsedTimeMicros() - start;
+
+		bool ok = true;
+		start = ofGetElapsedTimeMicros();
+		for(size_t i=0;i<packets.size();i++){
+			size_t decodedSize;
+			ok &= ofxGstOscDecoder::getDecodedSize(&encoded[i][0],encodedSizes[i],decodedSize)
+					&& decodedSize==packets[i].size()
+					&& ofxGstOscDecoder::decode(&encoded[i][0],encodedSizes[i],&decoded[i][0]);
+		}
+		decodeUs += ofGetElapsedTimeMicros() - start;
+
+		if(!ok || decoded!=packets){
+			ofLogError() << name << ": the trace doesn't decode to the original";
+			return;
+		}
+		bytesOut = encoder.getBytesOut();
+		packetsCompressed = encoder.getPacketsCompressed();
+	}
+
+	double messages = double(numMessages) * REPETITIONS;
+	results += name + ":\n";
+	results += "    " + ofToString(encodeUs*1000./messages,1) + "ns/msg encoding, " + ofToString(decodeUs*1000./messages,1) + "ns/msg decoding\n";
+	results += "    " + ofToString(double(bytesOut)/numMessages,1) + " bytes/msg payload, "
+			+ ofToString(double(bytesOut + packets.size()*PACKET_OVERHEAD)/numMessages,1) + " bytes/msg on the wire, "
+			+ ofToString(packetsCompressed) + " of " + ofToString(packets.size()) + " packets compressed\n";
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	ofBackground(0);
+	ofSetColor(255);
+	ofDrawBitmapString(results,20,20);
+}
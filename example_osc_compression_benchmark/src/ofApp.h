@@ -0,0 +1,34 @@
+/*
+ * ofApp.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGstOscCodec.h"
+
+/// encodes and decodes a trace of osc packets with each compression mode
+/// of the osc channels and reports the cpu time per message on each side
+/// and the bytes per message on the wire. The trace is read from
+/// data/osc_trace.bin, every packet preceded by its size as a big endian
+/// uint32. If it doesn't exist a synthetic one is generated and saved there
+/// so a trace recorded from a real session can replace it
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+
+		bool loadTrace(const string & path);
+		void generateTrace();
+		void saveTrace(const string & path);
+		void runMode(const string & name, ofxGstOscCompression compression);
+
+		vector<vector<char> > packets;
+		size_t numMessages;
+		size_t traceBytes;
+		string results;
+};
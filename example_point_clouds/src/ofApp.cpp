@@ -163,7 +163,7 @@ void ofApp::exit(){
 //--------------------------------------------------------------
 void ofApp::update(){
 	kinect.update();
-	GstClockTime now = rtp.getServer().getTimeStamp();
+	GstClockTime now = rtp.getServer().getFrameTimeStamp();
 
 	if(kinect.isFrameNewVideo()){
 		fpsRGB.newFrame();
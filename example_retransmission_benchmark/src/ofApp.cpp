@@ -0,0 +1,142 @@
+/*
+ * ofApp.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofApp.h"
+
+static const int WIDTH = 640;
+static const int HEIGHT = 480;
+static const int FPS = 30;
+static const int SERVER_PORT = 7000;
+static const int CLIENT_PORT = 5000;
+static const float LOSS = 0.05;
+static const int WARMUP_MS = 2000;
+static const int RUN_MS = 20000;
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	ofSetFrameRate(FPS);
+	frame.allocate(WIDTH,HEIGHT,OF_PIXELS_RGB);
+	finished = false;
+	results = "video " + ofToString(WIDTH) + "x" + ofToString(HEIGHT) + "@" + ofToString(FPS) + " through loopback with " + ofToString(LOSS*100,0) + "% packet loss\n\n";
+	startRun(false);
+}
+
+void ofApp::startRun(bool rtx){
+	retransmission = rtx;
+
+	// rtcp from the client goes through the relay untouched so the NACKs
+	// and keyframe requests always arrive
+	relay.setup(SERVER_PORT,CLIENT_PORT,LOSS);
+
+	server.reset(new ofxGstRTPServer);
+	server->setRetransmissionSettings(retransmission);
+	server->setup("127.0.0.1");
+	server->addVideoChannel(SERVER_PORT,WIDTH,HEIGHT,FPS);
+
+	client.reset(new ofxGstRTPClient);
+	client->setRetransmissionSettings(retransmission);
+	client->setup("127.0.0.1",200);
+	client->addVideoChannel(CLIENT_PORT,OFX_GST_RTP_X264);
+
+	client->play();
+	server->play();
+
+	runStart = ofGetElapsedTimeMillis();
+	measuring = false;
+}
+
+void ofApp::stopRun(){
+	client->close();
+	server->close();
+	relay.close();
+}
+
+void ofApp::measureRun(){
+	unsigned long long now = ofGetElapsedTimeMillis();
+	double seconds = (now - measureStart) / 1000.;
+	ofxGstRTPStats stats = client->getStats(OFX_GST_RTP_VIDEO);
+	results += string(retransmission ? "with retransmission:    " : "without retransmission: ");
+	results += "frozen " + ofToString(frozenMs) + "ms";
+	results += "  keyframes requested " + ofToString(stats.keyframesRequested - keyframesStart);
+	// what the server sends, retransmissions included
+	results += "  bandwidth " + ofToString(relay.getBytesSent() * 8 / seconds / 1000.,0) + "kbps";
+	results += "  received " + ofToString(framesReceived) + " frames";
+	if(retransmission){
+		results += "  retransmitted " + ofToString(stats.retransmissions) + " of " + ofToString(stats.retransmissionRequests) + " requested";
+	}
+	results += "\n";
+	ofLogNotice() << results;
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+	if(finished) return;
+
+	// a moving gradient so the encoder has some work to do every frame
+	int offset = ofGetFrameNum() * 4;
+	for(int y=0;y<HEIGHT;y++){
+		unsigned char * row = frame.getPixels() + y*WIDTH*3;
+		for(int x=0;x<WIDTH;x++){
+			row[x*3] = x + offset;
+			row[x*3+1] = y + offset;
+			row[x*3+2] = x + y;
+		}
+	}
+	server->newFrame(frame);
+
+	client->update();
+	unsigned long long now = ofGetElapsedTimeMillis();
+	if(client->isFrameNewVideo()){
+		// a gap of more than 2 frames counts as frozen video
+		if(measuring && now - lastFrame > 2000 / FPS){
+			frozenMs += now - lastFrame;
+		}
+		lastFrame = now;
+		framesReceived++;
+		remote.loadData(client->getPixelsVideo());
+	}
+
+	// the pipelines start during the warmup so it's not measured
+	if(!measuring && now - runStart > WARMUP_MS){
+		measuring = true;
+		measureStart = now;
+		lastFrame = now;
+		frozenMs = 0;
+		relay.resetCounters();
+		framesReceived = 0;
+		keyframesStart = client->getStats(OFX_GST_RTP_VIDEO).keyframesRequested;
+	}
+
+	if(measuring && now - measureStart > RUN_MS){
+		measureRun();
+		stopRun();
+		if(!retransmission){
+			startRun(true);
+		}else{
+			finished = true;
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	ofBackground(0);
+	ofSetColor(255);
+	if(remote.isAllocated()){
+		remote.draw(20,140,remote.getWidth()/2,remote.getHeight()/2);
+	}
+	ofDrawBitmapString(results,20,20);
+	if(!finished){
+		ofDrawBitmapString(string("running ") + (retransmission ? "with" : "without") + " retransmission",20,120);
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::exit(){
+	if(relay.isSetup()){
+		stopRun();
+	}
+}
@@ -0,0 +1,42 @@
+/*
+ * ofApp.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGstRTPServer.h"
+#include "ofxGstRTPClient.h"
+#include "ofxGstLossyRelay.h"
+
+/// sends a video channel to a client in the same app through a relay
+/// that drops 5% of the packets, once without retransmission and once
+/// with it, and compares the time the video stays frozen, the keyframes
+/// requested and the bandwidth used in each case
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+		void exit();
+
+		void startRun(bool retransmission);
+		void stopRun();
+		void measureRun();
+
+		shared_ptr<ofxGstRTPServer> server;
+		shared_ptr<ofxGstRTPClient> client;
+		ofxGstLossyRelay relay;
+		ofPixels frame;
+		ofTexture remote;
+
+		bool retransmission;
+		unsigned long long runStart, measureStart, lastFrame, frozenMs;
+		bool measuring, finished;
+		unsigned int keyframesStart;
+		int framesReceived;
+		string results;
+};
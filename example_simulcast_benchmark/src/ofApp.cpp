@@ -0,0 +1,115 @@
+/*
+ * ofApp.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofApp.h"
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+static const int FPS = 30;
+static const int PORT = 5000;
+static const int WARMUP_MS = 2000;
+static const int RUN_MS = 10000;
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	ofSetFrameRate(FPS);
+	frame.allocate(WIDTH,HEIGHT,OF_PIXELS_RGB);
+	results = "process cpu time per second of video, " + ofToString(WIDTH) + "x" + ofToString(HEIGHT) + "@" + ofToString(FPS) + " through loopback\n\n";
+	startRun(1);
+}
+
+void ofApp::startRun(int layers){
+	numLayers = layers;
+
+	server.reset(new ofxGstRTPServer);
+	server->setVideoLayers(numLayers);
+	server->setup("127.0.0.1");
+	server->addVideoChannel(PORT,WIDTH,HEIGHT,FPS);
+
+	client.reset(new ofxGstRTPClient);
+	client->setup("127.0.0.1",100);
+	client->addVideoChannel(PORT,OFX_GST_RTP_X264,numLayers);
+	client->autoVideoLayer = false;
+
+	client->play();
+	server->play();
+
+	runStart = ofGetElapsedTimeMillis();
+	measuring = false;
+}
+
+void ofApp::measureRun(){
+	double seconds = (ofGetElapsedTimeMillis() - measureStart) / 1000.;
+	double cpuMs = double(std::clock() - cpuStart) * 1000. / CLOCKS_PER_SEC / seconds;
+	cpuPerLayers.push_back(cpuMs);
+
+	results += ofToString(numLayers) + (numLayers==1 ? " layer:  " : " layers: ") + ofToString(cpuMs,1) + "ms";
+	if(cpuPerLayers.size()>1){
+		results += "  (+" + ofToString(cpuMs - cpuPerLayers[cpuPerLayers.size()-2],1) + "ms)";
+	}
+	results += "  sent " + ofToString(framesSent) + " received " + ofToString(framesReceived) + " frames\n";
+	ofLogNotice() << results;
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+	// a moving gradient so the encoder has some work to do every frame
+	int offset = ofGetFrameNum() * 4;
+	for(int y=0;y<HEIGHT;y++){
+		unsigned char * row = frame.getPixels() + y*WIDTH*3;
+		for(int x=0;x<WIDTH;x++){
+			row[x*3] = x + offset;
+			row[x*3+1] = y + offset;
+			row[x*3+2] = x + y;
+		}
+	}
+	server->newFrame(frame);
+	framesSent++;
+
+	client->update();
+	if(client->isFrameNewVideo()){
+		framesReceived++;
+		remote.loadData(client->getPixelsVideo());
+	}
+
+	// the pipelines start during the warmup so it's not measured
+	unsigned long long now = ofGetElapsedTimeMillis();
+	if(!measuring && now - runStart > WARMUP_MS){
+		measuring = true;
+		measureStart = now;
+		cpuStart = std::clock();
+		framesSent = 0;
+		framesReceived = 0;
+	}
+
+	if(measuring && cpuPerLayers.size()<3 && now - measureStart > RUN_MS){
+		measureRun();
+		// the last run stays open to try switching layers
+		if(numLayers<3){
+			client->close();
+			server->close();
+			startRun(numLayers+1);
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	ofBackground(0);
+	ofSetColor(255);
+	if(remote.isAllocated()){
+		remote.draw(20,140,remote.getWidth()/4,remote.getHeight()/4);
+	}
+	ofDrawBitmapString(results,20,20);
+	ofDrawBitmapString("running with " + ofToString(numLayers) + " layers, showing layer " + ofToString(client->getVideoLayer()) + " " + ofToString(remote.getWidth()) + "x" + ofToString(remote.getHeight()),20,120);
+}
+
+//--------------------------------------------------------------
+void ofApp::keyPressed(int key){
+	if(key>='1' && key<='3' && key-'1'<client->getNumVideoLayers()){
+		client->setVideoLayer(key-'1');
+	}
+}
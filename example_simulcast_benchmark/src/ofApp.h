@@ -0,0 +1,41 @@
+/*
+ * ofApp.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGstRTPServer.h"
+#include "ofxGstRTPClient.h"
+
+/// sends a video channel to a client in the same app through the loopback
+/// interface with 1, 2 and 3 simulcast layers and measures the cpu time
+/// the process uses in each case, which shows the cost of every
+/// additional layer. Press 1, 2 or 3 during the last run to switch the
+/// layer shown by the client
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+		void keyPressed(int key);
+
+		void startRun(int numLayers);
+		void measureRun();
+
+		shared_ptr<ofxGstRTPServer> server;
+		shared_ptr<ofxGstRTPClient> client;
+		ofPixels frame;
+		ofTexture remote;
+
+		int numLayers;
+		unsigned long long runStart, measureStart;
+		bool measuring;
+		std::clock_t cpuStart;
+		int framesSent, framesReceived;
+		vector<double> cpuPerLayers;
+		string results;
+};
@@ -0,0 +1,144 @@
+/*
+ * ofApp.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "ofApp.h"
+
+static const int WIDTH = 1280;
+static const int HEIGHT = 720;
+static const int FPS = 30;
+static const int PORT = 5000;
+static const int WARMUP_MS = 2000;
+static const int RUN_MS = 10000;
+
+enum Run{
+	COPY,
+	MOVE,
+	LEASE,
+	NUM_RUNS
+};
+
+static const char * RUN_NAMES[] = {
+	"newFrame(ofPixels&)",
+	"newFrame(ofPixels&&)",
+	"getVideoBuffer + newFrame",
+};
+
+// a moving gradient, the same work for every path
+static void render(ofPixels & pixels, int frameNum){
+	int offset = frameNum * 4;
+	for(int y=0;y<HEIGHT;y++){
+		unsigned char * row = pixels.getPixels() + y*WIDTH*3;
+		for(int x=0;x<WIDTH;x++){
+			row[x*3] = x + offset;
+			row[x*3+1] = y + offset;
+			row[x*3+2] = x + y;
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::setup(){
+	ofSetFrameRate(FPS);
+	results = "video " + ofToString(WIDTH) + "x" + ofToString(HEIGHT) + " RGB @" + ofToString(FPS) + "fps\n\n";
+	startRun(COPY);
+}
+
+void ofApp::startRun(int run){
+	this->run = run;
+	frame.allocate(WIDTH,HEIGHT,OF_PIXELS_RGB);
+
+	// the conversion to I420 is left to gstreamer so every path
+	// passes the RGB frame to a pooled buffer
+	server.reset(new ofxGstRTPServer);
+	server->setVideoConversionSettings(false);
+	server->setup("127.0.0.1");
+	server->addVideoChannel(PORT,WIDTH,HEIGHT,FPS);
+	server->play();
+
+	runStart = ofGetElapsedTimeMillis();
+	measuring = false;
+	framesSent = 0;
+	sendTimeUs = 0;
+}
+
+void ofApp::measureRun(){
+	ofxGstBufferPoolStats stats = server->getVideoPoolStats();
+	uint64_t bytesCopied = stats.bytesCopied - statsAtStart.bytesCopied;
+	uint64_t framesCopied = stats.framesCopied - statsAtStart.framesCopied;
+	results += string(RUN_NAMES[run]) + ":\n";
+	results += "    " + ofToString(framesSent ? bytesCopied/framesSent : 0) + " bytes copied per frame, "
+			+ ofToString(framesCopied) + " of " + ofToString(framesSent) + " frames copied\n";
+	results += "    " + ofToString(framesSent ? double(sendTimeUs)/framesSent : 0.,1) + "us per newFrame, "
+			+ ofToString(stats.misses - statsAtStart.misses) + " frames dropped\n";
+	ofLogNotice() << results;
+}
+
+//--------------------------------------------------------------
+void ofApp::update(){
+	// all the runs finished
+	if(!server) return;
+
+	int frameNum = ofGetFrameNum();
+	unsigned long long start;
+	switch(run){
+	case COPY:
+		render(frame,frameNum);
+		start = ofGetElapsedTimeMicros();
+		server->newFrame(frame);
+		sendTimeUs += ofGetElapsedTimeMicros() - start;
+		break;
+	case MOVE:
+		// after the swap frame holds the memory of a pooled buffer of
+		// the same size so it can be rendered into again
+		render(frame,frameNum);
+		start = ofGetElapsedTimeMicros();
+		server->newFrame(std::move(frame));
+		sendTimeUs += ofGetElapsedTimeMicros() - start;
+		if(!frame.isAllocated()){
+			frame.allocate(WIDTH,HEIGHT,OF_PIXELS_RGB);
+		}
+		break;
+	case LEASE:{
+		PooledPixels<unsigned char> * buffer = server->getVideoBuffer();
+		if(!buffer){
+			break;
+		}
+		render(*buffer,frameNum);
+		start = ofGetElapsedTimeMicros();
+		server->newFrame(buffer);
+		sendTimeUs += ofGetElapsedTimeMicros() - start;
+		break;
+	}
+	}
+	framesSent++;
+
+	// the pipeline starts during the warmup so it's not measured
+	unsigned long long now = ofGetElapsedTimeMillis();
+	if(!measuring && now - runStart > WARMUP_MS){
+		measuring = true;
+		runStart = now;
+		framesSent = 0;
+		sendTimeUs = 0;
+		statsAtStart = server->getVideoPoolStats();
+	}
+
+	if(measuring && now - runStart > RUN_MS){
+		measureRun();
+		server->close();
+		if(run+1<NUM_RUNS){
+			startRun(run+1);
+		}else{
+			server.reset();
+		}
+	}
+}
+
+//--------------------------------------------------------------
+void ofApp::draw(){
+	ofBackground(0);
+	ofSetColor(255);
+	ofDrawBitmapString(results,20,20);
+}
@@ -0,0 +1,38 @@
+/*
+ * ofApp.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#pragma once
+
+#include "ofMain.h"
+#include "ofxGstRTPServer.h"
+
+/// sends the same 720p video through the three ways of passing frames to
+/// the server: newFrame(ofPixels&) which copies the frame into a pooled
+/// buffer, newFrame(ofPixels&&) which swaps its memory with the pooled
+/// buffer and a buffer leased with getVideoBuffer which is rendered into
+/// directly. Reports the bytes copied per frame from the pool stats and
+/// the time spent in newFrame for each one
+class ofApp : public ofBaseApp{
+
+	public:
+		void setup();
+		void update();
+		void draw();
+
+		void startRun(int run);
+		void measureRun();
+
+		shared_ptr<ofxGstRTPServer> server;
+		ofPixels frame;
+
+		int run;
+		unsigned long long runStart;
+		bool measuring;
+		uint64_t framesSent;
+		uint64_t sendTimeUs;
+		ofxGstBufferPoolStats statsAtStart;
+		string results;
+};
@@ -0,0 +1,438 @@
+/*
+ * ofxGstDepth16Codec.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofxGstDepth16Codec.h"
+#include "ofLog.h"
+#include "snappy.h"
+#include <cstring>
+#include <algorithm>
+
+static const string LOG_NAME = "ofxGstDepth16Codec";
+
+// tiles smaller than this compress worse and don't split the work any better
+static const int MIN_TILE_ROWS = 8;
+
+static int getTileRow(int tile, int numTiles, int height){
+	return tile * height / numTiles;
+}
+
+// the differences wrap around in 16 bits so they can be added back exactly.
+// All the versions of the kernels give the same results
+static void subtractFrames(const uint16_t * a, const uint16_t * b, uint16_t * dst, size_t i, size_t n){
+	for(;i<n;i++){
+		dst[i] = a[i] - b[i];
+	}
+}
+
+static void addFrames(const uint16_t * a, uint16_t * dst, size_t i, size_t n){
+	for(;i<n;i++){
+		dst[i] += a[i];
+	}
+}
+
+#if OFX_GST_X86_SIMD
+
+OFX_GST_TARGET_SSSE3
+static void subtractFramesSSSE3(const uint16_t * a, const uint16_t * b, uint16_t * dst, size_t n){
+	size_t i = 0;
+	for(;i+8<=n;i+=8){
+		__m128i va = _mm_loadu_si128((const __m128i*)(a+i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b+i));
+		_mm_storeu_si128((__m128i*)(dst+i),_mm_sub_epi16(va,vb));
+	}
+	subtractFrames(a,b,dst,i,n);
+}
+
+OFX_GST_TARGET_SSSE3
+static void addFramesSSSE3(const uint16_t * a, uint16_t * dst, size_t n){
+	size_t i = 0;
+	for(;i+8<=n;i+=8){
+		__m128i va = _mm_loadu_si128((const __m128i*)(a+i));
+		__m128i vd = _mm_loadu_si128((const __m128i*)(dst+i));
+		_mm_storeu_si128((__m128i*)(dst+i),_mm_add_epi16(vd,va));
+	}
+	addFrames(a,dst,i,n);
+}
+
+OFX_GST_TARGET_AVX2
+static void subtractFramesAVX2(const uint16_t * a, const uint16_t * b, uint16_t * dst, size_t n){
+	size_t i = 0;
+	for(;i+16<=n;i+=16){
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a+i));
+		__m256i vb = _mm256_loadu_si256((const __m256i*)(b+i));
+		_mm256_storeu_si256((__m256i*)(dst+i),_mm256_sub_epi16(va,vb));
+	}
+	subtractFrames(a,b,dst,i,n);
+}
+
+OFX_GST_TARGET_AVX2
+static void addFramesAVX2(const uint16_t * a, uint16_t * dst, size_t n){
+	size_t i = 0;
+	for(;i+16<=n;i+=16){
+		__m256i va = _mm256_loadu_si256((const __m256i*)(a+i));
+		__m256i vd = _mm256_loadu_si256((const __m256i*)(dst+i));
+		_mm256_storeu_si256((__m256i*)(dst+i),_mm256_add_epi16(vd,va));
+	}
+	addFrames(a,dst,i,n);
+}
+
+#endif
+
+static void subtractFrames(const uint16_t * a, const uint16_t * b, uint16_t * dst, size_t n, ofxGstSimdLevel level){
+	switch(level){
+#if OFX_GST_X86_SIMD
+	case OFX_GST_SIMD_AVX2:
+		subtractFramesAVX2(a,b,dst,n);
+		break;
+	case OFX_GST_SIMD_SSSE3:
+		subtractFramesSSSE3(a,b,dst,n);
+		break;
+#endif
+	default:
+		subtractFrames(a,b,dst,0,n);
+		break;
+	}
+}
+
+static void addFrames(const uint16_t * a, uint16_t * dst, size_t n, ofxGstSimdLevel level){
+	switch(level){
+#if OFX_GST_X86_SIMD
+	case OFX_GST_SIMD_AVX2:
+		addFramesAVX2(a,dst,n);
+		break;
+	case OFX_GST_SIMD_SSSE3:
+		addFramesSSSE3(a,dst,n);
+		break;
+#endif
+	default:
+		addFrames(a,dst,0,n);
+		break;
+	}
+}
+
+ofxGstDepth16Compressor::ofxGstDepth16Compressor()
+:width(0)
+,height(0)
+,keyFrameInterval(DEFAULT_KEYFRAME_INTERVAL)
+,framesSinceKeyFrame(0)
+,numTiles(1)
+,simdLevel(ofxGstGetSimdLevel())
+,keyFrameRequested(true)
+,src(NULL)
+,dst(NULL)
+,currentIsKeyFrame(false){
+
+}
+
+void ofxGstDepth16Compressor::setup(int width, int height, int keyFrameInterval, int numThreads, int numTiles){
+	this->width = width;
+	this->height = height;
+	this->keyFrameInterval = std::max(1,keyFrameInterval);
+	framesSinceKeyFrame = 0;
+	keyFrameRequested = true;
+	keyFrame.assign(width*height,0);
+	delta.assign(width*height,0);
+
+	// with one thread there's no need to start any
+	workers.close();
+	if(numThreads!=1){
+		workers.setup(numThreads<=0 ? 0 : numThreads-1);
+	}
+	if(numTiles<=0){
+		numTiles = workers.getNumThreads() * 2;
+	}
+	numTiles = std::min(numTiles,std::max(1,height/MIN_TILE_ROWS));
+	this->numTiles = std::max(1,std::min(numTiles,int(ofxGstDepth16Header::MAX_TILES)));
+
+	// every tile is compressed in a slot big enough for its worst case
+	// and then moved next to the previous one
+	tileOffsets.resize(this->numTiles);
+	tileSizes.resize(this->numTiles);
+	size_t offset = sizeof(ofxGstDepth16Header) + this->numTiles * sizeof(uint32_t);
+	for(int i=0;i<this->numTiles;i++){
+		tileOffsets[i] = offset;
+		int rows = getTileRow(i+1,this->numTiles,height) - getTileRow(i,this->numTiles,height);
+		offset += snappy::MaxCompressedLength(rows*width*sizeof(uint16_t));
+	}
+}
+
+void ofxGstDepth16Compressor::close(){
+	workers.close();
+}
+
+size_t ofxGstDepth16Compressor::getMaxCompressedSize() const{
+	if(tileOffsets.empty()) return sizeof(ofxGstDepth16Header);
+	int rows = height - getTileRow(numTiles-1,numTiles,height);
+	return tileOffsets.back() + snappy::MaxCompressedLength(rows*width*sizeof(uint16_t));
+}
+
+void ofxGstDepth16Compressor::compressTile(int tile){
+	size_t begin = size_t(getTileRow(tile,numTiles,height)) * width;
+	size_t end = size_t(getTileRow(tile+1,numTiles,height)) * width;
+	const uint16_t * input;
+	if(currentIsKeyFrame){
+		memcpy(&keyFrame[begin],src+begin,(end-begin)*sizeof(uint16_t));
+		input = src + begin;
+	}else{
+		subtractFrames(src+begin,&keyFrame[begin],&delta[begin],end-begin,simdLevel);
+		input = &delta[begin];
+	}
+	snappy::RawCompress((const char*)input,(end-begin)*sizeof(uint16_t),(char*)dst+tileOffsets[tile],&tileSizes[tile]);
+}
+
+size_t ofxGstDepth16Compressor::compress(const ofShortPixels & pixels, float pixelSize, float distance, unsigned char * dst){
+	if(int(pixels.getWidth())!=width || int(pixels.getHeight())!=height || pixels.getNumChannels()!=1){
+		ofLogError(LOG_NAME) << "trying to compress " << pixels.getWidth() << "x" << pixels.getHeight() << " depth with a compressor for " << width << "x" << height;
+		return 0;
+	}
+
+	currentIsKeyFrame = keyFrameRequested.exchange(false) || framesSinceKeyFrame>=keyFrameInterval;
+	framesSinceKeyFrame = currentIsKeyFrame ? 0 : framesSinceKeyFrame+1;
+	this->src = (const uint16_t*)pixels.getPixels();
+	this->dst = dst;
+	workers.parallelFor(0,numTiles,[this](int begin, int end){
+		for(int tile=begin;tile<end;tile++){
+			compressTile(tile);
+		}
+	});
+
+	// close the gaps between the tiles and write their sizes
+	unsigned char * tilesTable = dst + sizeof(ofxGstDepth16Header);
+	size_t offset = tileOffsets[0];
+	for(int i=0;i<numTiles;i++){
+		if(offset!=tileOffsets[i]){
+			memmove(dst+offset,dst+tileOffsets[i],tileSizes[i]);
+		}
+		uint32_t tileSize = tileSizes[i];
+		memcpy(tilesTable+i*sizeof(uint32_t),&tileSize,sizeof(uint32_t));
+		offset += tileSizes[i];
+	}
+
+	ofxGstDepth16Header header;
+	header.magic = ofxGstDepth16Header::MAGIC;
+	header.width = width;
+	header.height = height;
+	header.version = ofxGstDepth16Header::VERSION;
+	header.keyFrame = currentIsKeyFrame;
+	header.numTiles = numTiles;
+	header.pixelSize = pixelSize;
+	header.distance = distance;
+	header.payloadSize = offset - sizeof(header);
+	memcpy(dst,&header,sizeof(header));
+
+	this->src = NULL;
+	this->dst = NULL;
+	return offset;
+}
+
+void ofxGstDepth16Compressor::setSimdLevel(ofxGstSimdLevel level){
+	simdLevel = std::min(level,ofxGstGetSimdLevel());
+}
+
+ofxGstSimdLevel ofxGstDepth16Compressor::getSimdLevel() const{
+	return simdLevel;
+}
+
+void ofxGstDepth16Compressor::requestKeyFrame(){
+	keyFrameRequested = true;
+}
+
+int ofxGstDepth16Compressor::getWidth() const{
+	return width;
+}
+
+int ofxGstDepth16Compressor::getHeight() const{
+	return height;
+}
+
+int ofxGstDepth16Compressor::getNumTiles() const{
+	return numTiles;
+}
+
+int ofxGstDepth16Compressor::getNumThreads() const{
+	return workers.getNumThreads();
+}
+
+
+ofxGstDepth16Decompressor::ofxGstDepth16Decompressor()
+:width(0)
+,height(0)
+,haveKeyFrame(false)
+,lastIsKeyFrame(false)
+,pixelSize(1)
+,distance(1)
+,simdLevel(ofxGstGetSimdLevel())
+,numTiles(0)
+,dst(NULL)
+,keyFrameCopy(NULL)
+,currentIsKeyFrame(false)
+,tilesOk(true){
+
+}
+
+void ofxGstDepth16Decompressor::setup(int numThreads){
+	workers.close();
+	if(numThreads!=1){
+		workers.setup(numThreads<=0 ? 0 : numThreads-1);
+	}
+}
+
+void ofxGstDepth16Decompressor::close(){
+	workers.close();
+}
+
+bool ofxGstDepth16Decompressor::decompressTile(int tile){
+	size_t begin = size_t(getTileRow(tile,numTiles,height)) * width;
+	size_t end = size_t(getTileRow(tile+1,numTiles,height)) * width;
+	size_t uncompressedSize = 0;
+	if(!snappy::GetUncompressedLength(tiles[tile],tileSizes[tile],&uncompressedSize) || uncompressedSize!=(end-begin)*sizeof(uint16_t)){
+		return false;
+	}
+	if(!snappy::RawUncompress(tiles[tile],tileSizes[tile],(char*)(dst+begin))){
+		return false;
+	}
+	// the tile was just written so adding the key frame to it
+	// is done while it's still in the cache
+	if(!currentIsKeyFrame){
+		addFrames(&keyFrame[begin],dst+begin,end-begin,simdLevel);
+	}else if(keyFrameCopy){
+		memcpy(keyFrameCopy+begin,dst+begin,(end-begin)*sizeof(uint16_t));
+	}
+	return true;
+}
+
+bool ofxGstDepth16Decompressor::decompress(const unsigned char * data, size_t size, ofShortPixels & pixels){
+	return decompress(data,size,pixels,false);
+}
+
+bool ofxGstDepth16Decompressor::decompressInto(const unsigned char * data, size_t size, ofShortPixels & pixels){
+	return decompress(data,size,pixels,true);
+}
+
+bool ofxGstDepth16Decompressor::decompress(const unsigned char * data, size_t size, ofShortPixels & pixels, bool intoPixels){
+	ofxGstDepth16Header header;
+	if(size<sizeof(header)){
+		return false;
+	}
+	memcpy(&header,data,sizeof(header));
+	if(header.magic!=ofxGstDepth16Header::MAGIC){
+		ofLogError(LOG_NAME) << "received depth frame without the GD16 magic, the sender is probably using a version of the addon older than the GD16 format";
+		return false;
+	}
+	if(header.version!=ofxGstDepth16Header::VERSION){
+		ofLogError(LOG_NAME) << "received depth frame in GD16 version " << int(header.version) << " but this addon only decodes version " << int(ofxGstDepth16Header::VERSION) << ", both peers need the same version of the addon";
+		return false;
+	}
+	size_t tablesSize = header.numTiles * sizeof(uint32_t);
+	if(header.numTiles==0 || header.numTiles>ofxGstDepth16Header::MAX_TILES || header.numTiles>header.height
+			|| header.payloadSize>size-sizeof(header) || tablesSize>header.payloadSize){
+		ofLogError(LOG_NAME) << "received invalid depth frame";
+		return false;
+	}
+
+	// a key frame with a different size restarts the decoder
+	if(header.width!=width || header.height!=height){
+		if(!header.keyFrame){
+			return false;
+		}
+		// the pixels could be pointing to the old frames
+		if(!intoPixels){
+			pixels.clear();
+		}
+		width = header.width;
+		height = header.height;
+		keyFrame.resize(width*height);
+		nextKeyFrame.resize(width*height);
+		frame.resize(width*height);
+		haveKeyFrame = false;
+	}
+	if(!header.keyFrame && !haveKeyFrame){
+		return false;
+	}
+
+	// find where each tile starts from the table of sizes
+	numTiles = header.numTiles;
+	const unsigned char * tilesTable = data + sizeof(header);
+	const unsigned char * tile = tilesTable + tablesSize;
+	const unsigned char * payloadEnd = data + sizeof(header) + header.payloadSize;
+	for(int i=0;i<numTiles;i++){
+		memcpy(&tileSizes[i],tilesTable+i*sizeof(uint32_t),sizeof(uint32_t));
+		if(tileSizes[i]>size_t(payloadEnd-tile)){
+			ofLogError(LOG_NAME) << "received corrupted depth frame";
+			return false;
+		}
+		tiles[i] = (const char*)tile;
+		tile += tileSizes[i];
+	}
+
+	// key frames are decompressed aside so a corrupted one doesn't
+	// break the current key frame
+	currentIsKeyFrame = header.keyFrame;
+	if(intoPixels){
+		if(int(pixels.getWidth())!=width || int(pixels.getHeight())!=height || pixels.getNumChannels()!=1){
+			pixels.allocate(width,height,1);
+		}
+		dst = pixels.getPixels();
+		keyFrameCopy = &nextKeyFrame[0];
+	}else{
+		dst = currentIsKeyFrame ? &nextKeyFrame[0] : &frame[0];
+		keyFrameCopy = NULL;
+	}
+	tilesOk = true;
+	workers.parallelFor(0,numTiles,[this](int begin, int end){
+		for(int tile=begin;tile<end;tile++){
+			if(!decompressTile(tile)){
+				tilesOk = false;
+			}
+		}
+	});
+	dst = NULL;
+	keyFrameCopy = NULL;
+
+	if(!tilesOk){
+		ofLogError(LOG_NAME) << "received corrupted depth frame";
+		return false;
+	}
+	if(header.keyFrame){
+		keyFrame.swap(nextKeyFrame);
+		haveKeyFrame = true;
+	}
+	if(!intoPixels){
+		pixels.setFromExternalPixels(header.keyFrame ? &keyFrame[0] : &frame[0],width,height,1);
+	}
+	lastIsKeyFrame = header.keyFrame;
+	pixelSize = header.pixelSize;
+	distance = header.distance;
+	return true;
+}
+
+void ofxGstDepth16Decompressor::reset(){
+	haveKeyFrame = false;
+}
+
+float ofxGstDepth16Decompressor::getPixelSize() const{
+	return pixelSize;
+}
+
+float ofxGstDepth16Decompressor::getDistance() const{
+	return distance;
+}
+
+bool ofxGstDepth16Decompressor::isKeyFrame() const{
+	return lastIsKeyFrame;
+}
+
+void ofxGstDepth16Decompressor::setSimdLevel(ofxGstSimdLevel level){
+	simdLevel = std::min(level,ofxGstGetSimdLevel());
+}
+
+ofxGstSimdLevel ofxGstDepth16Decompressor::getSimdLevel() const{
+	return simdLevel;
+}
+
+int ofxGstDepth16Decompressor::getNumThreads() const{
+	return workers.getNumThreads();
+}
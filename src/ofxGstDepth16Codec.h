@@ -0,0 +1,175 @@
+/*
+ * ofxGstDepth16Codec.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTDEPTH16CODEC_H_
+#define OFXGSTDEPTH16CODEC_H_
+
+#include "ofConstants.h"
+#include "ofPixels.h"
+#include "ofxGstWorkerPool.h"
+#include "ofxGstSimd.h"
+#include <atomic>
+#include <stdint.h>
+
+/// header at the beginning of every compressed 16bits depth frame. It's
+/// followed by a table with the compressed size of each tile as uint32 and
+/// the compressed tiles one after another. Tile i contains the rows
+/// [i*height/numTiles, (i+1)*height/numTiles)
+/// This format isn't compatible with the ofxDepthCompressedFrame sent by
+/// older versions of the addon, or with version 1 which had no tiles, so
+/// both peers need the same version
+struct ofxGstDepth16Header{
+	uint32_t magic;
+	uint16_t width;
+	uint16_t height;
+	uint8_t version;
+	uint8_t keyFrame;
+	uint16_t numTiles;
+	float pixelSize;
+	float distance;
+	/// bytes after the header, tiles table included
+	uint32_t payloadSize;
+
+	static const uint32_t MAGIC = 0x36314447; // "GD16"
+	static const uint8_t VERSION = 2;
+	static const int MAX_TILES = 256;
+};
+
+/// compresses 16bits depth frames for the depth16 channels. Key frames
+/// contain the whole depth, the rest the difference with the last key
+/// frame so a lost frame only affects itself. The result is compressed
+/// with snappy which works well with the runs of zeros of the differences.
+/// Each frame is split in tiles of whole rows that are compressed in
+/// parallel in several threads and can be decompressed in parallel too.
+/// The output is written directly in memory provided by the caller so it
+/// can be a buffer from a pool, nothing is allocated after setup
+class ofxGstDepth16Compressor{
+public:
+	ofxGstDepth16Compressor();
+
+	/// numThreads is the number of threads used for each frame including the
+	/// calling thread, 0 chooses it from the number of cores. numTiles 0
+	/// uses 2 tiles per thread
+	void setup(int width, int height, int keyFrameInterval=DEFAULT_KEYFRAME_INTERVAL, int numThreads=0, int numTiles=0);
+	void close();
+
+	/// size of the biggest frame compress can produce, the memory passed
+	/// to it needs to be at least this big
+	size_t getMaxCompressedSize() const;
+
+	/// compresses pixels into dst and returns the bytes written or 0 if the
+	/// pixels don't have the size passed to setup
+	size_t compress(const ofShortPixels & pixels, float pixelSize, float distance, unsigned char * dst);
+
+	/// the next frame will be a key frame, can be called from any thread
+	void requestKeyFrame();
+
+	int getWidth() const;
+	int getHeight() const;
+	int getNumTiles() const;
+	int getNumThreads() const;
+
+	/// instruction set used to calculate the differences, by default the
+	/// best available. It can't be set higher than what the cpu supports
+	void setSimdLevel(ofxGstSimdLevel level);
+	ofxGstSimdLevel getSimdLevel() const;
+
+	static const int DEFAULT_KEYFRAME_INTERVAL = 30;
+
+private:
+	void compressTile(int tile);
+
+	int width, height;
+	int keyFrameInterval;
+	int framesSinceKeyFrame;
+	int numTiles;
+	ofxGstSimdLevel simdLevel;
+	std::atomic<bool> keyFrameRequested;
+	vector<uint16_t> keyFrame;
+	vector<uint16_t> delta;
+	vector<size_t> tileOffsets;
+	vector<size_t> tileSizes;
+	ofxGstWorkerPool workers;
+
+	// current frame, only valid during compress
+	const uint16_t * src;
+	unsigned char * dst;
+	bool currentIsKeyFrame;
+};
+
+/// decompresses the frames of ofxGstDepth16Compressor, keeps the last key
+/// frame to reconstruct the rest. The tiles of a frame are decompressed in
+/// parallel and the differences are added to the key frame in place right
+/// after decompressing each tile. The decompressed frames are kept by the
+/// decompressor and key frames are swapped with the previous one instead of
+/// copied so nothing is allocated or copied after the first frame.
+/// decompressInto writes the frames in memory owned by the caller instead,
+/// for when the frame needs to outlive the next call, eg. when decompressing
+/// in a different thread than the one that reads the pixels
+class ofxGstDepth16Decompressor{
+public:
+	ofxGstDepth16Decompressor();
+
+	/// numThreads is the number of threads used for each frame including the
+	/// calling thread, 0 chooses it from the number of cores. Without calling
+	/// it frames are decompressed in the calling thread only
+	void setup(int numThreads=0);
+	void close();
+
+	/// decompresses a frame and points pixels to it, the pixels are only
+	/// valid until the next call. Returns false if the data is not valid
+	/// or it's a difference and no key frame has arrived yet, in that case
+	/// pixels still point to the last valid frame
+	bool decompress(const unsigned char * data, size_t size, ofShortPixels & pixels);
+
+	/// decompresses a frame into the memory of pixels, allocating them if
+	/// they don't have the size of the frame. Key frames are also copied
+	/// tile by tile to the decompressor to reconstruct the next frames.
+	/// If it returns false the contents of pixels are undefined
+	bool decompressInto(const unsigned char * data, size_t size, ofShortPixels & pixels);
+
+	/// forgets the key frame, differences are rejected until the next one
+	/// arrives. Needed if some frames were not passed to the decompressor
+	void reset();
+
+	/// zero plane pixel size and distance of the last frame
+	float getPixelSize() const;
+	float getDistance() const;
+
+	bool isKeyFrame() const;
+
+	int getNumThreads() const;
+
+	/// instruction set used to add the differences, by default the best
+	/// available. It can't be set higher than what the cpu supports
+	void setSimdLevel(ofxGstSimdLevel level);
+	ofxGstSimdLevel getSimdLevel() const;
+
+private:
+	bool decompress(const unsigned char * data, size_t size, ofShortPixels & pixels, bool intoPixels);
+	bool decompressTile(int tile);
+
+	int width, height;
+	bool haveKeyFrame;
+	bool lastIsKeyFrame;
+	float pixelSize, distance;
+	ofxGstSimdLevel simdLevel;
+	vector<uint16_t> keyFrame;
+	vector<uint16_t> nextKeyFrame;
+	vector<uint16_t> frame;
+	ofxGstWorkerPool workers;
+
+	// current frame, only valid during decompress
+	int numTiles;
+	const char * tiles[ofxGstDepth16Header::MAX_TILES];
+	uint32_t tileSizes[ofxGstDepth16Header::MAX_TILES];
+	uint16_t * dst;
+	uint16_t * keyFrameCopy;
+	bool currentIsKeyFrame;
+	std::atomic<bool> tilesOk;
+};
+
+#endif /* OFXGSTDEPTH16CODEC_H_ */
@@ -0,0 +1,184 @@
+/*
+ * ofxGstDepth16DoubleBuffer.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofxGstDepth16DoubleBuffer.h"
+#include <gst/gst.h>
+#include <algorithm>
+
+ofxGstDepth16DoubleBuffer::ofxGstDepth16DoubleBuffer()
+:running(false)
+,resetPending(false)
+,allocated(false)
+,bIsNewFrame(false)
+,pendingKeyFrame(NULL)
+,pendingFrame(NULL)
+,front(0)
+,ready(1)
+,back(2)
+,readyIsNew(false)
+,readyPixelSize(1)
+,readyDistance(1)
+,pixelSize(1)
+,distance(1)
+,framesDecoded(0)
+,framesDropped(0){
+
+}
+
+ofxGstDepth16DoubleBuffer::~ofxGstDepth16DoubleBuffer(){
+	close();
+}
+
+void ofxGstDepth16DoubleBuffer::setup(int numThreads){
+	close();
+	decompressor.setup(numThreads);
+	running = true;
+	thread = std::thread(&ofxGstDepth16DoubleBuffer::threadedFunction,this);
+	allocated = true;
+}
+
+void ofxGstDepth16DoubleBuffer::close(){
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		running = false;
+		condition.notify_all();
+	}
+	if(thread.joinable()){
+		thread.join();
+	}
+	if(pendingKeyFrame){
+		gst_sample_unref(pendingKeyFrame);
+		pendingKeyFrame = NULL;
+	}
+	if(pendingFrame){
+		gst_sample_unref(pendingFrame);
+		pendingFrame = NULL;
+	}
+	decompressor.close();
+	allocated = false;
+}
+
+bool ofxGstDepth16DoubleBuffer::isAllocated(){
+	return allocated;
+}
+
+void ofxGstDepth16DoubleBuffer::newSample(GstSample * sample){
+	// only the key frame flag is needed to decide what can be dropped
+	ofxGstDepth16Header header;
+	GstBuffer * buffer = gst_sample_get_buffer(sample);
+	bool keyFrame = buffer
+			&& gst_buffer_extract(buffer,0,&header,sizeof(header))==sizeof(header)
+			&& header.magic==ofxGstDepth16Header::MAGIC
+			&& header.keyFrame;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	if(keyFrame){
+		// differences waiting are from the previous key frame
+		if(pendingKeyFrame){
+			gst_sample_unref(pendingKeyFrame);
+			framesDropped++;
+		}
+		if(pendingFrame){
+			gst_sample_unref(pendingFrame);
+			pendingFrame = NULL;
+			framesDropped++;
+		}
+		pendingKeyFrame = sample;
+	}else{
+		if(pendingFrame){
+			gst_sample_unref(pendingFrame);
+			framesDropped++;
+		}
+		pendingFrame = sample;
+	}
+	condition.notify_all();
+}
+
+void ofxGstDepth16DoubleBuffer::threadedFunction(){
+	std::unique_lock<std::mutex> lock(mutex);
+	while(running){
+		if(!pendingKeyFrame && !pendingFrame){
+			condition.wait(lock);
+			continue;
+		}
+		// the decompressor is only touched from this thread
+		bool reset = resetPending;
+		resetPending = false;
+		GstSample * sample;
+		if(pendingKeyFrame){
+			sample = pendingKeyFrame;
+			pendingKeyFrame = NULL;
+		}else{
+			sample = pendingFrame;
+			pendingFrame = NULL;
+		}
+
+		// the back frame is only touched from this thread
+		lock.unlock();
+		if(reset){
+			decompressor.reset();
+		}
+		bool decoded = false;
+		GstBuffer * buffer = gst_sample_get_buffer(sample);
+		GstMapInfo mapinfo = {0,};
+		if(buffer && gst_buffer_map(buffer,&mapinfo,GST_MAP_READ)){
+			decoded = decompressor.decompressInto(mapinfo.data,mapinfo.size,frames[back]);
+			gst_buffer_unmap(buffer,&mapinfo);
+		}
+		gst_sample_unref(sample);
+		lock.lock();
+
+		if(decoded){
+			std::swap(ready,back);
+			readyIsNew = true;
+			readyPixelSize = decompressor.getPixelSize();
+			readyDistance = decompressor.getDistance();
+			framesDecoded++;
+		}
+	}
+}
+
+void ofxGstDepth16DoubleBuffer::reset(){
+	std::unique_lock<std::mutex> lock(mutex);
+	resetPending = true;
+}
+
+void ofxGstDepth16DoubleBuffer::update(){
+	std::unique_lock<std::mutex> lock(mutex);
+	if(readyIsNew){
+		std::swap(front,ready);
+		readyIsNew = false;
+		pixelSize = readyPixelSize;
+		distance = readyDistance;
+		bIsNewFrame = true;
+	}else{
+		bIsNewFrame = false;
+	}
+}
+
+bool ofxGstDepth16DoubleBuffer::isFrameNew(){
+	return bIsNewFrame;
+}
+
+ofShortPixels & ofxGstDepth16DoubleBuffer::getPixels(){
+	return frames[front];
+}
+
+float ofxGstDepth16DoubleBuffer::getZeroPlanePixelSize(){
+	return pixelSize;
+}
+
+float ofxGstDepth16DoubleBuffer::getZeroPlaneDistance(){
+	return distance;
+}
+
+uint64_t ofxGstDepth16DoubleBuffer::getFramesDecoded() const{
+	return framesDecoded;
+}
+
+uint64_t ofxGstDepth16DoubleBuffer::getFramesDropped() const{
+	return framesDropped;
+}
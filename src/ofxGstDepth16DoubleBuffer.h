@@ -0,0 +1,89 @@
+/*
+ * ofxGstDepth16DoubleBuffer.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTDEPTH16DOUBLEBUFFER_H_
+#define OFXGSTDEPTH16DOUBLEBUFFER_H_
+
+#include "ofPixels.h"
+#include "ofxGstDepth16Codec.h"
+#include <gst/gstsample.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <stdint.h>
+
+/// class used internally to receive compressed 16bits depth. The samples
+/// are decompressed in a thread of their own as they arrive so update,
+/// called from the main thread, only swaps the last decompressed frame.
+///
+/// There's 3 frames: the one the application reads, the last decompressed
+/// one waiting for update and the one being decompressed, so the decoder
+/// never waits for the application or the other way around.
+///
+/// If samples arrive faster than they can be decompressed only the last
+/// one is kept and the rest are counted as dropped. Differences only
+/// depend on the key frame so they can be dropped safely, but a key frame
+/// is only dropped when a newer key frame replaces it
+class ofxGstDepth16DoubleBuffer{
+public:
+	ofxGstDepth16DoubleBuffer();
+	~ofxGstDepth16DoubleBuffer();
+
+	/// starts the decoding thread, numThreads is the number of threads used
+	/// to decompress each frame as in ofxGstDepth16Decompressor::setup
+	void setup(int numThreads=0);
+	void close();
+	bool isAllocated();
+
+	/// called from the streaming thread, takes ownership of the sample
+	void newSample(GstSample * sample);
+
+	/// the frames received from now on don't follow the previous ones,
+	/// differences are dropped until the next key frame
+	void reset();
+
+	void update();
+	bool isFrameNew();
+	ofShortPixels & getPixels();
+
+	float getZeroPlanePixelSize();
+	float getZeroPlaneDistance();
+
+	/// frames decompressed and frames dropped because the decoder was still
+	/// busy with the previous ones. Can be called from any thread
+	uint64_t getFramesDecoded() const;
+	uint64_t getFramesDropped() const;
+
+private:
+	void threadedFunction();
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool running;
+	bool resetPending;
+	std::atomic<bool> allocated;
+	bool bIsNewFrame;
+
+	// waiting to be decoded, the key frame goes first since the
+	// frame could be a difference with it
+	GstSample * pendingKeyFrame, * pendingFrame;
+
+	ofxGstDepth16Decompressor decompressor;
+	ofShortPixels frames[3];
+	int front, ready, back;
+	bool readyIsNew;
+
+	// zero plane of the ready frame and of the front one
+	float readyPixelSize, readyDistance;
+	float pixelSize, distance;
+
+	std::atomic<uint64_t> framesDecoded;
+	std::atomic<uint64_t> framesDropped;
+};
+
+#endif /* OFXGSTDEPTH16DOUBLEBUFFER_H_ */
@@ -0,0 +1,234 @@
+/*
+ * ofxGstDepth16Packer.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofxGstDepth16Packer.h"
+#include "ofLog.h"
+#include "ofMath.h"
+#include <algorithm>
+#include <cmath>
+
+// all the math is done in float with the same operations in the same order
+// in every version of the kernels so they give exactly the same results.
+// Rounding is to the nearest even like the SIMD instructions do
+struct PackConstants{
+	PackConstants(float maxDepth, float step, float period)
+	:maxDepth(maxDepth)
+	,step(step)
+	,invStep(1.f/step)
+	,period(period)
+	,invPeriod(1.f/period)
+	,quarter(period*0.25f)
+	,toFine(255.f/(period*0.5f))
+	,fromFine(period*0.5f/255.f){}
+
+	float maxDepth;
+	float step, invStep;
+	float period, invPeriod;
+	float quarter;
+	float toFine, fromFine;
+};
+
+static inline float triangle(float d, const PackConstants & k){
+	float p = d - floorf(d * k.invPeriod) * k.period;
+	return nearbyintf(std::min(p,k.period - p) * k.toFine);
+}
+
+static void pack(const uint16_t * depth, unsigned char * coarse, unsigned char * fine, unsigned char * fineShifted, size_t i, size_t n, const PackConstants & k){
+	for(;i<n;i++){
+		float d = std::min(float(depth[i]),k.maxDepth);
+		coarse[i] = std::min(nearbyintf(d * k.invStep),255.f);
+		fine[i] = triangle(d,k);
+		fineShifted[i] = triangle(d + k.quarter,k);
+	}
+}
+
+static void unpack(const unsigned char * coarse, const unsigned char * fine, const unsigned char * fineShifted, uint16_t * depth, size_t i, size_t n, const PackConstants & k){
+	for(;i<n;i++){
+		float c = coarse[i] * k.step;
+		float a = fine[i] * k.fromFine;
+		float b = fineShifted[i] * k.fromFine;
+
+		// the position in the period comes from the wave that is further
+		// from its peaks, the other one tells if it's rising or falling
+		float positionA = b > k.quarter ? a : k.period - a;
+		float positionB = (a < k.quarter ? b : k.period - b) - k.quarter;
+		float position = fabsf(a - k.quarter) <= fabsf(b - k.quarter) ? positionA : positionB;
+
+		// and the coarse depth the period
+		float d = nearbyintf((c - position) * k.invPeriod) * k.period + position;
+		depth[i] = std::min(std::max(nearbyintf(d),0.f),65535.f);
+	}
+}
+
+#if OFX_GST_X86_SIMD
+
+#define OFX_GST_ROUND _MM_FROUND_TO_NEAREST_INT|_MM_FROUND_NO_EXC
+
+OFX_GST_TARGET_AVX2
+static inline __m256 triangleAVX2(__m256 d, __m256 period, __m256 invPeriod, __m256 toFine){
+	__m256 p = _mm256_sub_ps(d,_mm256_mul_ps(_mm256_floor_ps(_mm256_mul_ps(d,invPeriod)),period));
+	return _mm256_round_ps(_mm256_mul_ps(_mm256_min_ps(p,_mm256_sub_ps(period,p)),toFine),OFX_GST_ROUND);
+}
+
+// 8 floats in [0,255] as bytes in the low 8 bytes of the result
+OFX_GST_TARGET_AVX2
+static inline __m128i toBytesAVX2(__m256 v){
+	__m256i v16 = _mm256_packus_epi32(_mm256_cvtps_epi32(v),_mm256_setzero_si256());
+	__m256i v8 = _mm256_packus_epi16(v16,v16);
+	return _mm_unpacklo_epi32(_mm256_castsi256_si128(v8),_mm256_extracti128_si256(v8,1));
+}
+
+OFX_GST_TARGET_AVX2
+static inline __m256 fromBytesAVX2(const unsigned char * bytes){
+	return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)bytes)));
+}
+
+OFX_GST_TARGET_AVX2
+static void packAVX2(const uint16_t * depth, unsigned char * coarse, unsigned char * fine, unsigned char * fineShifted, size_t n, const PackConstants & k){
+	const __m256 maxDepth = _mm256_set1_ps(k.maxDepth);
+	const __m256 invStep = _mm256_set1_ps(k.invStep);
+	const __m256 maxCoarse = _mm256_set1_ps(255.f);
+	const __m256 period = _mm256_set1_ps(k.period);
+	const __m256 invPeriod = _mm256_set1_ps(k.invPeriod);
+	const __m256 quarter = _mm256_set1_ps(k.quarter);
+	const __m256 toFine = _mm256_set1_ps(k.toFine);
+	size_t i = 0;
+	for(;i+8<=n;i+=8){
+		__m256 d = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(depth+i))));
+		d = _mm256_min_ps(d,maxDepth);
+		__m256 c = _mm256_min_ps(_mm256_round_ps(_mm256_mul_ps(d,invStep),OFX_GST_ROUND),maxCoarse);
+		_mm_storel_epi64((__m128i*)(coarse+i),toBytesAVX2(c));
+		_mm_storel_epi64((__m128i*)(fine+i),toBytesAVX2(triangleAVX2(d,period,invPeriod,toFine)));
+		_mm_storel_epi64((__m128i*)(fineShifted+i),toBytesAVX2(triangleAVX2(_mm256_add_ps(d,quarter),period,invPeriod,toFine)));
+	}
+	pack(depth,coarse,fine,fineShifted,i,n,k);
+}
+
+OFX_GST_TARGET_AVX2
+static void unpackAVX2(const unsigned char * coarse, const unsigned char * fine, const unsigned char * fineShifted, uint16_t * depth, size_t n, const PackConstants & k){
+	const __m256 step = _mm256_set1_ps(k.step);
+	const __m256 period = _mm256_set1_ps(k.period);
+	const __m256 invPeriod = _mm256_set1_ps(k.invPeriod);
+	const __m256 quarter = _mm256_set1_ps(k.quarter);
+	const __m256 fromFine = _mm256_set1_ps(k.fromFine);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 maxDepth = _mm256_set1_ps(65535.f);
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+	size_t i = 0;
+	for(;i+8<=n;i+=8){
+		__m256 c = _mm256_mul_ps(fromBytesAVX2(coarse+i),step);
+		__m256 a = _mm256_mul_ps(fromBytesAVX2(fine+i),fromFine);
+		__m256 b = _mm256_mul_ps(fromBytesAVX2(fineShifted+i),fromFine);
+
+		__m256 positionA = _mm256_blendv_ps(_mm256_sub_ps(period,a),a,_mm256_cmp_ps(b,quarter,_CMP_GT_OQ));
+		__m256 positionB = _mm256_sub_ps(_mm256_blendv_ps(_mm256_sub_ps(period,b),b,_mm256_cmp_ps(a,quarter,_CMP_LT_OQ)),quarter);
+		__m256 useA = _mm256_cmp_ps(
+				_mm256_and_ps(_mm256_sub_ps(a,quarter),absMask),
+				_mm256_and_ps(_mm256_sub_ps(b,quarter),absMask),
+				_CMP_LE_OQ);
+		__m256 position = _mm256_blendv_ps(positionB,positionA,useA);
+
+		__m256 d = _mm256_add_ps(_mm256_mul_ps(_mm256_round_ps(_mm256_mul_ps(_mm256_sub_ps(c,position),invPeriod),OFX_GST_ROUND),period),position);
+		d = _mm256_min_ps(_mm256_max_ps(_mm256_round_ps(d,OFX_GST_ROUND),zero),maxDepth);
+		__m256i d16 = _mm256_packus_epi32(_mm256_cvtps_epi32(d),_mm256_setzero_si256());
+		d16 = _mm256_permute4x64_epi64(d16,_MM_SHUFFLE(3,1,2,0));
+		_mm_storeu_si128((__m128i*)(depth+i),_mm256_castsi256_si128(d16));
+	}
+	unpack(coarse,fine,fineShifted,depth,i,n,k);
+}
+
+#undef OFX_GST_ROUND
+
+#endif
+
+ofxGstDepth16Packer::ofxGstDepth16Packer()
+:maxDepth(0)
+,step(1)
+,period(PERIOD_STEPS)
+,simdLevel(ofxGstGetSimdLevel()){
+	setup();
+}
+
+void ofxGstDepth16Packer::setup(int maxDepth){
+	this->maxDepth = ofClamp(maxDepth,255,65535);
+	step = ceilf(this->maxDepth / 255.f);
+	period = step * PERIOD_STEPS;
+}
+
+int ofxGstDepth16Packer::getMaxDepth() const{
+	return maxDepth;
+}
+
+float ofxGstDepth16Packer::getCoarseStep() const{
+	return step;
+}
+
+float ofxGstDepth16Packer::getFineStep() const{
+	return period * 0.5f / 255.f;
+}
+
+void ofxGstDepth16Packer::pack(const ofShortPixels & depth, ofPixels & packed) const{
+	if(depth.getNumChannels()!=1){
+		ofLogError("ofxGstDepth16Packer") << "trying to pack depth with " << depth.getNumChannels() << " channels";
+		return;
+	}
+	if(packed.getWidth()!=depth.getWidth() || packed.getHeight()!=depth.getHeight()*NUM_PLANES || packed.getNumChannels()!=1){
+		packed.allocate(depth.getWidth(),depth.getHeight()*NUM_PLANES,1);
+	}
+	size_t numPixels = depth.getWidth() * depth.getHeight();
+	unsigned char * planes = packed.getPixels();
+	pack(depth.getPixels(),planes,planes+numPixels,planes+numPixels*2,numPixels);
+}
+
+void ofxGstDepth16Packer::pack(const uint16_t * depth, unsigned char * coarse, unsigned char * fine, unsigned char * fineShifted, size_t numPixels) const{
+	PackConstants k(maxDepth,step,period);
+	switch(simdLevel){
+#if OFX_GST_X86_SIMD
+	case OFX_GST_SIMD_AVX2:
+		packAVX2(depth,coarse,fine,fineShifted,numPixels,k);
+		break;
+#endif
+	default:
+		::pack(depth,coarse,fine,fineShifted,0,numPixels,k);
+		break;
+	}
+}
+
+void ofxGstDepth16Packer::unpack(const ofPixels & packed, ofShortPixels & depth) const{
+	if(packed.getNumChannels()!=1 || packed.getHeight()%NUM_PLANES!=0){
+		ofLogError("ofxGstDepth16Packer") << "trying to unpack a frame that is not gray with a height multiple of " << NUM_PLANES;
+		return;
+	}
+	int height = packed.getHeight()/NUM_PLANES;
+	if(depth.getWidth()!=packed.getWidth() || int(depth.getHeight())!=height || depth.getNumChannels()!=1){
+		depth.allocate(packed.getWidth(),height,1);
+	}
+	size_t numPixels = packed.getWidth() * height;
+	const unsigned char * planes = packed.getPixels();
+	unpack(planes,planes+numPixels,planes+numPixels*2,depth.getPixels(),numPixels);
+}
+
+void ofxGstDepth16Packer::unpack(const unsigned char * coarse, const unsigned char * fine, const unsigned char * fineShifted, uint16_t * depth, size_t numPixels) const{
+	PackConstants k(maxDepth,step,period);
+	switch(simdLevel){
+#if OFX_GST_X86_SIMD
+	case OFX_GST_SIMD_AVX2:
+		unpackAVX2(coarse,fine,fineShifted,depth,numPixels,k);
+		break;
+#endif
+	default:
+		::unpack(coarse,fine,fineShifted,depth,0,numPixels,k);
+		break;
+	}
+}
+
+void ofxGstDepth16Packer::setSimdLevel(ofxGstSimdLevel level){
+	simdLevel = std::min(level,ofxGstGetSimdLevel());
+}
+
+ofxGstSimdLevel ofxGstDepth16Packer::getSimdLevel() const{
+	return simdLevel;
+}
@@ -0,0 +1,74 @@
+/*
+ * ofxGstDepth16Packer.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTDEPTH16PACKER_H_
+#define OFXGSTDEPTH16PACKER_H_
+
+#include "ofPixels.h"
+#include "ofxGstSimd.h"
+#include <stdint.h>
+
+/// packs 16bits depth in an 8bits gray frame with 3 times the height so it
+/// can be sent through a video encoder like the 8bits depth. The top third
+/// is a coarse plane with the depth quantized in 256 steps up to maxDepth.
+/// The other two are fine planes with triangle waves of the depth that
+/// repeat every PERIOD_STEPS coarse steps, the second one shifted a quarter
+/// of the period. The waves have no discontinuities so they survive the
+/// quantization of the encoder much better than the low byte of the depth
+/// would, and at any depth one of them is far from its peaks and tells the
+/// position in the period while the other tells in which half it is.
+///
+/// To unpack, the coarse value only needs to select the period so it can
+/// arrive with an error of up to PERIOD_STEPS/2 - 1 steps, then the error of
+/// the result is the error of the fine planes multiplied by getFineStep(),
+/// around a millimeter for depth in mm up to 10m.
+///
+/// Depth over maxDepth is clamped. The zero plane pixel size and distance
+/// are not sent in this mode
+class ofxGstDepth16Packer{
+public:
+	ofxGstDepth16Packer();
+
+	void setup(int maxDepth=DEFAULT_MAX_DEPTH);
+	int getMaxDepth() const;
+
+	/// depth units per level of the coarse and fine planes
+	float getCoarseStep() const;
+	float getFineStep() const;
+
+	/// packs depth into a gray frame of width x height*NUM_PLANES, allocating
+	/// it if it doesn't have that size
+	void pack(const ofShortPixels & depth, ofPixels & packed) const;
+
+	/// packs depth into width x height planes
+	void pack(const uint16_t * depth, unsigned char * coarse, unsigned char * fine, unsigned char * fineShifted, size_t numPixels) const;
+
+	/// unpacks a gray frame of width x height*NUM_PLANES into depth,
+	/// allocating it if it doesn't have the size of one of the planes
+	void unpack(const ofPixels & packed, ofShortPixels & depth) const;
+
+	void unpack(const unsigned char * coarse, const unsigned char * fine, const unsigned char * fineShifted, uint16_t * depth, size_t numPixels) const;
+
+	/// forces a specific instruction set, by default the best one available
+	/// is used. Mostly useful for benchmarking
+	void setSimdLevel(ofxGstSimdLevel level);
+	ofxGstSimdLevel getSimdLevel() const;
+
+	static const int DEFAULT_MAX_DEPTH = 10000;
+
+	/// planes stacked vertically in a packed frame
+	static const int NUM_PLANES = 3;
+
+	/// coarse steps in each period of the fine planes
+	static const int PERIOD_STEPS = 16;
+
+private:
+	int maxDepth;
+	float step, period;
+	ofxGstSimdLevel simdLevel;
+};
+
+#endif /* OFXGSTDEPTH16PACKER_H_ */
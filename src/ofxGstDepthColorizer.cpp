@@ -0,0 +1,216 @@
+/*
+ * ofxGstDepthColorizer.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofxGstDepthColorizer.h"
+#include "ofLog.h"
+#include <algorithm>
+
+static const int INVERSE_SHIFT = 8 - ofxGstDepthColorizer::INVERSE_BITS;
+
+static inline uint32_t inverseIndex(uint32_t r, uint32_t g, uint32_t b){
+	return ((r >> INVERSE_SHIFT) << (2*ofxGstDepthColorizer::INVERSE_BITS))
+			| ((g >> INVERSE_SHIFT) << ofxGstDepthColorizer::INVERSE_BITS)
+			| (b >> INVERSE_SHIFT);
+}
+
+static void toColored(const uint16_t * depth, unsigned char * rgb, size_t i, size_t n, const uint32_t * colors){
+	for(;i<n;i++){
+		uint32_t color = colors[depth[i]];
+		rgb[i*3] = color;
+		rgb[i*3+1] = color >> 8;
+		rgb[i*3+2] = color >> 16;
+	}
+}
+
+static void toDepth(const unsigned char * rgb, uint16_t * depth, size_t i, size_t n, const uint16_t * depths){
+	for(;i<n;i++){
+		depth[i] = depths[inverseIndex(rgb[i*3],rgb[i*3+1],rgb[i*3+2])];
+	}
+}
+
+#if OFX_GST_X86_SIMD
+
+// every iteration of the AVX2 kernels loads or stores 16 bytes at the
+// position of the 5th pixel so they stop when there's less than 10 pixels
+// left to not touch memory after the end of the RGB pixels
+static const size_t AVX2_RGB_MARGIN = 10;
+
+OFX_GST_TARGET_AVX2
+static void toColoredAVX2(const uint16_t * depth, unsigned char * rgb, size_t n, const uint32_t * colors){
+	// packs the 3 first bytes of every color at the beginning of each lane
+	const __m256i pack = _mm256_setr_epi8(
+			0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1,
+			0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1);
+	size_t i = 0;
+	for(;i+AVX2_RGB_MARGIN<=n;i+=8){
+		__m256i index = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(depth+i)));
+		__m256i color = _mm256_shuffle_epi8(_mm256_i32gather_epi32((const int*)colors,index,4),pack);
+		_mm_storeu_si128((__m128i*)(rgb+i*3),_mm256_castsi256_si128(color));
+		_mm_storeu_si128((__m128i*)(rgb+i*3+12),_mm256_extracti128_si256(color,1));
+	}
+	toColored(depth,rgb,i,n,colors);
+}
+
+OFX_GST_TARGET_AVX2
+static void toDepthAVX2(const unsigned char * rgb, uint16_t * depth, size_t n, const uint16_t * depths){
+	// separate each component of the 4 pixels in each lane as 32bits
+	const __m256i rMask = _mm256_setr_epi8(
+			0,-1,-1,-1,3,-1,-1,-1,6,-1,-1,-1,9,-1,-1,-1,
+			0,-1,-1,-1,3,-1,-1,-1,6,-1,-1,-1,9,-1,-1,-1);
+	const __m256i gMask = _mm256_setr_epi8(
+			1,-1,-1,-1,4,-1,-1,-1,7,-1,-1,-1,10,-1,-1,-1,
+			1,-1,-1,-1,4,-1,-1,-1,7,-1,-1,-1,10,-1,-1,-1);
+	const __m256i bMask = _mm256_setr_epi8(
+			2,-1,-1,-1,5,-1,-1,-1,8,-1,-1,-1,11,-1,-1,-1,
+			2,-1,-1,-1,5,-1,-1,-1,8,-1,-1,-1,11,-1,-1,-1);
+	const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+	size_t i = 0;
+	for(;i+AVX2_RGB_MARGIN<=n;i+=8){
+		__m256i pixels = _mm256_inserti128_si256(
+				_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(rgb+i*3))),
+				_mm_loadu_si128((const __m128i*)(rgb+i*3+12)),1);
+		__m256i r = _mm256_srli_epi32(_mm256_shuffle_epi8(pixels,rMask),INVERSE_SHIFT);
+		__m256i g = _mm256_srli_epi32(_mm256_shuffle_epi8(pixels,gMask),INVERSE_SHIFT);
+		__m256i b = _mm256_srli_epi32(_mm256_shuffle_epi8(pixels,bMask),INVERSE_SHIFT);
+		__m256i index = _mm256_or_si256(
+				_mm256_or_si256(_mm256_slli_epi32(r,2*ofxGstDepthColorizer::INVERSE_BITS),_mm256_slli_epi32(g,ofxGstDepthColorizer::INVERSE_BITS)),
+				b);
+
+		// the gather reads 32bits so the depth is in the lower half
+		__m256i d = _mm256_and_si256(_mm256_i32gather_epi32((const int*)depths,index,2),low16);
+		d = _mm256_permute4x64_epi64(_mm256_packus_epi32(d,d),_MM_SHUFFLE(3,1,2,0));
+		_mm_storeu_si128((__m128i*)(depth+i),_mm256_castsi256_si128(d));
+	}
+	toDepth(rgb,depth,i,n,depths);
+}
+
+#endif
+
+ofxGstDepthColorizer::ofxGstDepthColorizer()
+:maxDepth(0)
+,simdLevel(ofxGstGetSimdLevel()){
+
+}
+
+void ofxGstDepthColorizer::setup(int maxDepth){
+	this->maxDepth = ofClamp(maxDepth,1,65536);
+
+	// same gradient as the old ofxGstRTPUtils::CreateColorGradientLUT
+	colors.resize(65536);
+	ofFloatColor floatColor;
+	for(int i=0;i<this->maxDepth;i++){
+		double p = i/double(this->maxDepth);
+		floatColor.setHsb(p,1-p,1-p);
+		ofColor color = floatColor;
+		colors[i] = color.g | (color.r << 8) | (color.b << 16);
+	}
+	std::fill(colors.begin()+this->maxDepth,colors.end(),colors[this->maxDepth-1]);
+
+	// the inverse of each cell crossed by the gradient is the average of
+	// the depths whose color falls in it. Colors out of the gradient, which
+	// appear after lossy compression, use the average of the depths given by
+	// each of hue, saturation and brightness of the center of the cell
+	int cells = 1 << INVERSE_BITS;
+	int halfCell = 1 << INVERSE_SHIFT >> 1;
+	vector<uint32_t> sums(cells*cells*cells,0);
+	vector<uint32_t> counts(cells*cells*cells,0);
+	for(int i=0;i<this->maxDepth;i++){
+		uint32_t index = inverseIndex(colors[i] & 0xFF, (colors[i] >> 8) & 0xFF, (colors[i] >> 16) & 0xFF);
+		sums[index] += i;
+		counts[index]++;
+	}
+	depths.resize(cells*cells*cells+1);
+	for(int r=0;r<cells;r++){
+		for(int g=0;g<cells;g++){
+			for(int b=0;b<cells;b++){
+				ofColor color((r << INVERSE_SHIFT) + halfCell, (g << INVERSE_SHIFT) + halfCell, (b << INVERSE_SHIFT) + halfCell);
+				uint32_t index = inverseIndex(color.r,color.g,color.b);
+				if(counts[index]){
+					depths[index] = sums[index] / counts[index];
+				}else{
+					ofFloatColor floatColor = color;
+					swap(floatColor.r,floatColor.g);
+					float h,s,v;
+					floatColor.getHsb(h,s,v);
+					double depth = (h + (1-v) + (1-s)) * this->maxDepth / 3.;
+					depths[index] = ofClamp(depth,0,this->maxDepth-1);
+				}
+			}
+		}
+	}
+	depths.back() = 0;
+}
+
+bool ofxGstDepthColorizer::isSetup() const{
+	return maxDepth>0;
+}
+
+int ofxGstDepthColorizer::getMaxDepth() const{
+	return maxDepth;
+}
+
+ofColor ofxGstDepthColorizer::getColor(unsigned short depth) const{
+	uint32_t color = colors[depth];
+	return ofColor(color & 0xFF, (color >> 8) & 0xFF, (color >> 16) & 0xFF);
+}
+
+unsigned short ofxGstDepthColorizer::getDepth(const ofColor & color) const{
+	return depths[inverseIndex(color.r,color.g,color.b)];
+}
+
+void ofxGstDepthColorizer::convertToColored(const ofShortPixels & depth, ofPixels & colored) const{
+	if(!isSetup()){
+		ofLogError("ofxGstDepthColorizer") << "trying to convert depth before calling setup";
+		return;
+	}
+	if(colored.getWidth()!=depth.getWidth() || colored.getHeight()!=depth.getHeight() || colored.getNumChannels()!=3){
+		colored.allocate(depth.getWidth(),depth.getHeight(),OF_PIXELS_RGB);
+	}
+	size_t n = depth.getWidth() * depth.getHeight();
+	switch(simdLevel){
+#if OFX_GST_X86_SIMD
+	case OFX_GST_SIMD_AVX2:
+		toColoredAVX2(depth.getPixels(),colored.getPixels(),n,&colors[0]);
+		break;
+#endif
+	default:
+		toColored(depth.getPixels(),colored.getPixels(),0,n,&colors[0]);
+		break;
+	}
+}
+
+void ofxGstDepthColorizer::convertToDepth(const ofPixels & colored, ofShortPixels & depth) const{
+	if(!isSetup()){
+		ofLogError("ofxGstDepthColorizer") << "trying to convert depth before calling setup";
+		return;
+	}
+	if(colored.getNumChannels()!=3){
+		ofLogError("ofxGstDepthColorizer") << "trying to convert colored depth with " << colored.getNumChannels() << " channels, only RGB is supported";
+		return;
+	}
+	if(depth.getWidth()!=colored.getWidth() || depth.getHeight()!=colored.getHeight() || depth.getNumChannels()!=1){
+		depth.allocate(colored.getWidth(),colored.getHeight(),1);
+	}
+	size_t n = colored.getWidth() * colored.getHeight();
+	switch(simdLevel){
+#if OFX_GST_X86_SIMD
+	case OFX_GST_SIMD_AVX2:
+		toDepthAVX2(colored.getPixels(),depth.getPixels(),n,&depths[0]);
+		break;
+#endif
+	default:
+		toDepth(colored.getPixels(),depth.getPixels(),0,n,&depths[0]);
+		break;
+	}
+}
+
+void ofxGstDepthColorizer::setSimdLevel(ofxGstSimdLevel level){
+	simdLevel = std::min(level,ofxGstGetSimdLevel());
+}
+
+ofxGstSimdLevel ofxGstDepthColorizer::getSimdLevel() const{
+	return simdLevel;
+}
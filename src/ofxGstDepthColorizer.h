@@ -0,0 +1,69 @@
+/*
+ * ofxGstDepthColorizer.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTDEPTHCOLORIZER_H_
+#define OFXGSTDEPTHCOLORIZER_H_
+
+#include "ofColor.h"
+#include "ofPixels.h"
+#include "ofxGstSimd.h"
+#include <stdint.h>
+
+/// converts 16bits depth to RGB and back so depth can be sent through a
+/// video channel. Each depth is mapped to a color of a gradient where hue
+/// grows and saturation and brightness decrease with the depth, so the
+/// depth can still be recovered after lossy compression.
+///
+/// The colors are precomputed for every possible depth in setup and the
+/// inverse uses a table indexed by the most significant bits of each
+/// component, so both directions are a lookup per pixel and whole frames
+/// are converted with AVX2 gathers when the cpu supports it.
+///
+/// After setup the tables are never modified so one colorizer can be used
+/// from several threads at the same time
+class ofxGstDepthColorizer{
+public:
+	ofxGstDepthColorizer();
+
+	/// builds the tables for depths in [0, maxDepth), bigger depths get the
+	/// color of maxDepth-1. Building them takes some milliseconds so it's
+	/// better done once and not per frame
+	void setup(int maxDepth);
+	bool isSetup() const;
+	int getMaxDepth() const;
+
+	ofColor getColor(unsigned short depth) const;
+	unsigned short getDepth(const ofColor & color) const;
+
+	/// converts a whole frame, colored is allocated as RGB if it doesn't
+	/// have the size of depth
+	void convertToColored(const ofShortPixels & depth, ofPixels & colored) const;
+
+	/// converts a whole RGB frame, depth is allocated if it doesn't have
+	/// the size of colored
+	void convertToDepth(const ofPixels & colored, ofShortPixels & depth) const;
+
+	/// forces a specific instruction set, by default the best one available
+	/// is used. Mostly useful for benchmarking
+	void setSimdLevel(ofxGstSimdLevel level);
+	ofxGstSimdLevel getSimdLevel() const;
+
+	/// bits of each color component used to index the inverse table
+	static const int INVERSE_BITS = 6;
+
+private:
+	int maxDepth;
+	ofxGstSimdLevel simdLevel;
+
+	/// RGB packed as r | g<<8 | b<<16 for every 16bits depth
+	vector<uint32_t> colors;
+
+	/// depth for every color indexed as r<<2*INVERSE_BITS | g<<INVERSE_BITS | b
+	/// with one more entry so it can be read with 32bits gathers
+	vector<uint16_t> depths;
+};
+
+#endif /* OFXGSTDEPTHCOLORIZER_H_ */
@@ -0,0 +1,66 @@
+/*
+ * ofxGstLockFreeFreeList.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTLOCKFREEFREELIST_H_
+#define OFXGSTLOCKFREEFREELIST_H_
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+
+/// fixed capacity lock free stack of indices used internally by the pools
+/// to recycle preallocated objects from any thread without locking or
+/// allocating memory. The head is tagged with a counter that is incremented
+/// on every change to avoid the ABA problem
+class ofxGstLockFreeFreeList{
+public:
+	ofxGstLockFreeFreeList()
+	:head(0){}
+
+	/// creates the list with indices [0, capacity) all free, shouldn't be
+	/// called while other threads are using the list
+	void setup(int capacity){
+		next = std::vector<std::atomic<int> >(capacity);
+		head = 0;
+		for(int i=capacity-1;i>=0;i--){
+			push(i);
+		}
+	}
+
+	/// returns a free index or -1 if there's none
+	int pop(){
+		uint64_t oldHead = head.load();
+		while(true){
+			int index = int(oldHead & 0xFFFFFFFF) - 1;
+			if(index<0) return -1;
+			int nextIndex = next[index].load(std::memory_order_relaxed);
+			uint64_t newHead = (((oldHead >> 32) + 1) << 32) | uint32_t(nextIndex + 1);
+			if(head.compare_exchange_weak(oldHead,newHead)){
+				return index;
+			}
+		}
+	}
+
+	/// returns an index obtained through pop to the list
+	void push(int index){
+		uint64_t oldHead = head.load();
+		uint64_t newHead;
+		do{
+			next[index].store(int(oldHead & 0xFFFFFFFF) - 1, std::memory_order_relaxed);
+			newHead = (((oldHead >> 32) + 1) << 32) | uint32_t(index + 1);
+		}while(!head.compare_exchange_weak(oldHead,newHead));
+	}
+
+	int capacity() const{
+		return next.size();
+	}
+
+private:
+	std::atomic<uint64_t> head;
+	std::vector<std::atomic<int> > next;
+};
+
+#endif /* OFXGSTLOCKFREEFREELIST_H_ */
@@ -0,0 +1,140 @@
+/*
+ * ofxGstLossyRelay.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "ofxGstLossyRelay.h"
+#include "ofLog.h"
+#include "ofUtils.h"
+
+static const string LOG_NAME = "ofxGstLossyRelay";
+
+const double ofxGstLossyRelay::BURST_SECONDS = 0.1;
+
+ofxGstLossyRelay::ofxGstLossyRelay()
+:pipeline(NULL)
+,capacity(0)
+,tokens(0)
+,lastRefill(0)
+,bytesSent(0)
+,bytesRelayed(0){
+	resetCounters();
+}
+
+ofxGstLossyRelay::~ofxGstLossyRelay(){
+	close();
+}
+
+bool ofxGstLossyRelay::setup(int serverPort, int clientPort, float loss){
+	close();
+
+	string host = " ! udpsink host=127.0.0.1 sync=false async=false port=";
+	string pipelineStr =
+			"udpsrc port=" + ofToString(serverPort) + " ! identity name=drop drop-probability=" + ofToString(loss)
+				+ " ! udpsink name=rtpsink host=127.0.0.1 sync=false async=false port=" + ofToString(clientPort) + " " +
+			"udpsrc port=" + ofToString(serverPort+1) + host + ofToString(clientPort+1) + " " +
+			"udpsrc port=" + ofToString(clientPort+3) + host + ofToString(serverPort+3);
+	GError * error = NULL;
+	pipeline = gst_parse_launch(pipelineStr.c_str(),&error);
+	if(error){
+		ofLogError(LOG_NAME) << "couldn't create relay: " << error->message;
+		g_error_free(error);
+		if(pipeline){
+			gst_object_unref(pipeline);
+			pipeline = NULL;
+		}
+		return false;
+	}
+
+	// the bytes sent are counted and policed before the random drop, the
+	// ones relayed after both
+	GstElement * identity = gst_bin_get_by_name(GST_BIN(pipeline),"drop");
+	GstPad * pad = gst_element_get_static_pad(identity,"sink");
+	gst_pad_add_probe(pad,GST_PAD_PROBE_TYPE_BUFFER,(GstPadProbeCallback)&ofxGstLossyRelay::on_sent_buffer,this,NULL);
+	gst_object_unref(pad);
+	gst_object_unref(identity);
+
+	GstElement * rtpsink = gst_bin_get_by_name(GST_BIN(pipeline),"rtpsink");
+	pad = gst_element_get_static_pad(rtpsink,"sink");
+	gst_pad_add_probe(pad,GST_PAD_PROBE_TYPE_BUFFER,(GstPadProbeCallback)&ofxGstLossyRelay::on_relayed_buffer,this,NULL);
+	gst_object_unref(pad);
+	gst_object_unref(rtpsink);
+
+	tokens = 0;
+	lastRefill = g_get_monotonic_time();
+	resetCounters();
+	gst_element_set_state(pipeline,GST_STATE_PLAYING);
+	return true;
+}
+
+void ofxGstLossyRelay::close(){
+	if(!pipeline) return;
+	gst_element_set_state(pipeline,GST_STATE_NULL);
+	gst_object_unref(pipeline);
+	pipeline = NULL;
+}
+
+bool ofxGstLossyRelay::isSetup() const{
+	return pipeline;
+}
+
+void ofxGstLossyRelay::setCapacity(int kbps){
+	capacity = kbps;
+}
+
+int ofxGstLossyRelay::getCapacity() const{
+	return capacity;
+}
+
+uint64_t ofxGstLossyRelay::getBytesSent() const{
+	return bytesSent;
+}
+
+uint64_t ofxGstLossyRelay::getBytesSent(int payloadType) const{
+	if(payloadType<0 || payloadType>=128) return 0;
+	return bytesSentPerPayload[payloadType];
+}
+
+uint64_t ofxGstLossyRelay::getBytesRelayed() const{
+	return bytesRelayed;
+}
+
+void ofxGstLossyRelay::resetCounters(){
+	bytesSent = 0;
+	bytesRelayed = 0;
+	for(size_t i=0;i<128;i++){
+		bytesSentPerPayload[i] = 0;
+	}
+}
+
+GstPadProbeReturn ofxGstLossyRelay::on_sent_buffer(GstPad * pad, GstPadProbeInfo * info, ofxGstLossyRelay * relay){
+	GstBuffer * buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+	gsize size = gst_buffer_get_size(buffer);
+	relay->bytesSent += size;
+
+	// payload type is in the lower 7 bits of the second byte of the rtp header
+	guint8 header[2];
+	if(gst_buffer_extract(buffer,0,header,2)==2){
+		relay->bytesSentPerPayload[header[1] & 0x7f] += size;
+	}
+
+	int kbps = relay->capacity;
+	if(kbps<=0){
+		return GST_PAD_PROBE_OK;
+	}
+	gint64 now = g_get_monotonic_time();
+	double bytesPerSecond = kbps * 1000. / 8.;
+	relay->tokens = std::min(relay->tokens + bytesPerSecond * (now - relay->lastRefill) / 1000000., bytesPerSecond * BURST_SECONDS);
+	relay->lastRefill = now;
+	if(relay->tokens < size){
+		return GST_PAD_PROBE_DROP;
+	}
+	relay->tokens -= size;
+	return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn ofxGstLossyRelay::on_relayed_buffer(GstPad * pad, GstPadProbeInfo * info, ofxGstLossyRelay * relay){
+	relay->bytesRelayed += gst_buffer_get_size(GST_PAD_PROBE_INFO_BUFFER(info));
+	return GST_PAD_PROBE_OK;
+}
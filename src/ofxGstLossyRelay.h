@@ -0,0 +1,70 @@
+/*
+ * ofxGstLossyRelay.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef OFXGSTLOSSYRELAY_H_
+#define OFXGSTLOSSYRELAY_H_
+
+#include <gst/gst.h>
+#include <atomic>
+#include <stdint.h>
+
+/// simulates a lossy link between a server and a client in the same
+/// machine to test and benchmark them. The server sends to serverPort and
+/// the client receives in clientPort. The rtp packets are dropped randomly
+/// with the loss probability and optionally policed to a capacity like the
+/// bottleneck of a real link. The rtcp packets of both sides go through
+/// untouched so the receiver reports, NACKs and keyframe requests always
+/// arrive. The ports follow the layout of ofxGstRTPServer and
+/// ofxGstRTPClient: rtcp from the server in port+1 and from the client in
+/// port+3
+class ofxGstLossyRelay{
+public:
+	ofxGstLossyRelay();
+	~ofxGstLossyRelay();
+
+	bool setup(int serverPort, int clientPort, float loss);
+	void close();
+	bool isSetup() const;
+
+	/// capacity of the link in kbps, 0 by default which disables the
+	/// policer. It lets through bursts of BURST_SECONDS at the capacity and
+	/// drops anything over it as a full router queue would. Can be changed
+	/// while the relay is running
+	void setCapacity(int kbps);
+	int getCapacity() const;
+
+	/// rtp bytes sent by the server, counted before any packet is dropped
+	uint64_t getBytesSent() const;
+
+	/// rtp bytes sent by the server with a payload type, counted before any
+	/// packet is dropped
+	uint64_t getBytesSent(int payloadType) const;
+
+	/// rtp bytes that reached the client
+	uint64_t getBytesRelayed() const;
+
+	/// puts all the counters back to 0
+	void resetCounters();
+
+	static const double BURST_SECONDS;
+
+private:
+	static GstPadProbeReturn on_sent_buffer(GstPad * pad, GstPadProbeInfo * info, ofxGstLossyRelay * relay);
+	static GstPadProbeReturn on_relayed_buffer(GstPad * pad, GstPadProbeInfo * info, ofxGstLossyRelay * relay);
+
+	GstElement * pipeline;
+
+	// the token bucket is only touched from the streaming thread of the
+	// relay except the capacity
+	std::atomic<int> capacity;
+	double tokens;
+	gint64 lastRefill;
+
+	std::atomic<uint64_t> bytesSent, bytesRelayed;
+	std::atomic<uint64_t> bytesSentPerPayload[128];
+};
+
+#endif /* OFXGSTLOSSYRELAY_H_ */
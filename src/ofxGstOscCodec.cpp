@@ -0,0 +1,126 @@
+/*
+ * ofxGstOscCodec.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "ofxGstOscCodec.h"
+#include "snappy.h"
+#include <cstring>
+
+const float ofxGstOscEncoder::MAX_RATIO = 0.9;
+
+ofxGstOscEncoder::ofxGstOscEncoder()
+:compression(OFX_GST_OSC_COMPRESSION_ADAPTIVE)
+,minBytes(DEFAULT_MIN_BYTES)
+,ratio(0)
+,packetsSinceProbe(0)
+,packetsRaw(0)
+,packetsCompressed(0)
+,bytesIn(0)
+,bytesOut(0){
+
+}
+
+void ofxGstOscEncoder::setup(ofxGstOscCompression compression, size_t minBytes){
+	this->compression = compression;
+	this->minBytes = minBytes;
+	ratio = 0;
+	packetsSinceProbe = 0;
+}
+
+ofxGstOscCompression ofxGstOscEncoder::getCompression() const{
+	return compression;
+}
+
+size_t ofxGstOscEncoder::getMaxEncodedSize(size_t size){
+	// snappy's worst case is always bigger than the raw packet
+	return 1 + snappy::MaxCompressedLength(size);
+}
+
+size_t ofxGstOscEncoder::encode(const char * data, size_t size, char * dst){
+	bool compress;
+	switch(compression){
+	case OFX_GST_OSC_COMPRESSION_NONE:
+		compress = false;
+		break;
+	case OFX_GST_OSC_COMPRESSION_SNAPPY:
+		compress = true;
+		break;
+	case OFX_GST_OSC_COMPRESSION_ADAPTIVE:
+	default:
+		compress = size>=minBytes && (ratio<=MAX_RATIO || packetsSinceProbe>=PROBE_INTERVAL);
+		if(size>=minBytes && !compress){
+			packetsSinceProbe++;
+		}
+		break;
+	}
+
+	bytesIn += size;
+	if(compress){
+		size_t compressedSize;
+		snappy::RawCompress(data,size,dst+1,&compressedSize);
+		if(compression==OFX_GST_OSC_COMPRESSION_ADAPTIVE){
+			ratio = ratio*0.75 + float(compressedSize)/size*0.25;
+			packetsSinceProbe = 0;
+		}
+		if(compressedSize<size || compression==OFX_GST_OSC_COMPRESSION_SNAPPY){
+			dst[0] = OFX_GST_OSC_ENCODING_SNAPPY;
+			packetsCompressed++;
+			bytesOut += compressedSize + 1;
+			return compressedSize + 1;
+		}
+	}
+
+	dst[0] = OFX_GST_OSC_ENCODING_RAW;
+	memcpy(dst+1,data,size);
+	packetsRaw++;
+	bytesOut += size + 1;
+	return size + 1;
+}
+
+uint64_t ofxGstOscEncoder::getPacketsRaw() const{
+	return packetsRaw;
+}
+
+uint64_t ofxGstOscEncoder::getPacketsCompressed() const{
+	return packetsCompressed;
+}
+
+uint64_t ofxGstOscEncoder::getBytesIn() const{
+	return bytesIn;
+}
+
+uint64_t ofxGstOscEncoder::getBytesOut() const{
+	return bytesOut;
+}
+
+bool ofxGstOscDecoder::getDecodedSize(const char * data, size_t size, size_t & decodedSize){
+	if(size==0){
+		return false;
+	}
+	switch(data[0]){
+	case OFX_GST_OSC_ENCODING_RAW:
+		decodedSize = size - 1;
+		return true;
+	case OFX_GST_OSC_ENCODING_SNAPPY:
+		return snappy::GetUncompressedLength(data+1,size-1,&decodedSize);
+	default:
+		return false;
+	}
+}
+
+bool ofxGstOscDecoder::decode(const char * data, size_t size, char * dst){
+	if(size==0){
+		return false;
+	}
+	switch(data[0]){
+	case OFX_GST_OSC_ENCODING_RAW:
+		memcpy(dst,data+1,size-1);
+		return true;
+	case OFX_GST_OSC_ENCODING_SNAPPY:
+		return snappy::RawUncompress(data+1,size-1,dst);
+	default:
+		return false;
+	}
+}
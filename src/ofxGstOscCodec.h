@@ -0,0 +1,82 @@
+/*
+ * ofxGstOscCodec.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef OFXGSTOSCCODEC_H_
+#define OFXGSTOSCCODEC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// how the osc channels compress their packets
+enum ofxGstOscCompression{
+	/// packets are sent as they are
+	OFX_GST_OSC_COMPRESSION_NONE,
+	/// every packet is compressed with snappy
+	OFX_GST_OSC_COMPRESSION_SNAPPY,
+	/// packets are compressed only when it's worth it, see ofxGstOscEncoder
+	OFX_GST_OSC_COMPRESSION_ADAPTIVE,
+};
+
+/// first byte of every osc packet on the wire, says how the rest
+/// of the packet is encoded
+enum ofxGstOscEncoding{
+	OFX_GST_OSC_ENCODING_RAW = 0,
+	OFX_GST_OSC_ENCODING_SNAPPY = 1,
+};
+
+/// encodes osc packets for an osc channel. In adaptive mode packets
+/// smaller than minBytes, where snappy's framing usually makes the result
+/// bigger, are sent raw and the rest are compressed only if the result is
+/// smaller. The ratio of the last compressed packets is tracked and while
+/// it's above MAX_RATIO, as with messages made mostly of floats, compression
+/// is skipped except for one packet every PROBE_INTERVAL to notice when the
+/// content changes. Not thread safe, each channel has its own
+class ofxGstOscEncoder{
+public:
+	ofxGstOscEncoder();
+
+	void setup(ofxGstOscCompression compression=OFX_GST_OSC_COMPRESSION_ADAPTIVE, size_t minBytes=DEFAULT_MIN_BYTES);
+	ofxGstOscCompression getCompression() const;
+
+	/// size of the biggest result of encoding size bytes, the memory
+	/// passed to encode needs to be at least this big
+	static size_t getMaxEncodedSize(size_t size);
+
+	/// encodes an osc packet into dst and returns the bytes written
+	size_t encode(const char * data, size_t size, char * dst);
+
+	/// packets sent raw and compressed and bytes before and after encoding
+	uint64_t getPacketsRaw() const;
+	uint64_t getPacketsCompressed() const;
+	uint64_t getBytesIn() const;
+	uint64_t getBytesOut() const;
+
+	static const size_t DEFAULT_MIN_BYTES = 64;
+	static const int PROBE_INTERVAL = 32;
+	static const float MAX_RATIO;
+
+private:
+	ofxGstOscCompression compression;
+	size_t minBytes;
+	float ratio;
+	int packetsSinceProbe;
+	uint64_t packetsRaw, packetsCompressed;
+	uint64_t bytesIn, bytesOut;
+};
+
+/// decodes the packets produced by ofxGstOscEncoder
+class ofxGstOscDecoder{
+public:
+	/// size of the packet once decoded or false if the encoding is unknown
+	/// or the data is corrupted
+	static bool getDecodedSize(const char * data, size_t size, size_t & decodedSize);
+
+	/// decodes into dst which needs to be at least getDecodedSize bytes,
+	/// returns false if the data is corrupted
+	static bool decode(const char * data, size_t size, char * dst);
+};
+
+#endif /* OFXGSTOSCCODEC_H_ */
@@ -6,64 +6,127 @@
  */
 
 #include "ofxGstOscDoubleBuffer.h"
-#include "snappy.h"
+#include "ofLog.h"
+#include "ofxGstOscCodec.h"
+#include <gst/gst.h>
+#include <algorithm>
 
 ofxGstOscDoubleBuffer::ofxGstOscDoubleBuffer()
-:frontSample(NULL)
-,backSample(NULL)
-,packet(NULL)
-,mapinfo()
-,bIsNewFrame(false)
-,uncompressed(new char[65535])
+:bIsNewFrame(false)
+,decompressed(false)
+,packetsReceived(0)
+,packetsDropped(0)
 {
-	GstMapInfo mapinfo = {0,};
-	this->mapinfo=mapinfo;
-
+	setup();
 }
 
 ofxGstOscDoubleBuffer::~ofxGstOscDoubleBuffer() {
-	// TODO Auto-generated destructor stub
+	releaseFrontSamples();
+	GstSample * sample;
+	while(queue.pop(sample)){
+		gst_sample_unref(sample);
+	}
 }
 
+void ofxGstOscDoubleBuffer::setup(int capacity){
+	GstSample * sample;
+	while(queue.pop(sample)){
+		gst_sample_unref(sample);
+	}
+	queue.setup(std::max(capacity,1));
+	frontSamples.reserve(queue.capacity());
+}
 
 bool ofxGstOscDoubleBuffer::isFrameNew(){
 	return bIsNewFrame;
 }
 
 void ofxGstOscDoubleBuffer::newSample(GstSample * sample){
-	mutex.lock();
-	if(backSample) gst_sample_unref(backSample);
-	backSample = sample;
-	mutex.unlock();
+	packetsReceived++;
+	if(!queue.push(sample)){
+		gst_sample_unref(sample);
+		packetsDropped++;
+	}
+}
 
+void ofxGstOscDoubleBuffer::releaseFrontSamples(){
+	for(size_t i=0;i<frontSamples.size();i++){
+		gst_sample_unref(frontSamples[i]);
+	}
+	frontSamples.clear();
 }
 
 void ofxGstOscDoubleBuffer::update(){
-	mutex.lock();
-	if(frontSample!=backSample){
-		if(frontSample) gst_sample_unref(frontSample);
-		frontSample = backSample;
-		gst_sample_ref(frontSample);
-		bIsNewFrame = true;
-		mutex.unlock();
+	releaseFrontSamples();
+	GstSample * sample;
+	while(queue.pop(sample)){
+		frontSamples.push_back(sample);
+	}
+	bIsNewFrame = !frontSamples.empty();
+	decompressed = false;
+}
 
-		GstBuffer * _buffer = gst_sample_get_buffer(frontSample);
-		gst_buffer_map (_buffer, &mapinfo, GST_MAP_READ);
+void ofxGstOscDoubleBuffer::decompress(){
+	decompressed = true;
+	packetOffsets.clear();
+	packetSizes.clear();
 
-		size_t uncompressedSize;
-		snappy::RawUncompress((const char*)mapinfo.data,mapinfo.size,uncompressed);
-		snappy::GetUncompressedLength((const char*)mapinfo.data,mapinfo.size,&uncompressedSize);
+	// the size of every packet is known before decoding so all of them
+	// fit in the same buffer, which only grows. Raw packets are copied too
+	// so every packet stays valid until the next update
+	GstMapInfo mapinfo = {0,};
+	size_t total = 0;
+	for(size_t i=0;i<frontSamples.size();i++){
+		GstBuffer * buffer = gst_sample_get_buffer(frontSamples[i]);
+		size_t size = 0;
+		if(buffer && gst_buffer_map(buffer,&mapinfo,GST_MAP_READ)){
+			if(!ofxGstOscDecoder::getDecodedSize((const char*)mapinfo.data,mapinfo.size,size) || size>MAX_PACKET_SIZE){
+				ofLogError("ofxGstOscDoubleBuffer") << "received corrupted osc packet";
+				size = 0;
+			}
+			gst_buffer_unmap(buffer,&mapinfo);
+		}
+		packetOffsets.push_back(total);
+		packetSizes.push_back(size);
+		total += size;
+	}
+	if(uncompressed.size()<total){
+		uncompressed.resize(total);
+	}
+
+	for(size_t i=0;i<frontSamples.size();i++){
+		if(packetSizes[i]==0) continue;
+		GstBuffer * buffer = gst_sample_get_buffer(frontSamples[i]);
+		if(gst_buffer_map(buffer,&mapinfo,GST_MAP_READ)){
+			if(!ofxGstOscDecoder::decode((const char*)mapinfo.data,mapinfo.size,&uncompressed[packetOffsets[i]])){
+				ofLogError("ofxGstOscDoubleBuffer") << "received corrupted osc packet";
+				packetSizes[i] = 0;
+			}
+			gst_buffer_unmap(buffer,&mapinfo);
+		}
+	}
+}
 
-		if(packet) delete packet;
-		packet = new osc::ReceivedPacket(uncompressed, uncompressedSize);
+size_t ofxGstOscDoubleBuffer::getNumPackets(){
+	return frontSamples.size();
+}
 
-		gst_buffer_unmap(_buffer,&mapinfo);
-	}else{
-		bIsNewFrame = false;
-		mutex.unlock();
+bool ofxGstOscDoubleBuffer::getPacket(size_t packet, const char * & data, size_t & size){
+	if(!decompressed){
+		decompress();
+	}
+	if(packet>=packetSizes.size() || packetSizes[packet]==0){
+		return false;
 	}
+	data = &uncompressed[packetOffsets[packet]];
+	size = packetSizes[packet];
+	return true;
+}
+
+uint64_t ofxGstOscDoubleBuffer::getPacketsReceived() const{
+	return packetsReceived;
 }
 
-osc::ReceivedPacket * ofxGstOscDoubleBuffer::getOscReceivedPacket(){
-	return packet;
+uint64_t ofxGstOscDoubleBuffer::getPacketsDropped() const{
+	return packetsDropped;
 }
@@ -10,28 +10,62 @@
 
 
 #include <gst/gstsample.h>
-#include "OscReceivedElements.h"
 #include "ofTypes.h"
+#include "ofxGstSPSCQueue.h"
+#include <atomic>
+#include <stdint.h>
 
-/// class used internally by the addon to implement a
-/// double buffer for received osc messages
+/// class used internally by the addon to pass the received osc packets
+/// to the application. Every sample from the streaming thread goes through
+/// a lock free queue and update takes all the ones received since the
+/// previous update so no packet is lost as long as the queue doesn't fill.
+/// The packets are decoded the first time they are requested after
+/// each update so it costs nothing if the application never reads them
 class ofxGstOscDoubleBuffer {
 public:
 	ofxGstOscDoubleBuffer();
 	virtual ~ofxGstOscDoubleBuffer();
 
+	/// packets that can wait for update, shouldn't be called once the
+	/// samples are arriving
+	void setup(int capacity=DEFAULT_CAPACITY);
+
 	bool isFrameNew();
 	void newSample(GstSample * sample);
 	void update();
-	osc::ReceivedPacket * getOscReceivedPacket();
+
+	/// packets received before the last update, getPacket returns false if
+	/// the packet couldn't be decompressed. The data is valid until the
+	/// next update
+	size_t getNumPackets();
+	bool getPacket(size_t packet, const char * & data, size_t & size);
+
+	/// packets received and dropped because the queue was full, can be
+	/// called from any thread
+	uint64_t getPacketsReceived() const;
+	uint64_t getPacketsDropped() const;
+
+	static const int DEFAULT_CAPACITY = 1024;
+
+	/// bigger packets are discarded without decompressing them
+	static const size_t MAX_PACKET_SIZE = 65536;
 
 private:
-	GstSample * frontSample, * backSample;
-	osc::ReceivedPacket * packet;
-	ofMutex mutex;
-	GstMapInfo mapinfo;
+	void decompress();
+	void releaseFrontSamples();
+
+	ofxGstSPSCQueue<GstSample*> queue;
+	vector<GstSample*> frontSamples;
 	bool bIsNewFrame;
-	char * uncompressed;
+
+	// all the packets of the frame decompressed one after another
+	vector<char> uncompressed;
+	vector<size_t> packetOffsets;
+	vector<size_t> packetSizes;
+	bool decompressed;
+
+	std::atomic<uint64_t> packetsReceived;
+	std::atomic<uint64_t> packetsDropped;
 };
 
 
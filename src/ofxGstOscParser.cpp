@@ -0,0 +1,271 @@
+/*
+ * ofxGstOscParser.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofxGstOscParser.h"
+#include "ofxOscMessage.h"
+#include "ofLog.h"
+#include <cstring>
+
+// osc is big endian and every element is aligned to 4 bytes
+static inline uint32_t readUInt32(const char * p){
+	const unsigned char * u = (const unsigned char *)p;
+	return (uint32_t(u[0]) << 24) | (uint32_t(u[1]) << 16) | (uint32_t(u[2]) << 8) | uint32_t(u[3]);
+}
+
+static inline uint64_t readUInt64(const char * p){
+	return (uint64_t(readUInt32(p)) << 32) | readUInt32(p+4);
+}
+
+static inline size_t padded(size_t size){
+	return (size + 3) & ~size_t(3);
+}
+
+// size of a string with its terminator and padding or 0 if it doesn't
+// end before the end of the data
+static size_t stringSize(const char * p, size_t available){
+	const char * end = (const char *)memchr(p,0,available);
+	if(!end) return 0;
+	size_t size = padded(end - p + 1);
+	return size<=available ? size : 0;
+}
+
+static const size_t INVALID_ARG = size_t(-1);
+
+static size_t argSize(char typeTag, const char * p, size_t available){
+	size_t size;
+	switch(typeTag){
+	case 'i': case 'f': case 'c': case 'r': case 'm':
+		size = 4;
+		break;
+	case 'h': case 'd': case 't':
+		size = 8;
+		break;
+	case 's': case 'S':
+		size = stringSize(p,available);
+		return size ? size : INVALID_ARG;
+	case 'b':
+		if(available<4) return INVALID_ARG;
+		size = 4 + padded(readUInt32(p));
+		break;
+	case 'T': case 'F': case 'N': case 'I': case '[': case ']':
+		size = 0;
+		break;
+	default:
+		return INVALID_ARG;
+	}
+	return size<=available ? size : INVALID_ARG;
+}
+
+ofxGstOscMessageView::ofxGstOscMessageView()
+:address("")
+,typeTags("")
+,args(NULL)
+,firstArg(0)
+,numArgs(0){
+
+}
+
+const char * ofxGstOscMessageView::getAddress() const{
+	return address;
+}
+
+size_t ofxGstOscMessageView::getNumArgs() const{
+	return numArgs;
+}
+
+char ofxGstOscMessageView::getArgTypeTag(size_t index) const{
+	return index<numArgs ? typeTags[index] : 0;
+}
+
+int32_t ofxGstOscMessageView::getArgAsInt32(size_t index) const{
+	return int32_t(getArgAsInt64(index));
+}
+
+int64_t ofxGstOscMessageView::getArgAsInt64(size_t index) const{
+	if(index>=numArgs) return 0;
+	const char * arg = args[index];
+	switch(typeTags[index]){
+	case 'i':
+	case 'c':
+		return int32_t(readUInt32(arg));
+	case 'h':
+		return int64_t(readUInt64(arg));
+	case 'f':
+	case 'd':
+		return int64_t(getArgAsDouble(index));
+	case 'T':
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+float ofxGstOscMessageView::getArgAsFloat(size_t index) const{
+	return float(getArgAsDouble(index));
+}
+
+double ofxGstOscMessageView::getArgAsDouble(size_t index) const{
+	if(index>=numArgs) return 0;
+	const char * arg = args[index];
+	switch(typeTags[index]){
+	case 'f':{
+		uint32_t bits = readUInt32(arg);
+		float value;
+		memcpy(&value,&bits,sizeof(value));
+		return value;
+	}
+	case 'd':{
+		uint64_t bits = readUInt64(arg);
+		double value;
+		memcpy(&value,&bits,sizeof(value));
+		return value;
+	}
+	case 'i':
+	case 'c':
+	case 'h':
+	case 'T':
+		return double(getArgAsInt64(index));
+	default:
+		return 0;
+	}
+}
+
+bool ofxGstOscMessageView::getArgAsBool(size_t index) const{
+	if(index>=numArgs) return false;
+	switch(typeTags[index]){
+	case 'T':
+		return true;
+	case 'F':
+		return false;
+	default:
+		return getArgAsDouble(index)!=0;
+	}
+}
+
+const char * ofxGstOscMessageView::getArgAsString(size_t index) const{
+	if(index>=numArgs || (typeTags[index]!='s' && typeTags[index]!='S')){
+		return "";
+	}
+	return args[index];
+}
+
+bool ofxGstOscMessageView::getArgAsBlob(size_t index, const char * & data, size_t & size) const{
+	if(index>=numArgs || typeTags[index]!='b'){
+		return false;
+	}
+	size = readUInt32(args[index]);
+	data = args[index] + 4;
+	return true;
+}
+
+void ofxGstOscMessageView::toOfxOscMessage(ofxOscMessage & message) const{
+	message.clear();
+	message.setAddress(address);
+	for(size_t i=0;i<numArgs;i++){
+		switch(typeTags[i]){
+		case 'i':
+			message.addIntArg(getArgAsInt32(i));
+			break;
+		case 'h':
+			message.addInt64Arg(getArgAsInt64(i));
+			break;
+		case 'f':
+			message.addFloatArg(getArgAsFloat(i));
+			break;
+		case 's':
+		case 'S':
+			message.addStringArg(getArgAsString(i));
+			break;
+		default:
+			ofLogError("ofxGstOscParser") << "argument " << i << " in message " << address << " of type " << typeTags[i] << " is not supported by ofxOscMessage";
+			break;
+		}
+	}
+}
+
+void ofxGstOscParser::clear(){
+	messages.clear();
+	args.clear();
+}
+
+bool ofxGstOscParser::parse(const char * data, size_t size){
+	bool ok = parseElement(data,size,0);
+
+	// the arguments vector could have grown while parsing so the
+	// messages point to it once everything is parsed
+	for(size_t i=0;i<messages.size();i++){
+		messages[i].args = args.empty() ? NULL : &args[messages[i].firstArg];
+	}
+	return ok;
+}
+
+const vector<ofxGstOscMessageView> & ofxGstOscParser::getMessages() const{
+	return messages;
+}
+
+bool ofxGstOscParser::parseElement(const char * data, size_t size, int depth){
+	if(size>=8 && memcmp(data,"#bundle",8)==0){
+		if(depth>=MAX_BUNDLE_DEPTH){
+			return false;
+		}
+		return parseBundle(data,size,depth);
+	}
+	return parseMessage(data,size);
+}
+
+bool ofxGstOscParser::parseMessage(const char * data, size_t size){
+	ofxGstOscMessageView message;
+	size_t addressSize = size ? stringSize(data,size) : 0;
+	if(addressSize==0){
+		return false;
+	}
+	message.address = data;
+	message.firstArg = args.size();
+
+	// messages from old implementations can come without type tags
+	size_t pos = addressSize;
+	if(pos<size && data[pos]==','){
+		size_t tagsSize = stringSize(data+pos,size-pos);
+		if(tagsSize==0){
+			return false;
+		}
+		message.typeTags = data + pos + 1;
+		pos += tagsSize;
+		for(const char * tag=message.typeTags;*tag;tag++){
+			size_t arg = argSize(*tag,data+pos,size-pos);
+			if(arg==INVALID_ARG){
+				args.resize(message.firstArg);
+				return false;
+			}
+			args.push_back(data+pos);
+			pos += arg;
+		}
+		message.numArgs = args.size() - message.firstArg;
+	}
+	messages.push_back(message);
+	return true;
+}
+
+bool ofxGstOscParser::parseBundle(const char * data, size_t size, int depth){
+	// "#bundle" and the time tag, the timestamp of the rtp packet is used
+	// instead so it's ignored
+	size_t pos = 16;
+	if(size<pos){
+		return false;
+	}
+	while(pos<size){
+		if(size-pos<4){
+			return false;
+		}
+		size_t elementSize = readUInt32(data+pos);
+		pos += 4;
+		if(elementSize>size-pos || !parseElement(data+pos,elementSize,depth+1)){
+			return false;
+		}
+		pos += elementSize;
+	}
+	return true;
+}
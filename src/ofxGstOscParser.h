@@ -0,0 +1,86 @@
+/*
+ * ofxGstOscParser.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTOSCPARSER_H_
+#define OFXGSTOSCPARSER_H_
+
+#include "ofConstants.h"
+#include <stdint.h>
+
+class ofxOscMessage;
+
+/// a received osc message read in place from the packet it arrived in,
+/// nothing is copied or allocated to read its address or arguments. It's
+/// only valid while the packet it points to is, for the messages returned
+/// by ofxGstRTPClient until the next update.
+///
+/// The arguments are accessed by index and identified by their osc type
+/// tag. Numeric arguments can be read as any numeric type and are converted,
+/// reading an argument as a type it can't be converted to returns 0 or an
+/// empty string
+class ofxGstOscMessageView{
+public:
+	ofxGstOscMessageView();
+
+	const char * getAddress() const;
+	size_t getNumArgs() const;
+
+	/// 'i' int32, 'h' int64, 'f' float, 'd' double, 's' string, 'S' symbol,
+	/// 'b' blob, 'c' char, 'T' true, 'F' false... as in the osc spec
+	char getArgTypeTag(size_t index) const;
+
+	int32_t getArgAsInt32(size_t index) const;
+	int64_t getArgAsInt64(size_t index) const;
+	float getArgAsFloat(size_t index) const;
+	double getArgAsDouble(size_t index) const;
+	bool getArgAsBool(size_t index) const;
+	const char * getArgAsString(size_t index) const;
+
+	/// returns false if the argument is not a blob
+	bool getArgAsBlob(size_t index, const char * & data, size_t & size) const;
+
+	/// copies the message in a regular ofxOscMessage, which allocates. Types
+	/// that ofxOscMessage doesn't support are skipped
+	void toOfxOscMessage(ofxOscMessage & message) const;
+
+private:
+	friend class ofxGstOscParser;
+	const char * address;
+	const char * typeTags;
+	const char * const * args;
+	size_t firstArg;
+	size_t numArgs;
+};
+
+/// parses osc packets, messages or bundles of any depth, into views of each
+/// message in the order they were sent. The vectors used to hold the views
+/// are kept between packets so once they have grown to the number of
+/// messages and arguments per frame parsing doesn't allocate
+class ofxGstOscParser{
+public:
+	/// forgets the messages parsed so far
+	void clear();
+
+	/// parses a packet and adds its messages, returns false if it's malformed
+	/// in which case the messages before the error are still added. The
+	/// packet has to stay valid while the messages are used
+	bool parse(const char * data, size_t size);
+
+	const vector<ofxGstOscMessageView> & getMessages() const;
+
+	/// maximum nesting of bundles inside bundles
+	static const int MAX_BUNDLE_DEPTH = 8;
+
+private:
+	bool parseElement(const char * data, size_t size, int depth);
+	bool parseMessage(const char * data, size_t size);
+	bool parseBundle(const char * data, size_t size, int depth);
+
+	vector<ofxGstOscMessageView> messages;
+	vector<const char *> args;
+};
+
+#endif /* OFXGSTOSCPARSER_H_ */
@@ -0,0 +1,141 @@
+/*
+ * ofxGstPipelineClock.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofxGstPipelineClock.h"
+#include "ofConstants.h"
+#include "ofAppRunner.h"
+#include <thread>
+#ifdef TARGET_LINUX
+#include <time.h>
+#endif
+
+ofxGstPipelineClock::ofxGstPipelineClock()
+:pipeline(NULL)
+,cached(false)
+,users(0)
+,clock(NULL)
+,baseTime(0)
+,systemMonotonic(false)
+,frameNum(0)
+,frameTime(GST_CLOCK_TIME_NONE){
+
+}
+
+ofxGstPipelineClock::~ofxGstPipelineClock(){
+	close();
+}
+
+void ofxGstPipelineClock::setup(GstElement * pipeline){
+	close();
+	std::unique_lock<std::mutex> lock(mutex);
+	this->pipeline = pipeline;
+}
+
+void ofxGstPipelineClock::close(){
+	{
+		std::unique_lock<std::mutex> lock(frameMutex);
+		frameNum = 0;
+		frameTime = GST_CLOCK_TIME_NONE;
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	cached = false;
+	// a thread in now() that saw the clock cached could still be using it,
+	// any call after this one sees cached false and queries the pipeline
+	while(users>0){
+		std::this_thread::yield();
+	}
+	if(clock){
+		gst_object_unref(clock);
+		clock = NULL;
+	}
+	pipeline = NULL;
+}
+
+bool ofxGstPipelineClock::cache(){
+	std::unique_lock<std::mutex> lock(mutex);
+	if(cached) return true;
+	if(!pipeline) return false;
+
+	// the clock is selected and the base time set when going to playing
+	GstState state = GST_STATE_NULL;
+	if(gst_element_get_state(pipeline,&state,NULL,0)!=GST_STATE_CHANGE_SUCCESS || state!=GST_STATE_PLAYING){
+		return false;
+	}
+	clock = gst_pipeline_get_clock(GST_PIPELINE(pipeline));
+	if(!clock) return false;
+	baseTime = gst_element_get_base_time(pipeline);
+
+	// the system clock in monotonic mode is clock_gettime(CLOCK_MONOTONIC)
+	// as long as it's not calibrated against other clock
+	systemMonotonic = false;
+#ifdef TARGET_LINUX
+	if(GST_IS_SYSTEM_CLOCK(clock)){
+		GstClockType type = GST_CLOCK_TYPE_REALTIME;
+		g_object_get(clock,"clock-type",&type,NULL);
+		GstClockTime internal, external, rateNum, rateDenom;
+		gst_clock_get_calibration(clock,&internal,&external,&rateNum,&rateDenom);
+		systemMonotonic = type==GST_CLOCK_TYPE_MONOTONIC && internal==external && rateNum==rateDenom;
+	}
+#endif
+	cached = true;
+	return true;
+}
+
+GstClockTime ofxGstPipelineClock::query(){
+	std::unique_lock<std::mutex> lock(mutex);
+	if(!pipeline) return GST_CLOCK_TIME_NONE;
+	GstClock * clock = gst_pipeline_get_clock(GST_PIPELINE(pipeline));
+	if(!clock) return GST_CLOCK_TIME_NONE;
+	GstClockTime now = gst_clock_get_time(clock) - gst_element_get_base_time(pipeline);
+	gst_object_unref(clock);
+	return now;
+}
+
+GstClockTime ofxGstPipelineClock::now(){
+	if(!cached && !cache()){
+		return query();
+	}
+
+	// users is incremented before checking cached again so close() either
+	// waits for this call or this call sees the clock released
+	users++;
+	if(!cached){
+		users--;
+		return query();
+	}
+	GstClockTime time;
+#ifdef TARGET_LINUX
+	if(systemMonotonic){
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC,&ts);
+		time = GST_TIMESPEC_TO_TIME(ts) - baseTime;
+	}else
+#endif
+	{
+		time = gst_clock_get_time(clock) - baseTime;
+	}
+	users--;
+	return time;
+}
+
+GstClockTime ofxGstPipelineClock::getFrameTime(){
+	uint64_t currentFrame = ofGetFrameNum() + 1;
+	std::unique_lock<std::mutex> lock(frameMutex);
+	if(frameNum!=currentFrame || frameTime==GST_CLOCK_TIME_NONE){
+		frameTime = now();
+		frameNum = currentFrame;
+	}
+	return frameTime;
+}
+
+GstClockTime ofxGstPipelineClock::getBaseTime(){
+	if(!cached && !cache()){
+		std::unique_lock<std::mutex> lock(mutex);
+		return pipeline ? gst_element_get_base_time(pipeline) : 0;
+	}
+	return baseTime;
+}
@@ -0,0 +1,67 @@
+/*
+ * ofxGstPipelineClock.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTPIPELINECLOCK_H_
+#define OFXGSTPIPELINECLOCK_H_
+
+#include <gst/gst.h>
+#include <atomic>
+#include <mutex>
+
+/// running time of a pipeline for timestamping buffers and events from the
+/// app. Asking the pipeline for its clock and base time locks the pipeline
+/// and refs the clock on every call, which adds up with osc at 1KHz plus
+/// video and depth. Once the pipeline is playing the clock and base time
+/// are cached and now() doesn't lock anymore. On linux when the pipeline
+/// uses the monotonic system clock it reads the system time directly.
+/// Can be called from any thread
+class ofxGstPipelineClock{
+public:
+	ofxGstPipelineClock();
+	~ofxGstPipelineClock();
+
+	/// the pipeline doesn't need to be playing yet, the clock is cached
+	/// the first time it's asked for the time once it's playing
+	void setup(GstElement * pipeline);
+
+	/// releases the clock, has to be called before the pipeline is
+	/// stopped or the base time changes. Waits for the threads that are
+	/// reading the cached clock in now() so it's safe to call while other
+	/// threads are still timestamping
+	void close();
+
+	/// current running time of the pipeline, before the pipeline is
+	/// playing it's queried every time as it'd be done without the cache.
+	/// GST_CLOCK_TIME_NONE if there's no pipeline
+	GstClockTime now();
+
+	/// running time taken the first time it's called in an app frame, every
+	/// call in the same frame returns the same value so several channels
+	/// can be timestamped together
+	GstClockTime getFrameTime();
+
+	/// base time of the pipeline, adding it to the running time gives
+	/// the absolute time of the clock
+	GstClockTime getBaseTime();
+
+private:
+	bool cache();
+	GstClockTime query();
+
+	GstElement * pipeline;
+	std::mutex mutex;
+	std::atomic<bool> cached;
+	std::atomic<int> users;
+	GstClock * clock;
+	GstClockTime baseTime;
+	bool systemMonotonic;
+
+	std::mutex frameMutex;
+	uint64_t frameNum;
+	GstClockTime frameTime;
+};
+
+#endif /* OFXGSTPIPELINECLOCK_H_ */
@@ -11,7 +11,11 @@
 #include "ofConstants.h"
 #include "ofTypes.h"
 #include "ofPixels.h"
-#include <list>
+#include "ofxGstLockFreeFreeList.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 template<typename PixelType>
 class ofxGstBufferPool;
@@ -21,27 +25,97 @@ template<typename PixelType>
 class PooledPixels: public ofPixels_<PixelType>{
 public:
 	ofxGstBufferPool<PixelType> * pool;
+	int index;
+};
+
+/// what the pool does when all its buffers are in use
+enum ofxGstBufferPoolOverflow{
+	/// wait for a buffer to be returned to the pool up to the block timeout
+	OFX_GST_POOL_BLOCK,
+	/// drop the frame that is being sent
+	OFX_GST_POOL_DROP_NEWEST,
+	/// drop the oldest frame waiting in the pipeline, the server inserts
+	/// a leaky queue after the appsrc so old buffers return to the pool.
+	/// if the pool is still empty the new frame is dropped
+	OFX_GST_POOL_DROP_OLDEST
+};
+
+/// counters for a buffer pool
+struct ofxGstBufferPoolStats{
+	/// buffers served from the pool
+	unsigned long long hits;
+	/// requests that couldn't get a buffer because the pool was empty
+	unsigned long long misses;
+	/// buffers currently outside of the pool
+	int inFlight;
+	/// maximum number of buffers that have been outside of the pool at once
+	int highWaterMark;
+	/// total number of buffers in the pool
+	int capacity;
+	/// frames copied into buffers of the pool and their size, the zero
+	/// copy paths of the server don't increase them
+	unsigned long long framesCopied;
+	unsigned long long bytesCopied;
 };
 
 
-/// pixels pool: ofPixels copies are allocated if the pool is empty
-/// if not we just get one from the pool. When a buffer is not needed anymore
+/// pixels pool: a fixed number of ofPixels are allocated when the pool is
+/// created and recycled through a lock free list so getting and returning
+/// buffers never allocates or locks. When a buffer is not needed anymore
 /// gstreamer calls the passed function which instead of deleting them
 /// will return them to the pool they belong
 /// Used internally by the addon to avoid allocation every frame
 template<typename PixelType>
 class ofxGstBufferPool{
 public:
-	ofxGstBufferPool(int width, int height, int channels);
+	ofxGstBufferPool(int width, int height, int channels, int capacity=DEFAULT_CAPACITY, ofxGstBufferPoolOverflow overflow=OFX_GST_POOL_DROP_OLDEST);
+	ofxGstBufferPool(int width, int height, ofPixelFormat format, int capacity=DEFAULT_CAPACITY, ofxGstBufferPoolOverflow overflow=OFX_GST_POOL_DROP_OLDEST);
 
+	/// returns a buffer from the pool or NULL if the pool is exhausted
+	/// and the overflow policy doesn't allow to wait for one
 	PooledPixels<PixelType> * newBuffer();
 	static void relaseBuffer(PooledPixels<PixelType> * buffer);
 
+	/// the pool can't be deleted while gstreamer still holds some of its
+	/// buffers, close marks it for deletion and it'll be deleted as soon
+	/// as all the buffers are returned
+	void close();
+
+	/// maximum time newBuffer will wait for a buffer when using
+	/// OFX_GST_POOL_BLOCK
+	void setBlockTimeout(int ms);
+
+	ofxGstBufferPoolOverflow getOverflowPolicy() const;
+	int getCapacity() const;
+	ofxGstBufferPoolStats getStats() const;
+
+	/// called by the users of the pool when they copy a frame into one of
+	/// its buffers, only to keep count in the stats
+	void bufferCopied(size_t bytes);
+
+	static const int DEFAULT_CAPACITY = 8;
+
 private:
+	~ofxGstBufferPool();
+	void allocateBuffers(int capacity);
 	void returnBufferToPool(PooledPixels<PixelType> * pixels);
-	list<PooledPixels<PixelType>*> pool;
-	int width, height, channels;
-	ofMutex mutex;
+	void bufferAcquired();
+
+	std::vector<PooledPixels<PixelType>*> buffers;
+	ofxGstLockFreeFreeList freeList;
+	ofxGstBufferPoolOverflow overflow;
+	int blockTimeoutMs;
+
+	// number of buffers in flight * 2, the lower bit is set when closed
+	std::atomic<int> state;
+	std::atomic<int> highWaterMark;
+	std::atomic<unsigned long long> hits, misses;
+	std::atomic<unsigned long long> framesCopied, bytesCopied;
+
+	// only used to wake up threads waiting with OFX_GST_POOL_BLOCK
+	std::atomic<int> waiting;
+	std::mutex mutex;
+	std::condition_variable condition;
 };
 
 
@@ -51,31 +125,99 @@ private:
 // implementation
 
 template<typename PixelType>
-ofxGstBufferPool<PixelType>::ofxGstBufferPool(int width, int height, int channels)
-:width(width), height(height), channels(channels){};
+ofxGstBufferPool<PixelType>::ofxGstBufferPool(int width, int height, int channels, int capacity, ofxGstBufferPoolOverflow overflow)
+:overflow(overflow)
+,blockTimeoutMs(100)
+,state(0)
+,highWaterMark(0)
+,hits(0)
+,misses(0)
+,framesCopied(0)
+,bytesCopied(0)
+,waiting(0){
+	allocateBuffers(capacity);
+	for(int i=0;i<capacity;i++){
+		buffers[i]->allocate(width,height,channels);
+	}
+}
+
+template<typename PixelType>
+ofxGstBufferPool<PixelType>::ofxGstBufferPool(int width, int height, ofPixelFormat format, int capacity, ofxGstBufferPoolOverflow overflow)
+:overflow(overflow)
+,blockTimeoutMs(100)
+,state(0)
+,highWaterMark(0)
+,hits(0)
+,misses(0)
+,framesCopied(0)
+,bytesCopied(0)
+,waiting(0){
+	allocateBuffers(capacity);
+	for(int i=0;i<capacity;i++){
+		buffers[i]->allocate(width,height,format);
+	}
+}
+
+template<typename PixelType>
+void ofxGstBufferPool<PixelType>::allocateBuffers(int capacity){
+	buffers.resize(capacity);
+	for(int i=0;i<capacity;i++){
+		buffers[i] = new PooledPixels<PixelType>;
+		buffers[i]->pool = this;
+		buffers[i]->index = i;
+	}
+	freeList.setup(capacity);
+}
+
+template<typename PixelType>
+ofxGstBufferPool<PixelType>::~ofxGstBufferPool(){
+	for(size_t i=0;i<buffers.size();i++){
+		delete buffers[i];
+	}
+}
 
 template<typename PixelType>
 PooledPixels<PixelType> * ofxGstBufferPool<PixelType>::newBuffer(){
-	PooledPixels<PixelType> * pixels;
-	mutex.lock();
-	if(pool.empty()){
-		mutex.unlock();
-		pixels = new PooledPixels<PixelType>;
-		pixels->allocate(width,height,channels);
-		pixels->pool = this;
-	}else{
-		pixels = pool.back();
-		pool.pop_back();
-		mutex.unlock();
+	int index = freeList.pop();
+	if(index<0 && overflow==OFX_GST_POOL_BLOCK){
+		waiting++;
+		std::unique_lock<std::mutex> lock(mutex);
+		std::chrono::steady_clock::time_point timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(blockTimeoutMs);
+		while((index = freeList.pop())<0){
+			if(condition.wait_until(lock,timeout)==std::cv_status::timeout){
+				index = freeList.pop();
+				break;
+			}
+		}
+		waiting--;
 	}
-	return pixels;
+	if(index<0){
+		misses++;
+		return NULL;
+	}
+	bufferAcquired();
+	return buffers[index];
+}
+
+template<typename PixelType>
+void ofxGstBufferPool<PixelType>::bufferAcquired(){
+	hits++;
+	int inFlight = (state.fetch_add(2) >> 1) + 1;
+	int prevMax = highWaterMark.load();
+	while(inFlight>prevMax && !highWaterMark.compare_exchange_weak(prevMax,inFlight));
 }
 
 template<typename PixelType>
 void ofxGstBufferPool<PixelType>::returnBufferToPool(PooledPixels<PixelType> * pixels){
-	mutex.lock();
-	pool.push_back(pixels);
-	mutex.unlock();
+	freeList.push(pixels->index);
+	if(waiting.load()>0){
+		std::unique_lock<std::mutex> lock(mutex);
+		condition.notify_one();
+	}
+	// if this was the last buffer in flight of a closed pool delete it
+	if(state.fetch_sub(2)==3){
+		delete this;
+	}
 }
 
 
@@ -85,5 +227,46 @@ void ofxGstBufferPool<PixelType>::relaseBuffer(PooledPixels<PixelType> * buffer)
 	pixels->pool->returnBufferToPool(pixels);
 }
 
+template<typename PixelType>
+void ofxGstBufferPool<PixelType>::close(){
+	if(state.fetch_or(1)==0){
+		delete this;
+	}
+}
+
+template<typename PixelType>
+void ofxGstBufferPool<PixelType>::setBlockTimeout(int ms){
+	blockTimeoutMs = ms;
+}
+
+template<typename PixelType>
+ofxGstBufferPoolOverflow ofxGstBufferPool<PixelType>::getOverflowPolicy() const{
+	return overflow;
+}
+
+template<typename PixelType>
+int ofxGstBufferPool<PixelType>::getCapacity() const{
+	return buffers.size();
+}
+
+template<typename PixelType>
+ofxGstBufferPoolStats ofxGstBufferPool<PixelType>::getStats() const{
+	ofxGstBufferPoolStats stats;
+	stats.hits = hits.load();
+	stats.misses = misses.load();
+	stats.inFlight = state.load() >> 1;
+	stats.highWaterMark = highWaterMark.load();
+	stats.capacity = buffers.size();
+	stats.framesCopied = framesCopied.load();
+	stats.bytesCopied = bytesCopied.load();
+	return stats;
+}
+
+template<typename PixelType>
+void ofxGstBufferPool<PixelType>::bufferCopied(size_t bytes){
+	framesCopied++;
+	bytesCopied += bytes;
+}
+
 
 #endif /* OFXGSTPIXELSPOOL_H_ */
@@ -0,0 +1,166 @@
+/*
+ * ofxGstRTPBitrateController.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofxGstRTPBitrateController.h"
+#include "ofUtils.h"
+#include "ofMath.h"
+#include <algorithm>
+#include <cmath>
+
+// number of reports used to calculate the base round trip time,
+// with the default RTCP interval it's around a minute and a half
+static const size_t ROUND_TRIP_WINDOW = 20;
+
+ofxGstRTPBitrateController::ofxGstRTPBitrateController()
+:target(0)
+,minBitrate(0)
+,maxBitrate(0)
+,lossLow(0.02)
+,lossHigh(0.1)
+,increaseFactor(1.08)
+,delayDecreaseFactor(0.85)
+,delayThreshold(0.05)
+,smoothedRoundTrip(0)
+,congestedBitrate(0)
+,haveReport(false)
+,lastSeq(0)
+,lastAction(OFX_GST_RTP_BITRATE_HOLD){
+
+}
+
+void ofxGstRTPBitrateController::setup(int initialBitrate, int minBitrate, int maxBitrate){
+	target = initialBitrate;
+	setBounds(minBitrate,maxBitrate);
+	reset();
+}
+
+void ofxGstRTPBitrateController::setBounds(int minBitrate, int maxBitrate){
+	this->minBitrate = std::min(minBitrate,maxBitrate);
+	this->maxBitrate = std::max(minBitrate,maxBitrate);
+	clamp();
+}
+
+void ofxGstRTPBitrateController::reset(){
+	recentRoundTrips.clear();
+	smoothedRoundTrip = 0;
+	congestedBitrate = 0;
+	haveReport = false;
+	lastSeq = 0;
+	lastAction = OFX_GST_RTP_BITRATE_HOLD;
+	reason = "waiting for reports";
+}
+
+void ofxGstRTPBitrateController::clamp(){
+	target = ofClamp(target,minBitrate,maxBitrate);
+}
+
+bool ofxGstRTPBitrateController::update(const ofxGstRTPReceiverReport & report){
+	if(haveReport && report.extHighestSeq==lastSeq){
+		return false;
+	}
+	haveReport = true;
+	lastSeq = report.extHighestSeq;
+
+	int prevTarget = getTargetBitrate();
+
+	// delay based: compare the smoothed round trip with the minimum in the
+	// last reports, the difference is an estimation of the time packets
+	// spend in queues
+	bool delayCongested = false;
+	double queuingDelay = 0;
+	if(report.roundTrip>0){
+		recentRoundTrips.push_back(report.roundTrip);
+		if(recentRoundTrips.size()>ROUND_TRIP_WINDOW){
+			recentRoundTrips.pop_front();
+		}
+		double baseRoundTrip = *std::min_element(recentRoundTrips.begin(),recentRoundTrips.end());
+		if(smoothedRoundTrip==0){
+			smoothedRoundTrip = report.roundTrip;
+		}else{
+			smoothedRoundTrip = smoothedRoundTrip * 0.7 + report.roundTrip * 0.3;
+		}
+		// the latest report has to agree with the smoothed value so we stop
+		// decreasing as soon as the queues are drained
+		queuingDelay = smoothedRoundTrip - baseRoundTrip;
+		delayCongested = queuingDelay > delayThreshold && report.roundTrip - baseRoundTrip > delayThreshold;
+	}
+
+	// loss based
+	if(report.fractionLost>lossHigh){
+		congestedBitrate = target;
+		target *= 1 - 0.5 * report.fractionLost;
+		lastAction = OFX_GST_RTP_BITRATE_DECREASE;
+		reason = "loss " + ofToString(report.fractionLost*100,1) + "% over " + ofToString(lossHigh*100,1) + "%";
+	}else if(delayCongested){
+		congestedBitrate = target;
+		target *= delayDecreaseFactor;
+		lastAction = OFX_GST_RTP_BITRATE_DECREASE;
+		reason = "queuing delay " + ofToString(queuingDelay*1000,0) + "ms over " + ofToString(delayThreshold*1000,0) + "ms";
+	}else if(report.fractionLost<lossLow){
+		// far from the last bitrate that caused congestion probe
+		// multiplicatively, close to it increase slowly
+		if(fabs(target - congestedBitrate) > congestedBitrate * 0.1){
+			target *= increaseFactor;
+		}else{
+			target += target * (increaseFactor - 1) * 0.25;
+		}
+		lastAction = OFX_GST_RTP_BITRATE_INCREASE;
+		reason = "loss " + ofToString(report.fractionLost*100,1) + "% and queuing delay " + ofToString(queuingDelay*1000,0) + "ms";
+	}else{
+		lastAction = OFX_GST_RTP_BITRATE_HOLD;
+		reason = "loss " + ofToString(report.fractionLost*100,1) + "% between thresholds";
+	}
+
+	clamp();
+	if(lastAction==OFX_GST_RTP_BITRATE_INCREASE && getTargetBitrate()==maxBitrate){
+		reason += ", at maximum";
+	}else if(lastAction==OFX_GST_RTP_BITRATE_DECREASE && getTargetBitrate()==minBitrate){
+		reason += ", at minimum";
+	}
+	return getTargetBitrate()!=prevTarget;
+}
+
+void ofxGstRTPBitrateController::setTargetBitrate(int bitrate){
+	target = bitrate;
+	clamp();
+}
+
+int ofxGstRTPBitrateController::getTargetBitrate() const{
+	return target + 0.5;
+}
+
+int ofxGstRTPBitrateController::getMinBitrate() const{
+	return minBitrate;
+}
+
+int ofxGstRTPBitrateController::getMaxBitrate() const{
+	return maxBitrate;
+}
+
+ofxGstRTPBitrateAction ofxGstRTPBitrateController::getLastAction() const{
+	return lastAction;
+}
+
+string ofxGstRTPBitrateController::getReason() const{
+	return reason;
+}
+
+void ofxGstRTPBitrateController::setLossThresholds(float low, float high){
+	lossLow = low;
+	lossHigh = high;
+}
+
+void ofxGstRTPBitrateController::setIncreaseFactor(float factor){
+	increaseFactor = factor;
+}
+
+void ofxGstRTPBitrateController::setDelayDecreaseFactor(float factor){
+	delayDecreaseFactor = factor;
+}
+
+void ofxGstRTPBitrateController::setDelayThreshold(double seconds){
+	delayThreshold = seconds;
+}
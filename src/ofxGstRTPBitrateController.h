@@ -0,0 +1,110 @@
+/*
+ * ofxGstRTPBitrateController.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTRTPBITRATECONTROLLER_H_
+#define OFXGSTRTPBITRATECONTROLLER_H_
+
+#include "ofConstants.h"
+#include <deque>
+
+/// the values of an RTCP receiver report in seconds and fractions
+/// instead of the raw RTCP units
+struct ofxGstRTPReceiverReport{
+	ofxGstRTPReceiverReport()
+	:roundTrip(0)
+	,fractionLost(0)
+	,jitter(0)
+	,packetsLost(0)
+	,extHighestSeq(0){}
+
+	/// round trip time in seconds, 0 if unknown
+	double roundTrip;
+	/// fraction of packets lost since the previous report [0..1]
+	float fractionLost;
+	/// interarrival jitter in seconds
+	double jitter;
+	/// total packets lost since the beginning of the session
+	int packetsLost;
+	/// extended highest sequence number received, used to detect
+	/// when a new report arrives
+	unsigned int extHighestSeq;
+};
+
+enum ofxGstRTPBitrateAction{
+	OFX_GST_RTP_BITRATE_HOLD,
+	OFX_GST_RTP_BITRATE_INCREASE,
+	OFX_GST_RTP_BITRATE_DECREASE
+};
+
+/// congestion control for a channel in the server. Similar to the sender
+/// side of google congestion control: it combines a loss based controller
+/// (multiplicative increase while loss is low, decrease proportional to the loss
+/// when it's high) with a delay based one that decreases the bitrate when the
+/// round trip time grows over its recent minimum, which means packets are
+/// queuing somewhere in the network. Once congestion has been detected the
+/// increase slows down when approaching the bitrate that caused it. The bitrate is always kept in the
+/// [min, max] bounds and the units are the same used by the encoder
+class ofxGstRTPBitrateController{
+public:
+	ofxGstRTPBitrateController();
+
+	void setup(int initialBitrate, int minBitrate, int maxBitrate);
+	void setBounds(int minBitrate, int maxBitrate);
+
+	/// feeds a new receiver report, reports that were already processed
+	/// are ignored. Returns true if the target bitrate changed
+	bool update(const ofxGstRTPReceiverReport & report);
+
+	/// sets the current target, used when the bitrate is changed manually.
+	/// the value is clamped to the bounds
+	void setTargetBitrate(int bitrate);
+
+	/// forgets the history of reports but keeps the current target
+	void reset();
+
+	int getTargetBitrate() const;
+	int getMinBitrate() const;
+	int getMaxBitrate() const;
+
+	/// action taken with the last report and a human readable explanation
+	ofxGstRTPBitrateAction getLastAction() const;
+	string getReason() const;
+
+	/// loss below low increases the bitrate, over high decreases it,
+	/// in between it's kept. Defaults to 0.02 and 0.1
+	void setLossThresholds(float low, float high);
+
+	/// factor applied to the bitrate on each report without congestion,
+	/// defaults to 1.08
+	void setIncreaseFactor(float factor);
+
+	/// factor applied to the bitrate when the delay grows, defaults to 0.85
+	void setDelayDecreaseFactor(float factor);
+
+	/// queuing delay in seconds over which the network is considered
+	/// congested, defaults to 0.05
+	void setDelayThreshold(double seconds);
+
+private:
+	void clamp();
+
+	double target;
+	int minBitrate, maxBitrate;
+	float lossLow, lossHigh;
+	float increaseFactor, delayDecreaseFactor;
+	double delayThreshold;
+
+	std::deque<double> recentRoundTrips;
+	double smoothedRoundTrip;
+	double congestedBitrate;
+	bool haveReport;
+	unsigned int lastSeq;
+
+	ofxGstRTPBitrateAction lastAction;
+	string reason;
+};
+
+#endif /* OFXGSTRTPBITRATECONTROLLER_H_ */
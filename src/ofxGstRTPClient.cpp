@@ -19,8 +19,10 @@
 //#include <gst/gstnice.h>
 
 #include "ofxGstRTPUtils.h"
+#include "ofMath.h"
 
 #define RTPBIN_MAX_LATENCY 2000
+#define KEYFRAME_REQUEST_INTERVAL_MS 500
 string ofxGstRTPClient::LOG_NAME="ofxGstRTPClient";
 
 
@@ -56,42 +58,85 @@ string ofxGstRTPClient::LOG_NAME="ofxGstRTPClient";
 //  port=5003  |     src->recv_rtcp      |
 //             '-------'      '----------'
 
+ofxGstRTPClient::Channel::Channel(ofxGstRTPClient * client, ofxGstRTPChannel type, int index, guint session)
+:client(client)
+,type(type)
+,index(index)
+,session(session)
+,layer(0)
+,numLayers(1)
+,payloadType(0)
+,retransmission(false)
+,fec(false)
+,depay(NULL)
+,valve(NULL)
+,sink(NULL)
+,rtpsrc(NULL)
+,rtcpsrc(NULL)
+,rtcpsink(NULL)
+,depth16(false)
+,ready(false)
+,processing(true)
+,depth16Packed(false)
+,depthUnpackedValid(false)
+,oscParsed(false)
+,oscLastMessageValid(false)
+,ssrc(0)
+,keyframesRequested(0)
+,keyFrameNeeded(false)
+,lastKeyFrameRequest(0)
+,jitterbuffer(NULL)
+,fecdec(NULL)
+,prevPacketsReceived(0)
+,prevPacketsLost(0)
+,activeLayer(0)
+,pendingLayer(-1)
+,lastLayerChange(0)
+,lastLayerSample(0){
+
+}
+
+ofxGstRTPClient::Channel::~Channel(){
+	if(jitterbuffer){
+		gst_object_unref(jitterbuffer);
+	}
+	if(fecdec){
+		gst_object_unref(fecdec);
+	}
+}
+
+string ofxGstRTPClient::Channel::getElementName(const string & name) const{
+	// every element is prefixed with the type of the channel and suffixed
+	// with its index so several channels of the same type can coexist
+	string prefix;
+	switch(type){
+	case OFX_GST_RTP_VIDEO: prefix = "v"; break;
+	case OFX_GST_RTP_DEPTH: prefix = "d"; break;
+	case OFX_GST_RTP_AUDIO: prefix = "a"; break;
+	case OFX_GST_RTP_OSC: prefix = "o"; break;
+	default: break;
+	}
+	string suffix = ofToString(index);
+	if(layer>0){
+		suffix += "l" + ofToString(layer);
+	}
+	return prefix + name + suffix;
+}
+
 ofxGstRTPClient::ofxGstRTPClient()
-:width(0)
-,height(0)
-,pipeline(0)
+:pipeline(0)
+,pipelineAudioOut(0)
 ,rtpbin(0)
-,vh264depay(0)
-,opusdepay(0)
-,depthdepay(0)
-,gstdepay(0)
-,videoSink(0)
-,depthSink(0)
-,oscSink(0)
-,vqueue(0)
-,dqueue(0)
-,vudpsrc(0)
-,audpsrc(0)
-,dudpsrc(0)
-,oudpsrc(0)
-,vudpsrcrtcp(0)
-,audpsrcrtcp(0)
-,dudpsrcrtcp(0)
-,oudpsrcrtcp(0)
-,depth16(false)
-,videoSessionNumber(-1)
-,audioSessionNumber(-1)
-,depthSessionNumber(-1)
-,oscSessionNumber(-1)
-,videoSSRC(0)
-,audioSSRC(0)
-,depthSSRC(0)
-,oscSSRC(0)
-,videoReady(false)
-,audioReady(false)
-,depthReady(false)
-,oscReady(false)
-,lastSessionNumber(0)
+,audioechosrc(NULL)
+,audioechosink(NULL)
+,retransmission(ofxGstRTPCodecs::isRetransmissionAvailable())
+,fec(false)
+,depthDecompressionThreads(0)
+,oscQueueCapacity(ofxGstOscDoubleBuffer::DEFAULT_CAPACITY)
+,depth16Packed(false)
+,depth16MaxDepth(ofxGstDepth16Packer::DEFAULT_MAX_DEPTH)
+,statsInterval(ofxGstRTPStatsCollector::DEFAULT_INTERVAL_MS)
+,statsHistorySize(ofxGstRTPStatsCollector::DEFAULT_HISTORY_SIZE)
 
 #if ENABLE_ECHO_CANCEL
 ,audioChannelReady(false)
@@ -102,8 +147,6 @@ ofxGstRTPClient::ofxGstRTPClient()
 ,prevAudioBuffer(0)
 ,audioFramesProcessed(0)
 #endif
-
-,audioechosrc(NULL)
 {
 	GstMapInfo initMapinfo		= {0,};
 	mapinfo = initMapinfo;
@@ -112,165 +155,542 @@ ofxGstRTPClient::ofxGstRTPClient()
 	latency.addListener(this,&ofxGstRTPClient::latencyChanged);
 	drop.set("drop",false);
 	drop.addListener(this,&ofxGstRTPClient::dropChanged);
+	autoVideoLayer.set("auto video layer",true);
+	videoLayerMaxLoss.set("video layer max loss",0.05,0,1);
+	videoLayerMaxJitter.set("video layer max jitter (ms)",30,0,500);
+	videoLayerUpgradeDelay.set("video layer upgrade delay (ms)",5000,0,30000);
 	parameters.setName("gst rtp client");
 	parameters.add(latency);
 	parameters.add(drop);
+	parameters.add(autoVideoLayer);
+	parameters.add(videoLayerMaxLoss);
+	parameters.add(videoLayerMaxJitter);
+	parameters.add(videoLayerUpgradeDelay);
 }
 
 ofxGstRTPClient::~ofxGstRTPClient() {
 	close();
 }
 
+ofxGstRTPClient::Channel & ofxGstRTPClient::createChannel(ofxGstRTPChannel type){
+	// session numbers are consecutive so they can be used as index
+	shared_ptr<Channel> channel(new Channel(this,type,channelsByType[type].size(),channels.size()));
+	switch(type){
+	case OFX_GST_RTP_VIDEO: channel->payloadType = ofxGstRTPCodecs::VIDEO_PAYLOAD_TYPE; break;
+	case OFX_GST_RTP_DEPTH: channel->payloadType = ofxGstRTPCodecs::DEPTH_PAYLOAD_TYPE; break;
+	case OFX_GST_RTP_AUDIO: channel->payloadType = ofxGstRTPCodecs::AUDIO_PAYLOAD_TYPE; break;
+	case OFX_GST_RTP_OSC: channel->payloadType = ofxGstRTPCodecs::OSC_PAYLOAD_TYPE; break;
+	default: break;
+	}
+	channel->retransmission = retransmission && type!=OFX_GST_RTP_AUDIO;
+	channel->fec = fec && type!=OFX_GST_RTP_AUDIO;
+#if ENABLE_NAT_TRANSVERSAL
+	channel->niceStream = nextNiceStream;
+	nextNiceStream.reset();
+#endif
+	channels.push_back(channel);
+	channelsByType[type].push_back(channel);
+	return *channel;
+}
+
+ofxGstRTPClient::Channel & ofxGstRTPClient::createLayerChannel(Channel & base, int layer){
+	// a layer has its own session but shares the index of its channel
+	shared_ptr<Channel> channel(new Channel(this,base.type,base.index,channels.size()));
+	channel->layer = layer;
+	channel->numLayers = base.numLayers;
+	channel->payloadType = base.payloadType;
+	channel->retransmission = base.retransmission;
+	channel->fec = base.fec;
+	channels.push_back(channel);
+	base.layers.push_back(channel.get());
+	return *channel;
+}
+
+ofxGstRTPClient::Channel * ofxGstRTPClient::getChannel(ofxGstRTPChannel type, int index){
+	if(index<0 || index>=int(channelsByType[type].size())){
+		return NULL;
+	}
+	return channelsByType[type][index].get();
+}
+
+ofxGstRTPClient::Channel * ofxGstRTPClient::getChannel(guint session){
+	if(session>=channels.size()){
+		return NULL;
+	}
+	return channels[session].get();
+}
+
+ofxGstRTPClient::Channel * ofxGstRTPClient::getVideoLayer(int channel, int layer){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	if(!video || layer<0 || layer>=video->numLayers){
+		return NULL;
+	}
+	return layer==0 ? video : video->layers[layer-1];
+}
 
-static string get_object_structure_property (GObject * object, const string & property){
-	GstStructure *structure;
-	gchar *str;
+ofxGstRTPClient::Channel * ofxGstRTPClient::getActiveVideoLayer(int channel){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	if(!video) return NULL;
+	return getVideoLayer(channel,video->activeLayer);
+}
 
-	if(object==NULL) return "";
+int ofxGstRTPClient::getNumVideoChannels(){
+	return channelsByType[OFX_GST_RTP_VIDEO].size();
+}
 
-	/* get the source stats */
-	g_object_get (object, property.c_str(), &structure, NULL);
+int ofxGstRTPClient::getNumDepthChannels(){
+	return channelsByType[OFX_GST_RTP_DEPTH].size();
+}
 
-	/* simply dump the stats structure */
-	str = gst_structure_to_string (structure);
+int ofxGstRTPClient::getNumOscChannels(){
+	return channelsByType[OFX_GST_RTP_OSC].size();
+}
+
+int ofxGstRTPClient::getNumVideoLayers(int channel){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	return video ? video->numLayers : 0;
+}
+
+void ofxGstRTPClient::setVideoLayer(int layer, int channel){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	if(!video || layer<0 || layer>=video->numLayers){
+		ofLogError(LOG_NAME) << "video channel " << channel << " doesn't have layer " << layer;
+		return;
+	}
+	switchVideoLayer(*video,layer);
+}
 
-	gst_structure_free (structure);
-	string ret = str;
-	g_free (str);
-	return ret;
+int ofxGstRTPClient::getVideoLayer(int channel){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	return video ? video->activeLayer : 0;
+}
+
+void ofxGstRTPClient::switchVideoLayer(Channel & channel, int layer){
+	// the new layer starts decoding right away but the current one
+	// keeps being shown until the new one has a frame, see updateVideoLayer
+	if(channel.pendingLayer>=0 && channel.pendingLayer!=layer){
+		g_object_set(getVideoLayer(channel.index,channel.pendingLayer)->valve,"drop",TRUE,NULL);
+		channel.pendingLayer = -1;
+	}
+	channel.lastLayerChange = ofGetElapsedTimeMillis();
+	if(layer==channel.activeLayer || layer==channel.pendingLayer){
+		return;
+	}
+	ofLogVerbose(LOG_NAME) << "video channel " << channel.index << " switching from layer " << channel.activeLayer << " to " << layer;
+	Channel & next = *getVideoLayer(channel.index,layer);
+	g_object_set(next.valve,"drop",FALSE,NULL);
+	channel.pendingLayer = layer;
+
+	// the decoder can't start until the next keyframe
+	requestKeyFrame(next);
+}
+
+void ofxGstRTPClient::updateVideoLayer(Channel & channel){
+	uint64_t now = ofGetElapsedTimeMillis();
+	if(channel.pendingLayer>=0){
+		Channel & pending = *getVideoLayer(channel.index,channel.pendingLayer);
+		if(pending.doubleBuffer.isFrameNew()){
+			g_object_set(getVideoLayer(channel.index,channel.activeLayer)->valve,"drop",TRUE,NULL);
+			channel.activeLayer = channel.pendingLayer;
+			channel.pendingLayer = -1;
+		}else if(now - channel.lastLayerChange > uint64_t(videoLayerUpgradeDelay)){
+			// the server is probably not sending that layer to us
+			ofLogWarning(LOG_NAME) << "video channel " << channel.index << " didn't receive layer " << channel.pendingLayer;
+			g_object_set(pending.valve,"drop",TRUE,NULL);
+			channel.pendingLayer = -1;
+			channel.lastLayerChange = now;
+		}
+		return;
+	}
+	if(!autoVideoLayer){
+		return;
+	}
+
+	// decide only once per new stats sample of the layer being shown
+	Channel & active = *getVideoLayer(channel.index,channel.activeLayer);
+	ofxGstRTPStats stats = statsCollector.getStats(active.session);
+	if(stats.timestamp==0 || stats.timestamp==channel.lastLayerSample){
+		return;
+	}
+	channel.lastLayerSample = stats.timestamp;
+
+	bool congested = stats.fractionLost>videoLayerMaxLoss || stats.jitter*1000>videoLayerMaxJitter;
+	if(congested){
+		if(channel.activeLayer<channel.numLayers-1){
+			switchVideoLayer(channel,channel.activeLayer+1);
+		}else{
+			channel.lastLayerChange = now;
+		}
+	}else if(channel.activeLayer>0 && now - channel.lastLayerChange > uint64_t(videoLayerUpgradeDelay)){
+		switchVideoLayer(channel,channel.activeLayer-1);
+	}
 }
 
 
 void ofxGstRTPClient::on_ssrc_active_handler(GstBin * rtpbin, guint session, guint ssrc, ofxGstRTPClient * rtpClient){
-	GObject * internalSession;
+	GObject * internalSession = NULL;
 	g_signal_emit_by_name(rtpbin,"get-internal-session",session,&internalSession,NULL);
+	if(!internalSession){
+		ofLogError(LOG_NAME) << "couldn't get internal session for active ssrc " << ssrc << " in session " << session;
+		return;
+	}
 	ofLogVerbose(LOG_NAME) << "ssrc active " << G_OBJECT_CLASS_NAME(G_OBJECT_GET_CLASS(internalSession)) << " for session " << session;
-
-	GObject * internalSource;
-	g_object_get (internalSession, "internal-source", &internalSource, NULL);
-	//ofLogVerbose(LOG_NAME) << get_object_structure_property(internalSource,"stats");
-
-	GObject * remoteSource;
-	g_signal_emit_by_name (internalSession, "get-source-by-ssrc", ssrc, &remoteSource, NULL);
+	g_object_unref(internalSession);
 }
 
 
 void ofxGstRTPClient::on_new_ssrc_handler(GstBin *rtpbin, guint session, guint ssrc, ofxGstRTPClient * rtpClient){
 	ofLogVerbose(LOG_NAME) << "new ssrc " << ssrc << " for session " << session;
-	GObject * internalSession;
+
+	GObject * internalSession = NULL;
 	g_signal_emit_by_name(rtpbin,"get-internal-session",session,&internalSession,NULL);
+	if(!internalSession){
+		ofLogError(LOG_NAME) << "couldn't get internal session for new ssrc " << ssrc << " in session " << session;
+		return;
+	}
 
-	GObject * remoteSource;
-	g_signal_emit_by_name (internalSession, "get-source-by-ssrc", ssrc, &remoteSource, NULL);
+	GObject * remoteSource = NULL;
+	g_signal_emit_by_name(internalSession,"get-source-by-ssrc",ssrc,&remoteSource,NULL);
+	if(remoteSource){
+		GstStructure * stats = NULL;
+		gchar * remoteAddress = NULL;
+		g_object_get(remoteSource,"stats",&stats,NULL);
+		if(stats){
+			gst_structure_get(stats,"rtcp-from",G_TYPE_STRING,&remoteAddress,NULL);
+			gst_structure_free(stats);
+		}
+		if(remoteAddress){
+			ofLogVerbose(LOG_NAME) << "new client connected from " << remoteAddress;
+			g_free(remoteAddress);
+		}else{
+			ofLogVerbose(LOG_NAME) << "couldn't get remote";
+		}
+		g_object_unref(remoteSource);
+	}else{
+		ofLogVerbose(LOG_NAME) << "couldn't get source for ssrc " << ssrc;
+	}
+	g_object_unref(internalSession);
+}
 
+void ofxGstRTPClient::on_new_jitterbuffer_handler(GstBin *rtpbin, GstElement * jitterbuffer, guint session, guint ssrc, ofxGstRTPClient * rtpClient){
+	Channel * channel = rtpClient->getChannel(session);
+	if(!channel) return;
+	std::unique_lock<std::mutex> lock(rtpClient->jitterbuffersMutex);
+	if(channel->jitterbuffer){
+		gst_object_unref(channel->jitterbuffer);
+	}
+	channel->jitterbuffer = (GstElement*)gst_object_ref(jitterbuffer);
 
-	GObject * internalSource;
-	g_object_get (internalSession, "internal-source", &internalSource, NULL);
-	ofLogVerbose(LOG_NAME) << get_object_structure_property(internalSource,"stats");
+	// the jitterbuffer sends a NACK for every missing packet until it's
+	// too late to use it
+	g_object_set(jitterbuffer,"do-retransmission",channel->retransmission,NULL);
+}
 
-	GstStructure *stats;
-	gchar* remoteAddress=0;
-	g_object_get (remoteSource, "stats", &stats, NULL);
-	gst_structure_get(stats,"rtcp-from",G_TYPE_STRING,&remoteAddress,NULL);
+GstElement * ofxGstRTPClient::on_request_aux_receiver(GstElement * rtpbin, guint session, ofxGstRTPClient * rtpClient){
+	// rtpbin asks for this when the receiving pads of a session are requested
+	// the retransmitted packets come in the same session with a different
+	// payload type and ssrc, rtprtxreceive restores the original ones
+	Channel * channel = rtpClient->getChannel(session);
+	if(!channel || !channel->retransmission){
+		return NULL;
+	}
 
-	if(remoteAddress){
-		ofLogVerbose(LOG_NAME) << "new client connected from " << remoteAddress;
-		g_free(remoteAddress);
-	}else{
-		ofLogVerbose(LOG_NAME) << "couldn't get remote";
+	GstElement * rtxreceive = gst_element_factory_make("rtprtxreceive",channel->getElementName("rtxreceive").c_str());
+	if(!rtxreceive){
+		ofLogError(LOG_NAME) << "couldn't create rtprtxreceive, retransmission disabled for " << channel->getElementName("");
+		return NULL;
 	}
-	ofLogVerbose(LOG_NAME) << get_object_structure_property(remoteSource,"stats");
+	GstElement * bin = gst_bin_new(NULL);
+	GstStructure * payloadTypeMap = ofxGstRTPCodecs::getRetransmissionPayloadTypeMap(channel->payloadType);
+	g_object_set(G_OBJECT(rtxreceive),"payload-type-map",payloadTypeMap,NULL);
+	gst_structure_free(payloadTypeMap);
+	gst_bin_add(GST_BIN(bin),rtxreceive);
 
+	GstPad * pad = gst_element_get_static_pad(rtxreceive,"src");
+	gst_element_add_pad(bin,gst_ghost_pad_new(("src_"+ofToString(session)).c_str(),pad));
+	gst_object_unref(pad);
+
+	pad = gst_element_get_static_pad(rtxreceive,"sink");
+	gst_element_add_pad(bin,gst_ghost_pad_new(("sink_"+ofToString(session)).c_str(),pad));
+	gst_object_unref(pad);
+
+	return bin;
 }
 
+GstElement * ofxGstRTPClient::on_request_fec_decoder(GstElement * rtpbin, guint session, ofxGstRTPClient * rtpClient){
+	// the decoder rebuilds lost packets from the FEC ones using the packets
+	// kept by the storage of the session when the jitterbuffer reports a loss
+	Channel * channel = rtpClient->getChannel(session);
+	if(!channel || !channel->fec){
+		return NULL;
+	}
 
-void ofxGstRTPClient::on_pad_added(GstBin *rtpbin, GstPad *pad, ofxGstRTPClient * rtpClient){
-	// when a pad is added to the rtbbin, connect the video and depth elements to the correct pads
-	// FIXME: there must be a better way to detect the correct pad than it's partial name
+	GObject * storage = NULL;
+	g_signal_emit_by_name(rtpbin,"get-internal-storage",session,&storage);
+	if(!storage){
+		ofLogError(LOG_NAME) << "couldn't get rtp storage for session " << session << ", FEC disabled";
+		return NULL;
+	}
+	GstElement * fecdec = gst_element_factory_make("rtpulpfecdec",channel->getElementName("fecdec").c_str());
+	g_object_set(G_OBJECT(fecdec),"pt",guint(channel->payloadType+ofxGstRTPCodecs::FEC_PAYLOAD_TYPE_OFFSET),
+								 "storage",storage,
+								 NULL);
+	g_object_unref(storage);
+
+	std::unique_lock<std::mutex> lock(rtpClient->jitterbuffersMutex);
+	if(channel->fecdec){
+		gst_object_unref(channel->fecdec);
+	}
+	channel->fecdec = (GstElement*)gst_object_ref(fecdec);
+	return fecdec;
+}
 
-	string padName = gst_object_get_name(GST_OBJECT(pad));
+void ofxGstRTPClient::on_new_storage(GstElement * rtpbin, GstElement * storage, guint session, ofxGstRTPClient * rtpClient){
+	// the packets need to be kept for as long as they can still be
+	// recovered, the latency can go up to the maximum while playing
+	Channel * channel = rtpClient->getChannel(session);
+	if(!channel || !channel->fec){
+		return;
+	}
+	g_object_set(G_OBJECT(storage),"size-time",guint64(RTPBIN_MAX_LATENCY*GST_MSECOND),NULL);
+}
 
+GstCaps * ofxGstRTPClient::on_request_pt_map(GstElement * rtpbin, guint session, guint pt, ofxGstRTPClient * rtpClient){
+	// the caps of the udpsrc only describe the original payload type, the
+	// session needs the clock rate of the retransmissions too
+	Channel * channel = rtpClient->getChannel(session);
+	if(!channel || channel->rtpCaps.empty()){
+		return NULL;
+	}
+	GstCaps * caps = gst_caps_from_string(channel->rtpCaps.c_str());
+	if(int(pt)==channel->payloadType+ofxGstRTPCodecs::RTX_PAYLOAD_TYPE_OFFSET){
+		gst_caps_set_simple(caps,"payload",G_TYPE_INT,int(pt),
+								 "encoding-name",G_TYPE_STRING,"RTX",
+								 "apt",G_TYPE_INT,channel->payloadType,
+								 NULL);
+	}else if(int(pt)==channel->payloadType+ofxGstRTPCodecs::FEC_PAYLOAD_TYPE_OFFSET){
+		gst_caps_set_simple(caps,"payload",G_TYPE_INT,int(pt),
+								 "encoding-name",G_TYPE_STRING,"ULPFEC",
+								 NULL);
+	}else if(int(pt)!=channel->payloadType){
+		gst_caps_unref(caps);
+		return NULL;
+	}
+	return caps;
+}
 
-	ofLogVerbose(LOG_NAME) << "new pad " << gst_object_get_name(GST_OBJECT(pad));
+GstPadProbeReturn ofxGstRTPClient::on_depay_event(GstPad * pad, GstPadProbeInfo * info, gpointer data){
+	// the jitterbuffer sends this event when it gives up on a packet,
+	// with retransmission that's after the NACKs failed
+	GstEvent * event = GST_PAD_PROBE_INFO_EVENT(info);
+	if(GST_EVENT_TYPE(event)==GST_EVENT_CUSTOM_DOWNSTREAM && gst_event_has_name(event,"GstRTPPacketLost")){
+		((Channel*)data)->keyFrameNeeded = true;
+	}
+	return GST_PAD_PROBE_OK;
+}
 
-	if(ofIsStringInString(padName,"recv_rtp_src_"+ofToString(rtpClient->videoSessionNumber))){
-		ofLogVerbose(LOG_NAME) << "video pad created";
-		rtpClient->linkVideoPad(pad);
+void ofxGstRTPClient::watchPacketLoss(Channel & channel){
+	GstPad * pad = gst_element_get_static_pad(channel.depay,"sink");
+	if(pad){
+		gst_pad_add_probe(pad,GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,&ofxGstRTPClient::on_depay_event,&channel,NULL);
+		gst_object_unref(pad);
+	}
+}
 
-	}else if(ofIsStringInString(padName,"recv_rtp_src_"+ofToString(rtpClient->audioSessionNumber))){
-		ofLogVerbose(LOG_NAME) << "audio pad created";
-		rtpClient->linkAudioPad(pad);
+bool ofxGstRTPClient::sampleStats(int session, ofxGstRTPStats & stats){
+	// called from the stats collector thread, the channels
+	// don't change while the collector is running
+	if(session<0 || session>=int(channels.size()) || !rtpbin){
+		return false;
+	}
+	Channel & channel = *channels[session];
+	guint ssrc = channel.ssrc;
+	if(ssrc==0){
+		return false;
+	}
 
-	}else if(ofIsStringInString(padName,"recv_rtp_src_"+ofToString(rtpClient->depthSessionNumber))){
-		ofLogVerbose(LOG_NAME) << "depth pad created";
-		rtpClient->linkDepthPad(pad);
+	int clockRate;
+	switch(channel.type){
+	case OFX_GST_RTP_VIDEO:
+	case OFX_GST_RTP_DEPTH:
+		clockRate = ofxGstRTPCodecs::VIDEO_CLOCK_RATE;
+		break;
+	case OFX_GST_RTP_AUDIO:
+		clockRate = ofxGstRTPCodecs::AUDIO_CLOCK_RATE;
+		break;
+	case OFX_GST_RTP_OSC:
+	default:
+		clockRate = ofxGstRTPCodecs::APPLICATION_CLOCK_RATE;
+		break;
+	}
 
-	}else if(ofIsStringInString(padName,"recv_rtp_src_"+ofToString(rtpClient->oscSessionNumber))){
-		ofLogVerbose(LOG_NAME) << "osc pad created";
-		rtpClient->linkOscPad(pad);
+	GObject * internalSession = NULL;
+	g_signal_emit_by_name(rtpbin,"get-internal-session",channel.session,&internalSession,NULL);
+	if(!internalSession){
+		ofLogError(LOG_NAME) << "couldn't get internal session " << channel.session;
+		return false;
 	}
-}
 
-void ofxGstRTPClient::linkAudioPad(GstPad * pad){
-	GstPad * sinkPad = gst_element_get_static_pad(opusdepay,"sink");
-	if(sinkPad){
-		if(gst_pad_link(pad,sinkPad)!=GST_PAD_LINK_OK){
-			ofLogError(LOG_NAME) << "couldn't link rtp source pad to audio depay";
-		}else{
-			ofLogVerbose(LOG_NAME) << "audio pipeline complete!";
-			audioReady = true;
+	// the remote source is the sender on the other side
+	GObject * remoteSource = NULL;
+	g_signal_emit_by_name(internalSession,"get-source-by-ssrc",ssrc,&remoteSource,NULL);
+	if(remoteSource){
+		GstStructure * sourceStats = NULL;
+		g_object_get(remoteSource,"stats",&sourceStats,NULL);
+		if(sourceStats){
+			guint64 bitrate = 0, packetsReceived = 0;
+			gint packetsLost = 0;
+			guint jitter = 0;
+			gst_structure_get(sourceStats,"bitrate",G_TYPE_UINT64,&bitrate,
+										  "packets-received",G_TYPE_UINT64,&packetsReceived,
+										  "packets-lost",G_TYPE_INT,&packetsLost,
+										  "jitter",G_TYPE_UINT,&jitter,
+										  NULL);
+			stats.bitrate = bitrate;
+			stats.packetsReceived = packetsReceived;
+			stats.packetsLost = packetsLost;
+			stats.jitter = jitter / double(clockRate);
+
+			// same as the fraction lost in a receiver report but between samples
+			gint64 expected = gint64(packetsReceived - channel.prevPacketsReceived) + (packetsLost - channel.prevPacketsLost);
+			if(expected>0){
+				stats.fractionLost = ofClamp(float(packetsLost - channel.prevPacketsLost) / expected, 0, 1);
+			}
+			channel.prevPacketsReceived = packetsReceived;
+			channel.prevPacketsLost = packetsLost;
+			gst_structure_free(sourceStats);
 		}
-	}else{
-		ofLogError(LOG_NAME) << "couldn't get sink pad for opus depay";
+		g_object_unref(remoteSource);
+	}
+	g_object_unref(internalSession);
+
+	GstElement * jitterbuffer = NULL;
+	GstElement * fecdec = NULL;
+	{
+		std::unique_lock<std::mutex> lock(jitterbuffersMutex);
+		if(channel.jitterbuffer){
+			jitterbuffer = (GstElement*)gst_object_ref(channel.jitterbuffer);
+		}
+		if(channel.fecdec){
+			fecdec = (GstElement*)gst_object_ref(channel.fecdec);
+		}
+	}
+	if(jitterbuffer){
+		GstStructure * jitterbufferStats = NULL;
+		g_object_get(jitterbuffer,"stats",&jitterbufferStats,NULL);
+		if(jitterbufferStats){
+			guint64 late = 0, lost = 0, duplicates = 0;
+			gst_structure_get(jitterbufferStats,"num-late",G_TYPE_UINT64,&late,
+												"num-lost",G_TYPE_UINT64,&lost,
+												"num-duplicates",G_TYPE_UINT64,&duplicates,
+												NULL);
+			guint64 rtxRequests = 0, rtxSuccess = 0;
+			gst_structure_get(jitterbufferStats,"rtx-count",G_TYPE_UINT64,&rtxRequests,
+												"rtx-success-count",G_TYPE_UINT64,&rtxSuccess,
+												NULL);
+			stats.jitterbufferLate = late;
+			stats.jitterbufferLost = lost;
+			stats.jitterbufferDuplicates = duplicates;
+			stats.retransmissionRequests = rtxRequests;
+			stats.retransmissions = rtxSuccess;
+			gst_structure_free(jitterbufferStats);
+		}
+		gst_object_unref(jitterbuffer);
+	}
+	if(fecdec){
+		guint recovered = 0, unrecovered = 0;
+		g_object_get(fecdec,"recovered",&recovered,"unrecovered",&unrecovered,NULL);
+		stats.fecRecovered = recovered;
+		stats.fecUnrecovered = unrecovered;
+		gst_object_unref(fecdec);
+	}
+
+	stats.keyframesRequested = channel.keyframesRequested;
+	if(channel.depth16){
+		stats.framesDecoded = channel.doubleBuffer16.getFramesDecoded();
+		stats.framesDropped = channel.doubleBuffer16.getFramesDropped();
+	}else if(channel.type==OFX_GST_RTP_OSC){
+		stats.framesDecoded = channel.doubleBufferOsc.getPacketsReceived() - channel.doubleBufferOsc.getPacketsDropped();
+		stats.framesDropped = channel.doubleBufferOsc.getPacketsDropped();
 	}
+	return true;
 }
 
-void ofxGstRTPClient::linkVideoPad(GstPad * pad){
-	GstPad * sinkPad = gst_element_get_static_pad(vh264depay,"sink");
-	if(sinkPad){
-		if(gst_pad_link(pad,sinkPad)!=GST_PAD_LINK_OK){
-			ofLogError(LOG_NAME) << "couldn't link rtp source pad to video depay";
-		}else{
-			ofLogVerbose(LOG_NAME) << "video pipeline complete!";
-			videoReady = true;
+ofxGstRTPStats ofxGstRTPClient::getStats(ofxGstRTPChannel type, int channel){
+	Channel * c = type==OFX_GST_RTP_VIDEO ? getActiveVideoLayer(channel) : getChannel(type,channel);
+	if(!c){
+		return ofxGstRTPStats();
+	}
+	return statsCollector.getStats(c->session);
+}
 
-			int currentLatency = latency;
-			latencyChanged(currentLatency);
-		}
-	}else{
-		ofLogError(LOG_NAME) << "couldn't get sink pad for video depay";
+ofxGstRTPStats ofxGstRTPClient::getVideoLayerStats(int layer, int channel){
+	Channel * c = getVideoLayer(channel,layer);
+	if(!c){
+		return ofxGstRTPStats();
 	}
+	return statsCollector.getStats(c->session);
 }
 
-void ofxGstRTPClient::linkDepthPad(GstPad * pad){
-	GstPad * sinkPad = gst_element_get_static_pad(depthdepay,"sink");
-	if(sinkPad){
-		if(gst_pad_link(pad,sinkPad)!=GST_PAD_LINK_OK){
-			ofLogError(LOG_NAME) << "couldn't link rtp source pad to depth depay";
-		}else{
-			ofLogVerbose(LOG_NAME) << "depth pipeline complete!";
-			depthReady = true;
+void ofxGstRTPClient::getStatsHistory(ofxGstRTPChannel type, vector<ofxGstRTPStats> & history, int channel){
+	Channel * c = type==OFX_GST_RTP_VIDEO ? getActiveVideoLayer(channel) : getChannel(type,channel);
+	if(!c){
+		history.clear();
+		return;
+	}
+	statsCollector.getHistory(c->session,history);
+}
+
+void ofxGstRTPClient::setStatsSettings(int intervalMs, int historySize){
+	statsInterval = max(1,intervalMs);
+	statsHistorySize = max(1,historySize);
+}
+
+
+void ofxGstRTPClient::on_pad_added(GstBin *rtpbin, GstPad *pad, ofxGstRTPClient * rtpClient){
+	// when a pad is added to the rtbbin, connect it to the elements of the
+	// channel with the same session. the pads are named recv_rtp_src_session_ssrc_pt
+	// so we match the full session number to not confuse session 1 with 10...
+	string padName = gst_object_get_name(GST_OBJECT(pad));
 
-			int currentLatency = latency;
-			latencyChanged(currentLatency);
+	ofLogVerbose(LOG_NAME) << "new pad " << padName;
+
+	for(size_t i=0;i<rtpClient->channels.size();i++){
+		Channel & channel = *rtpClient->channels[i];
+		string prefix = "recv_rtp_src_" + ofToString(channel.session) + "_";
+		if(padName.compare(0,prefix.size(),prefix)==0){
+			ofLogVerbose(LOG_NAME) << channel.getElementName("") << " pad created";
+			// remember the ssrc of the remote sender so the stats collector
+			// can query its source. The retransmissions have an ssrc of their
+			// own which would give the stats of the rtx stream instead
+			unsigned int ssrc, pt;
+			if(sscanf(padName.c_str()+prefix.size(),"%u_%u",&ssrc,&pt)==2
+					&& int(pt)!=channel.payloadType+ofxGstRTPCodecs::RTX_PAYLOAD_TYPE_OFFSET){
+				channel.ssrc = ssrc;
+			}
+			rtpClient->linkPad(channel,pad);
+			return;
 		}
-	}else{
-		ofLogError(LOG_NAME) << "couldn't get sink pad for depth depay";
 	}
 }
 
-
-void ofxGstRTPClient::linkOscPad(GstPad * pad){
-	GstPad * sinkPad = gst_element_get_static_pad(gstdepay,"sink");
+void ofxGstRTPClient::linkPad(Channel & channel, GstPad * pad){
+	GstPad * sinkPad = gst_element_get_static_pad(channel.depay,"sink");
 	if(sinkPad){
 		if(gst_pad_link(pad,sinkPad)!=GST_PAD_LINK_OK){
-			ofLogError(LOG_NAME) << "couldn't link rtp source pad to osc depay";
+			ofLogError(LOG_NAME) << "couldn't link rtp source pad to " << channel.getElementName("depay");
 		}else{
-			ofLogVerbose(LOG_NAME) << "osc pipeline complete!";
-			oscReady = true;
+			ofLogVerbose(LOG_NAME) << channel.getElementName("") << " pipeline complete!";
+			channel.ready = true;
+
+			if(channel.type==OFX_GST_RTP_VIDEO || channel.type==OFX_GST_RTP_DEPTH){
+				int currentLatency = latency;
+				latencyChanged(currentLatency);
+			}
 		}
+		gst_object_unref(sinkPad);
 	}else{
-		ofLogError(LOG_NAME) << "couldn't get sink pad for osc depay";
+		ofLogError(LOG_NAME) << "couldn't get sink pad for " << channel.getElementName("depay");
 	}
 }
 
@@ -380,12 +800,31 @@ void ofxGstRTPClient::createNetworkElements(NetworkElementsProperties properties
 	}
 }
 
-
-void ofxGstRTPClient::createVideoChannel(string rtpCaps){
-	videoSessionNumber = lastSessionNumber;
-	lastSessionNumber++;
+void ofxGstRTPClient::createNetworkElements(Channel & channel, const string & rtpCaps, int port){
+	channel.rtpCaps = rtpCaps;
+	NetworkElementsProperties properties;
+	properties.capsstr = rtpCaps;
+	properties.capsfiltername = channel.getElementName("capsfilter");
+	properties.source = &channel.rtpsrc;
+	properties.rtpcsource = &channel.rtcpsrc;
+	properties.rtpcsink = &channel.rtcpsink;
+	properties.port = port;
+	properties.rtpcsrcport = port+1;
+	properties.rtpcsinkport = port+3;
+	properties.srcIP = src;
+	properties.sessionNumber = channel.session;
+	properties.sourceName = channel.getElementName("rtpsrc");
+	properties.rtpcSourceName = channel.getElementName("rtcpsrc");
+	properties.rtpcSinkName = channel.getElementName("rtcpsink");
+#if ENABLE_NAT_TRANSVERSAL
+	createNetworkElements(properties,channel.niceStream);
+#else
+	createNetworkElements(properties,NULL);
+#endif
+}
 
 
+void ofxGstRTPClient::createVideoChannel(Channel & channel, string rtpCaps, ofxGstRTPVideoCodec codec){
 	// create and add video and depth elements and connect them to the correct pad.
 	// if we don't do this after the pad has been created when the connection is detected,
 	// gstreamer tries to link this elements by their capabilities and
@@ -393,12 +832,24 @@ void ofxGstRTPClient::createVideoChannel(string rtpCaps){
 	// and viceversa
 
 	// rgb pipeline to be connected to the corresponding recv_rtp_send pad:
-	// rtph264depay ! avdec_h264 ! videoconvert ! appsink
-	vh264depay = gst_element_factory_make("rtph264depay","rtph264depay_video");
-
-	GstElement * avdec_h264 = gst_element_factory_make("avdec_h264","avdec_h264_video");
-	GstElement * vconvert = gst_element_factory_make("videoconvert","vconvert");
-	videoSink = (GstAppSink*)gst_element_factory_make("appsink","videosink");
+	// depay ! decoder ! videoconvert ! appsink
+	// where depay and decoder depend on the codec, eg: rtph264depay ! avdec_h264
+	channel.depay = gst_element_factory_make(ofxGstRTPCodecs::getVideoDepayloader(codec).c_str(),channel.getElementName("depay").c_str());
+	GstElement * decoder = gst_element_factory_make(ofxGstRTPCodecs::getVideoDecoder(codec).c_str(),channel.getElementName("decoder").c_str());
+	if(!channel.depay || !decoder){
+		ofLogError(LOG_NAME) << "couldn't create video depayloader or decoder for " << ofxGstRTPCodecs::getEncodingName(codec);
+	}else{
+		watchPacketLoss(channel);
+	}
+	GstElement * vconvert = gst_element_factory_make("videoconvert",channel.getElementName("convert").c_str());
+	channel.sink = (GstAppSink*)gst_element_factory_make("appsink",channel.getElementName("sink").c_str());
+
+	// simulcast layers have a valve before the decoder so only the one
+	// being shown is decoded, the first one starts open
+	if(channel.numLayers>1){
+		channel.valve = gst_element_factory_make("valve",channel.getElementName("valve").c_str());
+		g_object_set(G_OBJECT(channel.valve),"drop",channel.layer!=0,NULL);
+	}
 
 	// set format for video appsink to rgb
 	GstCaps * caps = NULL;
@@ -409,29 +860,33 @@ void ofxGstRTPClient::createVideoChannel(string rtpCaps){
 	if(!caps){
 		ofLogError(LOG_NAME) << "couldn't get caps";
 	}else{
-		gst_app_sink_set_caps(videoSink,caps);
+		gst_app_sink_set_caps(channel.sink,caps);
 		gst_caps_unref(caps);
 	}
 
 	// set callbacks to receive rgb data
 	GstAppSinkCallbacks gstCallbacks;
-	gstCallbacks.eos = &ofxGstRTPClient::on_eos_from_video;
-	gstCallbacks.new_preroll = &ofxGstRTPClient::on_new_preroll_from_video;
+	gstCallbacks.eos = &ofxGstRTPClient::on_eos_from_sink;
+	gstCallbacks.new_preroll = &ofxGstRTPClient::on_new_preroll_from_sink;
 	gstCallbacks.new_sample = &ofxGstRTPClient::on_new_buffer_from_video;
-	gst_app_sink_set_callbacks(GST_APP_SINK(videoSink), &gstCallbacks, this, NULL);
-	gst_app_sink_set_emit_signals(GST_APP_SINK(videoSink),0);
+	gst_app_sink_set_callbacks(GST_APP_SINK(channel.sink), &gstCallbacks, &channel, NULL);
+	gst_app_sink_set_emit_signals(GST_APP_SINK(channel.sink),0);
 
 	// add elements to the pipeline and link them (but not yet to the rtpbin)
-	gst_bin_add_many(GST_BIN(pipeline), vh264depay, avdec_h264, vconvert, videoSink, NULL);
-	if(!gst_element_link_many(vh264depay, avdec_h264, vconvert, videoSink, NULL)){
-		ofLogError(LOG_NAME) << "couldn't link video elements";
+	if(channel.valve){
+		gst_bin_add_many(GST_BIN(pipeline), channel.depay, channel.valve, decoder, vconvert, channel.sink, NULL);
+		if(!gst_element_link_many(channel.depay, channel.valve, decoder, vconvert, channel.sink, NULL)){
+			ofLogError(LOG_NAME) << "couldn't link video elements";
+		}
+	}else{
+		gst_bin_add_many(GST_BIN(pipeline), channel.depay, decoder, vconvert, channel.sink, NULL);
+		if(!gst_element_link_many(channel.depay, decoder, vconvert, channel.sink, NULL)){
+			ofLogError(LOG_NAME) << "couldn't link video elements";
+		}
 	}
 }
 
-void ofxGstRTPClient::createAudioChannel(string rtpCaps){
-	audioSessionNumber = lastSessionNumber;
-	lastSessionNumber++;
-
+void ofxGstRTPClient::createAudioChannel(Channel & channel, string rtpCaps){
 	// create and add audio elements and connect them to the correct pad.
 	// audio pipeline to be connected to the corresponding recv_rtp_send pad:
 	// Linux:
@@ -439,7 +894,7 @@ void ofxGstRTPClient::createAudioChannel(string rtpCaps){
 	// everything else:
 	// rtpopusdepay ! opusdec ! audioconvert ! audioresample ! autoaudiosink
 
-	opusdepay = gst_element_factory_make("rtpopusdepay","rtpopusdepay1");
+	channel.depay = gst_element_factory_make("rtpopusdepay","rtpopusdepay1");
 	GstElement * opusdec = gst_element_factory_make("opusdec","opusdec1");
 	GstElement * audioconvert = gst_element_factory_make("audioconvert","audioconvert1");
 	GstElement * audioresample = gst_element_factory_make("audioresample","audioresample1");
@@ -501,8 +956,8 @@ void ofxGstRTPClient::createAudioChannel(string rtpCaps){
 		gst_app_sink_set_emit_signals(GST_APP_SINK(audioechosink),0);
 
 		// add elements to the pipeline and link them (but not yet to the rtpbin)
-		gst_bin_add_many(GST_BIN(pipeline), opusdepay, opusdec, audioconvert, audioresample, audioechosink, NULL);
-		if(!gst_element_link_many(opusdepay, opusdec, audioconvert, audioresample, audioechosink, NULL)){
+		gst_bin_add_many(GST_BIN(pipeline), channel.depay, opusdec, audioconvert, audioresample, audioechosink, NULL);
+		if(!gst_element_link_many(channel.depay, opusdec, audioconvert, audioresample, audioechosink, NULL)){
 			ofLogError(LOG_NAME) << "couldn't link audio elements";
 		}
 
@@ -515,8 +970,8 @@ void ofxGstRTPClient::createAudioChannel(string rtpCaps){
 #endif
 	{
 		// add elements to the pipeline and link them (but not yet to the rtpbin)
-		gst_bin_add_many(GST_BIN(pipeline), opusdepay, opusdec, audioconvert, audioresample, audiosink, NULL);
-		if(!gst_element_link_many(opusdepay, opusdec, audioconvert, audioresample, audiosink, NULL)){
+		gst_bin_add_many(GST_BIN(pipeline), channel.depay, opusdec, audioconvert, audioresample, audiosink, NULL);
+		if(!gst_element_link_many(channel.depay, opusdec, audioconvert, audioresample, audiosink, NULL)){
 			ofLogError(LOG_NAME) << "couldn't link audio elements";
 		}
 	}
@@ -524,23 +979,24 @@ void ofxGstRTPClient::createAudioChannel(string rtpCaps){
 
 }
 
-void ofxGstRTPClient::createDepthChannel(string rtpCaps, bool depth16){
-	depthSessionNumber = lastSessionNumber;
-	lastSessionNumber++;
-
-	this->depth16 = depth16;
+void ofxGstRTPClient::createDepthChannel(Channel & channel, string rtpCaps, bool depth16, ofxGstRTPVideoCodec codec){
+	channel.depth16 = depth16;
 
 
 	// create and add depth elements and connect them to the correct pad.
 	// depth pipeline to be connected to the corresponding recv_rtp_send pad:
-	// rtph264depay ! avdec_h264 ! videoconvert ! appsink
+	// depay ! decoder ! videoconvert ! appsink
 
 	if(!depth16){
-		depthdepay = gst_element_factory_make("rtph264depay","rtph264depay_depth");
-
-		GstElement * avdec_h264 = gst_element_factory_make("avdec_h264","avdec_h264_depth");
-		GstElement * vconvert = gst_element_factory_make("videoconvert","dconvert");
-		depthSink = (GstAppSink*)gst_element_factory_make("appsink","depthsink");
+		channel.depay = gst_element_factory_make(ofxGstRTPCodecs::getVideoDepayloader(codec).c_str(),channel.getElementName("depay").c_str());
+		GstElement * decoder = gst_element_factory_make(ofxGstRTPCodecs::getVideoDecoder(codec).c_str(),channel.getElementName("decoder").c_str());
+		if(!channel.depay || !decoder){
+			ofLogError(LOG_NAME) << "couldn't create depth depayloader or decoder for " << ofxGstRTPCodecs::getEncodingName(codec);
+		}else{
+			watchPacketLoss(channel);
+		}
+		GstElement * vconvert = gst_element_factory_make("videoconvert",channel.getElementName("convert").c_str());
+		channel.sink = (GstAppSink*)gst_element_factory_make("appsink",channel.getElementName("sink").c_str());
 
 		// set format for depth appsink to gray 8bits
 		GstCaps * caps = gst_caps_new_simple("video/x-raw",
@@ -549,29 +1005,29 @@ void ofxGstRTPClient::createDepthChannel(string rtpCaps, bool depth16){
 		if(!caps){
 			ofLogError(LOG_NAME) << "couldn't get caps";
 		}else{
-			gst_app_sink_set_caps(depthSink,caps);
+			gst_app_sink_set_caps(channel.sink,caps);
 			gst_caps_unref(caps);
 		}
 
 		// set callbacks to receive depth data
 		GstAppSinkCallbacks gstCallbacks;
-		gstCallbacks.eos = &ofxGstRTPClient::on_eos_from_depth;
-		gstCallbacks.new_preroll = &ofxGstRTPClient::on_new_preroll_from_depth;
+		gstCallbacks.eos = &ofxGstRTPClient::on_eos_from_sink;
+		gstCallbacks.new_preroll = &ofxGstRTPClient::on_new_preroll_from_sink;
 		gstCallbacks.new_sample = &ofxGstRTPClient::on_new_buffer_from_depth;
-		gst_app_sink_set_callbacks(GST_APP_SINK(depthSink), &gstCallbacks, this, NULL);
-		gst_app_sink_set_emit_signals(GST_APP_SINK(depthSink),0);
+		gst_app_sink_set_callbacks(GST_APP_SINK(channel.sink), &gstCallbacks, &channel, NULL);
+		gst_app_sink_set_emit_signals(GST_APP_SINK(channel.sink),0);
 
 		// add elements to the pipeline and link them (but not yet to the rtpbin)
-		gst_bin_add_many(GST_BIN(pipeline), depthdepay, avdec_h264, vconvert, depthSink, NULL);
-		if(!gst_element_link_many(depthdepay, avdec_h264, vconvert, depthSink, NULL)){
+		gst_bin_add_many(GST_BIN(pipeline), channel.depay, decoder, vconvert, channel.sink, NULL);
+		if(!gst_element_link_many(channel.depay, decoder, vconvert, channel.sink, NULL)){
 			ofLogError(LOG_NAME) << "couldn't link depth elements";
 		}
 	}else{
-		depthdepay = gst_element_factory_make("rtpgstdepay","rtpgstdepay_depth");
-		depthSink = (GstAppSink*)gst_element_factory_make("appsink","depthsink");
+		channel.depay = gst_element_factory_make("rtpgstdepay",channel.getElementName("depay").c_str());
+		channel.sink = (GstAppSink*)gst_element_factory_make("appsink",channel.getElementName("sink").c_str());
 
 
-		// set format for depth appsink to osc
+		// set format for depth appsink to compressed depth
 		GstCaps * caps;
 
 		caps = gst_caps_new_empty_simple("application/x-compresseddepth");
@@ -579,42 +1035,38 @@ void ofxGstRTPClient::createDepthChannel(string rtpCaps, bool depth16){
 		if(!caps){
 			ofLogError(LOG_NAME) << "couldn't get caps";
 		}else{
-			gst_app_sink_set_caps(depthSink,caps);
+			gst_app_sink_set_caps(channel.sink,caps);
 			gst_caps_unref(caps);
 		}
 
 
-		// set callbacks to receive osc data
+		// set callbacks to receive depth data
 		GstAppSinkCallbacks gstCallbacks;
-		gstCallbacks.eos = &ofxGstRTPClient::on_eos_from_depth;
-		gstCallbacks.new_preroll = &ofxGstRTPClient::on_new_preroll_from_depth;
+		gstCallbacks.eos = &ofxGstRTPClient::on_eos_from_sink;
+		gstCallbacks.new_preroll = &ofxGstRTPClient::on_new_preroll_from_sink;
 		gstCallbacks.new_sample = &ofxGstRTPClient::on_new_buffer_from_depth;
-		gst_app_sink_set_callbacks(GST_APP_SINK(depthSink), &gstCallbacks, this, NULL);
-		gst_app_sink_set_emit_signals(GST_APP_SINK(depthSink),0);
+		gst_app_sink_set_callbacks(GST_APP_SINK(channel.sink), &gstCallbacks, &channel, NULL);
+		gst_app_sink_set_emit_signals(GST_APP_SINK(channel.sink),0);
 
 		// add elements to the pipeline and link them (but not yet to the rtpbin)
-		gst_bin_add_many(GST_BIN(pipeline), depthdepay, depthSink, NULL);
-		if(!gst_element_link_many(depthdepay, GST_ELEMENT(depthSink), NULL)){
+		gst_bin_add_many(GST_BIN(pipeline), channel.depay, channel.sink, NULL);
+		if(!gst_element_link_many(channel.depay, GST_ELEMENT(channel.sink), NULL)){
 			ofLogError(LOG_NAME) << "couldn't link depth16 elements";
 		}
 
 	}
 }
 
-void ofxGstRTPClient::createOscChannel(string rtpCaps){
-
-	oscSessionNumber = lastSessionNumber;
-	lastSessionNumber++;
-
-
+void ofxGstRTPClient::createOscChannel(Channel & channel, string rtpCaps){
 	// create and add osc elements and connect them to the correct pad.
 	// osc pipeline to be connected to the corresponding recv_rtp_send pad:
 	// rtpgstdepay ! appsink
-	gstdepay = gst_element_factory_make("rtpgstdepay","rtpgstdepay_osc");
-	oscSink = (GstAppSink*)gst_element_factory_make("appsink","oscsink");
+	channel.depay = gst_element_factory_make("rtpgstdepay",channel.getElementName("depay").c_str());
+	channel.sink = (GstAppSink*)gst_element_factory_make("appsink",channel.getElementName("sink").c_str());
+	channel.doubleBufferOsc.setup(oscQueueCapacity);
 
 
-	// set format for depth appsink to osc
+	// set format for osc appsink to osc
 	GstCaps * caps;
 
 	caps = gst_caps_new_empty_simple("application/x-osc");
@@ -622,59 +1074,62 @@ void ofxGstRTPClient::createOscChannel(string rtpCaps){
 	if(!caps){
 		ofLogError(LOG_NAME) << "couldn't get caps";
 	}else{
-		gst_app_sink_set_caps(oscSink,caps);
+		gst_app_sink_set_caps(channel.sink,caps);
 		gst_caps_unref(caps);
 	}
 
 
 	// set callbacks to receive osc data
 	GstAppSinkCallbacks gstCallbacks;
-	gstCallbacks.eos = &ofxGstRTPClient::on_eos_from_osc;
-	gstCallbacks.new_preroll = &ofxGstRTPClient::on_new_preroll_from_osc;
+	gstCallbacks.eos = &ofxGstRTPClient::on_eos_from_sink;
+	gstCallbacks.new_preroll = &ofxGstRTPClient::on_new_preroll_from_sink;
 	gstCallbacks.new_sample = &ofxGstRTPClient::on_new_buffer_from_osc;
-	gst_app_sink_set_callbacks(GST_APP_SINK(oscSink), &gstCallbacks, this, NULL);
-	gst_app_sink_set_emit_signals(GST_APP_SINK(oscSink),0);
+	gst_app_sink_set_callbacks(GST_APP_SINK(channel.sink), &gstCallbacks, &channel, NULL);
+	gst_app_sink_set_emit_signals(GST_APP_SINK(channel.sink),0);
 
 	// add elements to the pipeline and link them (but not yet to the rtpbin)
-	gst_bin_add_many(GST_BIN(pipeline), gstdepay, oscSink, NULL);
-	if(!gst_element_link_many(gstdepay, GST_ELEMENT(oscSink), NULL)){
+	gst_bin_add_many(GST_BIN(pipeline), channel.depay, channel.sink, NULL);
+	if(!gst_element_link_many(channel.depay, GST_ELEMENT(channel.sink), NULL)){
 		ofLogError(LOG_NAME) << "couldn't link osc elements";
 	}
 }
 
-void ofxGstRTPClient::addVideoChannel(int port){
+int ofxGstRTPClient::addVideoChannel(int port, ofxGstRTPVideoCodec codec, int numLayers){
+	numLayers = max(1,min(3,numLayers));
+#if ENABLE_NAT_TRANSVERSAL
+	if(nextNiceStream && numLayers>1){
+		ofLogError(LOG_NAME) << "simulcast layers are only supported through udp, receiving only one";
+		numLayers = 1;
+	}
+#endif
 
 	// the caps of the sender RTP stream.
 	// FIXME: This is usually negotiated out of band with
 	// SDP or RTSP. normally these caps will also include SPS and PPS but we don't
 	// have that yet
-	string vcaps="application/x-rtp,media=(string)video,clock-rate=(int)90000,payload=(int)96,encoding-name=(string)H264,rtcp-fb-nack-pli=(int)1";
-
-	createVideoChannel(vcaps);
-
-	GstElement * rtcpsink;
-	NetworkElementsProperties properties;
-	properties.capsstr = vcaps;
-	properties.source = &vudpsrc;
-	properties.rtpcsource = &vudpsrcrtcp;
-	properties.rtpcsink = &rtcpsink;
-	properties.port = port;
-	properties.rtpcsrcport = port+1;
-	properties.rtpcsinkport = port+3;
-	properties.srcIP = src;
-	properties.sessionNumber = videoSessionNumber;
-	properties.sourceName = "vrtpsrc";
-	properties.rtpcSourceName = "vrtcpsrc";
-	properties.rtpcSinkName = "vrtcpsink";
-#if ENABLE_NAT_TRANSVERSAL
-	createNetworkElements(properties,shared_ptr<ofxNiceStream>());
-#else
-	createNetworkElements(properties,NULL);
-#endif
-
+	string vcaps=ofxGstRTPCodecs::getVideoRTPCaps(codec,ofxGstRTPCodecs::VIDEO_PAYLOAD_TYPE);
+
+	Channel & channel = createChannel(OFX_GST_RTP_VIDEO);
+	channel.numLayers = numLayers;
+	createVideoChannel(channel,vcaps,codec);
+	createNetworkElements(channel,vcaps,port);
+
+	// every layer is received in its own session, the same as the server
+	// sends them, layer n on port + 5*n
+	for(int i=1;i<numLayers;i++){
+		Channel & layer = createLayerChannel(channel,i);
+		createVideoChannel(layer,vcaps,codec);
+		createNetworkElements(layer,vcaps,port+i*5);
+	}
+	return channel.index;
 }
 
-void ofxGstRTPClient::addDepthChannel(int port, bool depth16){
+int ofxGstRTPClient::addDepthChannel(int port, bool depth16, ofxGstRTPVideoCodec codec){
+	// packed 16bits depth arrives as 8bits depth
+	bool packed = depth16 && depth16Packed;
+	if(packed){
+		depth16 = false;
+	}
 
 	// the caps of the sender RTP stream.
 	// FIXME: This is usually negotiated out of band with
@@ -682,213 +1137,77 @@ void ofxGstRTPClient::addDepthChannel(int port, bool depth16){
 	// have that yet
 	string dcaps;
 	if(!depth16){
-		dcaps="application/x-rtp,media=(string)video,clock-rate=(int)90000,payload=(int)98,encoding-name=(string)H264,rtcp-fb-nack-pli=(int)1";
+		dcaps=ofxGstRTPCodecs::getVideoRTPCaps(codec,ofxGstRTPCodecs::DEPTH_PAYLOAD_TYPE);
 	}else{
-		dcaps="application/x-rtp,media=(string)application,clock-rate=(int)90000,payload=(int)98,encoding-name=(string)X-GST,caps=(string)\"YXBwbGljYXRpb24veC1vc2M\\=\"";
+		dcaps=ofxGstRTPCodecs::getDepth16RTPCaps(ofxGstRTPCodecs::DEPTH_PAYLOAD_TYPE);
 	}
 
-	createDepthChannel(dcaps,depth16);
-
+	Channel & channel = createChannel(OFX_GST_RTP_DEPTH);
+	createDepthChannel(channel,dcaps,depth16,codec);
+	createNetworkElements(channel,dcaps,port);
+	if(packed){
+		channel.depth16Packed = true;
+		channel.depthPacker.setup(depth16MaxDepth);
+	}
+	return channel.index;
+}
 
-	GstElement * rtcpsink;
-	NetworkElementsProperties properties;
-	properties.capsstr = dcaps;
-	properties.source = &dudpsrc;
-	properties.rtpcsource = &dudpsrcrtcp;
-	properties.rtpcsink = &rtcpsink;
-	properties.port = port;
-	properties.rtpcsrcport = port+1;
-	properties.rtpcsinkport = port+3;
-	properties.srcIP = src;
-	properties.sessionNumber = depthSessionNumber;
-	properties.sourceName = "drtpsrc";
-	properties.rtpcSourceName = "drtcpsrc";
-	properties.rtpcSinkName = "drtcpsink";
+int ofxGstRTPClient::addAudioChannel(int port){
+	// the audio channel plays through the default output and feeds the
+	// echo canceller so there can only be one
+	if(!channelsByType[OFX_GST_RTP_AUDIO].empty()){
+		ofLogError(LOG_NAME) << "only one audio channel is supported";
 #if ENABLE_NAT_TRANSVERSAL
-	createNetworkElements(properties,shared_ptr<ofxNiceStream>());
-#else
-	createNetworkElements(properties,NULL);
+		nextNiceStream.reset();
 #endif
-
-}
-
-void ofxGstRTPClient::addAudioChannel(int port){
+		return -1;
+	}
 
 	// the caps of the sender RTP stream.
 	// FIXME: This is usually negotiated out of band with
 	// SDP or RTSP. normally these caps will also include SPS and PPS but we don't
 	// have that yet
-	string acaps="application/x-rtp,media=(string)audio,clock-rate=(int)48000,payload=(int)97,encoding-name=(string)X-GST-OPUS-DRAFT-SPITTKA-00";
-
-	createAudioChannel(acaps);
-
-	GstElement * rtcpsink;
-	NetworkElementsProperties properties;
-	properties.capsstr = acaps;
-	properties.source = &audpsrc;
-	properties.rtpcsource = &audpsrcrtcp;
-	properties.rtpcsink = &rtcpsink;
-	properties.port = port;
-	properties.rtpcsrcport = port+1;
-	properties.rtpcsinkport = port+3;
-	properties.srcIP = src;
-	properties.sessionNumber = audioSessionNumber;
-	properties.sourceName = "artpsrc";
-	properties.rtpcSourceName = "artcpsrc";
-	properties.rtpcSinkName = "artcpsink";
-#if ENABLE_NAT_TRANSVERSAL
-	createNetworkElements(properties,shared_ptr<ofxNiceStream>());
-#else
-	createNetworkElements(properties,NULL);
-#endif
+	string acaps=ofxGstRTPCodecs::getAudioRTPCaps(ofxGstRTPCodecs::AUDIO_PAYLOAD_TYPE);
 
+	Channel & channel = createChannel(OFX_GST_RTP_AUDIO);
+	createAudioChannel(channel,acaps);
+	createNetworkElements(channel,acaps,port);
+	return channel.index;
 }
 
-void ofxGstRTPClient::addOscChannel(int port){
+int ofxGstRTPClient::addOscChannel(int port){
 
 	// the caps of the sender RTP stream.
 	// FIXME: This is usually negotiated out of band with
 	// SDP or RTSP. normally these caps will also include SPS and PPS but we don't
 	// have that yet
-	string ocaps="application/x-rtp,media=(string)application,clock-rate=(int)90000,payload=(int)99,encoding-name=(string)X-GST,caps=(string)\"YXBwbGljYXRpb24veC1vc2M\\=\"";
-
-	createOscChannel(ocaps);
-
-	GstElement * rtcpsink;
-	NetworkElementsProperties properties;
-	properties.capsstr = ocaps;
-	properties.source = &oudpsrc;
-	properties.rtpcsource = &oudpsrcrtcp;
-	properties.rtpcsink = &rtcpsink;
-	properties.port = port;
-	properties.rtpcsrcport = port+1;
-	properties.rtpcsinkport = port+3;
-	properties.srcIP = src;
-	properties.sessionNumber = oscSessionNumber;
-	properties.sourceName = "ortpsrc";
-	properties.rtpcSourceName = "ortcpsrc";
-	properties.rtpcSinkName = "ortcpsink";
-#if ENABLE_NAT_TRANSVERSAL
-	createNetworkElements(properties,shared_ptr<ofxNiceStream>());
-#else
-	createNetworkElements(properties,NULL);
-#endif
+	string ocaps=ofxGstRTPCodecs::getOscRTPCaps(ofxGstRTPCodecs::OSC_PAYLOAD_TYPE);
 
+	Channel & channel = createChannel(OFX_GST_RTP_OSC);
+	createOscChannel(channel,ocaps);
+	createNetworkElements(channel,ocaps,port);
+	return channel.index;
 }
 
 #if ENABLE_NAT_TRANSVERSAL
-void ofxGstRTPClient::addVideoChannel(shared_ptr<ofxNiceStream> niceStream){
-	videoStream = niceStream;
-
-	// the caps of the sender RTP stream.
-	// FIXME: This is usually negotiated out of band with
-	// SDP or RTSP. normally these caps will also include SPS and PPS but we don't
-	// have that yet
-	string vcaps="application/x-rtp,media=(string)video,clock-rate=(int)90000,payload=(int)96,encoding-name=(string)H264,rtcp-fb-nack-pli=(int)1 ";
-
-	createVideoChannel(vcaps);
-
-	GstElement * rtcpsink;
-	NetworkElementsProperties properties;
-	properties.capsstr = vcaps;
-	properties.capsfiltername = "vcapsfilter";
-	properties.source = &vudpsrc;
-	properties.rtpcsource = &vudpsrcrtcp;
-	properties.rtpcsink = &rtcpsink;
-	properties.srcIP = src;
-	properties.sessionNumber = videoSessionNumber;
-	properties.sourceName = "vrtpsrc";
-	properties.rtpcSourceName = "vrtcpsrc";
-	properties.rtpcSinkName = "vrtcpsink";
-	createNetworkElements(properties,niceStream);
-
+int ofxGstRTPClient::addVideoChannel(shared_ptr<ofxNiceStream> niceStream, ofxGstRTPVideoCodec codec){
+	nextNiceStream = niceStream;
+	return addVideoChannel(0,codec);
 }
 
-void ofxGstRTPClient::addAudioChannel(shared_ptr<ofxNiceStream> niceStream){
-	audioStream = niceStream;
-
-	// the caps of the sender RTP stream.
-	// FIXME: This is usually negotiated out of band with
-	// SDP or RTSP. normally these caps will also include SPS and PPS but we don't
-	// have that yet
-	string acaps="application/x-rtp,media=(string)audio,clock-rate=(int)48000,payload=(int)98,encoding-name=(string)X-GST-OPUS-DRAFT-SPITTKA-00";
-
-	createAudioChannel(acaps);
-
-	GstElement * rtcpsink;
-	NetworkElementsProperties properties;
-	properties.capsstr = acaps;
-	properties.capsfiltername = "acapsfilter";
-	properties.source = &audpsrc;
-	properties.rtpcsource = &audpsrcrtcp;
-	properties.rtpcsink = &rtcpsink;
-	properties.srcIP = src;
-	properties.sessionNumber = audioSessionNumber;
-	properties.sourceName = "artpsrc";
-	properties.rtpcSourceName = "artcpsrc";
-	properties.rtpcSinkName = "artcpsink";
-	createNetworkElements(properties, niceStream);
+int ofxGstRTPClient::addAudioChannel(shared_ptr<ofxNiceStream> niceStream){
+	nextNiceStream = niceStream;
+	return addAudioChannel(0);
 }
 
-void ofxGstRTPClient::addDepthChannel(shared_ptr<ofxNiceStream> niceStream, bool depth16){
-	depthStream = niceStream;
-
-	// the caps of the sender RTP stream.
-	// FIXME: This is usually negotiated out of band with
-	// SDP or RTSP. normally these caps will also include SPS and PPS but we don't
-	// have that yet
-	string dcaps;
-	if(!depth16){
-		dcaps="application/x-rtp,media=(string)video,clock-rate=(int)90000,payload=(int)97,encoding-name=(string)H264,rtcp-fb-nack-pli=(int)1";
-	}else{
-		dcaps="application/x-rtp,media=(string)application,clock-rate=(int)90000,payload=(int)97,encoding-name=(string)X-GST,caps=(string)\"YXBwbGljYXRpb24veC1jb21wcmVzc2VkZGVwdGg\\=\"";
-	}
-
-
-	createDepthChannel(dcaps,depth16);
-
-	GstElement * rtcpsink;
-	NetworkElementsProperties properties;
-	properties.capsstr = dcaps;
-	properties.capsfiltername = "dcapsfilter";
-	properties.source = &dudpsrc;
-	properties.rtpcsource = &dudpsrcrtcp;
-	properties.rtpcsink = &rtcpsink;
-	properties.srcIP = src;
-	properties.sessionNumber = depthSessionNumber;
-	properties.sourceName = "drtpsrc";
-	properties.rtpcSourceName = "drtcpsrc";
-	properties.rtpcSinkName = "drtcpsink";
-	createNetworkElements(properties, niceStream);
-
+int ofxGstRTPClient::addDepthChannel(shared_ptr<ofxNiceStream> niceStream, bool depth16, ofxGstRTPVideoCodec codec){
+	nextNiceStream = niceStream;
+	return addDepthChannel(0,depth16,codec);
 }
 
-void ofxGstRTPClient::addOscChannel(shared_ptr<ofxNiceStream> niceStream){
-	oscStream = niceStream;
-
-	// the caps of the sender RTP stream.
-	// FIXME: This is usually negotiated out of band with
-	// SDP or RTSP. normally these caps will also include SPS and PPS but we don't
-	// have that yet
-	string ocaps="application/x-rtp,media=(string)application,clock-rate=(int)90000,payload=(int)99,encoding-name=(string)X-GST,caps=(string)\"YXBwbGljYXRpb24veC1vc2M\\=\"";
-
-
-	createOscChannel(ocaps);
-
-
-	GstElement * rtcpsink;
-	NetworkElementsProperties properties;
-	properties.capsstr = ocaps;
-	properties.source = &oudpsrc;
-	properties.capsfiltername = "ocapsfilter";
-	properties.rtpcsource = &oudpsrcrtcp;
-	properties.rtpcsink = &rtcpsink;
-	properties.srcIP = src;
-	properties.sessionNumber = oscSessionNumber;
-	properties.sourceName = "ortpsrc";
-	properties.rtpcSourceName = "ortcpsrc";
-	properties.rtpcSinkName = "ortcpsink";
-	createNetworkElements(properties,niceStream);
+int ofxGstRTPClient::addOscChannel(shared_ptr<ofxNiceStream> niceStream){
+	nextNiceStream = niceStream;
+	return addOscChannel(0);
 }
 
 void ofxGstRTPClient::setup(int latency){
@@ -906,6 +1225,63 @@ void ofxGstRTPClient::setEchoCancel(ofxEchoCancel & echoCancel){
 }
 #endif
 
+void ofxGstRTPClient::setRetransmissionSettings(bool enabled){
+	if(enabled && !ofxGstRTPCodecs::isRetransmissionAvailable()){
+		ofLogError(LOG_NAME) << "rtprtxreceive not available, retransmission disabled";
+		enabled = false;
+	}
+	retransmission = enabled;
+}
+
+void ofxGstRTPClient::setChannelProcessing(ofxGstRTPChannel type, bool enabled, int channel){
+	if(type==OFX_GST_RTP_AUDIO){
+		ofLogError(LOG_NAME) << "audio channels can't stop processing";
+		return;
+	}
+	Channel * c = getChannel(type,channel);
+	if(!c || c->processing==enabled) return;
+	for(int layer=0;layer<c->numLayers;layer++){
+		Channel & target = layer==0 ? *c : *c->layers[layer-1];
+		target.processing = enabled;
+		if(enabled){
+			// the frames received meanwhile were dropped so the next
+			// differences reference a key frame we haven't seen
+			if(target.depth16){
+				target.doubleBuffer16.reset();
+			}
+			if(target.type==OFX_GST_RTP_VIDEO || target.type==OFX_GST_RTP_DEPTH){
+				requestKeyFrame(target);
+			}
+		}
+	}
+}
+
+bool ofxGstRTPClient::isChannelProcessing(ofxGstRTPChannel type, int channel){
+	Channel * c = getChannel(type,channel);
+	return c && c->processing;
+}
+
+void ofxGstRTPClient::setOscQueueSettings(int capacity){
+	oscQueueCapacity = max(1,capacity);
+}
+
+void ofxGstRTPClient::setDepthDecompressionSettings(int numThreads){
+	depthDecompressionThreads = max(0,numThreads);
+}
+
+void ofxGstRTPClient::setDepth16Packing(bool packed, int maxDepth){
+	depth16Packed = packed;
+	depth16MaxDepth = maxDepth;
+}
+
+void ofxGstRTPClient::setFECSettings(bool enabled){
+	if(enabled && !ofxGstRTPCodecs::isFECAvailable()){
+		ofLogError(LOG_NAME) << "rtpulpfecdec not available, FEC disabled";
+		enabled = false;
+	}
+	fec = enabled;
+}
+
 void ofxGstRTPClient::setup(string srcIP, int latency){
 	this->src = srcIP;
 	this->latency = latency;
@@ -931,12 +1307,25 @@ void ofxGstRTPClient::setup(string srcIP, int latency){
 	g_object_set(rtpbin,"drop-on-latency",(bool)drop,NULL);
 	g_object_set(rtpbin,"do-lost",TRUE,NULL);
 
+	// avpf allows to send the NACKs and keyframe requests as soon as they
+	// are needed instead of waiting for the next rtcp interval
+	gst_util_set_object_arg(G_OBJECT(rtpbin),"rtp-profile","avpf");
+
+	// these are needed while adding the channels, before playing
+	g_signal_connect(rtpbin,"request-aux-receiver",G_CALLBACK(&ofxGstRTPClient::on_request_aux_receiver),this);
+	g_signal_connect(rtpbin,"request-pt-map",G_CALLBACK(&ofxGstRTPClient::on_request_pt_map),this);
+	g_signal_connect(rtpbin,"request-fec-decoder",G_CALLBACK(&ofxGstRTPClient::on_request_fec_decoder),this);
+	g_signal_connect(rtpbin,"new-storage",G_CALLBACK(&ofxGstRTPClient::on_new_storage),this);
+
 	if(!gst_bin_add(GST_BIN(pipeline),rtpbin)){
 		ofLogError() << "couldn't add rtpbin to pipeline";
 	}
 }
 
 void ofxGstRTPClient::close(){
+	// stop sampling before the pipeline is destroyed
+	statsCollector.close();
+	pipelineClock.close();
 	gst.close();
 #if ENABLE_ECHO_CANCEL
 	if(echoCancel){
@@ -944,59 +1333,39 @@ void ofxGstRTPClient::close(){
 	}
 #endif
 
-	width = 0;
-	height = 0;
 	pipeline = 0;
 	rtpbin = 0;
-	vh264depay = 0;
-	opusdepay = 0;
-	depthdepay = 0;
-	gstdepay = 0;
-	videoSink = 0;
-	depthSink = 0;
-	oscSink = 0;
-	vqueue = 0;
-	dqueue = 0;
-	vudpsrc = 0;
-	audpsrc = 0;
-	dudpsrc = 0;
-	oudpsrc = 0;
-	vudpsrcrtcp = 0;
-	audpsrcrtcp = 0;
-	dudpsrcrtcp = 0;
-	oudpsrcrtcp = 0;
-	depth16 = false;
-	videoSessionNumber = -1;
-	audioSessionNumber = -1;
-	depthSessionNumber = -1;
-	oscSessionNumber = -1;
-	videoSSRC = 0;
-	audioSSRC = 0;
-	depthSSRC = 0;
-	oscSSRC = 0;
-	videoReady = false;
-	audioReady = false;
-	depthReady = false;
-	oscReady = false;
-	lastSessionNumber = 0;
+	// the channels release their jitterbuffers
+	channels.clear();
+	for(int i=0;i<OFX_GST_RTP_NUM_CHANNELS;i++){
+		channelsByType[i].clear();
+	}
 #if ENABLE_NAT_TRANSVERSAL
-	videoStream.reset();
-	depthStream.reset();
-	oscStream.reset();
-	audioStream.reset();
+	nextNiceStream.reset();
 #endif
 }
 
 void ofxGstRTPClient::requestKeyFrame(){
-	GstClock * clock = gst_pipeline_get_clock(GST_PIPELINE(gst.getPipeline()));
-	gst_object_ref(clock);
-	GstClockTime time = gst_clock_get_time (clock);
-	GstClockTime now =  time - gst_element_get_base_time(gst.getPipeline());
-	gst_object_unref (clock);
-	GstEvent * keyFrameEvent = gst_video_event_new_upstream_force_key_unit(now,
+	// channels with retransmission recover the packets dropped while
+	// changing the latency and ask for a keyframe themselves if they can't
+	for(size_t i=0;i<channels.size();i++){
+		Channel & channel = *channels[i];
+		if((channel.type==OFX_GST_RTP_VIDEO || channel.type==OFX_GST_RTP_DEPTH) && !channel.retransmission){
+			requestKeyFrame(channel);
+		}
+	}
+}
+
+void ofxGstRTPClient::requestKeyFrame(Channel & channel){
+	// sent from the depayloader so it only goes upstream through this
+	// channel's session which asks the encoder in the other side for it
+	if(!channel.depay || !gst.isPlaying()) return;
+	GstEvent * keyFrameEvent = gst_video_event_new_upstream_force_key_unit(GST_CLOCK_TIME_NONE,
 															 TRUE,
 															 0);
-	gst_element_send_event(gst.getPipeline(),keyFrameEvent);
+	gst_element_send_event(channel.depay,keyFrameEvent);
+	channel.keyframesRequested++;
+	channel.lastKeyFrameRequest = ofGetElapsedTimeMillis();
 }
 
 void ofxGstRTPClient::latencyChanged(int & latency){
@@ -1017,6 +1386,7 @@ void ofxGstRTPClient::dropChanged(bool & drop){
 void ofxGstRTPClient::play(){
 	// pass the pipeline to ofGstVideoUtils so it starts it and allocates the needed resources
 	gst.setPipelineWithSink(pipeline,NULL,true);
+	pipelineClock.setup(gst.getPipeline());
 #if ENABLE_ECHO_CANCEL
 	gstAudioOut.setPipelineWithSink(pipelineAudioOut,NULL,true);
 #endif
@@ -1026,6 +1396,7 @@ void ofxGstRTPClient::play(){
 	g_signal_connect(gst.getGstElementByName("rtpbinclient"),"on-ssrc-active",G_CALLBACK(&ofxGstRTPClient::on_ssrc_active_handler),this);
 	g_signal_connect(gst.getGstElementByName("rtpbinclient"),"on-bye-ssrc",G_CALLBACK(&ofxGstRTPClient::on_bye_ssrc_handler),this);
 	g_signal_connect(gst.getGstElementByName("rtpbinclient"),"on-new-ssrc",G_CALLBACK(&ofxGstRTPClient::on_new_ssrc_handler),this);
+	g_signal_connect(gst.getGstElementByName("rtpbinclient"),"new-jitterbuffer",G_CALLBACK(&ofxGstRTPClient::on_new_jitterbuffer_handler),this);
 
 	if(audioechosrc){
 		gst_app_src_set_stream_type((GstAppSrc*)audioechosrc,GST_APP_STREAM_TYPE_STREAM);
@@ -1040,102 +1411,132 @@ void ofxGstRTPClient::play(){
 
 	gst.startPipeline();
 	gst.play();
+
+	statsCollector.setup(std::bind(&ofxGstRTPClient::sampleStats,this,std::placeholders::_1,std::placeholders::_2),channels.size(),statsInterval,statsHistorySize);
 }
 
 
 void ofxGstRTPClient::update(){
-	doubleBufferVideo.update();
-	if(depth16){
-		doubleBufferDepth16.update();
-	}else{
-		doubleBufferDepth.update();
+	for(size_t i=0;i<channels.size();i++){
+		Channel & channel = *channels[i];
+		switch(channel.type){
+		case OFX_GST_RTP_VIDEO:
+			channel.doubleBuffer.update();
+			break;
+		case OFX_GST_RTP_DEPTH:
+			if(channel.depth16){
+				channel.doubleBuffer16.update();
+			}else{
+				channel.doubleBuffer.update();
+				if(channel.doubleBuffer.isFrameNew()){
+					channel.depthUnpackedValid = false;
+				}
+			}
+			break;
+		case OFX_GST_RTP_OSC:
+			// the views point to the packets of the previous update which
+			// are released now, even if no new packet arrived
+			channel.doubleBufferOsc.update();
+			channel.oscParser.clear();
+			channel.oscParsed = false;
+			channel.oscLastMessageValid = false;
+			break;
+		default:
+			break;
+		}
+	}
+
+	for(size_t i=0;i<channelsByType[OFX_GST_RTP_VIDEO].size();i++){
+		Channel & video = *channelsByType[OFX_GST_RTP_VIDEO][i];
+		if(video.numLayers>1){
+			updateVideoLayer(video);
+		}
 	}
-	doubleBufferOsc.update();
-	if(depth16 && doubleBufferDepth.isFrameNew()){
-		ofxGstRTPUtils::convertColoredDepthToShort(doubleBufferDepth.getPixels(),depth16Pixels,pow(2.f,14.f));
+
+	// a lost packet breaks the decoding until the next keyframe, if it keeps
+	// happening the requests are limited so they don't add more traffic
+	uint64_t now = ofGetElapsedTimeMillis();
+	for(size_t i=0;i<channels.size();i++){
+		Channel & channel = *channels[i];
+		if(!channel.keyFrameNeeded || now - channel.lastKeyFrameRequest < KEYFRAME_REQUEST_INTERVAL_MS){
+			continue;
+		}
+		channel.keyFrameNeeded = false;
+
+		// layers that are not decoded don't need it
+		if(channel.valve){
+			Channel & video = *getChannel(OFX_GST_RTP_VIDEO,channel.index);
+			if(channel.layer!=video.activeLayer && channel.layer!=video.pendingLayer){
+				continue;
+			}
+		}
+		requestKeyFrame(channel);
 	}
 }
 
 
-bool ofxGstRTPClient::isFrameNewVideo(){
-	return doubleBufferVideo.isFrameNew();
+bool ofxGstRTPClient::isFrameNewVideo(int channel){
+	Channel * video = getActiveVideoLayer(channel);
+	return video && video->doubleBuffer.isFrameNew();
 }
 
 
-bool ofxGstRTPClient::isFrameNewDepth(){
-	if(depth16){
-		return doubleBufferDepth16.isFrameNew();
+bool ofxGstRTPClient::isFrameNewDepth(int channel){
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	if(!depth) return false;
+	if(depth->depth16){
+		return depth->doubleBuffer16.isFrameNew();
 
 	}else{
-		return doubleBufferDepth.isFrameNew();
+		return depth->doubleBuffer.isFrameNew();
 	}
 }
 
-bool ofxGstRTPClient::isFrameNewOsc(){
-	return doubleBufferOsc.isFrameNew();
+bool ofxGstRTPClient::isFrameNewOsc(int channel){
+	Channel * osc = getChannel(OFX_GST_RTP_OSC,channel);
+	return osc && osc->doubleBufferOsc.isFrameNew();
 }
 
-ofPixels & ofxGstRTPClient::getPixelsVideo(){
-	return doubleBufferVideo.getPixels();
+ofPixels & ofxGstRTPClient::getPixelsVideo(int channel){
+	Channel * video = getActiveVideoLayer(channel);
+	if(!video) return emptyPixels;
+	return video->doubleBuffer.getPixels();
 }
 
 
-ofPixels & ofxGstRTPClient::getPixelsDepth(){
-	return doubleBufferDepth.getPixels();
+ofPixels & ofxGstRTPClient::getPixelsDepth(int channel){
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	if(!depth) return emptyPixels;
+	return depth->doubleBuffer.getPixels();
 }
 
-ofShortPixels & ofxGstRTPClient::getPixelsDepth16(){
-	return doubleBufferDepth16.getPixels();
+ofShortPixels & ofxGstRTPClient::getPixelsDepth16(int channel){
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	if(!depth) return emptyShortPixels;
+	if(depth->depth16Packed){
+		if(!depth->depthUnpackedValid && depth->doubleBuffer.isAllocated()){
+			depth->depthPacker.unpack(depth->doubleBuffer.getPixels(),depth->depthUnpacked);
+			depth->depthUnpackedValid = true;
+		}
+		return depth->depthUnpacked;
+	}
+	return depth->doubleBuffer16.getPixels();
 }
 
-float ofxGstRTPClient::getZeroPlanePixelSize(){
-	return doubleBufferDepth16.getZeroPlanePixelSize();
+float ofxGstRTPClient::getZeroPlanePixelSize(int channel){
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	if(!depth) return 0;
+	return depth->doubleBuffer16.getZeroPlanePixelSize();
 }
 
-float ofxGstRTPClient::getZeroPlaneDistance(){
-	return doubleBufferDepth16.getZeroPlaneDistance();
+float ofxGstRTPClient::getZeroPlaneDistance(int channel){
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	if(!depth) return 0;
+	return depth->doubleBuffer16.getZeroPlaneDistance();
 }
 
 
 
-void appendMessage(ofxOscMessage & ofMessage, osc::ReceivedMessage & m){
-	// set the address
-	ofMessage.setAddress( m.AddressPattern() );
-
-	// transfer the arguments
-	for ( osc::ReceivedMessage::const_iterator arg = m.ArgumentsBegin();
-		  arg != m.ArgumentsEnd();
-		  ++arg )
-	{
-		if ( arg->IsInt32() )
-			ofMessage.addIntArg( arg->AsInt32Unchecked() );
-		else if ( arg->IsInt64() )
-			ofMessage.addInt64Arg( arg->AsInt64Unchecked() );
-		else if ( arg->IsFloat() )
-			ofMessage.addFloatArg( arg->AsFloatUnchecked() );
-		else if ( arg->IsString() )
-			ofMessage.addStringArg( arg->AsStringUnchecked() );
-		else
-		{
-			ofLogError("ofxOscReceiver") << "ProcessMessage: argument in message " << m.AddressPattern() << " is not an int, float, or string";
-		}
-	}
-}
-
-void appendBundle(ofxOscMessage & ofMessage, osc::ReceivedBundle & b){
-	for(osc::ReceivedBundleElementIterator i=b.ElementsBegin();i!=b.ElementsEnd();i++){
-		if(i->IsMessage()){
-			osc::ReceivedPacket p(i->Contents(),i->Size());
-			osc::ReceivedMessage m(p);
-			appendMessage(ofMessage,m);
-		}else if(i->IsBundle()){
-			osc::ReceivedPacket p(i->Contents(),i->Size());
-			osc::ReceivedBundle b(p);
-			appendBundle(ofMessage,b);
-		}
-	}
-}
-
 #if ENABLE_ECHO_CANCEL
 u_int64_t ofxGstRTPClient::getAudioOutLatencyMs(){
 	return gstAudioOut.getMinLatencyNanos()*0.000001;
@@ -1146,35 +1547,51 @@ u_int64_t ofxGstRTPClient::getAudioFramesProcessed(){
 }
 #endif
 
-ofxOscMessage ofxGstRTPClient::getOscMessage(){
-
-	osc::ReceivedPacket * packet = doubleBufferOsc.getOscReceivedPacket();
-
-	ofxOscMessage ofMessage;
+void ofxGstRTPClient::parseOsc(Channel & osc){
+	osc.oscParsed = true;
+	osc.oscParser.clear();
+	for(size_t i=0;i<osc.doubleBufferOsc.getNumPackets();i++){
+		const char * data;
+		size_t size;
+		if(osc.doubleBufferOsc.getPacket(i,data,size) && !osc.oscParser.parse(data,size)){
+			ofLogError(LOG_NAME) << "received malformed osc packet";
+		}
+	}
+}
 
-	if(packet==NULL)
-	{
-		ofLogError() << "packet NULL ";
-		return ofMessage;
+const vector<ofxGstOscMessageView> & ofxGstRTPClient::getOscMessageViews(int channel){
+	Channel * osc = getChannel(OFX_GST_RTP_OSC,channel);
+	if(!osc){
+		return emptyOscMessageViews;
 	}
+	if(!osc->oscParsed){
+		parseOsc(*osc);
+	}
+	return osc->oscParser.getMessages();
+}
 
-	if(packet->IsMessage()){
-		try{
-			osc::ReceivedMessage m(*packet);
-			appendMessage(ofMessage,m);
-		}catch(osc::MalformedMessageException & e){
-		}
-	}else if(packet->IsBundle()){
-		try{
-			osc::ReceivedBundle b(*packet);
-			appendBundle(ofMessage,b);
-		}catch(osc::MalformedBundleException & e){
-		}
-	}else{
-		ofLogError() << "received packet of type != message not supported yet";
+const ofxOscMessage & ofxGstRTPClient::getOscMessage(int channel){
+	Channel * osc = getChannel(OFX_GST_RTP_OSC,channel);
+	if(!osc){
+		return emptyOscMessage;
+	}
+	const vector<ofxGstOscMessageView> & views = getOscMessageViews(channel);
+	if(views.empty()){
+		return emptyOscMessage;
 	}
+	if(!osc->oscLastMessageValid){
+		views.back().toOfxOscMessage(osc->oscLastMessage);
+		osc->oscLastMessageValid = true;
+	}
+	return osc->oscLastMessage;
+}
 
-	return ofMessage;
+void ofxGstRTPClient::getOscMessages(vector<ofxOscMessage> & messages, int channel){
+	const vector<ofxGstOscMessageView> & views = getOscMessageViews(channel);
+	messages.resize(views.size());
+	for(size_t i=0;i<views.size();i++){
+		views[i].toOfxOscMessage(messages[i]);
+	}
 }
 
 bool ofxGstRTPClient::on_message(GstMessage * msg){
@@ -1229,79 +1646,69 @@ void ofxGstRTPClient::on_stream_prepared(){
 };
 
 
-void ofxGstRTPClient::on_eos_from_video(GstAppSink * elt, void * rtpClient){
+void ofxGstRTPClient::on_eos_from_sink(GstAppSink * elt, void * channel){
 
 }
 
 
-GstFlowReturn ofxGstRTPClient::on_new_preroll_from_video(GstAppSink * elt, void * rtpClient){
+GstFlowReturn ofxGstRTPClient::on_new_preroll_from_sink(GstAppSink * elt, void * channel){
 	return GST_FLOW_OK;
 }
 
 
 GstFlowReturn ofxGstRTPClient::on_new_buffer_from_video(GstAppSink * elt, void * data){
-	ofxGstRTPClient* rtpClient = (ofxGstRTPClient*) data;
-	return rtpClient->on_new_buffer_from_video(elt);
-}
-
-
-GstFlowReturn ofxGstRTPClient::on_new_buffer_from_video(GstAppSink * elt){
+	Channel * channel = (Channel*) data;
 	GstSample *sample = gst_app_sink_pull_sample (GST_APP_SINK (elt));
-	if(!doubleBufferVideo.isAllocated()){
+	if(!channel->processing){
+		gst_sample_unref(sample);
+		return GST_FLOW_OK;
+	}
+	if(!channel->doubleBuffer.isAllocated()){
 		GstCaps * sampleCaps = gst_sample_get_caps(sample);
 		if(sampleCaps){
 			GstVideoInfo sampleInfo;
 			if(gst_video_info_from_caps(&sampleInfo,sampleCaps)){
-				doubleBufferVideo.setup( sampleInfo.width , sampleInfo.height , 3);
+				channel->doubleBuffer.setup( sampleInfo.width , sampleInfo.height , 3);
 			}
 		}
 	}
-	if(doubleBufferVideo.isAllocated()){
-		doubleBufferVideo.newSample(sample);
+	if(channel->doubleBuffer.isAllocated()){
+		channel->doubleBuffer.newSample(sample);
 	}
 	return GST_FLOW_OK;
 }
 
 
-void ofxGstRTPClient::on_eos_from_depth(GstAppSink * elt, void * rtpClient){
-
-}
-
-
-GstFlowReturn ofxGstRTPClient::on_new_preroll_from_depth(GstAppSink * elt, void * rtpClient){
-	return GST_FLOW_OK;
-}
-
-
 GstFlowReturn ofxGstRTPClient::on_new_buffer_from_depth(GstAppSink * elt, void * data){
-	ofxGstRTPClient* rtpClient = (ofxGstRTPClient*) data;
-	return rtpClient->on_new_buffer_from_depth(elt);
-}
-
-GstFlowReturn ofxGstRTPClient::on_new_buffer_from_depth(GstAppSink * elt){
+	Channel * channel = (Channel*) data;
 	GstSample *sample = gst_app_sink_pull_sample (GST_APP_SINK (elt));
+	if(!channel->processing){
+		gst_sample_unref(sample);
+		return GST_FLOW_OK;
+	}
+
 
-	if(!depth16 && !doubleBufferDepth.isAllocated()){
+	if(!channel->depth16 && !channel->doubleBuffer.isAllocated()){
 		GstCaps * sampleCaps = gst_sample_get_caps(sample);
 		if(sampleCaps){
 			GstVideoInfo sampleInfo;
 			if(gst_video_info_from_caps(&sampleInfo,sampleCaps)){
-				doubleBufferDepth.setup(sampleInfo.width , sampleInfo.height,1);
+				channel->doubleBuffer.setup(sampleInfo.width , sampleInfo.height,1);
 			}
 		}
 	}
 
-	if(depth16 && !doubleBufferDepth16.isAllocated()){
-		doubleBufferDepth16.setupFor16();
+	if(channel->depth16 && !channel->doubleBuffer16.isAllocated()){
+		channel->doubleBuffer16.setup(channel->client->depthDecompressionThreads);
 	}
 
-	if(!depth16){
-		if(doubleBufferDepth.isAllocated()){
-			doubleBufferDepth.newSample(sample);
+	if(!channel->depth16){
+		if(channel->doubleBuffer.isAllocated()){
+			channel->doubleBuffer.newSample(sample);
 		}
 	}else{
-		if(doubleBufferDepth16.isAllocated()){
-			doubleBufferDepth16.newSample(sample);
+		if(channel->doubleBuffer16.isAllocated()){
+			channel->doubleBuffer16.newSample(sample);
 		}
 
 	}
@@ -1309,24 +1716,14 @@ GstFlowReturn ofxGstRTPClient::on_new_buffer_from_depth(GstAppSink * elt){
 }
 
 
-void ofxGstRTPClient::on_eos_from_osc(GstAppSink * elt, void * rtpClient){
-
-}
-
-
-GstFlowReturn ofxGstRTPClient::on_new_preroll_from_osc(GstAppSink * elt, void * rtpClient){
-	return GST_FLOW_OK;
-}
-
-
 GstFlowReturn ofxGstRTPClient::on_new_buffer_from_osc(GstAppSink * elt, void * data){
-	ofxGstRTPClient* rtpClient = (ofxGstRTPClient*) data;
-	return rtpClient->on_new_buffer_from_osc(elt);
-}
-
-GstFlowReturn ofxGstRTPClient::on_new_buffer_from_osc(GstAppSink * elt){
+	Channel * channel = (Channel*) data;
 	GstSample *sample = gst_app_sink_pull_sample (GST_APP_SINK (elt));
-	doubleBufferOsc.newSample(sample);
+	if(!channel->processing){
+		gst_sample_unref(sample);
+		return GST_FLOW_OK;
+	}
+	channel->doubleBufferOsc.newSample(sample);
 	return GST_FLOW_OK;
 }
 
@@ -1346,10 +1743,7 @@ void ofxGstRTPClient::sendAudioOut(PooledAudioFrame * pooledFrame){
 	// TODO: the echo appsrc doesn't seem to sync when latency is changed so we need
 	// to generate the timestamps for the audio out to compensate for latency - max_latency
 	if(firstAudioFrame){
-		GstClock * clock = gst_pipeline_get_clock(GST_PIPELINE(gst.getPipeline()));
-		gst_object_ref(clock);
-		prevTimestampAudio = (gint64)gst_clock_get_time (clock) - (gint64)gst_element_get_base_time(gst.getPipeline());
-		gst_object_unref (clock);
+		prevTimestampAudio = pipelineClock.now();
 		firstAudioFrame = false;
 	}
 	int size = pooledFrame->audioFrame._payloadDataLengthInSamples*2*pooledFrame->audioFrame._audioChannel;
@@ -11,9 +11,16 @@
 #include "ofGstUtils.h"
 #include <gst/app/gstappsink.h>
 #include "ofxGstVideoDoubleBuffer.h"
+#include "ofxGstDepth16DoubleBuffer.h"
+#include "ofxGstDepth16Packer.h"
 #include "ofxOsc.h"
 #include "ofxGstOscDoubleBuffer.h"
+#include "ofxGstOscParser.h"
 #include "ofxGstRTPConstants.h"
+#include "ofxGstRTPCodecs.h"
+#include "ofxGstRTPStats.h"
+#include "ofxGstPipelineClock.h"
+#include <atomic>
 
 #include "ofParameter.h"
 #include "ofParameterGroup.h"
@@ -54,23 +61,48 @@ public:
 	/// set later
 	void setup(string srcIP, int latency);
 
+	/// retransmission of lost packets (RFC 4588) for the video, depth and osc
+	/// channels added after calling it, enabled by default when gstreamer has
+	/// the rtprtxsend and rtprtxreceive elements. The jitterbuffer
+	/// sends a NACK for every missing packet and only if it doesn't arrive
+	/// before the latency expires a keyframe is requested. Latency changes
+	/// don't request keyframes for these channels
+	void setRetransmissionSettings(bool enabled);
+
+	/// forward error correction (ULPFEC) for the video, depth and osc channels
+	/// added after calling it, disabled by default. Lost packets are rebuilt
+	/// from the FEC packets sent by the server, which needs it enabled too,
+	/// before the jitterbuffer gives up on them
+	void setFECSettings(bool enabled);
+
 	/// add an audio channel receiving in a specific port, has to be the same port
 	/// specified in the server. Ports for the different channels will really occupy
 	/// the next 5 ports so if we specify 3000, 3000-3005 will be used and shouldn't
 	/// be specified for other channel
-	void addAudioChannel(int port);
+	/// There can only be one audio channel, returns -1 if there's one already
+	int addAudioChannel(int port);
 	/// add an video channel receiving in a specific port. Ports for the different channels will really occupy
 	/// the next 5 ports so if we specify 3000, 3000-3005 will be used and shouldn't
-	/// be specified for other channel
-	void addVideoChannel(int port);
+	/// be specified for other channel.
+	/// codec has to have the same encoding as the one used by the server
+	/// Any number of video channels can be added, each one in its own rtp session.
+	/// numLayers receives that many simulcast layers from a server using
+	/// setVideoLayers, layer n on port + 5*n. Only one layer is decoded at a
+	/// time, see setVideoLayer and autoVideoLayer.
+	/// Returns the index of the new channel to use with getPixelsVideo...
+	int addVideoChannel(int port, ofxGstRTPVideoCodec codec=OFX_GST_RTP_X264, int numLayers=1);
 	/// add an depth channel receiving in a specific port. Ports for the different channels will really occupy
 	/// the next 5 ports so if we specify 3000, 3000-3005 will be used and shouldn't
-	/// be specified for other channel
-	void addDepthChannel(int port, bool depth16=false);
+	/// be specified for other channel.
+	/// codec is only used for 8bits depth and has to have the same encoding as the
+	/// one used by the server
+	/// Returns the index of the new depth channel
+	int addDepthChannel(int port, bool depth16=false, ofxGstRTPVideoCodec codec=OFX_GST_RTP_X264);
 	/// add an osc channel receiving in a specific port. Ports for the different channels will really occupy
 	/// the next 5 ports so if we specify 3000, 3000-3005 will be used and shouldn't
 	/// be specified for other channel
-	void addOscChannel(int port);
+	/// Returns the index of the new osc channel
+	int addOscChannel(int port);
 
 #if ENABLE_NAT_TRANSVERSAL
 	/// use this version of setup when working with NAT transversal
@@ -78,12 +110,29 @@ public:
 	/// all the workflow of the session initiation as well as creating
 	/// the corresponging ICE streams and agent
 	void setup(int latency);
-	void addAudioChannel(shared_ptr<ofxNiceStream> niceStream);
-	void addVideoChannel(shared_ptr<ofxNiceStream> niceStream);
-	void addDepthChannel(shared_ptr<ofxNiceStream> niceStream, bool depth16=false);
-	void addOscChannel(shared_ptr<ofxNiceStream> niceStream);
+	int addAudioChannel(shared_ptr<ofxNiceStream> niceStream);
+	int addVideoChannel(shared_ptr<ofxNiceStream> niceStream, ofxGstRTPVideoCodec codec=OFX_GST_RTP_X264);
+	int addDepthChannel(shared_ptr<ofxNiceStream> niceStream, bool depth16=false, ofxGstRTPVideoCodec codec=OFX_GST_RTP_X264);
+	int addOscChannel(shared_ptr<ofxNiceStream> niceStream);
 #endif
 
+	/// number of channels of each kind added so far
+	int getNumVideoChannels();
+	int getNumDepthChannels();
+	int getNumOscChannels();
+
+	/// number of simulcast layers of a video channel, 1 if it has none
+	int getNumVideoLayers(int channel=0);
+
+	/// switches the layer decoded for a simulcast video channel, 0 is the full
+	/// resolution. The current layer keeps being shown until the new one
+	/// decodes its first keyframe. autoVideoLayer can change it again
+	void setVideoLayer(int layer, int channel=0);
+
+	/// layer currently shown for a video channel. When it changes the server
+	/// can be told to send only that one to us with setDestinationVideoLayer
+	int getVideoLayer(int channel=0);
+
 	/// close the current connection
 	void close();
 
@@ -94,30 +143,82 @@ public:
 	void update();
 
 	/// returns true if there's a new video frame after calling update
-	bool isFrameNewVideo();
+	bool isFrameNewVideo(int channel=0);
 
 	/// returns true if there's a new depth frame after calling update
-	bool isFrameNewDepth();
+	bool isFrameNewDepth(int channel=0);
 
 	/// returns true if there's a new osc frame after calling update
-	bool isFrameNewOsc();
+	bool isFrameNewOsc(int channel=0);
 
 	/// get the pixels for the last frame received for the video channel
-	ofPixels & getPixelsVideo();
+	ofPixels & getPixelsVideo(int channel=0);
 	/// get the pixels for the last frame received for the depth channel
-	ofPixels & getPixelsDepth();
-	/// get the pixels for the last frame received for the depth channel 16bits
-	ofShortPixels & getPixelsDepth16();
-	/// get the pixels for the last frame received for the osc channel
-	ofxOscMessage getOscMessage();
+	ofPixels & getPixelsDepth(int channel=0);
+	/// get the pixels for the last frame received for the depth channel 16bits,
+	/// packed depth is unpacked the first time they are requested after update
+	ofShortPixels & getPixelsDepth16(int channel=0);
+	/// get the last message received for the osc channel before update, it's
+	/// parsed the first time it's requested after update
+	const ofxOscMessage & getOscMessage(int channel=0);
+	/// get all the messages received for the osc channel before the last
+	/// update, with the bundles expanded, in the order they were sent. No
+	/// message is lost unless the queue set with setOscQueueSettings fills,
+	/// which is counted in framesDropped in the stats of the channel
+	void getOscMessages(vector<ofxOscMessage> & messages, int channel=0);
+	/// same messages as getOscMessages but read in place from the received
+	/// packets without copying or allocating anything. The views are valid
+	/// until the next update
+	const vector<ofxGstOscMessageView> & getOscMessageViews(int channel=0);
 	/// get the zero plane pixel size, of the remote peer, used to undistort the
 	/// received point cloud
-	float getZeroPlanePixelSize();
+	float getZeroPlanePixelSize(int channel=0);
 	/// get the zero plane distance of the remote peer, used to undistort the
 	/// received point cloud
-	float getZeroPlaneDistance();
+	float getZeroPlaneDistance(int channel=0);
+
 
 
+	/// last stats sampled for a channel: bitrate, packets received and lost,
+	/// jitter and the jitterbuffer counters. The stats are collected periodically
+	/// in a separate thread once the client is playing. For simulcast video
+	/// channels these are the stats of the layer being shown
+	ofxGstRTPStats getStats(ofxGstRTPChannel type, int channel=0);
+
+	/// last stats sampled for one simulcast layer of a video channel
+	ofxGstRTPStats getVideoLayerStats(int layer, int channel=0);
+
+	/// copies the recent stats samples of a channel, oldest first
+	void getStatsHistory(ofxGstRTPChannel type, vector<ofxGstRTPStats> & history, int channel=0);
+
+	/// time between stats samples and number of samples kept in the history
+	/// of each channel, takes effect the next time the client starts playing
+	void setStatsSettings(int intervalMs, int historySize);
+
+	/// stops processing the frames of a video, depth or osc channel that the
+	/// application doesn't use. The frames are still received, so the stats
+	/// keep working, but they are dropped as they arrive without decoding or
+	/// converting them and isFrameNew* returns false. When enabled again a
+	/// keyframe is requested so depth16 can be decompressed again
+	void setChannelProcessing(ofxGstRTPChannel type, bool enabled, int channel=0);
+	bool isChannelProcessing(ofxGstRTPChannel type, int channel=0);
+
+	/// osc packets that can be waiting for update in each osc channel added
+	/// afterwards, the ones that arrive when it's full are dropped
+	void setOscQueueSettings(int capacity);
+
+	/// number of threads used to decompress the tiles of each 16bits depth
+	/// frame, 0 chooses it from the number of cores. Applies to the depth
+	/// channels added afterwards. The frames are decompressed as they arrive
+	/// in a thread for each channel, update only swaps the last one. The
+	/// frames decompressed and dropped are in the stats of the channel
+	void setDepthDecompressionSettings(int numThreads);
+
+	/// receive the 16bits depth channels added afterwards packed in 8bits
+	/// planes and encoded with the codec passed to addDepthChannel, has to
+	/// match ofxGstRTPServer::setDepth16Packing. The depth is unpacked in
+	/// update
+	void setDepth16Packing(bool packed, int maxDepth=ofxGstDepth16Packer::DEFAULT_MAX_DEPTH);
 
 	/// this paramter adjusts the latency on the client side to a maximum of the
 	/// value set in setup
@@ -129,6 +230,14 @@ public:
 	/// glitches in the video and depth streams
 	ofParameter<bool> drop;
 
+	/// when enabled simulcast video channels go down one layer when the loss
+	/// or jitter of the current one is over the max and up one after it has
+	/// been below them for the upgrade delay
+	ofParameter<bool> autoVideoLayer;
+	ofParameter<float> videoLayerMaxLoss;
+	ofParameter<float> videoLayerMaxJitter;
+	ofParameter<int> videoLayerUpgradeDelay;
+
 	/// groups all the parameters of this class
 	ofParameterGroup parameters;
 
@@ -142,7 +251,90 @@ public:
 #endif
 
 private:
+	/// everything needed to receive one stream, there's one per rtp session
+	/// and the session number is also its index in the channels vector.
+	/// simulcast layers are channels too but only the first layer is listed
+	/// by type, the rest hang from it
+	struct Channel{
+		Channel(ofxGstRTPClient * client, ofxGstRTPChannel type, int index, guint session);
+		~Channel();
+
+		/// name of an element of this channel in the pipeline
+		string getElementName(const string & name) const;
+
+		ofxGstRTPClient * client;
+		ofxGstRTPChannel type;
+		int index;
+		guint session;
+		int layer;
+		int numLayers;
+		vector<Channel*> layers;
+		int payloadType;
+		string rtpCaps;
+		bool retransmission;
+		bool fec;
+
+		GstElement * depay;
+		GstElement * valve;
+		GstAppSink * sink;
+		GstElement * rtpsrc;
+		GstElement * rtcpsrc;
+		GstElement * rtcpsink;
+
+		ofxGstVideoDoubleBuffer<unsigned char> doubleBuffer;
+		ofxGstDepth16DoubleBuffer doubleBuffer16;
+		ofxGstOscDoubleBuffer doubleBufferOsc;
+		bool depth16;
+		bool ready;
+
+		// read from the streaming thread, samples are dropped when false
+		std::atomic<bool> processing;
+
+		// packed 16bits depth is received as 8bits and unpacked the first
+		// time it's requested after each new frame
+		bool depth16Packed;
+		ofxGstDepth16Packer depthPacker;
+		ofShortPixels depthUnpacked;
+		bool depthUnpackedValid;
+
+		// osc packets received before the last update, parsed in place
+		// the first time they are requested
+		ofxGstOscParser oscParser;
+		bool oscParsed;
+		ofxOscMessage oscLastMessage;
+		bool oscLastMessageValid;
+
+		// set from the streaming thread and read from the stats collector
+		std::atomic<guint> ssrc;
+		std::atomic<unsigned int> keyframesRequested;
+
+		// set from the streaming thread when the jitterbuffer gives up on
+		// a packet, the keyframe is requested from update
+		std::atomic<bool> keyFrameNeeded;
+		uint64_t lastKeyFrameRequest;
+
+		// created by rtpbin in the streaming thread, guarded by jitterbuffersMutex
+		GstElement * jitterbuffer;
+		GstElement * fecdec;
+
+		// only accessed from the stats collector thread, used to calculate
+		// the fraction lost between samples
+		guint64 prevPacketsReceived;
+		gint prevPacketsLost;
+
+		// layer selection, only used in the first layer
+		int activeLayer;
+		int pendingLayer;
+		uint64_t lastLayerChange;
+		uint64_t lastLayerSample;
+
+#if ENABLE_NAT_TRANSVERSAL
+		shared_ptr<ofxNiceStream> niceStream;
+#endif
+	};
+
 	void requestKeyFrame();
+	void requestKeyFrame(Channel & channel);
 	void latencyChanged(int & latency);
 	void dropChanged(bool & drop);
 
@@ -166,10 +358,21 @@ private:
 	void createNetworkElements(NetworkElementsProperties properties, void *);
 #endif
 
-	void createAudioChannel(string rtpCaps);
-	void createVideoChannel(string rtpCaps);
-	void createDepthChannel(string rtpCaps, bool depth16=false);
-	void createOscChannel(string rtpCaps);
+	Channel & createChannel(ofxGstRTPChannel type);
+	Channel & createLayerChannel(Channel & channel, int layer);
+	Channel * getChannel(ofxGstRTPChannel type, int index);
+	Channel * getChannel(guint session);
+	Channel * getVideoLayer(int channel, int layer);
+	Channel * getActiveVideoLayer(int channel);
+	void switchVideoLayer(Channel & channel, int layer);
+	void updateVideoLayer(Channel & channel);
+	void createNetworkElements(Channel & channel, const string & rtpCaps, int port);
+
+	void createAudioChannel(Channel & channel, string rtpCaps);
+	void createVideoChannel(Channel & channel, string rtpCaps, ofxGstRTPVideoCodec codec);
+	void createDepthChannel(Channel & channel, string rtpCaps, bool depth16, ofxGstRTPVideoCodec codec);
+	void createOscChannel(Channel & channel, string rtpCaps);
+	void parseOsc(Channel & osc);
 
 	// calbacks from gstUtils
 	bool on_message(GstMessage * msg);
@@ -181,21 +384,22 @@ private:
 	static void on_new_ssrc_handler(GstBin *rtpbin, guint session, guint ssrc, ofxGstRTPClient * rtpClient);
 	static void on_bye_ssrc_handler(GstBin *rtpbin, guint session, guint ssrc, ofxGstRTPClient * rtpClient);
 	static void on_pad_added(GstBin *rtpbin, GstPad *pad, ofxGstRTPClient * rtpClient);
-
-	// video callbacks
-	static void on_eos_from_video(GstAppSink * elt, void * rtpClient);
-	static GstFlowReturn on_new_preroll_from_video(GstAppSink * elt, void * rtpClient);
-	static GstFlowReturn on_new_buffer_from_video(GstAppSink * elt, void * rtpClient);
-
-	// depth callbacks
-	static void on_eos_from_depth(GstAppSink * elt, void * rtpClient);
-	static GstFlowReturn on_new_preroll_from_depth(GstAppSink * elt, void * rtpClient);
-	static GstFlowReturn on_new_buffer_from_depth(GstAppSink * elt, void * rtpClient);
-
-	// osc callbacks
-	static void on_eos_from_osc(GstAppSink * elt, void * rtpClient);
-	static GstFlowReturn on_new_preroll_from_osc(GstAppSink * elt, void * rtpClient);
-	static GstFlowReturn on_new_buffer_from_osc(GstAppSink * elt, void * rtpClient);
+	static void on_new_jitterbuffer_handler(GstBin *rtpbin, GstElement * jitterbuffer, guint session, guint ssrc, ofxGstRTPClient * rtpClient);
+	static GstElement * on_request_aux_receiver(GstElement * rtpbin, guint session, ofxGstRTPClient * rtpClient);
+	static GstElement * on_request_fec_decoder(GstElement * rtpbin, guint session, ofxGstRTPClient * rtpClient);
+	static void on_new_storage(GstElement * rtpbin, GstElement * storage, guint session, ofxGstRTPClient * rtpClient);
+	static GstCaps * on_request_pt_map(GstElement * rtpbin, guint session, guint pt, ofxGstRTPClient * rtpClient);
+	static GstPadProbeReturn on_depay_event(GstPad * pad, GstPadProbeInfo * info, gpointer channel);
+	void watchPacketLoss(Channel & channel);
+
+	bool sampleStats(int session, ofxGstRTPStats & stats);
+
+	// appsink callbacks, the user data is the Channel receiving the buffers
+	static void on_eos_from_sink(GstAppSink * elt, void * channel);
+	static GstFlowReturn on_new_preroll_from_sink(GstAppSink * elt, void * channel);
+	static GstFlowReturn on_new_buffer_from_video(GstAppSink * elt, void * channel);
+	static GstFlowReturn on_new_buffer_from_depth(GstAppSink * elt, void * channel);
+	static GstFlowReturn on_new_buffer_from_osc(GstAppSink * elt, void * channel);
 
 #if ENABLE_ECHO_CANCEL
 	// audio echo cancel callbacks
@@ -204,92 +408,45 @@ private:
 	static GstFlowReturn on_new_buffer_from_audio(GstAppSink * elt, void * rtpClient);
 #endif
 
-	// video instance callbacks
-	void on_eos_from_video(GstAppSink * elt){};
-	GstFlowReturn on_new_preroll_from_video(GstAppSink * elt){return GST_FLOW_OK;}
-	GstFlowReturn on_new_buffer_from_video(GstAppSink * elt);
-	void linkVideoPad(GstPad * pad);
-
-	// depth instance callbacks
-	void on_eos_from_depth(GstAppSink * elt){};
-	GstFlowReturn on_new_preroll_from_depth(GstAppSink * elt){return GST_FLOW_OK;};
-	GstFlowReturn on_new_buffer_from_depth(GstAppSink * elt);
-	void linkDepthPad(GstPad * pad);
-
-	// osc instance callbacks
-	void on_eos_from_osc(GstAppSink * elt){};
-	GstFlowReturn on_new_preroll_from_osc(GstAppSink * elt){return GST_FLOW_OK;};
-	GstFlowReturn on_new_buffer_from_osc(GstAppSink * elt);
-	void linkOscPad(GstPad * pad);
-
-	void linkAudioPad(GstPad * pad);
+	void linkPad(Channel & channel, GstPad * pad);
 
 	ofGstUtils gst;
 	ofGstUtils gstAudioOut;
-	int width, height;
 	GstMapInfo mapinfo;
 
 	GstElement * pipeline;
 	GstElement * pipelineAudioOut;
 	GstElement * rtpbin;
 
-	GstElement * vh264depay;
-	GstElement * opusdepay;
-	GstElement * depthdepay;
-	GstElement * gstdepay;
-
-	GstAppSink * videoSink;
-	GstAppSink * depthSink;
-	GstAppSink * oscSink;
-
-	GstElement * vqueue;
-	GstElement * dqueue;
-
-	GstElement * vudpsrc;
-	GstElement * audpsrc;
-	GstElement * dudpsrc;
-	GstElement * oudpsrc;
-	GstElement * vudpsrcrtcp;
-	GstElement * audpsrcrtcp;
-	GstElement * dudpsrcrtcp;
-	GstElement * oudpsrcrtcp;
-
 	GstElement * audioechosrc;
 	GstElement * audioechosink;
 
+	// indexed by session number and by type
+	vector<shared_ptr<Channel> > channels;
+	vector<shared_ptr<Channel> > channelsByType[OFX_GST_RTP_NUM_CHANNELS];
 
-	ofxGstVideoDoubleBuffer<unsigned char> doubleBufferVideo;
-	ofxGstVideoDoubleBuffer<unsigned char> doubleBufferDepth;
-	ofxGstVideoDoubleBuffer<unsigned short> doubleBufferDepth16;
-	ofxGstOscDoubleBuffer doubleBufferOsc;
-
-	bool depth16;
-	ofShortPixels depth16Pixels;
+	// returned when asking for a channel that doesn't exist
+	ofPixels emptyPixels;
+	ofShortPixels emptyShortPixels;
+	ofxOscMessage emptyOscMessage;
+	vector<ofxGstOscMessageView> emptyOscMessageViews;
 
 	string src;
-
-	int videoSessionNumber;
-	int audioSessionNumber;
-	int depthSessionNumber;
-	int oscSessionNumber;
-	int lastSessionNumber;
-
-	guint videoSSRC;
-	guint depthSSRC;
-	guint audioSSRC;
-	guint oscSSRC;
-
-	bool videoReady;
-	bool depthReady;
-	bool audioReady;
-	bool oscReady;
+	bool retransmission;
+	bool fec;
+	int depthDecompressionThreads;
+	int oscQueueCapacity;
+	bool depth16Packed;
+	int depth16MaxDepth;
+
+	ofxGstRTPStatsCollector statsCollector;
+	ofxGstPipelineClock pipelineClock;
+	int statsInterval, statsHistorySize;
+	std::mutex jitterbuffersMutex;
 
 #if ENABLE_NAT_TRANSVERSAL
-	// ICE/XMPP related
-	shared_ptr<ofxNiceStream> videoStream;
-	shared_ptr<ofxNiceStream> depthStream;
-	shared_ptr<ofxNiceStream> oscStream;
-	shared_ptr<ofxNiceStream> audioStream;
+	// ICE/XMPP related, stream for the next channel to be added
+	shared_ptr<ofxNiceStream> nextNiceStream;
 	ofxXMPPJingleInitiation remoteJingle;
 #endif
 
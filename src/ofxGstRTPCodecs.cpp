@@ -0,0 +1,238 @@
+/*
+ * ofxGstRTPCodecs.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofxGstRTPCodecs.h"
+#include "ofUtils.h"
+
+const string ofxGstRTPCodecs::AUDIO_ENCODING_NAME = "X-GST-OPUS-DRAFT-SPITTKA-00";
+const string ofxGstRTPCodecs::APPLICATION_ENCODING_NAME = "X-GST";
+
+string ofxGstRTPCodecs::getEncodingName(ofxGstRTPVideoCodec codec){
+	switch(codec){
+	case OFX_GST_RTP_VP8:
+		return "VP8";
+	case OFX_GST_RTP_VP9:
+		return "VP9";
+	case OFX_GST_RTP_X265:
+		return "H265";
+	case OFX_GST_RTP_X264:
+	case OFX_GST_RTP_OPENH264:
+	default:
+		return "H264";
+	}
+}
+
+bool ofxGstRTPCodecs::getVideoCodec(const string & encodingName, ofxGstRTPVideoCodec & codec){
+	if(encodingName=="H264"){
+		codec = OFX_GST_RTP_X264;
+	}else if(encodingName=="H265"){
+		codec = OFX_GST_RTP_X265;
+	}else if(encodingName=="VP8"){
+		codec = OFX_GST_RTP_VP8;
+	}else if(encodingName=="VP9"){
+		codec = OFX_GST_RTP_VP9;
+	}else{
+		return false;
+	}
+	return true;
+}
+
+static string getEncoderElement(ofxGstRTPVideoCodec codec){
+	switch(codec){
+	case OFX_GST_RTP_OPENH264:
+		return "openh264enc";
+	case OFX_GST_RTP_VP8:
+		return "vp8enc";
+	case OFX_GST_RTP_VP9:
+		return "vp9enc";
+	case OFX_GST_RTP_X265:
+		return "x265enc";
+	case OFX_GST_RTP_X264:
+	default:
+		return "x264enc";
+	}
+}
+
+static string getPayloaderElement(ofxGstRTPVideoCodec codec){
+	switch(codec){
+	case OFX_GST_RTP_VP8:
+		return "rtpvp8pay";
+	case OFX_GST_RTP_VP9:
+		return "rtpvp9pay";
+	case OFX_GST_RTP_X265:
+		return "rtph265pay";
+	case OFX_GST_RTP_X264:
+	case OFX_GST_RTP_OPENH264:
+	default:
+		return "rtph264pay";
+	}
+}
+
+static string getEncodedCaps(ofxGstRTPVideoCodec codec){
+	switch(codec){
+	case OFX_GST_RTP_VP8:
+		return "video/x-vp8";
+	case OFX_GST_RTP_VP9:
+		return "video/x-vp9";
+	case OFX_GST_RTP_X265:
+		return "video/x-h265";
+	case OFX_GST_RTP_X264:
+	case OFX_GST_RTP_OPENH264:
+	default:
+		return "video/x-h264";
+	}
+}
+
+static bool isElementAvailable(const string & name){
+	GstElementFactory * factory = gst_element_factory_find(name.c_str());
+	if(factory){
+		gst_object_unref(factory);
+		return true;
+	}else{
+		return false;
+	}
+}
+
+bool ofxGstRTPCodecs::isEncoderAvailable(ofxGstRTPVideoCodec codec){
+	return isElementAvailable(getEncoderElement(codec)) && isElementAvailable(getPayloaderElement(codec));
+}
+
+bool ofxGstRTPCodecs::acceptsFormat(ofxGstRTPVideoCodec codec, ofPixelFormat format){
+	switch(format){
+	case OF_PIXELS_I420:
+		return true;
+	case OF_PIXELS_NV12:
+		return codec==OFX_GST_RTP_X264;
+	default:
+		return false;
+	}
+}
+
+bool ofxGstRTPCodecs::isRetransmissionAvailable(){
+	return isElementAvailable("rtprtxsend") && isElementAvailable("rtprtxreceive");
+}
+
+GstStructure * ofxGstRTPCodecs::getRetransmissionPayloadTypeMap(int payloadType){
+	return gst_structure_new("application/x-rtp-pt-map",
+			ofToString(payloadType).c_str(),G_TYPE_UINT,guint(payloadType+RTX_PAYLOAD_TYPE_OFFSET),
+			NULL);
+}
+
+bool ofxGstRTPCodecs::isFECAvailable(){
+	return isElementAvailable("rtpulpfecenc") && isElementAvailable("rtpulpfecdec") && isElementAvailable("rtpstorage");
+}
+
+string ofxGstRTPCodecs::getVideoEncoder(ofxGstRTPVideoCodec codec, int w, int h, int fps, int bitrate, int payloadType, const string & encoderName, bool depth){
+	// all the encoders are set for realtime: no frame reordering or lookahead
+	// and the fastest presets since we need to encode every frame as it arrives
+	string encoder;
+	switch(codec){
+	case OFX_GST_RTP_OPENH264:
+		encoder = "openh264enc bitrate=" + ofToString(bitrate*1000) + " rate-control=bitrate complexity=low";
+		break;
+	case OFX_GST_RTP_VP8:
+		encoder = "vp8enc deadline=1 cpu-used=" + string(depth?"4":"8") + " end-usage=cbr lag-in-frames=0 target-bitrate=" + ofToString(bitrate*1000);
+		break;
+	case OFX_GST_RTP_VP9:
+		encoder = "vp9enc deadline=1 cpu-used=8 end-usage=cbr lag-in-frames=0 target-bitrate=" + ofToString(bitrate*1000);
+		break;
+	case OFX_GST_RTP_X265:
+		encoder = "x265enc tune=zerolatency speed-preset=ultrafast bitrate=" + ofToString(bitrate);
+		break;
+	case OFX_GST_RTP_X264:
+	default:
+		// x264 settings from http://stackoverflow.com/questions/12221569/x264-rate-control
+		if(depth){
+			encoder = "x264enc tune=zerolatency byte-stream=true bitrate="+ofToString(bitrate)+" speed-preset=superfast psy-tune=psnr me=4 subme=10 b-adapt=0 vbv-buf-capacity=600";
+		}else{
+			encoder = "x264enc tune=zerolatency byte-stream=true bitrate=" + ofToString(bitrate) +" speed-preset=ultrafast"; //psy-tune=grain me=4 subme=10 b-adapt=1 vbv-buf-capacity=1000
+		}
+		break;
+	}
+
+	return encoder + " name=" + encoderName +
+			" ! " + getEncodedCaps(codec) + ",width="+ofToString(w)+ ",height="+ofToString(h)+",framerate="+ofToString(fps)+"/1" +
+			" ! " + getPayloaderElement(codec) + " pt=" + ofToString(payloadType) +
+			" ! " + getVideoRTPCaps(codec,payloadType) + " ";
+}
+
+void ofxGstRTPCodecs::setVideoBitrate(GstElement * encoder, ofxGstRTPVideoCodec codec, int bitrate){
+	if(!encoder) return;
+	switch(codec){
+	case OFX_GST_RTP_OPENH264:
+		g_object_set(G_OBJECT(encoder),"bitrate",guint(bitrate*1000),NULL);
+		break;
+	case OFX_GST_RTP_VP8:
+	case OFX_GST_RTP_VP9:
+		g_object_set(G_OBJECT(encoder),"target-bitrate",gint(bitrate*1000),NULL);
+		break;
+	case OFX_GST_RTP_X265:
+	case OFX_GST_RTP_X264:
+	default:
+		g_object_set(G_OBJECT(encoder),"bitrate",guint(bitrate),NULL);
+		break;
+	}
+}
+
+string ofxGstRTPCodecs::getVideoDepayloader(ofxGstRTPVideoCodec codec){
+	switch(codec){
+	case OFX_GST_RTP_VP8:
+		return "rtpvp8depay";
+	case OFX_GST_RTP_VP9:
+		return "rtpvp9depay";
+	case OFX_GST_RTP_X265:
+		return "rtph265depay";
+	case OFX_GST_RTP_X264:
+	case OFX_GST_RTP_OPENH264:
+	default:
+		return "rtph264depay";
+	}
+}
+
+string ofxGstRTPCodecs::getVideoDecoder(ofxGstRTPVideoCodec codec){
+	switch(codec){
+	case OFX_GST_RTP_VP8:
+		return "vp8dec";
+	case OFX_GST_RTP_VP9:
+		return "vp9dec";
+	case OFX_GST_RTP_X265:
+		return "avdec_h265";
+	case OFX_GST_RTP_X264:
+	case OFX_GST_RTP_OPENH264:
+	default:
+		return "avdec_h264";
+	}
+}
+
+string ofxGstRTPCodecs::getVideoRTPCaps(ofxGstRTPVideoCodec codec, int payloadType){
+	return "application/x-rtp,media=(string)video,clock-rate=(int)" + ofToString(VIDEO_CLOCK_RATE) +
+			",payload=(int)" + ofToString(payloadType) +
+			",encoding-name=(string)" + getEncodingName(codec) +
+			",rtcp-fb-nack-pli=(int)1";
+}
+
+string ofxGstRTPCodecs::getAudioRTPCaps(int payloadType){
+	return "application/x-rtp,media=(string)audio,clock-rate=(int)" + ofToString(AUDIO_CLOCK_RATE) +
+			",payload=(int)" + ofToString(payloadType) +
+			",encoding-name=(string)" + AUDIO_ENCODING_NAME;
+}
+
+// the caps field is the base64 encoded caps of the stream before payloading
+// application/x-compresseddepth and application/x-osc respectively
+
+string ofxGstRTPCodecs::getDepth16RTPCaps(int payloadType){
+	return "application/x-rtp,media=(string)application,clock-rate=(int)" + ofToString(APPLICATION_CLOCK_RATE) +
+			",payload=(int)" + ofToString(payloadType) +
+			",encoding-name=(string)" + APPLICATION_ENCODING_NAME +
+			",caps=(string)\"YXBwbGljYXRpb24veC1jb21wcmVzc2VkZGVwdGg\\=\"";
+}
+
+string ofxGstRTPCodecs::getOscRTPCaps(int payloadType){
+	return "application/x-rtp,media=(string)application,clock-rate=(int)" + ofToString(APPLICATION_CLOCK_RATE) +
+			",payload=(int)" + ofToString(payloadType) +
+			",encoding-name=(string)" + APPLICATION_ENCODING_NAME +
+			",caps=(string)\"YXBwbGljYXRpb24veC1vc2M\\=\"";
+}
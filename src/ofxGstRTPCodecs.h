@@ -0,0 +1,96 @@
+/*
+ * ofxGstRTPCodecs.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTRTPCODECS_H_
+#define OFXGSTRTPCODECS_H_
+
+#include "ofConstants.h"
+#include <gst/gst.h>
+
+/// software video encoders that can be used for the video and 8bits depth
+/// channels. The client only needs to know the encoding (H264, H265, VP8,
+/// VP9) so both H264 encoders can be received with the same decoder
+enum ofxGstRTPVideoCodec{
+	OFX_GST_RTP_X264,
+	OFX_GST_RTP_OPENH264,
+	OFX_GST_RTP_VP8,
+	OFX_GST_RTP_VP9,
+	OFX_GST_RTP_X265
+};
+
+/// payload types, encoding names and gstreamer elements used by every kind
+/// of channel so server, client and the session negotiation in
+/// ofxGstXMPPRTP always agree
+class ofxGstRTPCodecs{
+public:
+	static const int VIDEO_PAYLOAD_TYPE = 96;
+	static const int AUDIO_PAYLOAD_TYPE = 97;
+	static const int DEPTH_PAYLOAD_TYPE = 98;
+	static const int OSC_PAYLOAD_TYPE = 99;
+
+	/// retransmissions (RFC 4588) of each payload type are sent in the same
+	/// session with this offset, eg. 106 for video
+	static const int RTX_PAYLOAD_TYPE_OFFSET = 10;
+
+	/// forward error correction (ULPFEC, RFC 5109) packets of each payload
+	/// type are sent in the same session with this offset, eg. 116 for video
+	static const int FEC_PAYLOAD_TYPE_OFFSET = 20;
+
+	static const int VIDEO_CLOCK_RATE = 90000;
+	static const int AUDIO_CLOCK_RATE = 48000;
+	static const int APPLICATION_CLOCK_RATE = 90000;
+
+	static const string AUDIO_ENCODING_NAME;
+	static const string APPLICATION_ENCODING_NAME;
+
+	/// encoding name of a codec as used in RTP caps and jingle payloads
+	static string getEncodingName(ofxGstRTPVideoCodec codec);
+
+	/// returns the codec corresponding to an encoding name received from the
+	/// remote peer, for H264 it returns x264 since both H264 encoders use the
+	/// same depayloader and decoder. Returns false if the encoding is not supported
+	static bool getVideoCodec(const string & encodingName, ofxGstRTPVideoCodec & codec);
+
+	/// returns false if the gstreamer plugins needed to encode with this
+	/// codec are not installed
+	static bool isEncoderAvailable(ofxGstRTPVideoCodec codec);
+
+	/// returns true if the encoder of a codec accepts raw frames in this
+	/// format without converting them first. Every encoder accepts I420,
+	/// only x264 accepts NV12
+	static bool acceptsFormat(ofxGstRTPVideoCodec codec, ofPixelFormat format);
+
+	/// returns false if the rtprtxsend and rtprtxreceive elements are not installed
+	static bool isRetransmissionAvailable();
+
+	/// payload type map used by rtprtxsend and rtprtxreceive to know the
+	/// retransmission payload type of a stream, has to be freed by the caller
+	static GstStructure * getRetransmissionPayloadTypeMap(int payloadType);
+
+	/// returns false if the rtpulpfecenc, rtpulpfecdec and rtpstorage
+	/// elements are not installed
+	static bool isFECAvailable();
+
+	/// pipeline description of encoder ! caps ! payloader ! rtp caps
+	/// bitrate is in kbps. The depth version tunes the encoder for depth
+	/// images when the encoder has any option for it
+	static string getVideoEncoder(ofxGstRTPVideoCodec codec, int w, int h, int fps, int bitrate, int payloadType, const string & encoderName, bool depth=false);
+
+	/// changes the bitrate of an encoder created with getVideoEncoder, in kbps
+	static void setVideoBitrate(GstElement * encoder, ofxGstRTPVideoCodec codec, int bitrate);
+
+	/// element names for the depayloader and decoder to receive a codec
+	static string getVideoDepayloader(ofxGstRTPVideoCodec codec);
+	static string getVideoDecoder(ofxGstRTPVideoCodec codec);
+
+	/// caps of the RTP streams for each kind of channel
+	static string getVideoRTPCaps(ofxGstRTPVideoCodec codec, int payloadType);
+	static string getAudioRTPCaps(int payloadType);
+	static string getDepth16RTPCaps(int payloadType);
+	static string getOscRTPCaps(int payloadType);
+};
+
+#endif /* OFXGSTRTPCODECS_H_ */
@@ -0,0 +1,80 @@
+/*
+ * ofxGstRTPFECController.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofxGstRTPFECController.h"
+#include <algorithm>
+#include <cmath>
+
+// smoothing of the loss when it increases and decreases, going up fast
+// protects the stream as soon as the network gets worse
+static const float LOSS_UP_WEIGHT = 0.5;
+static const float LOSS_DOWN_WEIGHT = 0.1;
+
+// changes smaller than this are ignored so the encoder is not
+// reconfigured with every report
+static const int MIN_PERCENTAGE_CHANGE = 2;
+
+ofxGstRTPFECController::ofxGstRTPFECController()
+:percentage(0)
+,minPercentage(0)
+,maxPercentage(100)
+,lossFactor(3)
+,smoothedLoss(0)
+,haveReport(false)
+,lastSeq(0){
+
+}
+
+void ofxGstRTPFECController::setup(int initialPercentage, int minPercentage, int maxPercentage){
+	this->minPercentage = std::max(0,std::min(minPercentage,maxPercentage));
+	this->maxPercentage = std::min(100,std::max(minPercentage,maxPercentage));
+	percentage = std::max(this->minPercentage,std::min(this->maxPercentage,initialPercentage));
+	reset();
+}
+
+void ofxGstRTPFECController::reset(){
+	smoothedLoss = percentage / 100.f / lossFactor;
+	haveReport = false;
+	lastSeq = 0;
+}
+
+bool ofxGstRTPFECController::update(const ofxGstRTPReceiverReport & report){
+	if(haveReport && report.extHighestSeq==lastSeq){
+		return false;
+	}
+	haveReport = true;
+	lastSeq = report.extHighestSeq;
+
+	float weight = report.fractionLost>smoothedLoss ? LOSS_UP_WEIGHT : LOSS_DOWN_WEIGHT;
+	smoothedLoss += (report.fractionLost - smoothedLoss) * weight;
+
+	int target = std::ceil(smoothedLoss * lossFactor * 100);
+	target = std::max(minPercentage,std::min(maxPercentage,target));
+	if(std::abs(target-percentage)<MIN_PERCENTAGE_CHANGE && target!=minPercentage && target!=maxPercentage){
+		return false;
+	}
+	if(target==percentage){
+		return false;
+	}
+	percentage = target;
+	return true;
+}
+
+int ofxGstRTPFECController::getPercentage() const{
+	return percentage;
+}
+
+int ofxGstRTPFECController::getMinPercentage() const{
+	return minPercentage;
+}
+
+int ofxGstRTPFECController::getMaxPercentage() const{
+	return maxPercentage;
+}
+
+void ofxGstRTPFECController::setLossFactor(float factor){
+	lossFactor = std::max(0.f,factor);
+}
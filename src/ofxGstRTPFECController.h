@@ -0,0 +1,49 @@
+/*
+ * ofxGstRTPFECController.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTRTPFECCONTROLLER_H_
+#define OFXGSTRTPFECCONTROLLER_H_
+
+#include "ofConstants.h"
+#include "ofxGstRTPBitrateController.h"
+
+/// chooses the amount of forward error correction of a channel from the
+/// loss in the RTCP receiver reports. The overhead is the percentage of FEC
+/// packets over media packets as used by rtpulpfecenc: with XOR parity each
+/// FEC packet can recover one packet of the ones it protects so the
+/// overhead needs to be a few times the loss to recover most of it when
+/// the losses are not perfectly spread. The loss is smoothed so a single
+/// report doesn't change it and it goes up fast and down slowly
+class ofxGstRTPFECController{
+public:
+	ofxGstRTPFECController();
+
+	void setup(int initialPercentage, int minPercentage, int maxPercentage);
+
+	/// feeds a new receiver report, reports that were already processed
+	/// are ignored. Returns true if the percentage changed
+	bool update(const ofxGstRTPReceiverReport & report);
+
+	/// forgets the history of reports but keeps the current percentage
+	void reset();
+
+	int getPercentage() const;
+	int getMinPercentage() const;
+	int getMaxPercentage() const;
+
+	/// overhead used per unit of loss, defaults to 3, so 5% loss uses 15%
+	void setLossFactor(float factor);
+
+private:
+	int percentage;
+	int minPercentage, maxPercentage;
+	float lossFactor;
+	float smoothedLoss;
+	bool haveReport;
+	unsigned int lastSeq;
+};
+
+#endif /* OFXGSTRTPFECCONTROLLER_H_ */
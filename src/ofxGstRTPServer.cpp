@@ -10,6 +10,7 @@
 #include <gst/app/gstappsrc.h>
 #include <gst/video/video.h>
 #include <gst/video/gstvideometa.h>
+#include <gst/rtp/gstrtcpbuffer.h>
 
 #include <glib-object.h>
 #include <glib.h>
@@ -82,44 +83,109 @@
 
 string ofxGstRTPServer::LOG_NAME="ofxGstRTPServer";
 
-ofxGstRTPServer::ofxGstRTPServer()
-:vRTPsink(NULL)
-,vRTPCsink(NULL)
-,vRTPCsrc(NULL)
-,vEncoder(NULL)
-,dEncoder(NULL)
-,aEncoder(NULL)
-,appSrcVideoRGB(NULL)
-,appSrcDepth(NULL)
-,appSrcOsc(NULL)
-,bufferPool(NULL)
-,bufferPoolDepth(NULL)
-,fps(0)
-,prevTimestamp(0)
-,numFrame(0)
-,prevTimestampDepth(0)
-,numFrameDepth(0)
-,prevTimestampOsc(0)
-,numFrameOsc(0)
-,prevTimestampAudio(0)
-,numFrameAudio(0)
+ofxGstRTPServer::Channel::Channel(ofxGstRTPChannel type, int index, guint session)
+:type(type)
+,index(index)
+,session(session)
+,port(0)
+,layer(0)
+,numLayers(1)
+,payloadType(0)
+,retransmission(false)
+,fec(false)
+,appsrc(NULL)
+,encoder(NULL)
+,rtpsink(NULL)
+,rtcpsink(NULL)
+,rtcpsrc(NULL)
+,rtxsend(NULL)
+,fecenc(NULL)
+,pool(NULL)
+,poolConverted(NULL)
 ,width(0)
 ,height(0)
-,lastSessionNumber(0)
-,videoSessionNumber(-1)
-,audioSessionNumber(-1)
-,depthSessionNumber(-1)
-,oscSessionNumber(-1)
-,videoSSRC(0)
-,audioSSRC(0)
-,depthSSRC(0)
-,oscSSRC(0)
-,sendVideoKeyFrame(true)
-,sendDepthKeyFrame(true)
-,firstVideoFrame(true)
-,firstOscFrame(true)
-,firstDepthFrame(true)
-,firstAudioFrame(true)
+,format(OF_PIXELS_RGB)
+,codec(OFX_GST_RTP_X264)
+,depth16(false)
+,depth16Packed(false)
+,oscBundled(false)
+,oscBundleWindowUs(0)
+,oscBundleMaxBytes(0)
+,oscBundle(NULL)
+,oscBundleTimestamp(GST_CLOCK_TIME_NONE)
+,oscBundleStart(0)
+,autoTimestamp(false)
+,firstFrame(true)
+,prevTimestamp(0)
+,numFrame(0)
+,sendKeyFrame(true)
+,keyframesRequested(0){
+
+}
+
+ofxGstRTPServer::Channel::~Channel(){
+	bitrate.removeListener(this,&Channel::bitrateChanged);
+	// the pools are deleted once gstreamer returns all their buffers
+	if(pool) pool->close();
+	if(poolConverted) poolConverted->close();
+	converter.close();
+	depthCompressor.close();
+	// a bundle that was never sent
+	if(oscBundle) ofxOscPacketPool::relaseBuffer(oscBundle);
+}
+
+void ofxGstRTPServer::Channel::bitrateChanged(int & bitrate){
+	if(type==OFX_GST_RTP_AUDIO){
+		if(encoder) g_object_set(G_OBJECT(encoder),"bitrate",bitrate,NULL);
+	}else{
+		ofxGstRTPCodecs::setVideoBitrate(encoder,codec,bitrate);
+	}
+	bitrateController.setTargetBitrate(bitrate);
+}
+
+string ofxGstRTPServer::Channel::getElementName(const string & name) const{
+	// every element is prefixed with the type of the channel and suffixed
+	// with its index so several channels of the same type can coexist
+	string prefix;
+	switch(type){
+	case OFX_GST_RTP_VIDEO: prefix = "v"; break;
+	case OFX_GST_RTP_DEPTH: prefix = "d"; break;
+	case OFX_GST_RTP_AUDIO: prefix = "a"; break;
+	case OFX_GST_RTP_OSC: prefix = "o"; break;
+	default: break;
+	}
+	string suffix = ofToString(index);
+	if(layer>0){
+		suffix += "l" + ofToString(layer);
+	}
+	return prefix + name + suffix;
+}
+
+ofxGstRTPServer::ofxGstRTPServer()
+:rtpbin(NULL)
+,convertVideoInProcess(true)
+,videoConversionThreads(0)
+,depthCompressionThreads(0)
+,depthCompressionTiles(0)
+,depth16Packed(false)
+,depth16MaxDepth(ofxGstDepth16Packer::DEFAULT_MAX_DEPTH)
+,oscBundled(false)
+,oscBundleWindowUs(0)
+,oscBundleMaxBytes(DEFAULT_OSC_BUNDLE_BYTES)
+,oscCompression(OFX_GST_OSC_COMPRESSION_ADAPTIVE)
+,oscCompressionMinBytes(ofxGstOscEncoder::DEFAULT_MIN_BYTES)
+,poolCapacity(ofxGstBufferPool<unsigned char>::DEFAULT_CAPACITY)
+,poolOverflow(OFX_GST_POOL_DROP_OLDEST)
+,videoCodec(OFX_GST_RTP_X264)
+,depthCodec(OFX_GST_RTP_X264)
+,videoLayers(1)
+,retransmission(ofxGstRTPCodecs::isRetransmissionAvailable())
+,retransmissionHistory(1000)
+,fec(false)
+,adaptiveFEC(true)
+,fecPercentage(10)
+,fecMinPercentage(5)
+,fecMaxPercentage(50)
 #if ENABLE_ECHO_CANCEL
 ,audioChannelReady(false)
 ,echoCancel(0)
@@ -127,19 +193,20 @@ ofxGstRTPServer::ofxGstRTPServer()
 ,audioFramesProcessed(0)
 ,analogAudio(0x10000U)
 #endif
-,videoAutoTimestamp(false)
-,depthAutoTimestamp(false)
-,audioAutoTimestamp(false)
-,oscAutoTimestamp(false)
+,statsInterval(ofxGstRTPStatsCollector::DEFAULT_INTERVAL_MS)
+,statsHistorySize(ofxGstRTPStatsCollector::DEFAULT_HISTORY_SIZE)
 {
 	videoBitrate.set("video bitrate (kbps)",300,0,6000);
-	videoBitrate.addListener(this,&ofxGstRTPServer::vBitRateChanged);
 	depthBitrate.set("depth bitrate (kbps)",1024,0,6000);
-	depthBitrate.addListener(this,&ofxGstRTPServer::dBitRateChanged);
 	audioBitrate.set("audio bitrate (bps)",64000,4000,650000);
-	audioBitrate.addListener(this,&ofxGstRTPServer::aBitRateChanged);
+	adaptiveBitrate.set("adaptive bitrate",false);
 	reverseDriftCalculation.set("reverse drift calc.",false);
 	parameters.setName("gst rtp server");
+	parameters.add(adaptiveBitrate);
+
+	videoBitrateController.setup(videoBitrate,100,6000);
+	depthBitrateController.setup(depthBitrate,100,6000);
+	audioBitrateController.setup(audioBitrate,8000,128000);
 
 #if ENABLE_ECHO_CANCEL
 	GstMapInfo mapinfo = {0,};
@@ -151,60 +218,481 @@ ofxGstRTPServer::~ofxGstRTPServer() {
 	close();
 }
 
+ofxGstRTPServer::Channel & ofxGstRTPServer::createChannel(ofxGstRTPChannel type, int port, bool autotimestamp){
+	// session numbers are consecutive so they can be used as index
+	shared_ptr<Channel> channel(new Channel(type,channelsByType[type].size(),channels.size()));
+	channel->port = port;
+	channel->autoTimestamp = autotimestamp;
+	switch(type){
+	case OFX_GST_RTP_VIDEO: channel->payloadType = ofxGstRTPCodecs::VIDEO_PAYLOAD_TYPE; break;
+	case OFX_GST_RTP_DEPTH: channel->payloadType = ofxGstRTPCodecs::DEPTH_PAYLOAD_TYPE; break;
+	case OFX_GST_RTP_AUDIO: channel->payloadType = ofxGstRTPCodecs::AUDIO_PAYLOAD_TYPE; break;
+	case OFX_GST_RTP_OSC: channel->payloadType = ofxGstRTPCodecs::OSC_PAYLOAD_TYPE; break;
+	default: break;
+	}
+	// opus conceals lost audio packets by itself and a retransmission
+	// would arrive too late for it anyway
+	channel->retransmission = retransmission && type!=OFX_GST_RTP_AUDIO;
+	// opus has its own in band FEC
+	channel->fec = fec && type!=OFX_GST_RTP_AUDIO;
+	channel->fecController.setup(fecPercentage,adaptiveFEC?fecMinPercentage:fecPercentage,adaptiveFEC?fecMaxPercentage:fecPercentage);
+#if ENABLE_NAT_TRANSVERSAL
+	channel->niceStream = nextNiceStream;
+	nextNiceStream.reset();
+#endif
+	channels.push_back(channel);
+	channelsByType[type].push_back(channel);
+	return *channel;
+}
+
+ofxGstRTPServer::Channel & ofxGstRTPServer::createLayerChannel(Channel & base, int layer){
+	// a layer has its own session but shares the index of its channel,
+	// each layer uses the next 5 ports
+	shared_ptr<Channel> channel(new Channel(base.type,base.index,channels.size()));
+	channel->layer = layer;
+	channel->numLayers = base.numLayers;
+	channel->port = base.port + layer*5;
+	channel->width = max(2,(base.width>>layer) & ~1);
+	channel->height = max(2,(base.height>>layer) & ~1);
+	channel->format = base.format;
+	channel->codec = base.codec;
+	channel->autoTimestamp = base.autoTimestamp;
+	channel->payloadType = base.payloadType;
+	channel->retransmission = base.retransmission;
+	channel->fec = base.fec;
+	channel->fecController = base.fecController;
+	channels.push_back(channel);
+	base.layers.push_back(channel.get());
+	return *channel;
+}
+
+void ofxGstRTPServer::setupChannelBitrate(Channel & channel, ofParameter<int> & bitrate, const ofxGstRTPBitrateController & settings){
+	// the first channel of each type uses the public parameter, the rest
+	// get their own starting from the same value. simulcast layers have
+	// a quarter of the pixels of the previous one so they start with a
+	// quarter of its bitrate
+	int shift = channel.layer*2;
+	if(channel.index==0 && channel.layer==0){
+		channel.bitrate.makeReferenceTo(bitrate);
+	}else if(channel.layer==0){
+		channel.bitrate.set(bitrate.getName() + " " + ofToString(channel.index),bitrate,bitrate.getMin(),bitrate.getMax());
+	}else{
+		channel.bitrate.set(bitrate.getName() + " " + ofToString(channel.index) + " layer " + ofToString(channel.layer),max(bitrate.getMin(),int(bitrate)>>shift),bitrate.getMin(),bitrate.getMax());
+	}
+	channel.bitrate.addListener(&channel,&Channel::bitrateChanged);
+	channel.bitrateController = settings;
+	if(shift>0){
+		channel.bitrateController.setBounds(max(1,settings.getMinBitrate()>>shift),max(1,settings.getMaxBitrate()>>shift));
+	}
+	channel.bitrateController.setTargetBitrate(channel.bitrate);
+	parameters.add(channel.bitrate);
+}
+
+ofxGstRTPServer::Channel * ofxGstRTPServer::getChannel(ofxGstRTPChannel type, int index){
+	if(index<0 || index>=int(channelsByType[type].size())){
+		return NULL;
+	}
+	return channelsByType[type][index].get();
+}
+
+ofxGstRTPServer::Channel * ofxGstRTPServer::getVideoLayer(int channel, int layer){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	if(!video || layer<0 || layer>=video->numLayers){
+		return NULL;
+	}
+	return layer==0 ? video : video->layers[layer-1];
+}
+
+string ofxGstRTPServer::getNetworkElements(const Channel & channel){
+	string rtpsink;
+	string rtcpsink;
+	string rtcpsrc;
+
+#if ENABLE_NAT_TRANSVERSAL
+	if(channel.niceStream){
+		rtpsink="nicesink ts-offset=0 name=" + channel.getElementName("rtpsink") + " max-lateness=5000000000 ";
+		rtcpsink="nicesink sync=false async=false name=" + channel.getElementName("rtcpsink") + " max-lateness=5000000000 ";
+		rtcpsrc="nicesrc name=" + channel.getElementName("rtcpsrc");
+	}else
+#endif
+	{
+		// multiudpsink so the same encoded stream can be sent to several
+		// destinations that can change while playing
+		rtpsink="multiudpsink " + getClients(channel,channel.port) + " ts-offset=0 force-ipv4=1 name=" + channel.getElementName("rtpsink");
+		rtcpsink="multiudpsink " + getClients(channel,channel.port+1) + " sync=false async=false force-ipv4=1 name=" + channel.getElementName("rtcpsink");
+		rtcpsrc="udpsrc port=" + ofToString(channel.port+3) + " name=" + channel.getElementName("rtcpsrc");
+	}
+
+	// the retransmission sender keeps the last packets to resend them when
+	// a NACK arrives, rtpbin sends it upstream from the session
+	string rtxsend;
+	if(channel.retransmission){
+		rtxsend = " ! rtprtxsend name=" + channel.getElementName("rtxsend") + " max-size-time=" + ofToString(retransmissionHistory) + " max-size-packets=0";
+	}
+
+	// the FEC packets go in the same stream with their own payload type
+	// and are also kept by the retransmission sender
+	string fecenc;
+	if(channel.fec){
+		fecenc = " ! rtpulpfecenc name=" + channel.getElementName("fecenc") +
+				" pt=" + ofToString(channel.payloadType+ofxGstRTPCodecs::FEC_PAYLOAD_TYPE_OFFSET) +
+				" percentage=" + ofToString(channel.fecController.getPercentage());
+	}
+
+	string session = ofToString(channel.session);
+	return fecenc + rtxsend + " ! rtpbin.send_rtp_sink_" + session +
+			" rtpbin.send_rtp_src_" + session + " ! " + rtpsink +
+			" rtpbin.send_rtcp_src_" + session + " ! " + rtcpsink +
+			" " + rtcpsrc + " ! rtpbin.recv_rtcp_sink_" + session + " ";
+}
+
+
+bool ofxGstRTPServer::isSentTo(const Channel & channel, const string & host){
+	if(channel.numLayers==1){
+		return true;
+	}
+	map<string,int>::iterator it = destinationLayers.find(host);
+	if(it==destinationLayers.end() || it->second<0){
+		return true;
+	}
+	return channel.layer == min(it->second,channel.numLayers-1);
+}
+
+string ofxGstRTPServer::getClients(const Channel & channel, int port){
+	string clients;
+	for(size_t i=0;i<destinations.size();i++){
+		if(!isSentTo(channel,destinations[i])) continue;
+		clients += (clients.empty() ? "clients=" : ",") + destinations[i] + ":" + ofToString(port);
+	}
+	return clients;
+}
+
+bool ofxGstRTPServer::addDestination(const string & host){
+	if(find(destinations.begin(),destinations.end(),host)!=destinations.end()){
+		ofLogWarning(LOG_NAME) << "destination " << host << " already added";
+		return false;
+	}
+	destinations.push_back(host);
+
+	// once playing the sinks are updated directly, before that
+	// the destinations are added to the pipeline description
+	for(size_t i=0;i<channels.size();i++){
+		Channel & channel = *channels[i];
+#if ENABLE_NAT_TRANSVERSAL
+		if(channel.niceStream) continue;
+#endif
+		if(channel.rtpsink && isSentTo(channel,host)){
+			g_signal_emit_by_name(channel.rtpsink,"add",host.c_str(),channel.port,NULL);
+			g_signal_emit_by_name(channel.rtcpsink,"add",host.c_str(),channel.port+1,NULL);
+
+			// the new receiver can't decode anything until the next keyframe,
+			// keep sending them until its first rtcp arrives
+			if(channel.type==OFX_GST_RTP_VIDEO || channel.type==OFX_GST_RTP_DEPTH){
+				channel.sendKeyFrame = true;
+				emitKeyFrame(channel);
+			}
+		}
+	}
+	return true;
+}
+
+bool ofxGstRTPServer::removeDestination(const string & host){
+	vector<string>::iterator it = find(destinations.begin(),destinations.end(),host);
+	if(it==destinations.end()){
+		ofLogWarning(LOG_NAME) << "destination " << host << " not found";
+		return false;
+	}
+	destinations.erase(it);
+
+	for(size_t i=0;i<channels.size();i++){
+		Channel & channel = *channels[i];
+#if ENABLE_NAT_TRANSVERSAL
+		if(channel.niceStream) continue;
+#endif
+		if(channel.rtpsink && isSentTo(channel,host)){
+			g_signal_emit_by_name(channel.rtpsink,"remove",host.c_str(),channel.port,NULL);
+			g_signal_emit_by_name(channel.rtcpsink,"remove",host.c_str(),channel.port+1,NULL);
+		}
+	}
+	destinationLayers.erase(host);
+	return true;
+}
+
+vector<string> ofxGstRTPServer::getDestinations(){
+	return destinations;
+}
+
+bool ofxGstRTPServer::setDestinationVideoLayer(const string & host, int layer){
+	if(find(destinations.begin(),destinations.end(),host)==destinations.end()){
+		ofLogWarning(LOG_NAME) << "destination " << host << " not found";
+		return false;
+	}
+
+	vector<bool> sentBefore(channels.size());
+	for(size_t i=0;i<channels.size();i++){
+		sentBefore[i] = isSentTo(*channels[i],host);
+	}
+	destinationLayers[host] = layer;
+
+	// only the layers that change are added or removed from the sinks
+	for(size_t i=0;i<channels.size();i++){
+		Channel & channel = *channels[i];
+		bool sent = isSentTo(channel,host);
+		if(!channel.rtpsink || sent==sentBefore[i]) continue;
+		if(sent){
+			g_signal_emit_by_name(channel.rtpsink,"add",host.c_str(),channel.port,NULL);
+			g_signal_emit_by_name(channel.rtcpsink,"add",host.c_str(),channel.port+1,NULL);
+			channel.sendKeyFrame = true;
+			emitKeyFrame(channel);
+		}else{
+			g_signal_emit_by_name(channel.rtpsink,"remove",host.c_str(),channel.port,NULL);
+			g_signal_emit_by_name(channel.rtcpsink,"remove",host.c_str(),channel.port+1,NULL);
+		}
+	}
+	return true;
+}
+
+int ofxGstRTPServer::addVideoChannel(int port, int w, int h, int fps, bool autotimestamp, ofPixelFormat format){
+	GstVideoFormat gstFormat = ofxGstRTPUtils::getGstVideoFormat(format);
+	if(gstFormat==GST_VIDEO_FORMAT_UNKNOWN || format==OF_PIXELS_GRAY){
+		ofLogError(LOG_NAME) << "unsupported video format " << format << ", using RGB";
+		format = OF_PIXELS_RGB;
+		gstFormat = GST_VIDEO_FORMAT_RGB;
+	}
+
+	// RGB frames are converted to I420 in the addon when possible
+	// so the pipeline receives a format the encoder accepts directly
+	ofPixelFormat pipelineFormat = format;
+	if(format==OF_PIXELS_RGB && convertVideoInProcess && ofxGstVideoConverter::isSupported(w,h)){
+		pipelineFormat = OF_PIXELS_I420;
+		gstFormat = GST_VIDEO_FORMAT_I420;
+	}
+
+	if(!ofxGstRTPCodecs::isEncoderAvailable(videoCodec)){
+		ofLogError(LOG_NAME) << "video encoder for " << ofxGstRTPCodecs::getEncodingName(videoCodec) << " not available, using x264";
+		videoCodec = OFX_GST_RTP_X264;
+	}
+
+	int numLayers = videoLayers;
+#if ENABLE_NAT_TRANSVERSAL
+	if(nextNiceStream && numLayers>1){
+		ofLogError(LOG_NAME) << "simulcast layers are only supported through udp, sending only one";
+		numLayers = 1;
+	}
+#endif
+
+	Channel & channel = createChannel(OFX_GST_RTP_VIDEO,port,autotimestamp);
+	channel.format = format;
+	channel.width = w;
+	channel.height = h;
+	channel.codec = videoCodec;
+	channel.numLayers = numLayers;
+	setupChannelBitrate(channel,videoBitrate,videoBitrateController);
 
-void ofxGstRTPServer::addVideoChannel(int port, int w, int h, int fps, bool autotimestamp){
-	videoSessionNumber = lastSessionNumber;
-	videoAutoTimestamp = autotimestamp;
-	lastSessionNumber++;
 	// video elements
 	// ------------------
 		// appsrc, allows to pass new frames from the app using the newFrame method
-		string velem="appsrc is-live=1 do-timestamp="+ string(autotimestamp?"1":"0") +" format=time name=appsrcvideo";
+		string velem="appsrc is-live=1 do-timestamp="+ string(autotimestamp?"1":"0") +" format=time name=" + channel.getElementName("appsrc");
 
 		// video format that we are pushing to the pipeline
-		string vcaps="video/x-raw,format=RGB,width="+ofToString(w)+ ",height="+ofToString(h)+",framerate="+ofToString(fps)+"/1";
+		string vcaps="video/x-raw,format="+string(gst_video_format_to_string(gstFormat))+",width="+ofToString(w)+ ",height="+ofToString(h)+",framerate="+ofToString(fps)+"/1";
+		if(pipelineFormat!=format){
+			vcaps += ",colorimetry=bt601";
+		}
 
-		// queue so the conversion and encoding happen in a different thread to appsrc
-		string vsource= velem + " ! " + vcaps + " ! videoconvert name=vconvert1 ";
+		// formats the encoder doesn't accept directly need to be converted first
+		string vconvert;
+		if(!ofxGstRTPCodecs::acceptsFormat(channel.codec,pipelineFormat)){
+			vconvert = " ! videoconvert name=" + channel.getElementName("convert");
+		}
 
-		// h264 encoder + rtp pay
-		// x264 settings from http://stackoverflow.com/questions/12221569/x264-rate-control
-		string venc="x264enc tune=zerolatency byte-stream=true bitrate=" + ofToString(videoBitrate) +" speed-preset=ultrafast name=vencoder ! video/x-h264,width="+ofToString(w)+ ",height="+ofToString(h)+",framerate="+ofToString(fps)+"/1 ! rtph264pay pt=96 ! application/x-rtp,media=(string)video,clock-rate=(int)90000,payload=(int)96,encoding-name=(string)H264,rtcp-fb-nack-pli=(int)1 "; //psy-tune=grain me=4 subme=10 b-adapt=1 vbv-buf-capacity=1000
+		// queue so the conversion and encoding happen in a different thread to appsrc
+		string vsource= velem + " ! " + vcaps + getPoolQueue() + vconvert;
 
-	// video rtpc
-	// ------------------
-		string vrtpsink;
-		string vrtpcsink;
-		string vrtpcsrc;
+		// encoder + rtp pay
+		string venc=ofxGstRTPCodecs::getVideoEncoder(channel.codec,w,h,fps,channel.bitrate,ofxGstRTPCodecs::VIDEO_PAYLOAD_TYPE,channel.getElementName("encoder"));
 
-#if ENABLE_NAT_TRANSVERSAL
-		if(videoStream){
-			vrtpsink="nicesink ts-offset=0 name=vrtpsink max-lateness=5000000000 ";
-			vrtpcsink="nicesink  sync=false async=false name=vrtcpsink max-lateness=5000000000 ";
-			vrtpcsrc="nicesrc name=vrtcpsrc";
-		}else
-#endif
-		{
-			vrtpsink="udpsink port=" + ofToString(port) + " host="+dest+" ts-offset=0 force-ipv4=1 name=vrtpsink";
-			vrtpcsink="udpsink port=" + ofToString(port+1) + " host="+dest+" sync=false async=false force-ipv4=1 name=vrtcpsink";
-			vrtpcsrc="udpsrc port=" + ofToString(port+3) + " name=vrtcpsrc";
+	if(numLayers==1){
+		pipelineStr += " " + vsource + " ! " + venc + getNetworkElements(channel);
+	}else{
+		// simulcast: the converted frames are split with a tee, the first
+		// layer encodes them as they are and the rest scale them down first.
+		// the queues in the scaled layers are leaky so a slow layer doesn't
+		// stall the others
+		string tee = channel.getElementName("tee");
+		pipelineStr += " " + vsource + " ! tee name=" + tee + " " + tee + ". ! queue ! " + venc + getNetworkElements(channel);
+		for(int i=1;i<numLayers;i++){
+			Channel & layer = createLayerChannel(channel,i);
+			setupChannelBitrate(layer,videoBitrate,videoBitrateController);
+			string lscale = "queue leaky=downstream max-size-buffers=2 max-size-bytes=0 max-size-time=0 ! videoscale name=" + layer.getElementName("scale") +
+					" ! video/x-raw,width=" + ofToString(layer.width) + ",height=" + ofToString(layer.height);
+			string lenc = ofxGstRTPCodecs::getVideoEncoder(layer.codec,layer.width,layer.height,fps,layer.bitrate,ofxGstRTPCodecs::VIDEO_PAYLOAD_TYPE,layer.getElementName("encoder"));
+			pipelineStr += " " + tee + ". ! " + lscale + " ! " + lenc + getNetworkElements(layer);
 		}
-
-	pipelineStr += " " + vsource + " ! " + venc + " ! rtpbin.send_rtp_sink_" + ofToString(videoSessionNumber) +
-				" rtpbin.send_rtp_src_" + ofToString(videoSessionNumber) + " ! " + vrtpsink +
-				" rtpbin.send_rtcp_src_" + ofToString(videoSessionNumber) + " ! " + vrtpcsink +
-				" " + vrtpcsrc + " ! rtpbin.recv_rtcp_sink_" + ofToString(videoSessionNumber) + " ";
+	}
 
 	// create a pixels pool of the correct w,h and bpp to use on newFrame
-	bufferPool = new ofxGstBufferPool<unsigned char>(w,h,3);
-	parameters.add(videoBitrate);
+	channel.pool = new ofxGstBufferPool<unsigned char>(w,h,format,poolCapacity,poolOverflow);
+	if(pipelineFormat!=format){
+		// the app buffers return to their pool as soon as they are converted
+		// so only the converted ones need to wait in the pipeline
+		channel.poolConverted = new ofxGstBufferPool<unsigned char>(w,h,pipelineFormat,poolCapacity,poolOverflow);
+		channel.converter.setup(w,h,videoConversionThreads);
+	}
+	return channel.index;
 }
 
 
-void ofxGstRTPServer::addAudioChannel(int port, bool autotimestamp){
-	audioSessionNumber = lastSessionNumber;
-	audioAutoTimestamp = autotimestamp;
-	lastSessionNumber++;
+string ofxGstRTPServer::getPoolQueue(){
+	// when dropping the oldest frames, a leaky queue after the appsrc discards
+	// the oldest buffers if the encoder stalls so they return to the pool.
+	// leave some buffers for the one being encoded and the app
+	if(poolOverflow==OFX_GST_POOL_DROP_OLDEST){
+		int maxBuffers = max(1,poolCapacity-3);
+		return " ! queue leaky=downstream max-size-buffers=" + ofToString(maxBuffers) + " max-size-bytes=0 max-size-time=0";
+	}else{
+		return "";
+	}
+}
+
+void ofxGstRTPServer::setVideoConversionSettings(bool inProcess, int numThreads){
+	convertVideoInProcess = inProcess;
+	videoConversionThreads = numThreads;
+}
+
+void ofxGstRTPServer::setDepthCompressionSettings(int numThreads, int numTiles){
+	depthCompressionThreads = max(0,numThreads);
+	depthCompressionTiles = max(0,numTiles);
+}
+
+void ofxGstRTPServer::setDepth16Packing(bool packed, int maxDepth){
+	depth16Packed = packed;
+	depth16MaxDepth = maxDepth;
+}
+
+void ofxGstRTPServer::setOscBundleSettings(bool bundled, int windowUs, int maxBytes){
+	oscBundled = bundled;
+	oscBundleWindowUs = max(0,windowUs);
+	oscBundleMaxBytes = ofClamp(maxBytes,1,MAX_OSC_BUNDLE_BYTES);
+}
+
+void ofxGstRTPServer::setOscCompressionSettings(ofxGstOscCompression compression, int minBytes){
+	oscCompression = compression;
+	oscCompressionMinBytes = max(0,minBytes);
+}
+
+void ofxGstRTPServer::setVideoCodec(ofxGstRTPVideoCodec codec){
+	videoCodec = codec;
+}
+
+void ofxGstRTPServer::setDepthCodec(ofxGstRTPVideoCodec codec){
+	depthCodec = codec;
+}
+
+void ofxGstRTPServer::setRetransmissionSettings(bool enabled, int historyMs){
+	if(enabled && !ofxGstRTPCodecs::isRetransmissionAvailable()){
+		ofLogError(LOG_NAME) << "rtprtxsend not available, retransmission disabled";
+		enabled = false;
+	}
+	retransmission = enabled;
+	retransmissionHistory = max(1,historyMs);
+}
+
+void ofxGstRTPServer::setFECSettings(bool enabled, int percentage, bool adaptive, int minPercentage, int maxPercentage){
+	if(enabled && !ofxGstRTPCodecs::isFECAvailable()){
+		ofLogError(LOG_NAME) << "rtpulpfecenc not available, FEC disabled";
+		enabled = false;
+	}
+	fec = enabled;
+	adaptiveFEC = adaptive;
+	fecMinPercentage = max(0,min(100,min(minPercentage,maxPercentage)));
+	fecMaxPercentage = max(0,min(100,max(minPercentage,maxPercentage)));
+	fecPercentage = max(0,min(100,percentage));
+}
+
+void ofxGstRTPServer::setVideoLayers(int numLayers){
+	videoLayers = max(1,min(3,numLayers));
+}
+
+int ofxGstRTPServer::getVideoLayers(){
+	return videoLayers;
+}
+
+ofxGstRTPVideoCodec ofxGstRTPServer::getVideoCodec(){
+	return videoCodec;
+}
+
+ofxGstRTPVideoCodec ofxGstRTPServer::getDepthCodec(){
+	return depthCodec;
+}
+
+void ofxGstRTPServer::setBufferPoolSettings(int capacity, ofxGstBufferPoolOverflow overflow){
+	poolCapacity = max(1,capacity);
+	poolOverflow = overflow;
+}
+
+ofxGstBufferPoolStats ofxGstRTPServer::getVideoPoolStats(int channel){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	if(video && video->pool){
+		return video->pool->getStats();
+	}else{
+		ofxGstBufferPoolStats stats = {0,};
+		return stats;
+	}
+}
+
+ofxGstBufferPoolStats ofxGstRTPServer::getDepthPoolStats(int channel){
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	if(depth && depth->pool){
+		return depth->pool->getStats();
+	}else{
+		ofxGstBufferPoolStats stats = {0,};
+		return stats;
+	}
+}
+
+void ofxGstRTPServer::setOscPoolSettings(size_t maxRetainedBytes){
+	if(!channelsByType[OFX_GST_RTP_OSC].empty()){
+		ofLogError(LOG_NAME) << "osc pool settings have to be set before adding any osc channel";
+		return;
+	}
+	oscPacketPool.setup(maxRetainedBytes);
+}
+
+ofxOscPacketPoolStats ofxGstRTPServer::getOscPoolStats(int sizeClass){
+	return oscPacketPool.getStats(sizeClass);
+}
+
+int ofxGstRTPServer::getNumVideoChannels(){
+	return channelsByType[OFX_GST_RTP_VIDEO].size();
+}
+
+int ofxGstRTPServer::getNumDepthChannels(){
+	return channelsByType[OFX_GST_RTP_DEPTH].size();
+}
+
+int ofxGstRTPServer::getNumOscChannels(){
+	return channelsByType[OFX_GST_RTP_OSC].size();
+}
+
+int ofxGstRTPServer::getNumVideoLayers(int channel){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	return video ? video->numLayers : 0;
+}
+
+int ofxGstRTPServer::addAudioChannel(int port, bool autotimestamp){
+	// the audio channel captures from the default input and is the one
+	// processed by the echo canceller so there can only be one
+	if(!channelsByType[OFX_GST_RTP_AUDIO].empty()){
+		ofLogError(LOG_NAME) << "only one audio channel is supported";
+#if ENABLE_NAT_TRANSVERSAL
+		nextNiceStream.reset();
+#endif
+		return -1;
+	}
+
+	Channel & channel = createChannel(OFX_GST_RTP_AUDIO,port,autotimestamp);
+	setupChannelBitrate(channel,audioBitrate,audioBitrateController);
 
 	// audio elements
 	//-------------------
@@ -235,47 +723,42 @@ void ofxGstRTPServer::addAudioChannel(int port, bool autotimestamp){
 
 		// opus encoder + opus pay
 		// FIXME: audio=0 is voice??
-		string aenc = "opusenc name=aencoder audio=0 ! rtpopuspay pt=97";
+		string aenc = "opusenc name=" + channel.getElementName("encoder") + " audio=0 ! rtpopuspay pt=" + ofToString(ofxGstRTPCodecs::AUDIO_PAYLOAD_TYPE);
 
-	// audio rtpc
-		string artpsink;
-		string artpcsink;
-		string artpcsrc;
-
-#if ENABLE_NAT_TRANSVERSAL
-		if(audioStream){
-			artpsink="nicesink ts-offset=0 name=artpsink max-lateness=5000000000 ";
-			artpcsink="nicesink sync=false async=false name=artcpsink max-lateness=5000000000 ";
-			artpcsrc="nicesrc name=artcpsrc";
-		}else
-#endif
-		{
-			artpsink="udpsink port=" + ofToString(port) + " host="+dest+" ts-offset=0 force-ipv4=1 name=artpsink";
-			artpcsink="udpsink port=" + ofToString(port+1) + " host="+dest+" sync=false async=false force-ipv4=1 name=artcpsink";
-			artpcsrc="udpsrc port=" + ofToString(port+3) + " name=artcpsrc";
-		}
-
-		// audio
-	pipelineStr += " " +  asource + " ! " + aenc + " ! rtpbin.send_rtp_sink_" + ofToString(audioSessionNumber) +
-			" rtpbin.send_rtp_src_" + ofToString(audioSessionNumber) + " ! " + artpsink +
-			" rtpbin.send_rtcp_src_" + ofToString(audioSessionNumber) + " ! " + artpcsink +
-			" " + artpcsrc + " ! rtpbin.recv_rtcp_sink_" + ofToString(audioSessionNumber) + " ";
+	pipelineStr += " " +  asource + " ! " + aenc + getNetworkElements(channel);
 
 #if ENABLE_ECHO_CANCEL
 	audioChannelReady = true;
 #endif
-	parameters.add(audioBitrate);
+	return channel.index;
 }
 
-void ofxGstRTPServer::addDepthChannel(int port, int w, int h, int fps, bool depth16, bool autotimestamp){
-	depthSessionNumber = lastSessionNumber;
-	depthAutoTimestamp = autotimestamp;
-	lastSessionNumber++;
+int ofxGstRTPServer::addDepthChannel(int port, int w, int h, int fps, bool depth16, bool autotimestamp){
+	// packed 16bits depth is sent as 8bits depth with the planes one
+	// on top of the other
+	bool packed = depth16 && depth16Packed;
+	if(packed){
+		depth16 = false;
+	}
+
+	if(!depth16 && !ofxGstRTPCodecs::isEncoderAvailable(depthCodec)){
+		ofLogError(LOG_NAME) << "depth encoder for " << ofxGstRTPCodecs::getEncodingName(depthCodec) << " not available, using x264";
+		depthCodec = OFX_GST_RTP_X264;
+	}
+
+	Channel & channel = createChannel(OFX_GST_RTP_DEPTH,port,autotimestamp);
+	channel.width = w;
+	channel.height = h;
+	channel.format = OF_PIXELS_GRAY;
+	channel.depth16 = depth16;
+	channel.depth16Packed = packed;
+	channel.codec = depthCodec;
+	int encodedHeight = packed ? h*ofxGstDepth16Packer::NUM_PLANES : h;
 
 	// depth elements
 	// ------------------
 		// appsrc, allows to pass new frames from the app using the newFrame method
-		string delem="appsrc is-live=1 do-timestamp="+ string(autotimestamp?"1":"0") +" format=time name=appsrcdepth";
+		string delem="appsrc is-live=1 do-timestamp="+ string(autotimestamp?"1":"0") +" format=time name=" + channel.getElementName("appsrc");
 
 		// video format that we are pushing to the pipeline
 		string dcaps;
@@ -284,117 +767,78 @@ void ofxGstRTPServer::addDepthChannel(int port, int w, int h, int fps, bool dept
 		if(depth16){
 			dcaps="application/x-compresseddepth ";//compresseddepth,width="+ofToString(w)+ ",height="+ofToString(h)+",framerate="+ofToString(fps)+"/1";
 
-			dsource = delem + " ! " + dcaps;
+			// the compressed frames are written in buffers from the pool
+			dsource = delem + " ! " + dcaps + getPoolQueue();
 
-			denc = " rtpgstpay pt=98 ";
+			denc = " rtpgstpay pt=" + ofToString(ofxGstRTPCodecs::DEPTH_PAYLOAD_TYPE) + " ";
 		}else{
-			dcaps="video/x-raw,format=GRAY8,width="+ofToString(w)+ ",height="+ofToString(h)+",framerate="+ofToString(fps)+"/1";
+			// 16bits depth is not encoded so its bitrate can't be changed
+			setupChannelBitrate(channel,depthBitrate,depthBitrateController);
 
-			// queue so the conversion and encoding happen in a different thread to appsrc
-			dsource= delem + " ! " + dcaps + " ! videoconvert name=dconvert1";
+			dcaps="video/x-raw,format=GRAY8,width="+ofToString(w)+ ",height="+ofToString(encodedHeight)+",framerate="+ofToString(fps)+"/1";
 
-			// h264 encoder + rtp pay
-			denc="x264enc tune=zerolatency byte-stream=true bitrate="+ofToString(depthBitrate)+" speed-preset=superfast psy-tune=psnr me=4 subme=10 b-adapt=0 vbv-buf-capacity=600 name=dencoder ! video/x-h264,width="+ofToString(w)+ ",height="+ofToString(h)+",framerate="+ofToString(fps)+"/1 ! rtph264pay pt=98	 ! application/x-rtp,media=(string)video,clock-rate=(int)90000,payload=(int)98,encoding-name=(string)H264,rtcp-fb-nack-pli=(int)1 ";
-		}
-	// depth rtpc
-	// ------------------
-		string drtpsink;
-		string drtpcsink;
-		string drtpcsrc;
+			// queue so the conversion and encoding happen in a different thread to appsrc
+			dsource= delem + " ! " + dcaps + getPoolQueue() + " ! videoconvert name=" + channel.getElementName("convert");
 
-#if ENABLE_NAT_TRANSVERSAL
-		if(depthStream){
-			drtpsink="nicesink ts-offset=0 name=drtpsink max-lateness=5000000000 ";
-			drtpcsink="nicesink sync=false async=false name=drtcpsink max-lateness=5000000000 ";
-			drtpcsrc="nicesrc name=drtcpsrc";
-		}else
-#endif
-		{
-			drtpsink="udpsink port=" + ofToString(port) + " host="+dest+" ts-offset=0 force-ipv4=1 name=drtpsink";
-			drtpcsink="udpsink port=" + ofToString(port+1) + " host="+dest+" sync=false async=false force-ipv4=1 name=drtcpsink";
-			drtpcsrc="udpsrc port=" + ofToString(port+3) + " name=drtcpsrc";
+			// encoder + rtp pay
+			denc=ofxGstRTPCodecs::getVideoEncoder(channel.codec,w,encodedHeight,fps,channel.bitrate,ofxGstRTPCodecs::DEPTH_PAYLOAD_TYPE,channel.getElementName("encoder"),true);
 		}
 
-	// depth
-	pipelineStr += " " +  dsource + " ! " + denc + " ! rtpbin.send_rtp_sink_" + ofToString(depthSessionNumber) +
-		" rtpbin.send_rtp_src_" + ofToString(depthSessionNumber) + " ! " + drtpsink +
-		" rtpbin.send_rtcp_src_" + ofToString(depthSessionNumber) + " ! " + drtpcsink +
-		" " + drtpcsrc + " ! rtpbin.recv_rtcp_sink_" + ofToString(depthSessionNumber) + " ";
+	pipelineStr += " " +  dsource + " ! " + denc + getNetworkElements(channel);
 
 	if(depth16){
-		depthCompressor.setup(w,h);
+		channel.depthCompressor.setup(w,h,ofxGstDepth16Compressor::DEFAULT_KEYFRAME_INTERVAL,depthCompressionThreads,depthCompressionTiles);
+		channel.pool = new ofxGstBufferPool<unsigned char>(channel.depthCompressor.getMaxCompressedSize(),1,1,poolCapacity,poolOverflow);
 	}else{
-		bufferPoolDepth = new ofxGstBufferPool<unsigned char>(w,h,1);
-		parameters.add(depthBitrate);
+		channel.pool = new ofxGstBufferPool<unsigned char>(w,encodedHeight,1,poolCapacity,poolOverflow);
 	}
+	if(packed){
+		channel.depthPacker.setup(depth16MaxDepth);
+	}
+	return channel.index;
 }
 
-void ofxGstRTPServer::addOscChannel(int port, bool autotimestamp){
-	oscSessionNumber = lastSessionNumber;
-	oscAutoTimestamp = autotimestamp;
-	lastSessionNumber++;
+int ofxGstRTPServer::addOscChannel(int port, bool autotimestamp){
+	Channel & channel = createChannel(OFX_GST_RTP_OSC,port,autotimestamp);
+	channel.oscBundled = oscBundled;
+	channel.oscBundleWindowUs = oscBundleWindowUs;
+	channel.oscBundleMaxBytes = oscBundleMaxBytes;
+	channel.oscEncoder.setup(oscCompression,oscCompressionMinBytes);
 
 	// osc elements
 	// ------------------
 		// appsrc, allows to pass new frames from the app using the newFrame method
-		string oelem="appsrc is-live=1 format=time do-timestamp="+ string(autotimestamp?"1":"0") +"  name=appsrcosc ! application/x-osc ";
+		string oelem="appsrc is-live=1 format=time do-timestamp="+ string(autotimestamp?"1":"0") +"  name=" + channel.getElementName("appsrc") + " ! application/x-osc ";
 
 		// queue so the conversion and encoding happen in a different thread to appsrc
 		string osource = oelem;
 
 		// rtp pay
-		string oenc=" rtpgstpay pt=99";
-
-	// osc rtpc
-	// ------------------
-		string ortpsink;
-		string ortpcsink;
-		string ortpcsrc;
-
-#if ENABLE_NAT_TRANSVERSAL
-		if(oscStream){
-			ortpsink="nicesink ts-offset=0 name=ortpsink max-lateness=5000000000 ";
-			ortpcsink="nicesink sync=false async=false name=ortcpsink max-lateness=5000000000 ";
-			ortpcsrc="nicesrc name=ortcpsrc";
-		}else
-#endif
-		{
-			ortpsink="udpsink port=" + ofToString(port) + " host="+dest+" ts-offset=0 force-ipv4=1 name=ortpsink";
-			ortpcsink="udpsink port=" + ofToString(port+1) + " host="+dest+" sync=false async=false force-ipv4=1 name=ortcpsink";
-			ortpcsrc="udpsrc port=" + ofToString(port+3) + " name=ortcpsrc";
+		string oenc=" rtpgstpay pt=" + ofToString(ofxGstRTPCodecs::OSC_PAYLOAD_TYPE);
 
-		}
-
-	// osc
-	pipelineStr += " " + osource + " ! " + oenc + " ! rtpbin.send_rtp_sink_" + ofToString(oscSessionNumber) +
-		" rtpbin.send_rtp_src_" + ofToString(oscSessionNumber) + " ! " + ortpsink +
-		" rtpbin.send_rtcp_src_" + ofToString(oscSessionNumber) + " ! " + ortpcsink +
-		" " + ortpcsrc + " ! rtpbin.recv_rtcp_sink_" + ofToString(oscSessionNumber) + " ";
+	pipelineStr += " " + osource + " ! " + oenc + getNetworkElements(channel);
+	return channel.index;
 }
 
 #if ENABLE_NAT_TRANSVERSAL
-void ofxGstRTPServer::addVideoChannel(shared_ptr<ofxNiceStream> niceStream, int w, int h, int fps, bool autotimestamp){
-	videoStream = niceStream;
-	videoAutoTimestamp = autotimestamp;
-	addVideoChannel(0,w,h,fps,autotimestamp);
+int ofxGstRTPServer::addVideoChannel(shared_ptr<ofxNiceStream> niceStream, int w, int h, int fps, bool autotimestamp, ofPixelFormat format){
+	nextNiceStream = niceStream;
+	return addVideoChannel(0,w,h,fps,autotimestamp,format);
 }
 
-void ofxGstRTPServer::addAudioChannel(shared_ptr<ofxNiceStream> niceStream, bool autotimestamp){
-	audioStream = niceStream;
-	audioAutoTimestamp = autotimestamp;
-	addAudioChannel(0);
+int ofxGstRTPServer::addAudioChannel(shared_ptr<ofxNiceStream> niceStream, bool autotimestamp){
+	nextNiceStream = niceStream;
+	return addAudioChannel(0,autotimestamp);
 }
 
-void ofxGstRTPServer::addDepthChannel(shared_ptr<ofxNiceStream> niceStream, int w, int h, int fps, bool depth16, bool autotimestamp){
-	depthStream = niceStream;
-	depthAutoTimestamp = autotimestamp;
-	addDepthChannel(0,w,h,fps,depth16,autotimestamp);
+int ofxGstRTPServer::addDepthChannel(shared_ptr<ofxNiceStream> niceStream, int w, int h, int fps, bool depth16, bool autotimestamp){
+	nextNiceStream = niceStream;
+	return addDepthChannel(0,w,h,fps,depth16,autotimestamp);
 }
 
-void ofxGstRTPServer::addOscChannel(shared_ptr<ofxNiceStream> niceStream, bool autotimestamp){
-	oscStream = niceStream;
-	oscAutoTimestamp = autotimestamp;
-	addOscChannel(0,autotimestamp);
+int ofxGstRTPServer::addOscChannel(shared_ptr<ofxNiceStream> niceStream, bool autotimestamp){
+	nextNiceStream = niceStream;
+	return addOscChannel(0,autotimestamp);
 }
 
 void ofxGstRTPServer::setup(){
@@ -402,13 +846,20 @@ void ofxGstRTPServer::setup(){
 }
 #endif
 
+
 void ofxGstRTPServer::setup(string dest){
-	this->dest = dest;
+	destinations.clear();
+	destinationLayers.clear();
+	if(!dest.empty()){
+		destinations.push_back(dest);
+	}
 	// full pipeline
 	// FIXME: we should set this more modularly to allow to negociate the formats
 	// through rtpc with the server.
 	// force-ipv4 is needed on all osx udpsinks or it'll fail
-	pipelineStr = "rtpbin name=rtpbin ";
+	// avpf allows to send the NACKs and keyframe requests as soon as they
+	// are needed instead of waiting for the next rtcp interval
+	pipelineStr = "rtpbin name=rtpbin rtp-profile=avpf ";
 
 
 	// set this class as listener so we can get messages from the pipeline
@@ -474,95 +925,108 @@ void ofxGstRTPServer::setEchoCancel(ofxEchoCancel & echoCancel){
 #endif
 
 void ofxGstRTPServer::close(){
-	if(appSrcDepth){
-		gst_element_send_event(appSrcDepth,gst_event_new_eos());
-	}
-	if(appSrcVideoRGB){
-		gst_element_send_event(appSrcVideoRGB,gst_event_new_eos());
-	}
-	if(appSrcOsc){
-		gst_element_send_event(appSrcOsc,gst_event_new_eos());
+	// stop sampling before the pipeline is destroyed
+	statsCollector.close();
+	pipelineClock.close();
+	for(size_t i=0;i<channels.size();i++){
+		if(channels[i]->appsrc){
+			gst_element_send_event(channels[i]->appsrc,gst_event_new_eos());
+		}
 	}
 	if(gst.getGstElementByName("audiocapture")){
 		gst_element_send_event(gst.getGstElementByName("audiocapture"),gst_event_new_eos());
 	}
 	gst.close();
-	vRTPsink = NULL;
-	vRTPCsink = NULL;
-	vRTPCsrc = NULL;
-	vEncoder = NULL;
-	dEncoder = NULL;
-	aEncoder = NULL;
-	appSrcVideoRGB = NULL;
-	appSrcDepth = NULL;
-	appSrcOsc = NULL;
-	bufferPool = NULL;
-	bufferPoolDepth = NULL;
-	fps = 0;
-	prevTimestamp = 0;
-	numFrame = 0;
-	prevTimestampDepth = 0;
-	numFrameDepth = 0;
-	prevTimestampOsc = 0;
-	numFrameOsc = 0;
-	width = 0;
-	height = 0;
-	lastSessionNumber = 0;
+	rtpbin = NULL;
+	// the channels close their pools which are deleted once gstreamer
+	// returns all their buffers
+	channels.clear();
+	for(int i=0;i<OFX_GST_RTP_NUM_CHANNELS;i++){
+		channelsByType[i].clear();
+	}
 #if ENABLE_NAT_TRANSVERSAL
-	videoStream.reset();
-	depthStream.reset();
-	oscStream.reset();
-	audioStream.reset();
+	nextNiceStream.reset();
 #endif
-	firstVideoFrame = true;
-	firstOscFrame = true;
-	firstDepthFrame = true;
 
 	ofRemoveListener(ofEvents().update,this,&ofxGstRTPServer::update);
 }
 
 
-void ofxGstRTPServer::vBitRateChanged(int & bitrate){
-	g_object_set(G_OBJECT(vEncoder),"bitrate",bitrate,NULL);
+void ofxGstRTPServer::updateBitrate(const ofxGstRTPStats & stats, Channel & channel){
+	ofxGstRTPReceiverReport report;
+	report.roundTrip = stats.roundTrip;
+	report.fractionLost = stats.fractionLost;
+	report.jitter = stats.jitter;
+	report.packetsLost = stats.packetsLost;
+	report.extHighestSeq = stats.extHighestSeq;
+	if(channel.bitrateController.update(report)){
+		ofLogVerbose(LOG_NAME) << channel.bitrate.getName() << ": " << channel.bitrate << " -> " << channel.bitrateController.getTargetBitrate() << " (" << channel.bitrateController.getReason() << ")";
+		channel.bitrate = channel.bitrateController.getTargetBitrate();
+	}
+}
+
+void ofxGstRTPServer::updateFEC(const ofxGstRTPStats & stats, Channel & channel){
+	ofxGstRTPReceiverReport report;
+	report.roundTrip = stats.roundTrip;
+	report.fractionLost = stats.fractionLost;
+	report.jitter = stats.jitter;
+	report.packetsLost = stats.packetsLost;
+	report.extHighestSeq = stats.extHighestSeq;
+	if(channel.fecController.update(report)){
+		ofLogVerbose(LOG_NAME) << channel.getElementName("fecenc") << ": " << channel.fecController.getPercentage() << "% for " << stats.fractionLost*100 << "% loss";
+		g_object_set(G_OBJECT(channel.fecenc),"percentage",guint(channel.fecController.getPercentage()),NULL);
+	}
 }
 
-void ofxGstRTPServer::dBitRateChanged(int & bitrate){
-	g_object_set(G_OBJECT(dEncoder),"bitrate",bitrate,NULL);
+ofxGstRTPBitrateController & ofxGstRTPServer::getVideoBitrateController(int channel){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	return video ? video->bitrateController : videoBitrateController;
 }
 
-void ofxGstRTPServer::aBitRateChanged(int & bitrate){
-	g_object_set(G_OBJECT(aEncoder),"bitrate",bitrate,NULL);
+ofxGstRTPBitrateController & ofxGstRTPServer::getDepthBitrateController(int channel){
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	return depth ? depth->bitrateController : depthBitrateController;
+}
+
+ofxGstRTPBitrateController & ofxGstRTPServer::getAudioBitrateController(){
+	Channel * audio = getChannel(OFX_GST_RTP_AUDIO,0);
+	return audio ? audio->bitrateController : audioBitrateController;
 }
 
 void ofxGstRTPServer::play(){
 	// pass the pipeline to the gstUtils so it starts everything
 	gst.setPipelineWithSink(pipelineStr,"",true);
+	pipelineClock.setup(gst.getPipeline());
 
 	// get the rtp and rtpc elements from the pipeline so we can read their properties
 	// during execution
 	rtpbin = gst.getGstElementByName("rtpbin");
-	vRTPsink = gst.getGstElementByName("vrtpsink");
-	vRTPCsink = gst.getGstElementByName("vrtcpsink");
-	vRTPCsrc = gst.getGstElementByName("vrtcpsrc");
-
-	aRTPsink = gst.getGstElementByName("artpsink");
-	aRTPCsink = gst.getGstElementByName("artcpsink");
-	aRTPCsrc = gst.getGstElementByName("artcpsrc");
-
-	dRTPsink = gst.getGstElementByName("drtpsink");
-	dRTPCsink = gst.getGstElementByName("drtcpsink");
-	dRTPCsrc = gst.getGstElementByName("drtcpsrc");
+	for(size_t i=0;i<channels.size();i++){
+		Channel & channel = *channels[i];
+		channel.appsrc = gst.getGstElementByName(channel.getElementName("appsrc"));
+		channel.encoder = gst.getGstElementByName(channel.getElementName("encoder"));
+		channel.rtpsink = gst.getGstElementByName(channel.getElementName("rtpsink"));
+		channel.rtcpsink = gst.getGstElementByName(channel.getElementName("rtcpsink"));
+		channel.rtcpsrc = gst.getGstElementByName(channel.getElementName("rtcpsrc"));
+		channel.rtxsend = gst.getGstElementByName(channel.getElementName("rtxsend"));
+		channel.fecenc = gst.getGstElementByName(channel.getElementName("fecenc"));
+
+		if(channel.rtxsend){
+			GstStructure * payloadTypeMap = ofxGstRTPCodecs::getRetransmissionPayloadTypeMap(channel.payloadType);
+			g_object_set(G_OBJECT(channel.rtxsend),"payload-type-map",payloadTypeMap,NULL);
+			gst_structure_free(payloadTypeMap);
+		}
 
-	oRTPsink = gst.getGstElementByName("ortpsink");
-	oRTPCsink = gst.getGstElementByName("ortcpsink");
-	oRTPCsrc = gst.getGstElementByName("ortcpsrc");
+#if ENABLE_NAT_TRANSVERSAL
+		if(channel.niceStream){
+			g_object_set(G_OBJECT(channel.rtpsink),"agent",channel.niceStream->getAgent(),"stream",channel.niceStream->getStreamID(),"component",1,NULL);
+			g_object_set(G_OBJECT(channel.rtcpsink),"agent",channel.niceStream->getAgent(),"stream",channel.niceStream->getStreamID(),"component",2,NULL);
+			g_object_set(G_OBJECT(channel.rtcpsrc),"agent",channel.niceStream->getAgent(),"stream",channel.niceStream->getStreamID(),"component",3,NULL);
+		}
+#endif
 
-	vEncoder = gst.getGstElementByName("vencoder");
-	dEncoder = gst.getGstElementByName("dencoder");
-	aEncoder = gst.getGstElementByName("aencoder");
-	appSrcVideoRGB = gst.getGstElementByName("appsrcvideo");
-	appSrcDepth = gst.getGstElementByName("appsrcdepth");
-	appSrcOsc = gst.getGstElementByName("appsrcosc");
+		if(channel.appsrc) gst_app_src_set_stream_type((GstAppSrc*)channel.appsrc,GST_APP_STREAM_TYPE_STREAM);
+	}
 
 #if ENABLE_ECHO_CANCEL
 	if(echoCancel && audioChannelReady){
@@ -594,35 +1058,22 @@ void ofxGstRTPServer::play(){
 	}
 #endif
 
-#if ENABLE_NAT_TRANSVERSAL
-	if(videoStream){
-		g_object_set(G_OBJECT(vRTPsink),"agent",videoStream->getAgent(),"stream",videoStream->getStreamID(),"component",1,NULL);
-		g_object_set(G_OBJECT(vRTPCsink),"agent",videoStream->getAgent(),"stream",videoStream->getStreamID(),"component",2,NULL);
-		g_object_set(G_OBJECT(vRTPCsrc),"agent",videoStream->getAgent(),"stream",videoStream->getStreamID(),"component",3,NULL);
-	}
-	if(depthStream){
-		g_object_set(G_OBJECT(dRTPsink),"agent",depthStream->getAgent(),"stream",depthStream->getStreamID(),"component",1,NULL);
-		g_object_set(G_OBJECT(dRTPCsink),"agent",depthStream->getAgent(),"stream",depthStream->getStreamID(),"component",2,NULL);
-		g_object_set(G_OBJECT(dRTPCsrc),"agent",depthStream->getAgent(),"stream",depthStream->getStreamID(),"component",3,NULL);
-	}
-	if(audioStream){
-		g_object_set(G_OBJECT(aRTPsink),"agent",audioStream->getAgent(),"stream",audioStream->getStreamID(),"component",1,NULL);
-		g_object_set(G_OBJECT(aRTPCsink),"agent",audioStream->getAgent(),"stream",audioStream->getStreamID(),"component",2,NULL);
-		g_object_set(G_OBJECT(aRTPCsrc),"agent",audioStream->getAgent(),"stream",audioStream->getStreamID(),"component",3,NULL);
-	}
-	if(oscStream){
-		g_object_set(G_OBJECT(oRTPsink),"agent",oscStream->getAgent(),"stream",oscStream->getStreamID(),"component",1,NULL);
-		g_object_set(G_OBJECT(oRTPCsink),"agent",oscStream->getAgent(),"stream",oscStream->getStreamID(),"component",2,NULL);
-		g_object_set(G_OBJECT(oRTPCsrc),"agent",oscStream->getAgent(),"stream",oscStream->getStreamID(),"component",3,NULL);
-	}
-#endif
-
-
-	if(appSrcVideoRGB) gst_app_src_set_stream_type((GstAppSrc*)appSrcVideoRGB,GST_APP_STREAM_TYPE_STREAM);
-	if(appSrcDepth) gst_app_src_set_stream_type((GstAppSrc*)appSrcDepth,GST_APP_STREAM_TYPE_STREAM);
-	if(appSrcOsc) gst_app_src_set_stream_type((GstAppSrc*)appSrcOsc,GST_APP_STREAM_TYPE_STREAM);
-
 	g_signal_connect(rtpbin,"on-new-ssrc",G_CALLBACK(&ofxGstRTPServer::on_new_ssrc_handler),this);
+	g_signal_connect(rtpbin,"on-bye-ssrc",G_CALLBACK(&ofxGstRTPServer::on_bye_ssrc_handler),this);
+	g_signal_connect(rtpbin,"on-timeout",G_CALLBACK(&ofxGstRTPServer::on_bye_ssrc_handler),this);
+
+	// keyframe requests from the receivers are answered by rtpbin by sending
+	// a force key unit event upstream to the encoder. depth16 channels have no
+	// encoder so the handler asks their compressor for a key frame. all the
+	// requests are counted
+	for(size_t i=0;i<channels.size();i++){
+		GObject * internalSession = NULL;
+		g_signal_emit_by_name(rtpbin,"get-internal-session",channels[i]->session,&internalSession,NULL);
+		if(internalSession){
+			g_signal_connect(internalSession,"on-feedback-rtcp",G_CALLBACK(&ofxGstRTPServer::on_feedback_rtcp_handler),channels[i].get());
+			g_object_unref(internalSession);
+		}
+	}
 
 #if ENABLE_ECHO_CANCEL
 	if(echoCancel && audioChannelReady){
@@ -634,243 +1085,319 @@ void ofxGstRTPServer::play(){
 	gst.startPipeline();
 	gst.play();
 
+	statsCollector.setup(std::bind(&ofxGstRTPServer::sampleStats,this,std::placeholders::_1,std::placeholders::_2),channels.size(),statsInterval,statsHistorySize);
 	ofAddListener(ofEvents().update,this,&ofxGstRTPServer::update);
 }
 
 void ofxGstRTPServer::on_new_ssrc_handler(GstBin *rtpbin, guint session, guint ssrc, ofxGstRTPServer * server){
 	ofLogVerbose(LOG_NAME) << "new ssrc " << ssrc << " for session " << session;
-	if(session==server->audioSessionNumber){
-		server->audioSSRC = ssrc;
-	}else if(session==server->videoSessionNumber){
-		server->videoSSRC = ssrc;
-		server->sendVideoKeyFrame = false;
-	}else if(session==server->depthSessionNumber){
-		server->depthSSRC = ssrc;
-		server->sendDepthKeyFrame = false;
-	}else if(session==server->oscSessionNumber){
-		server->oscSSRC = ssrc;
+	if(session>=server->channels.size()) return;
+
+	// our own source is also notified, every other ssrc is a receiver
+	GObject * internalSession = NULL;
+	g_signal_emit_by_name(rtpbin,"get-internal-session",session,&internalSession,NULL);
+	if(internalSession){
+		guint internalSSRC = 0;
+		g_object_get(internalSession,"internal-ssrc",&internalSSRC,NULL);
+		g_object_unref(internalSession);
+		if(internalSSRC==ssrc) return;
+	}
+
+	Channel & channel = *server->channels[session];
+	{
+		std::unique_lock<std::mutex> lock(channel.receiversMutex);
+		for(size_t i=0;i<channel.receivers.size();i++){
+			if(channel.receivers[i].ssrc==ssrc) return;
+		}
+		Receiver receiver;
+		receiver.ssrc = ssrc;
+		receiver.packetsLost = 0;
+		receiver.keyframesRequested = 0;
+		channel.receivers.push_back(receiver);
 	}
+	channel.sendKeyFrame = false;
 }
 
-void ofxGstRTPServer::update(ofEventArgs & args){
-	if(ofGetFrameNum()%60==0){
-		if(videoSSRC!=0 && videoSessionNumber!=guint(-1)){
-			GObject * internalSession;
-			g_signal_emit_by_name(rtpbin,"get-internal-session",videoSessionNumber,&internalSession,NULL);
-
-			if(internalSession){
-				// read all the properties in the internal session
-				/*GParamSpec** properties;
-				guint n_properties;
-				properties = g_object_class_list_properties(G_OBJECT_GET_CLASS(internalSession),&n_properties);
-				for(guint i=0; i<n_properties; i++){
-					cout << properties[i]->name <<endl;
-				}*/
-
-				// get internal session stats useful? perhaps sent packages and bitrate?
-				GObject * internalSource;
-				g_object_get(internalSession,"internal-source",&internalSource, NULL);
-
-				if(internalSource){
-					GstStructure *stats;
-					g_object_get (internalSource, "stats", &stats, NULL);
-
-					//ofLogNotice(LOG_NAME) << gst_structure_to_string(stats);
-					guint64 bitrate;
-					if(stats){
-						gst_structure_get(stats,"bitrate",G_TYPE_UINT64,&bitrate, NULL);
-
-						ofLogNotice(LOG_NAME) << "local video bitrate: " << bitrate;
-					}
-				}else{
-					ofLogError(LOG_NAME) << "couldn't get internal video source";
-				}
-			}else{
-				ofLogError() << "couldn't get local video internal session";
-			}
+void ofxGstRTPServer::on_bye_ssrc_handler(GstBin *rtpbin, guint session, guint ssrc, ofxGstRTPServer * server){
+	ofLogVerbose(LOG_NAME) << "ssrc " << ssrc << " left session " << session;
+	if(session>=server->channels.size()) return;
 
-			GObject * remoteSource;
-			g_signal_emit_by_name (internalSession, "get-source-by-ssrc", videoSSRC, &remoteSource, NULL);
-
-			if(remoteSource){
-				GstStructure *stats;
-				g_object_get (remoteSource, "stats", &stats, NULL);
-
-				ofLogNotice(LOG_NAME) << gst_structure_to_string(stats);
-				uint rb_round_trip;
-				int rb_packetslost;
-				uint rb_fractionlost;
-				uint rb_jitter;
-				gst_structure_get(stats,"rb-round-trip",G_TYPE_UINT,&rb_round_trip,
-										"rb-packetslost",G_TYPE_INT,&rb_packetslost,
-										"rb-fractionlost",G_TYPE_UINT,&rb_fractionlost,
-										"rb-jitter",G_TYPE_UINT,&rb_jitter,
-										NULL);
-				ofLogNotice(LOG_NAME) << "remote video: round trip:" << rb_round_trip
-						<< " packetslost: " << rb_packetslost
-						<< " fractionlost: " << rb_fractionlost
-						<< " jitter: " << rb_jitter;
-
-				if(videoPacketsLost<rb_packetslost){
-					emitVideoKeyFrame();
-				}
-				videoPacketsLost = rb_packetslost;
-			}else{
-				ofLogError() << "couldn't get remote stats";
-			}
+	Channel & channel = *server->channels[session];
+	std::unique_lock<std::mutex> lock(channel.receiversMutex);
+	for(size_t i=0;i<channel.receivers.size();i++){
+		if(channel.receivers[i].ssrc==ssrc){
+			channel.receivers.erase(channel.receivers.begin()+i);
+			break;
 		}
+	}
+}
 
-		if(depthSSRC!=0 && depthSessionNumber!=guint(-1)){
-			GObject * internalSession;
-			g_signal_emit_by_name(rtpbin,"get-internal-session",depthSessionNumber,&internalSession,NULL);
+void ofxGstRTPServer::on_feedback_rtcp_handler(GObject * session, guint type, guint fbtype, guint senderSSRC, guint mediaSSRC, GstBuffer * fci, Channel * channel){
+	if(type!=GST_RTCP_TYPE_PSFB || (fbtype!=GST_RTCP_PSFB_TYPE_PLI && fbtype!=GST_RTCP_PSFB_TYPE_FIR)){
+		return;
+	}
+	channel->keyframesRequested++;
+	if(channel->depth16){
+		channel->depthCompressor.requestKeyFrame();
+	}
+	std::unique_lock<std::mutex> lock(channel->receiversMutex);
+	for(size_t i=0;i<channel->receivers.size();i++){
+		if(channel->receivers[i].ssrc==senderSSRC){
+			channel->receivers[i].keyframesRequested++;
+			break;
+		}
+	}
+}
 
-			GObject * remoteSource;
-			g_signal_emit_by_name (internalSession, "get-source-by-ssrc", depthSSRC, &remoteSource, NULL);
+bool ofxGstRTPServer::sampleStats(int session, ofxGstRTPStats & stats){
+	// called from the stats collector thread, the channels
+	// don't change while the collector is running
+	if(session<0 || session>=int(channels.size()) || !rtpbin){
+		return false;
+	}
+	Channel & channel = *channels[session];
+	vector<guint> ssrcs;
+	{
+		std::unique_lock<std::mutex> lock(channel.receiversMutex);
+		for(size_t i=0;i<channel.receivers.size();i++){
+			ssrcs.push_back(channel.receivers[i].ssrc);
+		}
+	}
+	if(ssrcs.empty()){
+		return false;
+	}
 
-			if(internalSession){
-				// get internal session stats useful? perhaps sent packages and bitrate?
-				GObject * internalSource;
-				g_object_get(internalSession,"internal-source",&internalSource, NULL);
+	int clockRate;
+	switch(channel.type){
+	case OFX_GST_RTP_VIDEO:
+	case OFX_GST_RTP_DEPTH:
+		clockRate = ofxGstRTPCodecs::VIDEO_CLOCK_RATE;
+		break;
+	case OFX_GST_RTP_AUDIO:
+		clockRate = ofxGstRTPCodecs::AUDIO_CLOCK_RATE;
+		break;
+	case OFX_GST_RTP_OSC:
+	default:
+		clockRate = ofxGstRTPCodecs::APPLICATION_CLOCK_RATE;
+		break;
+	}
 
-				if(internalSource){
-					GstStructure *stats;
-					g_object_get (internalSource, "stats", &stats, NULL);
+	GObject * internalSession = NULL;
+	g_signal_emit_by_name(rtpbin,"get-internal-session",channel.session,&internalSession,NULL);
+	if(!internalSession){
+		ofLogError(LOG_NAME) << "couldn't get internal session " << channel.session;
+		return false;
+	}
 
-					//ofLogNotice(LOG_NAME) << gst_structure_to_string(stats);
-					guint64 bitrate;
-					if(stats){
-						gst_structure_get(stats,"bitrate",G_TYPE_UINT64,&bitrate, NULL);
+	// local stats: what we are sending
+	GObject * internalSource = NULL;
+	g_object_get(internalSession,"internal-source",&internalSource,NULL);
+	if(internalSource){
+		GstStructure * sourceStats = NULL;
+		g_object_get(internalSource,"stats",&sourceStats,NULL);
+		if(sourceStats){
+			guint64 bitrate = 0, packetsSent = 0;
+			gst_structure_get(sourceStats,"bitrate",G_TYPE_UINT64,&bitrate,
+										  "packets-sent",G_TYPE_UINT64,&packetsSent,
+										  NULL);
+			stats.bitrate = bitrate;
+			stats.packetsSent = packetsSent;
+			gst_structure_free(sourceStats);
+		}
+		g_object_unref(internalSource);
+	}
 
-						ofLogNotice(LOG_NAME) << "local depth bitrate: " << bitrate;
-					}
-				}else{
-					ofLogError(LOG_NAME) << "couldn't get depth internal source";
+	// remote stats: the last receiver report sent by each destination,
+	// the channel gets the worst values since the encoding is shared
+	vector<Receiver> sampled(ssrcs.size());
+	for(size_t i=0;i<ssrcs.size();i++){
+		Receiver & receiver = sampled[i];
+		receiver.ssrc = ssrcs[i];
+		GObject * remoteSource = NULL;
+		g_signal_emit_by_name(internalSession,"get-source-by-ssrc",ssrcs[i],&remoteSource,NULL);
+		if(!remoteSource) continue;
+
+		GstStructure * sourceStats = NULL;
+		g_object_get(remoteSource,"stats",&sourceStats,NULL);
+		if(sourceStats){
+			gboolean haveRB = FALSE;
+			gchar * rtcpFrom = NULL;
+			gst_structure_get(sourceStats,"have-rb",G_TYPE_BOOLEAN,&haveRB,
+										  "rtcp-from",G_TYPE_STRING,&rtcpFrom,
+										  NULL);
+			if(rtcpFrom){
+				// host:port, we only want the host
+				receiver.host = rtcpFrom;
+				size_t colon = receiver.host.rfind(':');
+				if(colon!=string::npos){
+					receiver.host = receiver.host.substr(0,colon);
 				}
-			}else{
-				ofLogError() << "couldn't get local depth internal session";
+				g_free(rtcpFrom);
 			}
+			if(haveRB){
+				guint roundTrip = 0, fractionLost = 0, jitter = 0, extHighestSeq = 0;
+				gint packetsLost = 0;
+				gst_structure_get(sourceStats,"rb-round-trip",G_TYPE_UINT,&roundTrip,
+											  "rb-packetslost",G_TYPE_INT,&packetsLost,
+											  "rb-fractionlost",G_TYPE_UINT,&fractionLost,
+											  "rb-jitter",G_TYPE_UINT,&jitter,
+											  "rb-exthighestseq",G_TYPE_UINT,&extHighestSeq,
+											  NULL);
+
+				// round trip comes in 1/65536 of a second, fraction lost in 1/256
+				// and jitter in units of the clock rate of the stream
+				receiver.stats.haveReceiverReport = true;
+				receiver.stats.roundTrip = roundTrip / 65536.;
+				receiver.stats.fractionLost = fractionLost / 256.f;
+				receiver.stats.jitter = jitter / double(clockRate);
+				receiver.stats.packetsLost = packetsLost;
+				receiver.stats.extHighestSeq = extHighestSeq;
+
+				// the sum of the sequence numbers changes when any of the
+				// receivers sends a new report which is what the bitrate
+				// controller uses to detect them
+				stats.haveReceiverReport = true;
+				stats.roundTrip = max(stats.roundTrip,receiver.stats.roundTrip);
+				stats.fractionLost = max(stats.fractionLost,receiver.stats.fractionLost);
+				stats.jitter = max(stats.jitter,receiver.stats.jitter);
+				stats.packetsLost += packetsLost;
+				stats.extHighestSeq += extHighestSeq;
+			}
+			gst_structure_free(sourceStats);
+		}
+		g_object_unref(remoteSource);
+	}
 
-			if(remoteSource){
-				GstStructure *stats;
-				g_object_get (remoteSource, "stats", &stats, NULL);
-
-				//ofLogNotice(LOG_NAME) << gst_structure_to_string(stats);
-				uint rb_round_trip;
-				int rb_packetslost;
-				uint rb_fractionlost;
-				uint rb_jitter;
-				gst_structure_get(stats,"rb-round-trip",G_TYPE_UINT,&rb_round_trip,
-										"rb-packetslost",G_TYPE_INT,&rb_packetslost,
-										"rb-fractionlost",G_TYPE_UINT,&rb_fractionlost,
-										"rb-jitter",G_TYPE_UINT,&rb_jitter,
-										NULL);
-				ofLogNotice(LOG_NAME) << "remote audio: round trip:" << rb_round_trip
-						<< " packetslost: " << rb_packetslost
-						<< " fractionlost: " << rb_fractionlost
-						<< " jitter: " << rb_jitter;
-
-				if(depthPacketsLost<rb_packetslost){
-					emitDepthKeyFrame();
+	{
+		std::unique_lock<std::mutex> lock(channel.receiversMutex);
+		for(size_t i=0;i<sampled.size();i++){
+			for(size_t j=0;j<channel.receivers.size();j++){
+				if(channel.receivers[j].ssrc==sampled[i].ssrc){
+					if(!sampled[i].host.empty()) channel.receivers[j].host = sampled[i].host;
+					sampled[i].stats.bitrate = stats.bitrate;
+					sampled[i].stats.packetsSent = stats.packetsSent;
+					sampled[i].stats.timestamp = ofGetElapsedTimeMillis();
+					channel.receivers[j].stats = sampled[i].stats;
+					break;
 				}
-				depthPacketsLost = rb_packetslost;
-			}else{
-				ofLogError() << "couldn't get stats";
 			}
 		}
+	}
+	g_object_unref(internalSession);
 
-		if(audioSSRC!=0 && audioSessionNumber!=guint(-1)){
-			GObject * internalSession;
-			g_signal_emit_by_name(rtpbin,"get-internal-session",audioSessionNumber,&internalSession,NULL);
-
-			GObject * remoteSource;
-			g_signal_emit_by_name (internalSession, "get-source-by-ssrc", audioSSRC, &remoteSource, NULL);
+	if(channel.rtxsend){
+		guint requests = 0, retransmissions = 0;
+		g_object_get(channel.rtxsend,"num-rtx-requests",&requests,"num-rtx-packets",&retransmissions,NULL);
+		stats.retransmissionRequests = requests;
+		stats.retransmissions = retransmissions;
+	}
 
-			if(internalSession){
-				// get internal session stats useful? perhaps sent packages and bitrate?
-				GObject * internalSource;
-				g_object_get(internalSession,"internal-source",&internalSource, NULL);
+	if(channel.fecenc){
+		guint percentage = 0;
+		g_object_get(channel.fecenc,"percentage",&percentage,NULL);
+		stats.fecPercentage = percentage;
+	}
 
-				if(internalSource){
-					GstStructure *stats;
-					g_object_get (internalSource, "stats", &stats, NULL);
+	stats.keyframesRequested = channel.keyframesRequested;
+	return true;
+}
 
-					//ofLogNotice(LOG_NAME) << gst_structure_to_string(stats);
-					guint64 bitrate;
-					if(stats){
-						gst_structure_get(stats,"bitrate",G_TYPE_UINT64,&bitrate, NULL);
+void ofxGstRTPServer::update(ofEventArgs & args){
+	// osc bundles whose window is over, or every bundle if they are per frame
+	for(size_t i=0;i<channelsByType[OFX_GST_RTP_OSC].size();i++){
+		Channel & osc = *channelsByType[OFX_GST_RTP_OSC][i];
+		if(!osc.oscBundled) continue;
+		std::unique_lock<std::mutex> lock(osc.oscMutex);
+		if(osc.oscBundle && (osc.oscBundleWindowUs==0 || ofGetElapsedTimeMicros() - osc.oscBundleStart >= (unsigned long long)osc.oscBundleWindowUs)){
+			pushOscBundle(osc);
+		}
+	}
 
-						ofLogNotice(LOG_NAME) << "local audio bitrate: " << bitrate;
+	// the stats are sampled in the collector thread, here we only react
+	// to new receiver reports
+	for(size_t i=0;i<channels.size();i++){
+		Channel & channel = *channels[i];
+		ofxGstRTPStats stats = statsCollector.getStats(channel.session);
+		if(!stats.haveReceiverReport) continue;
+
+		// any destination losing packets needs a keyframe, which is
+		// shared by all of them. with retransmission the lost packets
+		// are resent and the clients ask for a keyframe if that fails
+		if(!channel.retransmission && (channel.type==OFX_GST_RTP_VIDEO || channel.type==OFX_GST_RTP_DEPTH)){
+			bool lost = false;
+			{
+				std::unique_lock<std::mutex> lock(channel.receiversMutex);
+				for(size_t j=0;j<channel.receivers.size();j++){
+					Receiver & receiver = channel.receivers[j];
+					if(receiver.packetsLost<receiver.stats.packetsLost){
+						receiver.keyframesRequested++;
+						lost = true;
 					}
-				}else{
-					ofLogError(LOG_NAME) << "couldn't get audio internal source";
+					receiver.packetsLost = receiver.stats.packetsLost;
 				}
-			}else{
-				ofLogError() << "couldn't get local audio internal session";
 			}
-
-			if(remoteSource){
-				GstStructure *stats;
-				g_object_get (remoteSource, "stats", &stats, NULL);
-
-				//ofLogNotice(LOG_NAME) << gst_structure_to_string(stats);
-				uint rb_round_trip;
-				int rb_packetslost;
-				uint rb_fractionlost;
-				uint rb_jitter;
-				gst_structure_get(stats,"rb-round-trip",G_TYPE_UINT,&rb_round_trip,
-										"rb-packetslost",G_TYPE_INT,&rb_packetslost,
-										"rb-fractionlost",G_TYPE_UINT,&rb_fractionlost,
-										"rb-jitter",G_TYPE_UINT,&rb_jitter,
-										NULL);
-				ofLogNotice(LOG_NAME) << "remote audio: round trip:" << rb_round_trip
-						<< " packetslost: " << rb_packetslost
-						<< " fractionlost: " << rb_fractionlost
-						<< " jitter: " << rb_jitter;
-			}else{
-				ofLogError() << "couldn't get stats";
+			if(lost){
+				channel.keyframesRequested++;
+				emitKeyFrame(channel);
 			}
 		}
 
-		if(oscSSRC!=0 && oscSessionNumber!=guint(-1)){
-			GObject * internalSession;
-			g_signal_emit_by_name(rtpbin,"get-internal-session",oscSessionNumber,&internalSession,NULL);
-
-			if(internalSession){
-				// get internal session stats useful? perhaps sent packages and bitrate?
-				GObject * internalSource;
-				g_object_get(internalSession,"internal-source",&internalSource, NULL);
-
-				if(internalSource){
-					GstStructure *stats;
-					g_object_get (internalSource, "stats", &stats, NULL);
+		// osc and 16bits depth are not encoded so their bitrate can't be changed
+		if(adaptiveBitrate && channel.encoder){
+			updateBitrate(stats,channel);
+		}
 
-					//ofLogNotice(LOG_NAME) << gst_structure_to_string(stats);
-					guint64 bitrate;
-					if(stats){
-						gst_structure_get(stats,"bitrate",G_TYPE_UINT64,&bitrate, NULL);
+		// the overhead of the FEC follows the loss the receivers report
+		if(channel.fecenc){
+			updateFEC(stats,channel);
+		}
+	}
+}
 
-						ofLogNotice(LOG_NAME) << "local osc bitrate: " << bitrate;
-					}
-				}else{
-					ofLogError(LOG_NAME) << "couldn't get internal osc source";
-				}
-			}else{
-				ofLogError() << "couldn't get local osc internal session";
-			}
+ofxGstRTPStats ofxGstRTPServer::getStats(ofxGstRTPChannel type, int channel){
+	Channel * c = getChannel(type,channel);
+	if(!c){
+		return ofxGstRTPStats();
+	}
+	return statsCollector.getStats(c->session);
+}
 
-			GObject * remoteSource;
-			g_signal_emit_by_name (internalSession, "get-source-by-ssrc", oscSSRC, &remoteSource, NULL);
+void ofxGstRTPServer::getStatsHistory(ofxGstRTPChannel type, vector<ofxGstRTPStats> & history, int channel){
+	Channel * c = getChannel(type,channel);
+	if(!c){
+		history.clear();
+		return;
+	}
+	statsCollector.getHistory(c->session,history);
+}
 
-			if(remoteSource){
-				GstStructure *stats;
-				g_object_get (remoteSource, "stats", &stats, NULL);
+ofxGstRTPStats ofxGstRTPServer::getVideoLayerStats(int layer, int channel){
+	Channel * c = getVideoLayer(channel,layer);
+	if(!c){
+		return ofxGstRTPStats();
+	}
+	return statsCollector.getStats(c->session);
+}
 
-				ofLogNotice(LOG_NAME) << gst_structure_to_string(stats);
-			}else{
-				ofLogError() << "couldn't get stats";
-			}
+ofxGstRTPStats ofxGstRTPServer::getDestinationStats(ofxGstRTPChannel type, const string & host, int channel){
+	Channel * c = getChannel(type,channel);
+	if(!c){
+		return ofxGstRTPStats();
+	}
+	std::unique_lock<std::mutex> lock(c->receiversMutex);
+	for(size_t i=0;i<c->receivers.size();i++){
+		if(c->receivers[i].host==host){
+			ofxGstRTPStats stats = c->receivers[i].stats;
+			stats.keyframesRequested = c->receivers[i].keyframesRequested;
+			return stats;
 		}
 	}
+	return ofxGstRTPStats();
+}
+
+void ofxGstRTPServer::setStatsSettings(int intervalMs, int historySize){
+	statsInterval = max(1,intervalMs);
+	statsHistorySize = max(1,historySize);
 }
 
 bool ofxGstRTPServer::on_message(GstMessage * msg){
@@ -917,251 +1444,529 @@ bool ofxGstRTPServer::on_message(GstMessage * msg){
 	}
 }
 
-void ofxGstRTPServer::emitVideoKeyFrame(){
-	GstClock * clock = gst_pipeline_get_clock(GST_PIPELINE(gst.getPipeline()));
-	gst_object_ref(clock);
-	GstClockTime time = gst_clock_get_time (clock);
-	GstClockTime now =  time - gst_element_get_base_time(gst.getPipeline());
-	gst_object_unref (clock);
-	GstEvent * keyFrameEvent = gst_video_event_new_downstream_force_key_unit(now,
-															 time,
-															 now,
-															 TRUE,
-															 0);
-	gst_element_send_event(appSrcVideoRGB,keyFrameEvent);
-
-}
+void ofxGstRTPServer::emitKeyFrame(Channel & channel){
+	// 16bits depth is compressed by the addon, not by an encoder
+	if(channel.depth16){
+		channel.depthCompressor.requestKeyFrame();
+		return;
+	}
 
-void ofxGstRTPServer::emitDepthKeyFrame(){
-	GstClock * clock = gst_pipeline_get_clock(GST_PIPELINE(gst.getPipeline()));
-	gst_object_ref(clock);
-	GstClockTime time = gst_clock_get_time (clock);
-	GstClockTime now =  time - gst_element_get_base_time(gst.getPipeline());
-	gst_object_unref (clock);
+	// with simulcast the event goes directly to the encoder of the layer
+	// otherwise it would reach every layer through the tee
+	GstElement * element = channel.numLayers>1 ? channel.encoder : channel.appsrc;
+	if(!element) return;
+	GstClockTime now = pipelineClock.now();
+	GstClockTime time = now + pipelineClock.getBaseTime();
 	GstEvent * keyFrameEvent = gst_video_event_new_downstream_force_key_unit(now,
 															 time,
 															 now,
 															 TRUE,
 															 0);
-	gst_element_send_event(appSrcDepth,keyFrameEvent);
+	gst_element_send_event(element,keyFrameEvent);
 
 }
 
-void ofxGstRTPServer::newFrame(ofPixels & pixels, GstClockTime timestamp){
-	// here we push new video frames in the pipeline, it's important
-	// to timestamp them properly so gstreamer can sync them with the
-	// audio.
+void ofxGstRTPServer::emitVideoKeyFrame(int channel){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	if(!video) return;
+	emitKeyFrame(*video);
+	for(size_t i=0;i<video->layers.size();i++){
+		emitKeyFrame(*video->layers[i]);
+	}
+}
 
-	if(!bufferPool || !appSrcVideoRGB) return;
+void ofxGstRTPServer::emitDepthKeyFrame(int channel){
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	if(depth) emitKeyFrame(*depth);
+}
 
-	GstClockTime now = timestamp;
-	if(!videoAutoTimestamp){
+bool ofxGstRTPServer::getFrameTimestamp(Channel & channel, GstClockTime & now){
+	// when the timestamps are not generated by gstreamer, the first frame
+	// is only used as reference for the duration of the next one
+	if(!channel.autoTimestamp){
 		if(now==GST_CLOCK_TIME_NONE){
 			now = getTimeStamp();
 		}
-		if(firstVideoFrame){
-			prevTimestamp = now;
-			firstVideoFrame = false;
-			return;
+		if(channel.firstFrame){
+			channel.prevTimestamp = now;
+			channel.firstFrame = false;
+			return false;
 		}
 	}
+	return true;
+}
 
-	// get a pixels buffer from the pool and copy the passed frame into it
-	PooledPixels<unsigned char> * pooledPixels = bufferPool->newBuffer();
-	*(ofPixels*)pooledPixels=pixels;
-
-	// wrap the pooled pixels into a gstreamer buffer and pass the release
-	// callback so when it's not needed anymore by gst we can return it to the pool
-	GstBuffer * buffer;
-	buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,pooledPixels->getPixels(), pooledPixels->size(), 0, pooledPixels->size(), pooledPixels, (GDestroyNotify)&ofxGstBufferPool<unsigned char>::relaseBuffer);
-
+void ofxGstRTPServer::setBufferTimestamp(Channel & channel, GstBuffer * buffer, GstClockTime now){
 	// timestamp the buffer, right now we are using:
 	// timestamp = current pipeline time - base time
 	// duration = timestamp - previousTimeStamp
 	// the duration is actually the duration of the previous frame
 	// but should be accurate enough
-	if(!videoAutoTimestamp){
-		GST_BUFFER_OFFSET(buffer) = numFrame++;
-		GST_BUFFER_OFFSET_END(buffer) = numFrame;
+	if(!channel.autoTimestamp){
+		GST_BUFFER_OFFSET(buffer) = channel.numFrame++;
+		GST_BUFFER_OFFSET_END(buffer) = channel.numFrame;
 		GST_BUFFER_DTS (buffer) = now;
 		GST_BUFFER_PTS (buffer) = now;
-		GST_BUFFER_DURATION(buffer) = now-prevTimestamp;
-		prevTimestamp = now;
+		GST_BUFFER_DURATION(buffer) = now-channel.prevTimestamp;
+		channel.prevTimestamp = now;
 	}
+}
 
+void ofxGstRTPServer::newFrame(ofPixels & pixels, GstClockTime timestamp){
+	newFrame(0,pixels,timestamp);
+}
+
+void ofxGstRTPServer::newFrame(ofPixels && pixels, GstClockTime timestamp){
+	newFrame(0,std::move(pixels),timestamp);
+}
+
+void ofxGstRTPServer::newFrame(PooledPixels<unsigned char> * pixels, GstClockTime timestamp){
+	newFrame(0,pixels,timestamp);
+}
+
+void ofxGstRTPServer::newFrame(const unsigned char * const planes[], const int strides[], GstClockTime timestamp){
+	newFrame(0,planes,strides,timestamp);
+}
+
+void ofxGstRTPServer::newFrame(int channel, ofPixels & pixels, GstClockTime timestamp){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	if(!video || !video->pool || !video->appsrc) return;
 
-	if(sendVideoKeyFrame && numFrame%5==0){
-		emitVideoKeyFrame();
+	// if the frame needs to be converted do it directly from the passed
+	// pixels instead of copying them first
+	if(video->poolConverted && pixels.getPixelFormat()==video->format && int(pixels.getWidth())==video->width && int(pixels.getHeight())==video->height){
+		PooledPixels<unsigned char> * converted = convertVideoFrame(*video,pixels);
+		if(converted){
+			pushVideoBuffer(*video,converted,timestamp);
+		}
+		return;
 	}
-	numFrame++;
 
-	// finally push the buffer into the pipeline through the appsrc element
-	GstFlowReturn flow_return = gst_app_src_push_buffer((GstAppSrc*)appSrcVideoRGB, buffer);
-	if (flow_return != GST_FLOW_OK) {
-		ofLogError() << "error pushing video buffer: flow_return was " << flow_return;
+	// get a pixels buffer from the pool and copy the passed frame into it
+	PooledPixels<unsigned char> * pooledPixels = video->pool->newBuffer();
+	if(!pooledPixels){
+		ofLogVerbose(LOG_NAME) << "video pool exhausted, dropping frame";
+		return;
 	}
+	*(ofPixels*)pooledPixels=pixels;
+	video->pool->bufferCopied(pooledPixels->getTotalBytes());
+
+	pushVideoBuffer(*video,pooledPixels,timestamp);
 }
 
+void ofxGstRTPServer::newFrame(int channel, ofPixels && pixels, GstClockTime timestamp){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	if(!video || !video->pool || !video->appsrc) return;
 
-void ofxGstRTPServer::newFrameDepth(ofPixels & pixels, GstClockTime timestamp){
-	// here we push new depth frames in the pipeline, it's important
+	// get a pixels buffer from the pool and swap the memory of the passed
+	// frame into it, if the frame has a different format we can't swap
+	// it since the pool buffers would end with different sizes
+	PooledPixels<unsigned char> * pooledPixels = video->pool->newBuffer();
+	if(!pooledPixels){
+		ofLogVerbose(LOG_NAME) << "video pool exhausted, dropping frame";
+		return;
+	}
+	if(pooledPixels->getWidth()==pixels.getWidth() && pooledPixels->getHeight()==pixels.getHeight() && pooledPixels->getPixelFormat()==pixels.getPixelFormat()){
+		pooledPixels->swap(pixels);
+	}else{
+		ofLogWarning(LOG_NAME) << "video frame doesn't match the channel format, copying it";
+		*(ofPixels*)pooledPixels=pixels;
+		video->pool->bufferCopied(pooledPixels->getTotalBytes());
+	}
+
+	pushVideoBuffer(*video,pooledPixels,timestamp);
+}
+
+void ofxGstRTPServer::newFrame(int channel, PooledPixels<unsigned char> * pixels, GstClockTime timestamp){
+	if(!pixels) return;
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	if(!video || !video->appsrc){
+		releaseBuffer(pixels);
+		return;
+	}
+	pushVideoBuffer(*video,pixels,timestamp);
+}
+
+void ofxGstRTPServer::newFrame(int channel, const unsigned char * const planes[], const int strides[], GstClockTime timestamp){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	if(!video || !video->pool || !video->appsrc) return;
+
+	PooledPixels<unsigned char> * pooledPixels = video->pool->newBuffer();
+	if(!pooledPixels){
+		ofLogVerbose(LOG_NAME) << "video pool exhausted, dropping frame";
+		return;
+	}
+
+	// copy every plane in the pooled buffer, row by row if the source
+	// has padding at the end of each row
+	gsize offsets[GST_VIDEO_MAX_PLANES];
+	gint dstStrides[GST_VIDEO_MAX_PLANES];
+	int rows[GST_VIDEO_MAX_PLANES];
+	int numPlanes = ofxGstRTPUtils::getPlanesLayout(video->format,video->width,video->height,offsets,dstStrides,rows);
+	unsigned char * dst = pooledPixels->getPixels();
+	for(int i=0;i<numPlanes;i++){
+		if(strides[i]==dstStrides[i]){
+			memcpy(dst+offsets[i],planes[i],dstStrides[i]*rows[i]);
+		}else{
+			for(int y=0;y<rows[i];y++){
+				memcpy(dst+offsets[i]+y*dstStrides[i],planes[i]+y*strides[i],dstStrides[i]);
+			}
+		}
+	}
+	video->pool->bufferCopied(pooledPixels->getTotalBytes());
+
+	pushVideoBuffer(*video,pooledPixels,timestamp);
+}
+
+PooledPixels<unsigned char> * ofxGstRTPServer::getVideoBuffer(int channel){
+	Channel * video = getChannel(OFX_GST_RTP_VIDEO,channel);
+	if(!video || !video->pool) return NULL;
+	return video->pool->newBuffer();
+}
+
+static void addVideoMeta(GstBuffer * buffer, const ofPixels & pixels){
+	gsize offsets[GST_VIDEO_MAX_PLANES];
+	gint strides[GST_VIDEO_MAX_PLANES];
+	int rows[GST_VIDEO_MAX_PLANES];
+	int numPlanes = ofxGstRTPUtils::getPlanesLayout(pixels.getPixelFormat(),pixels.getWidth(),pixels.getHeight(),offsets,strides,rows);
+	if(numPlanes>0){
+		gst_buffer_add_video_meta_full(buffer,GST_VIDEO_FRAME_FLAG_NONE,ofxGstRTPUtils::getGstVideoFormat(pixels.getPixelFormat()),pixels.getWidth(),pixels.getHeight(),numPlanes,offsets,strides);
+	}
+}
+
+PooledPixels<unsigned char> * ofxGstRTPServer::convertVideoFrame(Channel & channel, const ofPixels & pixels){
+	PooledPixels<unsigned char> * converted = channel.poolConverted->newBuffer();
+	if(!converted){
+		ofLogVerbose(LOG_NAME) << "converted video pool exhausted, dropping frame";
+		return NULL;
+	}
+	channel.converter.convert(pixels,*converted);
+	return converted;
+}
+
+void ofxGstRTPServer::pushVideoBuffer(Channel & channel, PooledPixels<unsigned char> * pooledPixels, GstClockTime timestamp){
+	// here we push new video frames in the pipeline, it's important
 	// to timestamp them properly so gstreamer can sync them with the
 	// audio.
 
-	if(!bufferPoolDepth || !appSrcDepth) return;
+	// frames in the app format that need conversion are converted
+	// into a new buffer and the original returns to its pool
+	if(channel.poolConverted && pooledPixels->getPixelFormat()==channel.format){
+		PooledPixels<unsigned char> * converted = convertVideoFrame(channel,*pooledPixels);
+		releaseBuffer(pooledPixels);
+		if(!converted) return;
+		pooledPixels = converted;
+	}
 
 	GstClockTime now = timestamp;
-	if(!depthAutoTimestamp){
-		if(now==GST_CLOCK_TIME_NONE){
-			now = getTimeStamp();
-		}
+	if(!getFrameTimestamp(channel,now)){
+		releaseBuffer(pooledPixels);
+		return;
+	}
 
-		if(firstDepthFrame){
-			prevTimestampDepth = now;
-			firstDepthFrame = false;
-			return;
+	// wrap the pooled pixels into a gstreamer buffer and pass the release
+	// callback so when it's not needed anymore by gst we can return it to the pool
+	GstBuffer * buffer;
+	buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,pooledPixels->getPixels(), pooledPixels->getTotalBytes(), 0, pooledPixels->getTotalBytes(), pooledPixels, (GDestroyNotify)&ofxGstBufferPool<unsigned char>::relaseBuffer);
+
+	// ofPixels don't have padding between rows or planes which is not always
+	// the default layout in gstreamer so we describe it with a video meta
+	addVideoMeta(buffer,*pooledPixels);
+
+	setBufferTimestamp(channel,buffer,now);
+
+	if(channel.numFrame%5==0){
+		if(channel.sendKeyFrame) emitKeyFrame(channel);
+		for(size_t i=0;i<channel.layers.size();i++){
+			if(channel.layers[i]->sendKeyFrame) emitKeyFrame(*channel.layers[i]);
 		}
 	}
+	channel.numFrame++;
+
+	// finally push the buffer into the pipeline through the appsrc element
+	GstFlowReturn flow_return = gst_app_src_push_buffer((GstAppSrc*)channel.appsrc, buffer);
+	if (flow_return != GST_FLOW_OK) {
+		ofLogError() << "error pushing video buffer: flow_return was " << flow_return;
+	}
+}
+
+
+void ofxGstRTPServer::newFrameDepth(ofPixels & pixels, GstClockTime timestamp){
+	newFrameDepth(0,pixels,timestamp);
+}
+
+void ofxGstRTPServer::newFrameDepth(ofPixels && pixels, GstClockTime timestamp){
+	newFrameDepth(0,std::move(pixels),timestamp);
+}
+
+void ofxGstRTPServer::newFrameDepth(PooledPixels<unsigned char> * pixels, GstClockTime timestamp){
+	newFrameDepth(0,pixels,timestamp);
+}
+
+void ofxGstRTPServer::newFrameDepth(ofShortPixels & pixels, GstClockTime timestamp, float pixel_size, float distance){
+	newFrameDepth(0,pixels,timestamp,pixel_size,distance);
+}
+
+void ofxGstRTPServer::newFrameDepth(int channel, ofPixels & pixels, GstClockTime timestamp){
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	if(!depth || depth->depth16 || depth->depth16Packed || !depth->pool || !depth->appsrc) return;
 
 	// get a pixels buffer from the pool and copy the passed frame into it
-	PooledPixels<unsigned char> * pooledPixels = bufferPoolDepth->newBuffer();
-	//pooledPixels->swap(pixels);
+	PooledPixels<unsigned char> * pooledPixels = depth->pool->newBuffer();
+	if(!pooledPixels){
+		ofLogVerbose(LOG_NAME) << "depth pool exhausted, dropping frame";
+		return;
+	}
 	*(ofPixels*)pooledPixels=pixels;
+	depth->pool->bufferCopied(pooledPixels->getTotalBytes());
+
+	pushDepthBuffer(*depth,pooledPixels,timestamp);
+}
+
+void ofxGstRTPServer::newFrameDepth(int channel, ofPixels && pixels, GstClockTime timestamp){
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	if(!depth || depth->depth16 || depth->depth16Packed || !depth->pool || !depth->appsrc) return;
+
+	// get a pixels buffer from the pool and swap the passed frame into it
+	PooledPixels<unsigned char> * pooledPixels = depth->pool->newBuffer();
+	if(!pooledPixels){
+		ofLogVerbose(LOG_NAME) << "depth pool exhausted, dropping frame";
+		return;
+	}
+	if(pooledPixels->getWidth()==pixels.getWidth() && pooledPixels->getHeight()==pixels.getHeight() && pooledPixels->getPixelFormat()==pixels.getPixelFormat()){
+		pooledPixels->swap(pixels);
+	}else{
+		ofLogWarning(LOG_NAME) << "depth frame doesn't match the channel format, copying it";
+		*(ofPixels*)pooledPixels=pixels;
+		depth->pool->bufferCopied(pooledPixels->getTotalBytes());
+	}
+
+	pushDepthBuffer(*depth,pooledPixels,timestamp);
+}
+
+void ofxGstRTPServer::newFrameDepth(int channel, PooledPixels<unsigned char> * pixels, GstClockTime timestamp){
+	if(!pixels) return;
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	if(!depth || depth->depth16 || depth->depth16Packed || !depth->appsrc){
+		releaseBuffer(pixels);
+		return;
+	}
+	pushDepthBuffer(*depth,pixels,timestamp);
+}
+
+PooledPixels<unsigned char> * ofxGstRTPServer::getDepthBuffer(int channel){
+	// 16bits depth pools hold compressed or packed frames
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	if(!depth || !depth->pool || depth->depth16 || depth->depth16Packed) return NULL;
+	return depth->pool->newBuffer();
+}
+
+void ofxGstRTPServer::releaseBuffer(PooledPixels<unsigned char> * pixels){
+	ofxGstBufferPool<unsigned char>::relaseBuffer(pixels);
+}
+
+void ofxGstRTPServer::pushDepthBuffer(Channel & channel, PooledPixels<unsigned char> * pooledPixels, GstClockTime timestamp){
+	// here we push new depth frames in the pipeline, it's important
+	// to timestamp them properly so gstreamer can sync them with the
+	// audio.
+
+	GstClockTime now = timestamp;
+	if(!getFrameTimestamp(channel,now)){
+		releaseBuffer(pooledPixels);
+		return;
+	}
 
 	// wrap the pooled pixels into a gstreamer buffer and pass the release
 	// callback so when it's not needed anymore by gst we can return it to the pool
 	GstBuffer * buffer;
 	buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,pooledPixels->getPixels(), pooledPixels->size(), 0, pooledPixels->size(), pooledPixels, (GDestroyNotify)&ofxGstBufferPool<unsigned char>::relaseBuffer);
+	addVideoMeta(buffer,*pooledPixels);
 
-	// timestamp the buffer, right now we are using:
-	// timestamp = current pipeline time - base time
-	// duration = timestamp - previousTimeStamp
-	// the duration is actually the duration of the previous frame
-	// but should be accurate enough
-
-	if(!depthAutoTimestamp){
-		GST_BUFFER_OFFSET(buffer) = numFrameDepth++;
-		GST_BUFFER_OFFSET_END(buffer) = numFrameDepth;
-		GST_BUFFER_DTS (buffer) = now;
-		GST_BUFFER_PTS (buffer) = now;
-		GST_BUFFER_DURATION(buffer) = now-prevTimestampDepth;
-		prevTimestampDepth = now;
-	}
+	setBufferTimestamp(channel,buffer,now);
 
-	if(sendDepthKeyFrame){
-		emitDepthKeyFrame();
+	if(channel.sendKeyFrame){
+		emitKeyFrame(channel);
 	}
 
 	// finally push the buffer into the pipeline through the appsrc element
-	GstFlowReturn flow_return = gst_app_src_push_buffer((GstAppSrc*)appSrcDepth, buffer);
+	GstFlowReturn flow_return = gst_app_src_push_buffer((GstAppSrc*)channel.appsrc, buffer);
 	if (flow_return != GST_FLOW_OK) {
 		ofLogError() << "error pushing depth buffer: flow_return was " << flow_return;
 	}
 }
 
 
-void ofxGstRTPServer::newFrameDepth(ofShortPixels & pixels, GstClockTime timestamp, float pixel_size, float distance){
+void ofxGstRTPServer::newFrameDepth(int channel, ofShortPixels & pixels, GstClockTime timestamp, float pixel_size, float distance){
 	//unsigned long long time = ofGetElapsedTimeMicros();
 
 	// here we push new depth frames in the pipeline, it's important
 	// to timestamp them properly so gstreamer can sync them with the
 	// audio.
 
-	if(!appSrcDepth) return;
+	Channel * depth = getChannel(OFX_GST_RTP_DEPTH,channel);
+	if(!depth || !depth->appsrc) return;
 
-	GstClockTime now = timestamp;
-	if(!depthAutoTimestamp){
-		if(now==GST_CLOCK_TIME_NONE){
-			now = getTimeStamp();
+	// packed depth goes through the encoder as an 8bits frame
+	if(depth->depth16Packed){
+		if(int(pixels.getWidth())!=depth->width || int(pixels.getHeight())!=depth->height || pixels.getNumChannels()!=1){
+			ofLogError(LOG_NAME) << "depth frame doesn't match the channel size " << depth->width << "x" << depth->height;
+			return;
 		}
-
-		if(firstDepthFrame){
-			prevTimestampDepth = now;
-			firstDepthFrame = false;
+		PooledPixels<unsigned char> * pooledPixels = depth->pool->newBuffer();
+		if(!pooledPixels){
+			ofLogVerbose(LOG_NAME) << "depth pool exhausted, dropping frame";
 			return;
 		}
+		depth->depthPacker.pack(pixels,*pooledPixels);
+		pushDepthBuffer(*depth,pooledPixels,timestamp);
+		return;
 	}
+	if(!depth->depth16) return;
 
-	ofxDepthCompressedFrame frame = depthCompressor.newFrame(pixels,pixel_size,distance);
-	GstBuffer * buffer = gst_buffer_new_allocate(NULL,frame.compressedData().size()*sizeof(short),NULL);
-	GstMapInfo mapinfo;
-	gst_buffer_map(buffer,&mapinfo,GST_MAP_WRITE);
-	memcpy(mapinfo.data,&frame.compressedData()[0],frame.compressedData().size()*sizeof(short));
-	gst_buffer_unmap(buffer,&mapinfo);
-	// timestamp the buffer, right now we are using:
-	// timestamp = current pipeline time - base time
-	// duration = timestamp - previousTimeStamp
-	// the duration is actually the duration of the previous frame
-	// but should be accurate enough
-
-	if(!depthAutoTimestamp){
-		GST_BUFFER_OFFSET(buffer) = numFrameDepth++;
-		GST_BUFFER_OFFSET_END(buffer) = numFrameDepth;
-		GST_BUFFER_DTS (buffer) = now;
-		GST_BUFFER_PTS (buffer) = now;
-		GST_BUFFER_DURATION(buffer) = now-prevTimestampDepth;
-		prevTimestampDepth = now;
+	GstClockTime now = timestamp;
+	if(!getFrameTimestamp(*depth,now)){
+		return;
 	}
 
-	if(sendDepthKeyFrame){
-		//emitDepthKeyFrame();
+	// the frame is compressed directly in a pooled buffer sized for the
+	// worst case which returns to the pool once it's been sent
+	PooledPixels<unsigned char> * pooledPixels = depth->pool->newBuffer();
+	if(!pooledPixels){
+		ofLogVerbose(LOG_NAME) << "depth pool exhausted, dropping frame";
+		return;
 	}
+	size_t size = depth->depthCompressor.compress(pixels,pixel_size,distance,pooledPixels->getPixels());
+	if(size==0){
+		releaseBuffer(pooledPixels);
+		return;
+	}
+	GstBuffer * buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,pooledPixels->getPixels(),pooledPixels->size(),0,size,pooledPixels,(GDestroyNotify)&ofxGstBufferPool<unsigned char>::relaseBuffer);
+
+	setBufferTimestamp(*depth,buffer,now);
 
 	// finally push the buffer into the pipeline through the appsrc element
-	GstFlowReturn flow_return = gst_app_src_push_buffer((GstAppSrc*)appSrcDepth, buffer);
+	GstFlowReturn flow_return = gst_app_src_push_buffer((GstAppSrc*)depth->appsrc, buffer);
 	if (flow_return != GST_FLOW_OK) {
 		ofLogError() << "error pushing depth buffer: flow_return was " << flow_return;
 	}
-	//cout << "sending depth buffer with " << pixels.getWidth() << "," << pixels.getHeight() << " csize: " << frame.compressedData().size() << endl;
+	//cout << "sending depth buffer with " << pixels.getWidth() << "," << pixels.getHeight() << " csize: " << size << endl;
 	//cout << ofGetElapsedTimeMicros() - time << endl;
 }
 
 
 void ofxGstRTPServer::newOscMsg(ofxOscMessage & msg, GstClockTime timestamp){
-	if(!appSrcOsc) return;
+	newOscMsg(0,msg,timestamp);
+}
 
-	GstClockTime now = timestamp;
-	if(!oscAutoTimestamp){
-		if(now==GST_CLOCK_TIME_NONE){
-			now = getTimeStamp();
+void ofxGstRTPServer::newOscMsg(int channel, ofxOscMessage & msg, GstClockTime timestamp){
+	Channel * osc = getChannel(OFX_GST_RTP_OSC,channel);
+	if(!osc || !osc->appsrc) return;
+
+	if(!osc->oscBundled){
+		// the timestamp state of the channel is also protected by the
+		// mutex so the messages are pushed in the order they are stamped
+		std::unique_lock<std::mutex> lock(osc->oscMutex);
+		GstClockTime now = timestamp;
+		if(!getFrameTimestamp(*osc,now)){
+			return;
 		}
+		PooledOscPacket * pooledOscPkg = oscPacketPool.newBuffer(getOscMessageSize(msg));
+		if(!pooledOscPkg){
+			return;
+		}
+		appendMessage(msg,pooledOscPkg->packet);
+		pushOscPacket(*osc,pooledOscPkg,now);
+		return;
+	}
 
-		if(firstOscFrame){
-			prevTimestampOsc = now;
-			firstOscFrame = false;
+	// each element in a bundle is preceded by its size
+	size_t elementSize = getOscMessageSize(msg) + 4;
+	std::unique_lock<std::mutex> lock(osc->oscMutex);
+	if(osc->oscBundle && osc->oscBundle->packet.Size() + elementSize > osc->oscBundle->capacity()){
+		pushOscBundle(*osc);
+	}
+	if(!osc->oscBundle){
+		// the bundle is sent with the timestamp of its first message, its
+		// packet is sized for maxBytes or for this message if it's bigger
+		GstClockTime now = timestamp;
+		if(!getFrameTimestamp(*osc,now)){
+			return;
+		}
+		osc->oscBundle = oscPacketPool.newBuffer(OSC_BUNDLE_HEADER_BYTES + max<size_t>(osc->oscBundleMaxBytes,elementSize));
+		if(!osc->oscBundle){
 			return;
 		}
+		osc->oscBundle->packet << osc::BeginBundleImmediate;
+		osc->oscBundleTimestamp = now;
+		osc->oscBundleStart = ofGetElapsedTimeMicros();
 	}
+	appendMessage(msg,osc->oscBundle->packet);
 
-	PooledOscPacket * pooledOscPkg = oscPacketPool.newBuffer();
-	appendMessage(msg,pooledOscPkg->packet);
+	if(int(osc->oscBundle->packet.Size())>=osc->oscBundleMaxBytes
+			|| (osc->oscBundleWindowUs>0 && ofGetElapsedTimeMicros() - osc->oscBundleStart >= (unsigned long long)osc->oscBundleWindowUs)){
+		pushOscBundle(*osc);
+	}
+}
+
+void ofxGstRTPServer::flushOscBundle(int channel){
+	Channel * osc = getChannel(OFX_GST_RTP_OSC,channel);
+	if(!osc) return;
+	std::unique_lock<std::mutex> lock(osc->oscMutex);
+	pushOscBundle(*osc);
+}
 
-	GstBuffer * buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,(void*)pooledOscPkg->compressedData(),pooledOscPkg->compressedSize(),0,pooledOscPkg->compressedSize(),pooledOscPkg,(GDestroyNotify)&ofxOscPacketPool::relaseBuffer);
+void ofxGstRTPServer::pushOscBundle(Channel & channel){
+	// called with the oscMutex of the channel locked
+	if(!channel.oscBundle) return;
+	PooledOscPacket * bundle = channel.oscBundle;
+	channel.oscBundle = NULL;
+	bundle->packet << osc::EndBundle;
+	pushOscPacket(channel,bundle,channel.oscBundleTimestamp);
+}
 
+void ofxGstRTPServer::pushOscPacket(Channel & channel, PooledOscPacket * pooledOscPkg, GstClockTime timestamp){
+	// called with the oscMutex of the channel locked, which also protects
+	// the state of its encoder
+	pooledOscPkg->encode(channel.oscEncoder);
+	GstBuffer * buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,(void*)pooledOscPkg->encodedData(),pooledOscPkg->encodedSize(),0,pooledOscPkg->encodedSize(),pooledOscPkg,(GDestroyNotify)&ofxOscPacketPool::relaseBuffer);
 
-	if(!oscAutoTimestamp){
-		GST_BUFFER_OFFSET(buffer) = numFrameOsc++;
-		GST_BUFFER_OFFSET_END(buffer) = numFrameOsc;
-		GST_BUFFER_DTS (buffer) = now;
-		GST_BUFFER_PTS (buffer) = now;
-		GST_BUFFER_DURATION(buffer) = now-prevTimestampOsc;
-		prevTimestampOsc = now;
-	}
+	setBufferTimestamp(channel,buffer,timestamp);
 
-	GstFlowReturn flow_return = gst_app_src_push_buffer((GstAppSrc*)appSrcOsc, buffer);
+	GstFlowReturn flow_return = gst_app_src_push_buffer((GstAppSrc*)channel.appsrc, buffer);
 	if (flow_return != GST_FLOW_OK) {
 		ofLogError() << "error pushing osc buffer: flow_return was " << flow_return;
 	}
 }
 
+size_t ofxGstRTPServer::getOscMessageSize(ofxOscMessage & message){
+	// address and type tags are null terminated strings padded to 4 bytes,
+	// the type tags start with a ','
+	size_t size = ((message.getAddress().size() + 4) & ~size_t(3))
+			+ ((message.getNumArgs() + 5) & ~size_t(3));
+	for(int i=0;i<message.getNumArgs();i++){
+		switch(message.getArgType(i)){
+		case OFXOSC_TYPE_INT64:
+			size += 8;
+			break;
+		case OFXOSC_TYPE_STRING:
+			size += (message.getArgAsString(i).size() + 4) & ~size_t(3);
+			break;
+		default:
+			size += 4;
+			break;
+		}
+	}
+	return size;
+}
+
 GstClockTime ofxGstRTPServer::getTimeStamp(){
 	if(!gst.isLoaded()) return GST_CLOCK_TIME_NONE;
-	GstClock * clock = gst_pipeline_get_clock(GST_PIPELINE(gst.getPipeline()));
+	return pipelineClock.now();
+}
 
-	gst_object_ref(clock);
-	GstClockTime now = gst_clock_get_time (clock) - gst_element_get_base_time(gst.getPipeline());
-	gst_object_unref (clock);
-	return now;
+GstClockTime ofxGstRTPServer::getFrameTimeStamp(){
+	if(!gst.isLoaded()) return GST_CLOCK_TIME_NONE;
+	return pipelineClock.getFrameTime();
 }
 
 void ofxGstRTPServer::appendMessage( ofxOscMessage& message, osc::OutboundPacketStream& p )
@@ -1197,13 +2002,13 @@ GstFlowReturn ofxGstRTPServer::on_new_preroll_from_audio(GstAppSink * elt, void
 }
 
 void ofxGstRTPServer::sendAudioOut(PooledAudioFrame * pooledFrame){
-	GstClock * clock = gst_pipeline_get_clock(GST_PIPELINE(gst.getPipeline()));
-	gst_object_ref(clock);
-	GstClockTime now = gst_clock_get_time (clock) - gst_element_get_base_time(gst.getPipeline());
-	gst_object_unref (clock);
-	if(firstAudioFrame && !audioAutoTimestamp){
-		prevTimestampAudio = now;
-		firstAudioFrame = false;
+	Channel * audio = getChannel(OFX_GST_RTP_AUDIO,0);
+	if(!audio) return;
+
+	GstClockTime now = pipelineClock.now();
+	if(audio->firstFrame && !audio->autoTimestamp){
+		audio->prevTimestamp = now;
+		audio->firstFrame = false;
 		return;
 	}
 
@@ -1211,16 +2016,16 @@ void ofxGstRTPServer::sendAudioOut(PooledAudioFrame * pooledFrame){
 
 	GstBuffer * echoCancelledBuffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,(void*)pooledFrame->audioFrame._payloadData,size,0,size,pooledFrame,(GDestroyNotify)&ofxWebRTCAudioPool::relaseFrame);
 
-	if(!audioAutoTimestamp){
+	if(!audio->autoTimestamp){
 		GstClockTime duration = (pooledFrame->audioFrame._payloadDataLengthInSamples * GST_SECOND / pooledFrame->audioFrame._frequencyInHz);
-		GstClockTime now = prevTimestamp + duration;
+		GstClockTime now = audio->prevTimestamp + duration;
 
-		GST_BUFFER_OFFSET(echoCancelledBuffer) = numFrameAudio++;
-		GST_BUFFER_OFFSET_END(echoCancelledBuffer) = numFrameAudio;
+		GST_BUFFER_OFFSET(echoCancelledBuffer) = audio->numFrame++;
+		GST_BUFFER_OFFSET_END(echoCancelledBuffer) = audio->numFrame;
 		GST_BUFFER_DTS (echoCancelledBuffer) = now;
 		GST_BUFFER_PTS (echoCancelledBuffer) = now;
 		GST_BUFFER_DURATION(echoCancelledBuffer) = duration;
-		prevTimestampAudio = now;
+		audio->prevTimestamp = now;
 	}
 
 
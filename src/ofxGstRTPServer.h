@@ -15,11 +15,19 @@
 #include "ofParameterGroup.h"
 
 #include "ofxGstRTPConstants.h"
+#include "ofxGstRTPCodecs.h"
+#include "ofxGstRTPBitrateController.h"
+#include "ofxGstRTPFECController.h"
+#include "ofxGstRTPStats.h"
+#include "ofxGstPipelineClock.h"
+#include "ofxGstPixelsPool.h"
+#include "ofxGstVideoConverter.h"
 
 #include "ofxOsc.h"
 #include "ofxOscPacketPool.h"
 
-#include "ofxDepthStreamCompression.h"
+#include "ofxGstDepth16Codec.h"
+#include "ofxGstDepth16Packer.h"
 
 #if ENABLE_NAT_TRANSVERSAL
 	#include "ofxNice.h"
@@ -34,9 +42,6 @@
 
 class ofxGstRTPClient;
 
-template<typename PixelType>
-class ofxGstBufferPool;
-
 
 /// Server part implementing RTP. Allows to send audio, video, depth
 /// and metadata through osc to a remote peer. All the channels
@@ -54,18 +59,136 @@ public:
 	void setRTPClient(ofxGstRTPClient & client);
 #endif
 
+	/// sets the number of buffers preallocated for each video and depth channel
+	/// and what to do when all of them are in use by the pipeline, usually when
+	/// the encoder can't keep up. Needs to be called before adding the channels
+	void setBufferPoolSettings(int capacity, ofxGstBufferPoolOverflow overflow);
+
+	/// by default RGB video frames are converted to I420 by the addon using
+	/// SIMD and several threads before passing them to the pipeline instead
+	/// of using videoconvert. inProcess=false goes back to videoconvert.
+	/// numThreads is the number of threads used to convert each frame, 0 chooses
+	/// it from the number of cores. Applies to the video channels added afterwards
+	void setVideoConversionSettings(bool inProcess, int numThreads=0);
+
+	/// 16bits depth frames are split in tiles of whole rows compressed in
+	/// parallel. numThreads is the number of threads used to compress each
+	/// frame, 0 chooses it from the number of cores, numTiles 0 uses 2 per
+	/// thread. Applies to the depth channels added afterwards
+	void setDepthCompressionSettings(int numThreads=0, int numTiles=0);
+
+	/// by default 16bits depth is compressed losslessly by the addon. With
+	/// packed=true the 16bits depth channels added afterwards are packed in
+	/// 8bits planes with ofxGstDepth16Packer and encoded with the depth codec
+	/// instead, which uses much less bandwidth with an error of around a
+	/// millimeter for depth in mm up to maxDepth. The client needs the same
+	/// settings
+	void setDepth16Packing(bool packed, int maxDepth=ofxGstDepth16Packer::DEFAULT_MAX_DEPTH);
+
+	/// by default every osc message is sent in its own packet. With bundled=true
+	/// the osc channels added afterwards coalesce the messages in an osc bundle
+	/// that is sent as one packet with the timestamp of its first message once
+	/// windowUs microseconds have passed since that message or the bundle has
+	/// maxBytes or more. windowUs 0 sends one bundle per app frame. The window
+	/// is checked on every message and on every update so a bundle can be
+	/// delayed up to one app frame after its window. The client expands the
+	/// bundles so it doesn't need any settings
+	void setOscBundleSettings(bool bundled, int windowUs=0, int maxBytes=DEFAULT_OSC_BUNDLE_BYTES);
+
+	/// sends the osc bundle being built for a channel right away
+	void flushOscBundle(int channel=0);
+
+	/// compression of the osc channels added afterwards, adaptive by default:
+	/// packets smaller than minBytes are sent raw and the rest are compressed
+	/// with snappy while it makes them smaller, see ofxGstOscEncoder. Every
+	/// packet carries a byte saying how it's encoded so the client doesn't
+	/// need any settings
+	void setOscCompressionSettings(ofxGstOscCompression compression, int minBytes=ofxGstOscEncoder::DEFAULT_MIN_BYTES);
+
+	static const int DEFAULT_OSC_BUNDLE_BYTES = 1024;
+
+	/// bundles can't grow more than this so they fit in a pooled packet
+	static const int MAX_OSC_BUNDLE_BYTES = 32768;
+
+	/// selects the encoder for the video channels added after calling it, x264
+	/// by default. The client needs to use a codec with the same encoding, which
+	/// ofxGstXMPPRTP negotiates automatically
+	void setVideoCodec(ofxGstRTPVideoCodec codec);
+
+	/// selects the encoder for the 8bits depth channels added after calling it,
+	/// x264 by default
+	void setDepthCodec(ofxGstRTPVideoCodec codec);
+
+	/// codec that will be used by the next channel, if the selected one is not
+	/// available when adding a channel this returns the one used instead
+	ofxGstRTPVideoCodec getVideoCodec();
+	ofxGstRTPVideoCodec getDepthCodec();
+
+	/// simulcast: the video channels added after calling this send numLayers
+	/// versions of the same input, full, half and quarter resolution, each in
+	/// its own rtp session with its own ssrc, bitrate and stats. The frames are
+	/// converted once and every layer scales and encodes them separately.
+	/// Layer n is sent from port + 5*n so a channel with layers occupies 5 ports
+	/// per layer. Up to 3 layers, only for channels sent through udp
+	void setVideoLayers(int numLayers);
+	int getVideoLayers();
+
+	/// retransmission of lost packets (RFC 4588) for the video, depth and osc
+	/// channels added after calling it, enabled by default when gstreamer has
+	/// the rtprtxsend and rtprtxreceive elements. The sent packets
+	/// are kept for historyMs to answer the NACKs of the clients. With it
+	/// enabled the server doesn't send keyframes when the receivers report
+	/// loss, the client asks for one only if a packet couldn't be recovered
+	void setRetransmissionSettings(bool enabled, int historyMs=1000);
+
+	/// forward error correction (ULPFEC, XOR parity) for the video, depth and
+	/// osc channels added after calling it, disabled by default. Recovers lost
+	/// packets without waiting for a retransmission which is useful when the
+	/// round trip is longer than the latency of the client. percentage is the
+	/// overhead, FEC packets per 100 media packets. When adaptive it changes
+	/// between min and max following the loss in the receiver reports.
+	/// The client needs to enable it too
+	void setFECSettings(bool enabled, int percentage=10, bool adaptive=true, int minPercentage=5, int maxPercentage=50);
+
 	/// use this version of setup when working with direct connection
 	/// to an specific IP and port, usually in LANs when there's no need
 	/// for NAT transversal.
+	/// destinationAddress is the first destination, it can be empty and the
+	/// destinations added later with addDestination
 	void setup(string destinationAddress);
 
+	/// fan-out: every channel is encoded only once and sent to all the
+	/// destinations, using the same ports for all of them. Destinations can be
+	/// added and removed while the server is playing, a new destination forces
+	/// a keyframe in the video and depth channels so it can start decoding.
+	/// Only applies to channels sent through udp, not the ofxNiceStream ones.
+	/// Returns false if the destination was already added or not found
+	bool addDestination(const string & host);
+	bool removeDestination(const string & host);
+
+	/// current list of destinations
+	vector<string> getDestinations();
+
+	/// sends only one layer of the simulcast video channels to a destination,
+	/// usually the one its client selected, so receivers with less bandwidth
+	/// don't get the rest. Channels with less layers send their last one.
+	/// layer -1 goes back to sending every layer, which is the default.
+	/// Returns false if the destination was not added
+	bool setDestinationVideoLayer(const string & host, int layer);
+
 	/// add a video channel sending from a specific port, has to be the same port
 	/// specified in the client. Ports for the different channels will really occupy
 	/// the next 5 ports so if we specify 3000, 3000-3005 will be used and shouldn't
 	/// be specified for other channel
 	/// autotimestamp, specifies if the gstreamer will create timestamps automatically (true)
 	/// or we want to generate them internally or externally (false)
-	void addVideoChannel(int port, int w, int h, int fps, bool autotimestamp=false);
+	/// format, is the format of the frames passed to newFrame, it can be OF_PIXELS_RGB,
+	/// OF_PIXELS_RGBA, OF_PIXELS_YUY2, OF_PIXELS_I420 or OF_PIXELS_NV12. I420, and NV12
+	/// with x264, are passed directly to the encoder without any conversion
+	/// Any number of video channels can be added, each one in its own rtp session
+	/// of the same pipeline. Returns the index of the new channel that has to be
+	/// passed to newFrame when there's more than one
+	int addVideoChannel(int port, int w, int h, int fps, bool autotimestamp=false, ofPixelFormat format=OF_PIXELS_RGB);
 
 	/// add an audio channel sending from a specific port, has to be the same port
 	/// specified in the client. Ports for the different channels will really occupy
@@ -73,7 +196,9 @@ public:
 	/// be specified for other channel
 	/// autotimestamp, specifies if the gstreamer will create timestamps automatically (true)
 	/// or we want to generate them internally or externally (false)
-	void addAudioChannel(int port, bool autotimestamp=false);
+	/// There can only be one audio channel since it's tied to the audio capture and
+	/// the echo cancellation, returns -1 if there's one already
+	int addAudioChannel(int port, bool autotimestamp=false);
 
 	/// add a depth channel sending from a specific port, has to be the same port
 	/// specified in the client. Ports for the different channels will really occupy
@@ -81,7 +206,8 @@ public:
 	/// be specified for other channel
 	/// autotimestamp, specifies if the gstreamer will create timestamps automatically (true)
 	/// or we want to generate them internally or externally (false)
-	void addDepthChannel(int port, int w, int h, int fps, bool depth16=false, bool autotimestamp=false);
+	/// Returns the index of the new depth channel
+	int addDepthChannel(int port, int w, int h, int fps, bool depth16=false, bool autotimestamp=false);
 
 	/// add an osc channel sending from a specific port, has to be the same port
 	/// specified in the client. Ports for the different channels will really occupy
@@ -89,7 +215,8 @@ public:
 	/// be specified for other channel
 	/// autotimestamp, specifies if the gstreamer will create timestamps automatically (true)
 	/// or we want to generate them internally or externally (false)
-	void addOscChannel(int port, bool autotimestamp=false);
+	/// Returns the index of the new osc channel
+	int addOscChannel(int port, bool autotimestamp=false);
 
 #if ENABLE_NAT_TRANSVERSAL
 	/// use this version of setup when working with NAT transversal
@@ -97,57 +224,179 @@ public:
 	/// all the workflow of the session initiation as well as creating
 	/// the corresponging ICE streams and agent
 	void setup();
-	void addVideoChannel(shared_ptr<ofxNiceStream>, int w, int h, int fps, bool autotimestamp=false);
-	void addAudioChannel(shared_ptr<ofxNiceStream>, bool autotimestamp=false);
-	void addDepthChannel(shared_ptr<ofxNiceStream>, int w, int h, int fps, bool depth16=false, bool autotimestamp=false);
-	void addOscChannel(shared_ptr<ofxNiceStream>, bool autotimestamp=false);
+	int addVideoChannel(shared_ptr<ofxNiceStream>, int w, int h, int fps, bool autotimestamp=false, ofPixelFormat format=OF_PIXELS_RGB);
+	int addAudioChannel(shared_ptr<ofxNiceStream>, bool autotimestamp=false);
+	int addDepthChannel(shared_ptr<ofxNiceStream>, int w, int h, int fps, bool depth16=false, bool autotimestamp=false);
+	int addOscChannel(shared_ptr<ofxNiceStream>, bool autotimestamp=false);
 #endif
 
+	/// number of channels of each kind added since setup
+	int getNumVideoChannels();
+	int getNumDepthChannels();
+	int getNumOscChannels();
+
+	/// number of simulcast layers of a video channel, 1 if it has none
+	int getNumVideoLayers(int channel=0);
+
 	/// close the current connection
 	void close();
 
 	/// starts the gstreamer pipeline
 	void play();
 
-	/// generate a keyframe on the video stream, used by other parts of the
+	/// generate a keyframe on a video stream, used by other parts of the
 	/// addon to avoid glitches when some packages are lost
-	void emitVideoKeyFrame();
+	void emitVideoKeyFrame(int channel=0);
 
-	/// generate a keyframe on the depth stream, used by other parts of the
+	/// generate a keyframe on a depth stream, used by other parts of the
 	/// addon to avoid glitches when some packages are lost
-	void emitDepthKeyFrame();
+	void emitDepthKeyFrame(int channel=0);
 
 	/// ofxGstRTPServer will generate timestamps for every channel if the
 	/// corresponding newFrame* method is called with timestamp = GST_CLOCK_TIME_NONE
 	/// In some cases is better to get a timestamp each update and use that for
-	/// every channel to improve sync
+	/// every channel to improve sync. Doesn't lock the pipeline once it's
+	/// playing so it can be called at a high rate from any thread
 	GstClockTime getTimeStamp();
 
+	/// same as getTimeStamp but returns the same value for every call
+	/// during an app frame, to pass to the newFrame* methods of several
+	/// channels so they are timestamped together
+	GstClockTime getFrameTimeStamp();
+
 	/// Should be called when there's a new video frame, if timestamp is not
 	/// specified, will generate one internally
 	void newFrame(ofPixels & pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
 
+	/// Zero copy version of newFrame, the memory of the passed pixels is swapped
+	/// into a buffer from the internal pool instead of copied so the passed
+	/// pixels will contain a different buffer after calling this method
+	void newFrame(ofPixels && pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+
+	/// Zero copy version of newFrame for buffers obtained through getVideoBuffer,
+	/// the buffer is passed to the pipeline and will return to the pool once
+	/// it's not needed anymore so it shouldn't be used after calling this method
+	void newFrame(PooledPixels<unsigned char> * pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+
+	/// Should be called when there's a new video frame that is stored in separate
+	/// planes like usually happens with the output of cameras in yuv formats.
+	/// planes and strides should contain as many elements as planes in the
+	/// format of the channel (I420: 3, NV12: 2, others 1). The planes are copied
+	/// without doing any conversion
+	void newFrame(const unsigned char * const planes[], const int strides[], GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+
+	/// versions of newFrame for sessions with several video channels, channel is
+	/// the index returned by addVideoChannel. The ones above send to channel 0
+	void newFrame(int channel, ofPixels & pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+	void newFrame(int channel, ofPixels && pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+	void newFrame(int channel, PooledPixels<unsigned char> * pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+	void newFrame(int channel, const unsigned char * const planes[], const int strides[], GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+
+	/// returns a buffer from a video channel pool so the application can render
+	/// or capture directly into it and pass it to newFrame without any copy.
+	/// if the buffer is not passed to newFrame it has to be returned using
+	/// releaseBuffer. Returns NULL if the pool is exhausted
+	PooledPixels<unsigned char> * getVideoBuffer(int channel=0);
+
 	/// Should be called when there's a new depth frame, if timestamp is not
 	/// specified, will generate one internally
 	void newFrameDepth(ofPixels & pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
 
+	/// Zero copy version of newFrameDepth, the memory of the passed pixels is
+	/// swapped into a buffer from the internal pool instead of copied
+	void newFrameDepth(ofPixels && pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+
+	/// Zero copy version of newFrameDepth for buffers obtained through getDepthBuffer
+	void newFrameDepth(PooledPixels<unsigned char> * pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+
 	/// Should be called when there's a new 16bits depth frame, if timestamp is not
 	/// specified, will generate one internally
 	/// pixel_size and distance are the calibration parameter from the kinect
 	void newFrameDepth(ofShortPixels & pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE, float pixel_size=1, float distance=1);
 
+	/// versions of newFrameDepth for sessions with several depth channels, channel
+	/// is the index returned by addDepthChannel. The ones above send to channel 0
+	void newFrameDepth(int channel, ofPixels & pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+	void newFrameDepth(int channel, ofPixels && pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+	void newFrameDepth(int channel, PooledPixels<unsigned char> * pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+	void newFrameDepth(int channel, ofShortPixels & pixels, GstClockTime timestamp=GST_CLOCK_TIME_NONE, float pixel_size=1, float distance=1);
+
+	/// returns a buffer from an 8bits depth channel pool, same as getVideoBuffer
+	PooledPixels<unsigned char> * getDepthBuffer(int channel=0);
+
+	/// returns a buffer obtained through getVideoBuffer or getDepthBuffer
+	/// to its pool when it's not going to be sent
+	void releaseBuffer(PooledPixels<unsigned char> * pixels);
+
 	/// Should be called when there's a new osc message, if timestamp is not
 	/// specified, will generate one internally
 	void newOscMsg(ofxOscMessage & msg, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
 
+	/// sends an osc message through the osc channel with the passed index
+	void newOscMsg(int channel, ofxOscMessage & msg, GstClockTime timestamp=GST_CLOCK_TIME_NONE);
+
+	/// counters of the buffers pool used by a video channel
+	ofxGstBufferPoolStats getVideoPoolStats(int channel=0);
+
+	/// counters of the buffers pool used by a depth channel. 16bits depth is
+	/// compressed directly into buffers of this pool big enough for the
+	/// worst case, so as long as misses stay at 0 no memory is allocated
+	/// to send it
+	ofxGstBufferPoolStats getDepthPoolStats(int channel=0);
+
+	/// osc packets are taken from a pool shared by all the osc channels with
+	/// classes of 256B, 2KB and 64KB chosen by the size of each message or
+	/// bundle. maxRetainedBytes bounds the memory the pool keeps for reuse,
+	/// packets that don't fit are allocated and freed once sent. Has to be
+	/// called before adding any osc channel
+	void setOscPoolSettings(size_t maxRetainedBytes=ofxOscPacketPool::DEFAULT_MAX_RETAINED_BYTES);
+
+	/// counters of one size class of the osc packets pool, from 0 to
+	/// ofxOscPacketPool::NUM_SIZE_CLASSES-1
+	ofxOscPacketPoolStats getOscPoolStats(int sizeClass);
+
+	/// last stats sampled for a channel: local bitrate and packets sent and
+	/// the loss, jitter and round trip reported by the remote peer. The stats
+	/// are collected periodically in a separate thread once the server is playing.
+	/// With several destinations the receiver report values are the worst of
+	/// all of them, since the bitrate has to work for every receiver
+	ofxGstRTPStats getStats(ofxGstRTPChannel type, int channel=0);
+
+	/// last stats sampled for one destination of a channel, host is the address
+	/// the receiver sends its rtcp from, usually the one passed to addDestination.
+	/// keyframesRequested counts the keyframes caused by loss in that destination
+	ofxGstRTPStats getDestinationStats(ofxGstRTPChannel type, const string & host, int channel=0);
+
+	/// copies the recent stats samples of a channel, oldest first
+	void getStatsHistory(ofxGstRTPChannel type, vector<ofxGstRTPStats> & history, int channel=0);
+
+	/// last stats sampled for one simulcast layer of a video channel, getStats
+	/// returns the ones of layer 0
+	ofxGstRTPStats getVideoLayerStats(int layer, int channel=0);
+
+	/// time between stats samples and number of samples kept in the history
+	/// of each channel, takes effect the next time the server starts playing
+	void setStatsSettings(int intervalMs, int historySize);
+
+	/// the bitrate controllers adjust the bitrate of each channel from the
+	/// RTCP receiver reports when adaptiveBitrate is enabled. Use them to
+	/// change the min/max bounds or to query the current target and the
+	/// reason for the last change. Video and depth are in kbps, audio in bps.
+	/// Before adding a channel these return the controller every new channel
+	/// of that kind copies its settings from
+	ofxGstRTPBitrateController & getVideoBitrateController(int channel=0);
+	ofxGstRTPBitrateController & getDepthBitrateController(int channel=0);
+	ofxGstRTPBitrateController & getAudioBitrateController();
+
 	/// groups all the parameters of this class
 	ofParameterGroup parameters;
 
-	/// parameter to adjust the bitrate of the video stream, can be adjunsted
-	/// on runtime
+	/// parameter to adjust the bitrate of the first video stream, can be adjusted
+	/// on runtime. Other video channels start with this value and add their
+	/// own parameter to the group
 	ofParameter<int> videoBitrate;
 
-	/// parameter to adjust the bitrate of the depth stream, can be adjusted
+	/// parameter to adjust the bitrate of the first depth stream, can be adjusted
 	/// on runtime
 	ofParameter<int> depthBitrate;
 
@@ -155,6 +404,11 @@ public:
 	/// on runtime
 	ofParameter<int> audioBitrate;
 
+	/// when enabled the bitrate parameters are adjusted automatically
+	/// by the bitrate controllers depending on the network conditions.
+	/// Disabled by default so the bitrates set by the application are kept
+	ofParameter<bool> adaptiveBitrate;
+
 	/// parameter to change the type of calculation for the drift when doing
 	/// echo cancellation
 	ofParameter<bool> reverseDriftCalculation;
@@ -163,73 +417,161 @@ public:
 
 private:
 
+	/// a remote peer receiving a channel, identified by the ssrc of its
+	/// receiver reports
+	struct Receiver{
+		guint ssrc;
+		string host;
+		ofxGstRTPStats stats;
+		int packetsLost;
+		unsigned int keyframesRequested;
+	};
+
+	/// everything needed to send one stream, there's one per rtp session
+	/// and the session number is also its index in the channels vector.
+	/// simulcast layers are channels too but only the first layer is listed
+	/// by type, the rest hang from it
+	struct Channel{
+		Channel(ofxGstRTPChannel type, int index, guint session);
+		~Channel();
+
+		void bitrateChanged(int & bitrate);
+
+		/// name of an element of this channel in the pipeline
+		string getElementName(const string & name) const;
+
+		ofxGstRTPChannel type;
+		int index;
+		guint session;
+		int port;
+		int layer;
+		int numLayers;
+		vector<Channel*> layers;
+		int payloadType;
+		bool retransmission;
+		bool fec;
+
+		GstElement * appsrc;
+		GstElement * encoder;
+		GstElement * rtpsink;
+		GstElement * rtcpsink;
+		GstElement * rtcpsrc;
+		GstElement * rtxsend;
+		GstElement * fecenc;
+
+		// video and depth frames
+		ofxGstBufferPool<unsigned char> * pool;
+		ofxGstBufferPool<unsigned char> * poolConverted;
+		ofxGstVideoConverter converter;
+		ofxGstDepth16Compressor depthCompressor;
+		ofxGstDepth16Packer depthPacker;
+		int width, height;
+		ofPixelFormat format;
+		ofxGstRTPVideoCodec codec;
+		bool depth16;
+		bool depth16Packed;
+
+		// osc bundle being built, can be sent from newOscMsg or from update
+		std::mutex oscMutex;
+		bool oscBundled;
+		int oscBundleWindowUs;
+		int oscBundleMaxBytes;
+		PooledOscPacket * oscBundle;
+		GstClockTime oscBundleTimestamp;
+		unsigned long long oscBundleStart;
+		ofxGstOscEncoder oscEncoder;
+
+		bool autoTimestamp;
+		bool firstFrame;
+		GstClockTime prevTimestamp;
+		unsigned long long numFrame;
+		bool sendKeyFrame;
+
+		// remote peers receiving this channel, added from the streaming
+		// thread and sampled from the stats collector
+		std::mutex receiversMutex;
+		vector<Receiver> receivers;
+		std::atomic<unsigned int> keyframesRequested;
+
+		// rtcp stats stream adjustment
+		ofParameter<int> bitrate;
+		ofxGstRTPBitrateController bitrateController;
+		ofxGstRTPFECController fecController;
+
+#if ENABLE_NAT_TRANSVERSAL
+		shared_ptr<ofxNiceStream> niceStream;
+#endif
+	};
+
+	Channel & createChannel(ofxGstRTPChannel type, int port, bool autotimestamp);
+	Channel & createLayerChannel(Channel & channel, int layer);
+	void setupChannelBitrate(Channel & channel, ofParameter<int> & bitrate, const ofxGstRTPBitrateController & settings);
+	Channel * getChannel(ofxGstRTPChannel type, int index);
+	Channel * getVideoLayer(int channel, int layer);
+	string getNetworkElements(const Channel & channel);
+	bool getFrameTimestamp(Channel & channel, GstClockTime & timestamp);
+	void setBufferTimestamp(Channel & channel, GstBuffer * buffer, GstClockTime timestamp);
+	void emitKeyFrame(Channel & channel);
+
 	bool on_message(GstMessage * msg);
-	void vBitRateChanged(int & bitrate);
-	void dBitRateChanged(int & bitrate);
-	void aBitRateChanged(int & bitrate);
+	void updateBitrate(const ofxGstRTPStats & stats, Channel & channel);
+	void updateFEC(const ofxGstRTPStats & stats, Channel & channel);
+	bool sampleStats(int session, ofxGstRTPStats & stats);
 	void appendMessage( ofxOscMessage& message, osc::OutboundPacketStream& p );
+	size_t getOscMessageSize(ofxOscMessage & message);
+	void pushOscPacket(Channel & channel, PooledOscPacket * packet, GstClockTime timestamp);
+	void pushOscBundle(Channel & channel);
+	// "#bundle" and the time tag
+	static const int OSC_BUNDLE_HEADER_BYTES = 16;
+	void pushVideoBuffer(Channel & channel, PooledPixels<unsigned char> * pixels, GstClockTime timestamp);
+	PooledPixels<unsigned char> * convertVideoFrame(Channel & channel, const ofPixels & pixels);
+	void pushDepthBuffer(Channel & channel, PooledPixels<unsigned char> * pixels, GstClockTime timestamp);
+	string getPoolQueue();
 	static void on_new_ssrc_handler(GstBin *rtpbin, guint session, guint ssrc, ofxGstRTPServer * rtpClient);
+	static void on_bye_ssrc_handler(GstBin *rtpbin, guint session, guint ssrc, ofxGstRTPServer * rtpClient);
+	static void on_feedback_rtcp_handler(GObject * session, guint type, guint fbtype, guint senderSSRC, guint mediaSSRC, GstBuffer * fci, Channel * channel);
+	bool isSentTo(const Channel & channel, const string & host);
+	string getClients(const Channel & channel, int port);
 	void update(ofEventArgs& args);
 
 
 	ofGstUtils gst;
 	ofGstUtils gstAudioIn;
 	GstElement * rtpbin;
-	GstElement * vRTPsink;
-	GstElement * vRTPCsink;
-	GstElement * vRTPCsrc;
-
-	GstElement * aRTPsink;
-	GstElement * aRTPCsink;
-	GstElement * aRTPCsrc;
-
-	GstElement * dRTPsink;
-	GstElement * dRTPCsink;
-	GstElement * dRTPCsrc;
-
-	GstElement * oRTPsink;
-	GstElement * oRTPCsink;
-	GstElement * oRTPCsrc;
-
-	GstElement * vEncoder;
-	GstElement * dEncoder;
-	GstElement * aEncoder;
-	GstElement * appSrcVideoRGB;
-	GstElement * appSrcDepth;
-	GstElement * appSrcOsc;
-	ofxGstBufferPool<unsigned char> * bufferPool;
-	ofxGstBufferPool<unsigned char> * bufferPoolDepth;
+
+	// every channel indexed by session number and by type
+	vector<shared_ptr<Channel> > channels;
+	vector<shared_ptr<Channel> > channelsByType[OFX_GST_RTP_NUM_CHANNELS];
+
+	bool convertVideoInProcess;
+	int videoConversionThreads;
+	int depthCompressionThreads, depthCompressionTiles;
+	bool depth16Packed;
+	int depth16MaxDepth;
+	bool oscBundled;
+	int oscBundleWindowUs;
+	int oscBundleMaxBytes;
+	ofxGstOscCompression oscCompression;
+	int oscCompressionMinBytes;
+	int poolCapacity;
+	ofxGstBufferPoolOverflow poolOverflow;
 	ofxOscPacketPool oscPacketPool;
-	int fps;
-	GstClockTime prevTimestamp;
-	unsigned long long numFrame;
-	GstClockTime prevTimestampDepth;
-	unsigned long long numFrameDepth;
-	GstClockTime prevTimestampOsc;
-	unsigned long long numFrameOsc;
-	GstClockTime prevTimestampAudio;
-	unsigned long long numFrameAudio;
-	int width, height;
+	ofxGstRTPVideoCodec videoCodec, depthCodec;
+	int videoLayers;
+	bool retransmission;
+	int retransmissionHistory;
+	bool fec, adaptiveFEC;
+	int fecPercentage, fecMinPercentage, fecMaxPercentage;
 
 	string pipelineStr;
-	string dest;
-	guint lastSessionNumber;
-	guint audioSessionNumber, videoSessionNumber, depthSessionNumber, oscSessionNumber;
-	guint audioSSRC, videoSSRC, depthSSRC, oscSSRC;
-	bool sendVideoKeyFrame, sendDepthKeyFrame;
+	vector<string> destinations;
+	map<string,int> destinationLayers;
 
 #if ENABLE_NAT_TRANSVERSAL
-	shared_ptr<ofxNiceStream> videoStream;
-	shared_ptr<ofxNiceStream> depthStream;
-	shared_ptr<ofxNiceStream> oscStream;
-	shared_ptr<ofxNiceStream> audioStream;
+	// stream for the channel being added by the ofxNiceStream versions of add*Channel
+	shared_ptr<ofxNiceStream> nextNiceStream;
 #endif
 
-	bool firstVideoFrame;
-	bool firstOscFrame;
-	bool firstDepthFrame;
-	bool firstAudioFrame;
-
 #if ENABLE_ECHO_CANCEL
 	bool audioChannelReady;
 	GstElement * appSinkAudio;
@@ -251,12 +593,13 @@ private:
 	void sendAudioOut(PooledAudioFrame * pooledFrame);
 #endif
 
-	ofxDepthStreamCompression depthCompressor;
-
-	// rctp stats stream adjustment
-	int videoPacketsLost, depthPacketsLost;
-
-	bool videoAutoTimestamp, depthAutoTimestamp, audioAutoTimestamp, oscAutoTimestamp;
+	// settings copied by every new channel of each kind
+	ofxGstRTPBitrateController videoBitrateController;
+	ofxGstRTPBitrateController depthBitrateController;
+	ofxGstRTPBitrateController audioBitrateController;
+	ofxGstRTPStatsCollector statsCollector;
+	ofxGstPipelineClock pipelineClock;
+	int statsInterval, statsHistorySize;
 };
 
 #endif /* OFXGSTRTPSERVER_H_ */
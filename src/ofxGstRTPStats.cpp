@@ -0,0 +1,129 @@
+/*
+ * ofxGstRTPStats.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofxGstRTPStats.h"
+#include "ofUtils.h"
+
+ofxGstRTPStats::ofxGstRTPStats()
+:timestamp(0)
+,bitrate(0)
+,packetsSent(0)
+,packetsReceived(0)
+,packetsLost(0)
+,fractionLost(0)
+,jitter(0)
+,roundTrip(0)
+,haveReceiverReport(false)
+,extHighestSeq(0)
+,jitterbufferLate(0)
+,jitterbufferLost(0)
+,jitterbufferDuplicates(0)
+,retransmissionRequests(0)
+,retransmissions(0)
+,fecPercentage(0)
+,fecRecovered(0)
+,fecUnrecovered(0)
+,keyframesRequested(0)
+,framesDecoded(0)
+,framesDropped(0){
+
+}
+
+ofxGstRTPStatsCollector::ofxGstRTPStatsCollector()
+:intervalMs(DEFAULT_INTERVAL_MS)
+,running(false){
+
+}
+
+ofxGstRTPStatsCollector::~ofxGstRTPStatsCollector(){
+	close();
+}
+
+void ofxGstRTPStatsCollector::setup(Sampler sampler, int numSessions, int intervalMs, int historySize){
+	close();
+	this->sampler = sampler;
+	this->intervalMs = intervalMs;
+	histories.resize(std::max(numSessions,0));
+	for(size_t i=0;i<histories.size();i++){
+		histories[i].samples.assign(std::max(historySize,1),ofxGstRTPStats());
+		histories[i].next = 0;
+		histories[i].count = 0;
+	}
+	running = true;
+	thread = std::thread(&ofxGstRTPStatsCollector::threadedFunction,this);
+}
+
+void ofxGstRTPStatsCollector::close(){
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		running = false;
+		condition.notify_all();
+	}
+	if(thread.joinable()){
+		thread.join();
+	}
+	for(size_t i=0;i<histories.size();i++){
+		histories[i].next = 0;
+		histories[i].count = 0;
+	}
+}
+
+void ofxGstRTPStatsCollector::threadedFunction(){
+	vector<ofxGstRTPStats> stats(histories.size());
+	vector<bool> sampled(histories.size());
+	std::unique_lock<std::mutex> lock(mutex);
+	while(running){
+		// the sampler queries gstreamer which can take some time,
+		// don't hold the lock while doing it. The number of sessions only
+		// changes in setup so histories can be read without locking
+		lock.unlock();
+		for(size_t i=0;i<histories.size();i++){
+			stats[i] = ofxGstRTPStats();
+			sampled[i] = sampler(i,stats[i]);
+			stats[i].timestamp = ofGetElapsedTimeMillis();
+		}
+		lock.lock();
+
+		for(size_t i=0;i<histories.size();i++){
+			if(!sampled[i]) continue;
+			History & history = histories[i];
+			history.samples[history.next] = stats[i];
+			history.next = (history.next + 1) % history.samples.size();
+			history.count = std::min(history.count + 1, history.samples.size());
+		}
+
+		// the predicate catches a close that happened while sampling and
+		// ignores spurious wakeups
+		condition.wait_for(lock,std::chrono::milliseconds(intervalMs),[this]{return !running;});
+	}
+}
+
+ofxGstRTPStats ofxGstRTPStatsCollector::getStats(int session) const{
+	std::unique_lock<std::mutex> lock(mutex);
+	if(session<0 || session>=int(histories.size())){
+		return ofxGstRTPStats();
+	}
+	const History & history = histories[session];
+	if(history.count==0){
+		return ofxGstRTPStats();
+	}
+	size_t last = (history.next + history.samples.size() - 1) % history.samples.size();
+	return history.samples[last];
+}
+
+void ofxGstRTPStatsCollector::getHistory(int session, vector<ofxGstRTPStats> & samples) const{
+	std::unique_lock<std::mutex> lock(mutex);
+	if(session<0 || session>=int(histories.size())){
+		samples.clear();
+		return;
+	}
+	const History & history = histories[session];
+	samples.resize(history.count);
+	size_t first = (history.next + history.samples.size() - history.count) % std::max<size_t>(history.samples.size(),1);
+	for(size_t i=0;i<history.count;i++){
+		samples[i] = history.samples[(first + i) % history.samples.size()];
+	}
+}
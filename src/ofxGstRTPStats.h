@@ -0,0 +1,140 @@
+/*
+ * ofxGstRTPStats.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTRTPSTATS_H_
+#define OFXGSTRTPSTATS_H_
+
+#include "ofConstants.h"
+#include <stdint.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/// kind of media sent through a channel, a session can contain several
+/// channels of each kind
+enum ofxGstRTPChannel{
+	OFX_GST_RTP_VIDEO,
+	OFX_GST_RTP_DEPTH,
+	OFX_GST_RTP_AUDIO,
+	OFX_GST_RTP_OSC,
+	OFX_GST_RTP_NUM_CHANNELS
+};
+
+/// statistics of a channel at some point in time. Fields that don't apply
+/// to the side that collected them (eg. packetsReceived in the server or
+/// roundTrip in the client) are 0
+struct ofxGstRTPStats{
+	ofxGstRTPStats();
+
+	/// time when the sample was taken in ms since the app started,
+	/// 0 if no sample has been taken yet
+	uint64_t timestamp;
+
+	/// bitrate in bits per second as estimated by the rtp session
+	uint64_t bitrate;
+
+	uint64_t packetsSent;
+	uint64_t packetsReceived;
+
+	/// total packets lost, in the server as reported by the remote peer
+	int packetsLost;
+
+	/// fraction of packets lost since the previous report [0..1]
+	float fractionLost;
+
+	/// interarrival jitter in seconds
+	double jitter;
+
+	/// round trip time in seconds
+	double roundTrip;
+
+	/// server only: true if the remote peer has sent a receiver report, the
+	/// loss, jitter and round trip values come from it
+	bool haveReceiverReport;
+
+	/// server only: extended highest sequence number in the last receiver
+	/// report, changes every time a new report arrives
+	unsigned int extHighestSeq;
+
+	/// client only: counters of the jitterbuffer
+	uint64_t jitterbufferLate;
+	uint64_t jitterbufferLost;
+	uint64_t jitterbufferDuplicates;
+
+	/// retransmissions requested through NACKs and packets retransmitted,
+	/// in the server from the retransmission sender and in the client from
+	/// the jitterbuffer, where retransmissions only counts the ones that
+	/// arrived in time
+	uint64_t retransmissionRequests;
+	uint64_t retransmissions;
+
+	/// forward error correction, in the server the current overhead in FEC
+	/// packets per 100 media packets, in the client the lost packets the
+	/// FEC decoder could and couldn't recover
+	unsigned int fecPercentage;
+	uint64_t fecRecovered;
+	uint64_t fecUnrecovered;
+
+	/// keyframes requested because of packet loss or latency changes
+	unsigned int keyframesRequested;
+
+	/// client only: 16bits depth frames decompressed and frames dropped
+	/// without decompressing because the decoder couldn't keep up, for osc
+	/// channels packets queued for the application and packets dropped
+	/// because the queue was full
+	uint64_t framesDecoded;
+	uint64_t framesDropped;
+};
+
+/// samples the stats of every rtp session periodically from its own thread so
+/// querying gstreamer never blocks the main thread, and keeps a fixed size
+/// history of the last samples for each session.
+/// The sampler function is called from the collector thread and should
+/// return false if the session has no stats yet
+class ofxGstRTPStatsCollector{
+public:
+	typedef std::function<bool(int session, ofxGstRTPStats &)> Sampler;
+
+	ofxGstRTPStatsCollector();
+	~ofxGstRTPStatsCollector();
+
+	/// starts the collector thread for sessions [0..numSessions),
+	/// intervalMs is the time between samples
+	void setup(Sampler sampler, int numSessions, int intervalMs=DEFAULT_INTERVAL_MS, int historySize=DEFAULT_HISTORY_SIZE);
+
+	/// stops the thread and clears the history
+	void close();
+
+	/// last sample for a session, timestamp is 0 if there's none
+	ofxGstRTPStats getStats(int session) const;
+
+	/// copies the history of a session into the passed vector, oldest first
+	void getHistory(int session, vector<ofxGstRTPStats> & history) const;
+
+	static const int DEFAULT_INTERVAL_MS = 1000;
+	static const int DEFAULT_HISTORY_SIZE = 120;
+
+private:
+	void threadedFunction();
+
+	struct History{
+		vector<ofxGstRTPStats> samples;
+		size_t next;
+		size_t count;
+	};
+
+	Sampler sampler;
+	int intervalMs;
+	vector<History> histories;
+
+	mutable std::mutex mutex;
+	std::condition_variable condition;
+	std::thread thread;
+	bool running;
+};
+
+#endif /* OFXGSTRTPSTATS_H_ */
@@ -8,19 +8,6 @@
 #include "ofxGstRTPUtils.h"
 
 
-ofColor * colorGradientLUT;
-
-void ofxGstRTPUtils::CreateColorGradientLUT(double maxDepth){
-	colorGradientLUT = new ofColor[(int)maxDepth];
-	ofFloatColor c;
-	for(int i=0;i<maxDepth;i++){
-		double p = i/maxDepth;
-		c.setHsb(p,1-p,1-p);
-		colorGradientLUT[i] = c;
-		swap(colorGradientLUT[i].r,colorGradientLUT[i].g);
-	}
-}
-
 ofxGstRTPUtils::ofxGstRTPUtils() {
 	// TODO Auto-generated constructor stub
 
@@ -30,36 +17,67 @@ ofxGstRTPUtils::~ofxGstRTPUtils() {
 	// TODO Auto-generated destructor stub
 }
 
-void ofxGstRTPUtils::getColoredDepth(double maxDepth, unsigned short depth, ofColor& color) {
-	color = colorGradientLUT[depth];
-
-	/*color.r = (depth >> 8) & 0xFF;
-	color.g = depth & 0xFF;
-	color.b = (depth >> 8) & 0xFF;*/
-}
-
-
-void ofxGstRTPUtils::getRawDepthFromColored(double maxDepth, const ofColor & color, unsigned short & depth){
-	ofFloatColor f = color;
-	swap(f.r,f.g);
-	float h,s,b;
-	f.getHsb(h,s,b);
-	depth = ((h*maxDepth) + ((1-b)*maxDepth) + ((1-s)*maxDepth))/3.;
-
-	//depth = (((int(color.r)<<8) & 0xFF00) + ((int(color.b)<<8) & 0xFF00))*.5 + color.g;
-
-}
-
-void ofxGstRTPUtils::convertShortToColoredDepth(const ofShortPixels& rawDepth, ofPixels& coloredDepth, double maxDepth) {
-	for(int i=0;i<rawDepth.size();i++){
-		double depth = rawDepth[i];
-		getColoredDepth(maxDepth,depth,*((ofColor*)&coloredDepth[i*3]));
+GstVideoFormat ofxGstRTPUtils::getGstVideoFormat(ofPixelFormat format){
+	switch(format){
+	case OF_PIXELS_GRAY:
+		return GST_VIDEO_FORMAT_GRAY8;
+	case OF_PIXELS_RGB:
+		return GST_VIDEO_FORMAT_RGB;
+	case OF_PIXELS_RGBA:
+		return GST_VIDEO_FORMAT_RGBA;
+	case OF_PIXELS_I420:
+		return GST_VIDEO_FORMAT_I420;
+	case OF_PIXELS_NV12:
+		return GST_VIDEO_FORMAT_NV12;
+	case OF_PIXELS_YUY2:
+		return GST_VIDEO_FORMAT_YUY2;
+	default:
+		return GST_VIDEO_FORMAT_UNKNOWN;
 	}
 }
 
-void ofxGstRTPUtils::convertColoredDepthToShort(const ofPixels& coloredDepth, ofShortPixels& rawDepth, double maxDepth) {
-	for(int i=0;i<rawDepth.size();i++){
-		const ofColor & color = *((ofColor*)&coloredDepth[i*3]);
-		getRawDepthFromColored(maxDepth,color,rawDepth[i]);
+int ofxGstRTPUtils::getPlanesLayout(ofPixelFormat format, int width, int height, gsize offsets[GST_VIDEO_MAX_PLANES], gint strides[GST_VIDEO_MAX_PLANES], int rows[GST_VIDEO_MAX_PLANES]){
+	switch(format){
+	case OF_PIXELS_I420:
+		offsets[0] = 0;
+		strides[0] = width;
+		rows[0] = height;
+		offsets[1] = width*height;
+		strides[1] = width/2;
+		rows[1] = height/2;
+		offsets[2] = offsets[1] + strides[1]*rows[1];
+		strides[2] = width/2;
+		rows[2] = height/2;
+		return 3;
+	case OF_PIXELS_NV12:
+		offsets[0] = 0;
+		strides[0] = width;
+		rows[0] = height;
+		offsets[1] = width*height;
+		strides[1] = width;
+		rows[1] = height/2;
+		return 2;
+	case OF_PIXELS_YUY2:
+		offsets[0] = 0;
+		strides[0] = width*2;
+		rows[0] = height;
+		return 1;
+	case OF_PIXELS_RGBA:
+		offsets[0] = 0;
+		strides[0] = width*4;
+		rows[0] = height;
+		return 1;
+	case OF_PIXELS_RGB:
+		offsets[0] = 0;
+		strides[0] = width*3;
+		rows[0] = height;
+		return 1;
+	case OF_PIXELS_GRAY:
+		offsets[0] = 0;
+		strides[0] = width;
+		rows[0] = height;
+		return 1;
+	default:
+		return 0;
 	}
 }
@@ -8,20 +8,22 @@
 #ifndef UTILS_H_
 #define UTILS_H_
 
-#include "ofColor.h"
 #include "ofPixels.h"
+#include <gst/video/video.h>
 
 class ofxGstRTPUtils {
 public:
 	ofxGstRTPUtils();
 	virtual ~ofxGstRTPUtils();
 
-	static void CreateColorGradientLUT(double maxDepth);
+	/// returns the gstreamer equivalent of an ofPixels format or
+	/// GST_VIDEO_FORMAT_UNKNOWN if it's not supported by the addon
+	static GstVideoFormat getGstVideoFormat(ofPixelFormat format);
 
-	static void getColoredDepth(double maxDepth, unsigned short depth, ofColor & color);
-	static void convertShortToColoredDepth(const ofShortPixels & rawDepth, ofPixels & coloredDepth, double maxDepth);
-	static void getRawDepthFromColored(double maxDepth, const ofColor & color, unsigned short & depth);
-	static void convertColoredDepthToShort(const ofPixels & coloredDepth, ofShortPixels & rawDepth, double maxDepth);
+	/// returns the number of planes and the offset, stride and number of rows
+	/// of each plane for pixels of the specified format stored as ofPixels does
+	/// (without padding between rows or planes)
+	static int getPlanesLayout(ofPixelFormat format, int width, int height, gsize offsets[GST_VIDEO_MAX_PLANES], gint strides[GST_VIDEO_MAX_PLANES], int rows[GST_VIDEO_MAX_PLANES]);
 };
 
 #endif /* UTILS_H_ */
@@ -0,0 +1,71 @@
+/*
+ * ofxGstSPSCQueue.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTSPSCQUEUE_H_
+#define OFXGSTSPSCQUEUE_H_
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+
+/// fixed capacity lock free queue for one producer and one consumer thread,
+/// used internally to pass samples from the streaming thread to the main
+/// thread without locking or allocating. The positions only grow and are
+/// masked to index the ring, the producer only writes tail and the consumer
+/// only head so each of them lives in its own cache line
+template<typename T>
+class ofxGstSPSCQueue{
+public:
+	ofxGstSPSCQueue()
+	:mask(0)
+	,head(0)
+	,tail(0){}
+
+	/// capacity is rounded up to a power of 2, shouldn't be called while
+	/// other threads are using the queue and drops anything in it
+	void setup(size_t capacity){
+		size_t size = 1;
+		while(size<capacity) size *= 2;
+		items.assign(size,T());
+		mask = size - 1;
+		head = 0;
+		tail = 0;
+	}
+
+	/// called from the producer, returns false if the queue is full
+	bool push(const T & item){
+		size_t currentTail = tail.load(std::memory_order_relaxed);
+		if(items.empty() || currentTail - head.load(std::memory_order_acquire) > mask){
+			return false;
+		}
+		items[currentTail & mask] = item;
+		tail.store(currentTail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// called from the consumer, returns false if the queue is empty
+	bool pop(T & item){
+		size_t currentHead = head.load(std::memory_order_relaxed);
+		if(currentHead == tail.load(std::memory_order_acquire)){
+			return false;
+		}
+		item = items[currentHead & mask];
+		head.store(currentHead + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t capacity() const{
+		return items.size();
+	}
+
+private:
+	std::vector<T> items;
+	size_t mask;
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+};
+
+#endif /* OFXGSTSPSCQUEUE_H_ */
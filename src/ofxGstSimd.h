@@ -0,0 +1,43 @@
+/*
+ * ofxGstSimd.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTSIMD_H_
+#define OFXGSTSIMD_H_
+
+/// SIMD support used by the per pixel kernels in the addon. The kernels are
+/// compiled for several instruction sets using target attributes so the addon
+/// doesn't need any special compiler flag and the best version is chosen at
+/// runtime depending on the cpu. On compilers or architectures where this is
+/// not available only the scalar versions are used
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	#define OFX_GST_X86_SIMD 1
+	#define OFX_GST_TARGET_SSSE3 __attribute__((target("ssse3")))
+	#define OFX_GST_TARGET_AVX2 __attribute__((target("avx2")))
+	#include <immintrin.h>
+#else
+	#define OFX_GST_X86_SIMD 0
+#endif
+
+enum ofxGstSimdLevel{
+	OFX_GST_SIMD_NONE,
+	OFX_GST_SIMD_SSSE3,
+	OFX_GST_SIMD_AVX2
+};
+
+/// returns the best instruction set available in this cpu
+inline ofxGstSimdLevel ofxGstGetSimdLevel(){
+#if OFX_GST_X86_SIMD
+	static ofxGstSimdLevel level =
+			__builtin_cpu_supports("avx2") ? OFX_GST_SIMD_AVX2 :
+			__builtin_cpu_supports("ssse3") ? OFX_GST_SIMD_SSSE3 :
+			OFX_GST_SIMD_NONE;
+	return level;
+#else
+	return OFX_GST_SIMD_NONE;
+#endif
+}
+
+#endif /* OFXGSTSIMD_H_ */
@@ -0,0 +1,317 @@
+/*
+ * ofxGstVideoConverter.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofxGstVideoConverter.h"
+#include "ofLog.h"
+#include <algorithm>
+
+// BT.601 limited range in 8.8 fixed point. All the versions of the kernels
+// give exactly the same results. The chroma is calculated from the average
+// of each 2x2 block and its offset includes the 128 rounding so all the
+// intermediate values are positive and fit in 16 bits
+static inline unsigned char rgbToY(int r, int g, int b){
+	return ((66*r + 129*g + 25*b + 128) >> 8) + 16;
+}
+
+static inline unsigned char rgbToU(int r, int g, int b){
+	return (112*b - 38*r - 74*g + 32896) >> 8;
+}
+
+static inline unsigned char rgbToV(int r, int g, int b){
+	return (112*r - 94*g - 18*b + 32896) >> 8;
+}
+
+static void convertRowPair(const unsigned char * rgb0, const unsigned char * rgb1,
+		unsigned char * y0, unsigned char * y1,
+		unsigned char * u, unsigned char * v,
+		int x, int width){
+	for(;x<width;x+=2){
+		const unsigned char * p00 = rgb0 + x*3;
+		const unsigned char * p01 = p00 + 3;
+		const unsigned char * p10 = rgb1 + x*3;
+		const unsigned char * p11 = p10 + 3;
+		y0[x] = rgbToY(p00[0],p00[1],p00[2]);
+		y0[x+1] = rgbToY(p01[0],p01[1],p01[2]);
+		y1[x] = rgbToY(p10[0],p10[1],p10[2]);
+		y1[x+1] = rgbToY(p11[0],p11[1],p11[2]);
+		int r = (p00[0] + p01[0] + p10[0] + p11[0] + 2) >> 2;
+		int g = (p00[1] + p01[1] + p10[1] + p11[1] + 2) >> 2;
+		int b = (p00[2] + p01[2] + p10[2] + p11[2] + 2) >> 2;
+		u[x/2] = rgbToU(r,g,b);
+		v[x/2] = rgbToV(r,g,b);
+	}
+}
+
+#if OFX_GST_X86_SIMD
+
+// shuffle masks to separate the R, G and B components of 16 packed RGB
+// pixels loaded in 3 registers: deinterleaveMasks[component][register]
+static const unsigned char deinterleaveMasks[3][3][16] __attribute__((aligned(16))) = {
+	{
+		{0,3,6,9,12,15,128,128,128,128,128,128,128,128,128,128},
+		{128,128,128,128,128,128,2,5,8,11,14,128,128,128,128,128},
+		{128,128,128,128,128,128,128,128,128,128,128,1,4,7,10,13},
+	},{
+		{1,4,7,10,13,128,128,128,128,128,128,128,128,128,128,128},
+		{128,128,128,128,128,0,3,6,9,12,15,128,128,128,128,128},
+		{128,128,128,128,128,128,128,128,128,128,128,2,5,8,11,14},
+	},{
+		{2,5,8,11,14,128,128,128,128,128,128,128,128,128,128,128},
+		{128,128,128,128,128,1,4,7,10,13,128,128,128,128,128,128},
+		{128,128,128,128,128,128,128,128,128,128,0,3,6,9,12,15},
+	}
+};
+
+OFX_GST_TARGET_SSSE3
+static inline __m128i deinterleave(__m128i a, __m128i b, __m128i c, int component){
+	return _mm_or_si128(
+			_mm_or_si128(
+				_mm_shuffle_epi8(a,_mm_load_si128((const __m128i*)deinterleaveMasks[component][0])),
+				_mm_shuffle_epi8(b,_mm_load_si128((const __m128i*)deinterleaveMasks[component][1]))),
+			_mm_shuffle_epi8(c,_mm_load_si128((const __m128i*)deinterleaveMasks[component][2])));
+}
+
+OFX_GST_TARGET_SSSE3
+static inline void loadRGB(const unsigned char * p, __m128i & r, __m128i & g, __m128i & b){
+	__m128i p0 = _mm_loadu_si128((const __m128i*)p);
+	__m128i p1 = _mm_loadu_si128((const __m128i*)(p+16));
+	__m128i p2 = _mm_loadu_si128((const __m128i*)(p+32));
+	r = deinterleave(p0,p1,p2,0);
+	g = deinterleave(p0,p1,p2,1);
+	b = deinterleave(p0,p1,p2,2);
+}
+
+OFX_GST_TARGET_SSSE3
+static inline __m128i lumaHalf(__m128i r, __m128i g, __m128i b){
+	__m128i y = _mm_add_epi16(
+			_mm_add_epi16(_mm_mullo_epi16(r,_mm_set1_epi16(66)),_mm_mullo_epi16(g,_mm_set1_epi16(129))),
+			_mm_add_epi16(_mm_mullo_epi16(b,_mm_set1_epi16(25)),_mm_set1_epi16(128)));
+	return _mm_add_epi16(_mm_srli_epi16(y,8),_mm_set1_epi16(16));
+}
+
+OFX_GST_TARGET_SSSE3
+static inline __m128i luma(__m128i r, __m128i g, __m128i b){
+	__m128i zero = _mm_setzero_si128();
+	__m128i lo = lumaHalf(_mm_unpacklo_epi8(r,zero),_mm_unpacklo_epi8(g,zero),_mm_unpacklo_epi8(b,zero));
+	__m128i hi = lumaHalf(_mm_unpackhi_epi8(r,zero),_mm_unpackhi_epi8(g,zero),_mm_unpackhi_epi8(b,zero));
+	return _mm_packus_epi16(lo,hi);
+}
+
+// average of each 2x2 block as 8 16bit values
+OFX_GST_TARGET_SSSE3
+static inline __m128i average2x2(__m128i row0, __m128i row1){
+	__m128i ones = _mm_set1_epi8(1);
+	__m128i sum = _mm_add_epi16(_mm_maddubs_epi16(row0,ones),_mm_maddubs_epi16(row1,ones));
+	return _mm_srli_epi16(_mm_add_epi16(sum,_mm_set1_epi16(2)),2);
+}
+
+OFX_GST_TARGET_SSSE3
+static inline __m128i chroma(__m128i a, __m128i b, __m128i c, short ca, short cb, short cc){
+	// ca*a - cb*b - cc*c + offset wraps around in 16 bits but the
+	// final result is always in [0, 65535] so it's correct
+	__m128i sum = _mm_sub_epi16(_mm_add_epi16(_mm_mullo_epi16(a,_mm_set1_epi16(ca)),_mm_set1_epi16((short)32896)),
+			_mm_add_epi16(_mm_mullo_epi16(b,_mm_set1_epi16(cb)),_mm_mullo_epi16(c,_mm_set1_epi16(cc))));
+	return _mm_srli_epi16(sum,8);
+}
+
+OFX_GST_TARGET_SSSE3
+static void convertRowPairSSSE3(const unsigned char * rgb0, const unsigned char * rgb1,
+		unsigned char * y0, unsigned char * y1,
+		unsigned char * u, unsigned char * v,
+		int width){
+	int x = 0;
+	for(;x+16<=width;x+=16){
+		__m128i r0,g0,b0,r1,g1,b1;
+		loadRGB(rgb0+x*3,r0,g0,b0);
+		loadRGB(rgb1+x*3,r1,g1,b1);
+		_mm_storeu_si128((__m128i*)(y0+x),luma(r0,g0,b0));
+		_mm_storeu_si128((__m128i*)(y1+x),luma(r1,g1,b1));
+
+		__m128i r = average2x2(r0,r1);
+		__m128i g = average2x2(g0,g1);
+		__m128i b = average2x2(b0,b1);
+		__m128i zero = _mm_setzero_si128();
+		_mm_storel_epi64((__m128i*)(u+x/2),_mm_packus_epi16(chroma(b,r,g,112,38,74),zero));
+		_mm_storel_epi64((__m128i*)(v+x/2),_mm_packus_epi16(chroma(r,g,b,112,94,18),zero));
+	}
+	convertRowPair(rgb0,rgb1,y0,y1,u,v,x,width);
+}
+
+OFX_GST_TARGET_AVX2
+static inline __m256i loadLanes(const unsigned char * lo, const unsigned char * hi){
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)lo)),_mm_loadu_si128((const __m128i*)hi),1);
+}
+
+OFX_GST_TARGET_AVX2
+static inline __m256i deinterleave(__m256i a, __m256i b, __m256i c, int component){
+	return _mm256_or_si256(
+			_mm256_or_si256(
+				_mm256_shuffle_epi8(a,_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)deinterleaveMasks[component][0]))),
+				_mm256_shuffle_epi8(b,_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)deinterleaveMasks[component][1])))),
+			_mm256_shuffle_epi8(c,_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)deinterleaveMasks[component][2]))));
+}
+
+// loads 32 pixels, the first 16 in the low lane and the next 16 in the high
+// lane so the in lane shuffles work as in the SSSE3 version
+OFX_GST_TARGET_AVX2
+static inline void loadRGB(const unsigned char * p, __m256i & r, __m256i & g, __m256i & b){
+	__m256i p0 = loadLanes(p,p+48);
+	__m256i p1 = loadLanes(p+16,p+64);
+	__m256i p2 = loadLanes(p+32,p+80);
+	r = deinterleave(p0,p1,p2,0);
+	g = deinterleave(p0,p1,p2,1);
+	b = deinterleave(p0,p1,p2,2);
+}
+
+OFX_GST_TARGET_AVX2
+static inline __m256i lumaHalf(__m256i r, __m256i g, __m256i b){
+	__m256i y = _mm256_add_epi16(
+			_mm256_add_epi16(_mm256_mullo_epi16(r,_mm256_set1_epi16(66)),_mm256_mullo_epi16(g,_mm256_set1_epi16(129))),
+			_mm256_add_epi16(_mm256_mullo_epi16(b,_mm256_set1_epi16(25)),_mm256_set1_epi16(128)));
+	return _mm256_add_epi16(_mm256_srli_epi16(y,8),_mm256_set1_epi16(16));
+}
+
+// unpack and pack work per lane so the pixels end in the original order
+OFX_GST_TARGET_AVX2
+static inline __m256i luma(__m256i r, __m256i g, __m256i b){
+	__m256i zero = _mm256_setzero_si256();
+	__m256i lo = lumaHalf(_mm256_unpacklo_epi8(r,zero),_mm256_unpacklo_epi8(g,zero),_mm256_unpacklo_epi8(b,zero));
+	__m256i hi = lumaHalf(_mm256_unpackhi_epi8(r,zero),_mm256_unpackhi_epi8(g,zero),_mm256_unpackhi_epi8(b,zero));
+	return _mm256_packus_epi16(lo,hi);
+}
+
+OFX_GST_TARGET_AVX2
+static inline __m256i average2x2(__m256i row0, __m256i row1){
+	__m256i ones = _mm256_set1_epi8(1);
+	__m256i sum = _mm256_add_epi16(_mm256_maddubs_epi16(row0,ones),_mm256_maddubs_epi16(row1,ones));
+	return _mm256_srli_epi16(_mm256_add_epi16(sum,_mm256_set1_epi16(2)),2);
+}
+
+OFX_GST_TARGET_AVX2
+static inline __m128i chroma(__m256i a, __m256i b, __m256i c, short ca, short cb, short cc){
+	__m256i sum = _mm256_sub_epi16(_mm256_add_epi16(_mm256_mullo_epi16(a,_mm256_set1_epi16(ca)),_mm256_set1_epi16((short)32896)),
+			_mm256_add_epi16(_mm256_mullo_epi16(b,_mm256_set1_epi16(cb)),_mm256_mullo_epi16(c,_mm256_set1_epi16(cc))));
+	// pack in each lane and move the 8 valid bytes of the high lane
+	// next to the ones in the low lane
+	__m256i packed = _mm256_packus_epi16(_mm256_srli_epi16(sum,8),_mm256_setzero_si256());
+	return _mm256_castsi256_si128(_mm256_permute4x64_epi64(packed,0x08));
+}
+
+OFX_GST_TARGET_AVX2
+static void convertRowPairAVX2(const unsigned char * rgb0, const unsigned char * rgb1,
+		unsigned char * y0, unsigned char * y1,
+		unsigned char * u, unsigned char * v,
+		int width){
+	int x = 0;
+	for(;x+32<=width;x+=32){
+		__m256i r0,g0,b0,r1,g1,b1;
+		loadRGB(rgb0+x*3,r0,g0,b0);
+		loadRGB(rgb1+x*3,r1,g1,b1);
+		_mm256_storeu_si256((__m256i*)(y0+x),luma(r0,g0,b0));
+		_mm256_storeu_si256((__m256i*)(y1+x),luma(r1,g1,b1));
+
+		__m256i r = average2x2(r0,r1);
+		__m256i g = average2x2(g0,g1);
+		__m256i b = average2x2(b0,b1);
+		_mm_storeu_si128((__m128i*)(u+x/2),chroma(b,r,g,112,38,74));
+		_mm_storeu_si128((__m128i*)(v+x/2),chroma(r,g,b,112,94,18));
+	}
+	convertRowPair(rgb0,rgb1,y0,y1,u,v,x,width);
+}
+
+#endif
+
+ofxGstVideoConverter::ofxGstVideoConverter()
+:simdLevel(ofxGstGetSimdLevel())
+,width(0)
+,height(0){
+
+}
+
+void ofxGstVideoConverter::setup(int width, int height, int numThreads){
+	this->width = width;
+	this->height = height;
+	// with one thread there's no need to start any
+	workers.close();
+	if(numThreads!=1){
+		workers.setup(numThreads<=0 ? 0 : numThreads-1);
+	}
+}
+
+void ofxGstVideoConverter::close(){
+	workers.close();
+}
+
+bool ofxGstVideoConverter::isSupported(int width, int height){
+	return width>0 && height>0 && width%2==0 && height%2==0;
+}
+
+void ofxGstVideoConverter::setSimdLevel(ofxGstSimdLevel level){
+	simdLevel = std::min(level,ofxGstGetSimdLevel());
+}
+
+ofxGstSimdLevel ofxGstVideoConverter::getSimdLevel() const{
+	return simdLevel;
+}
+
+int ofxGstVideoConverter::getNumThreads() const{
+	return workers.getNumThreads();
+}
+
+void ofxGstVideoConverter::convertRows(const unsigned char * rgb, int rgbStride,
+		unsigned char * y, int yStride,
+		unsigned char * u, int uStride,
+		unsigned char * v, int vStride,
+		int width, int rowPairBegin, int rowPairEnd,
+		ofxGstSimdLevel level){
+	for(int i=rowPairBegin;i<rowPairEnd;i++){
+		const unsigned char * rgb0 = rgb + i*2*rgbStride;
+		const unsigned char * rgb1 = rgb0 + rgbStride;
+		unsigned char * y0 = y + i*2*yStride;
+		unsigned char * y1 = y0 + yStride;
+		unsigned char * uRow = u + i*uStride;
+		unsigned char * vRow = v + i*vStride;
+		switch(level){
+#if OFX_GST_X86_SIMD
+		case OFX_GST_SIMD_AVX2:
+			convertRowPairAVX2(rgb0,rgb1,y0,y1,uRow,vRow,width);
+			break;
+		case OFX_GST_SIMD_SSSE3:
+			convertRowPairSSSE3(rgb0,rgb1,y0,y1,uRow,vRow,width);
+			break;
+#endif
+		default:
+			convertRowPair(rgb0,rgb1,y0,y1,uRow,vRow,0,width);
+			break;
+		}
+	}
+}
+
+void ofxGstVideoConverter::convert(const unsigned char * rgb, int rgbStride,
+		unsigned char * y, int yStride,
+		unsigned char * u, int uStride,
+		unsigned char * v, int vStride){
+	ofxGstSimdLevel level = simdLevel;
+	int width = this->width;
+	workers.parallelFor(0,height/2,[&](int begin, int end){
+		convertRows(rgb,rgbStride,y,yStride,u,uStride,v,vStride,width,begin,end,level);
+	});
+}
+
+void ofxGstVideoConverter::convert(const ofPixels & rgb, ofPixels & i420){
+	if(rgb.getWidth()!=width || rgb.getHeight()!=height || rgb.getNumChannels()!=3){
+		ofLogError("ofxGstVideoConverter") << "wrong input format, expecting RGB " << width << "x" << height;
+		return;
+	}
+	if(i420.getWidth()!=width || i420.getHeight()!=height || i420.getPixelFormat()!=OF_PIXELS_I420){
+		ofLogError("ofxGstVideoConverter") << "wrong output format, expecting I420 " << width << "x" << height;
+		return;
+	}
+	unsigned char * y = i420.getPixels();
+	unsigned char * u = y + width*height;
+	unsigned char * v = u + (width/2)*(height/2);
+	convert(rgb.getPixels(),width*3,y,width,u,width/2,v,width/2);
+}
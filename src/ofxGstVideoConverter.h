@@ -0,0 +1,63 @@
+/*
+ * ofxGstVideoConverter.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTVIDEOCONVERTER_H_
+#define OFXGSTVIDEOCONVERTER_H_
+
+#include "ofPixels.h"
+#include "ofxGstSimd.h"
+#include "ofxGstWorkerPool.h"
+
+/// RGB to I420 converter used by the server to feed the encoder without
+/// going through videoconvert. The conversion uses BT.601 limited range, the
+/// same gstreamer uses for I420 caps with colorimetry=bt601, runs with SIMD
+/// when the cpu supports it and splits the rows of each frame among several
+/// threads. Only frames with even width and height are supported
+class ofxGstVideoConverter{
+public:
+	ofxGstVideoConverter();
+
+	/// numThreads is the number of threads used for each frame including the
+	/// calling thread, 0 chooses it from the number of cores
+	void setup(int width, int height, int numThreads=0);
+	void close();
+
+	/// converts RGB pixels into I420 pixels, both need to be allocated with
+	/// the size passed to setup
+	void convert(const ofPixels & rgb, ofPixels & i420);
+
+	/// converts an RGB image with an arbitrary stride into I420 planes
+	void convert(const unsigned char * rgb, int rgbStride,
+			unsigned char * y, int yStride,
+			unsigned char * u, int uStride,
+			unsigned char * v, int vStride);
+
+	/// forces a specific instruction set, by default the best one available
+	/// is used. Mostly useful for benchmarking
+	void setSimdLevel(ofxGstSimdLevel level);
+	ofxGstSimdLevel getSimdLevel() const;
+
+	int getNumThreads() const;
+
+	/// returns true if frames of this size can be converted
+	static bool isSupported(int width, int height);
+
+	/// converts the row pairs [rowPairBegin, rowPairEnd) of a frame
+	/// in the calling thread
+	static void convertRows(const unsigned char * rgb, int rgbStride,
+			unsigned char * y, int yStride,
+			unsigned char * u, int uStride,
+			unsigned char * v, int vStride,
+			int width, int rowPairBegin, int rowPairEnd,
+			ofxGstSimdLevel level);
+
+private:
+	ofxGstWorkerPool workers;
+	ofxGstSimdLevel simdLevel;
+	int width, height;
+};
+
+#endif /* OFXGSTVIDEOCONVERTER_H_ */
@@ -10,11 +10,11 @@
 
 #include "ofPixels.h"
 #include "ofTypes.h"
-#include "ofxDepthCompressedFrame.h"
 
 #include <gst/gstsample.h>
 
-/// class used internally to keep a double buffer for video and depth frames
+/// class used internally to keep a double buffer for video and depth frames,
+/// compressed 16bits depth uses ofxGstDepth16DoubleBuffer
 template<typename PixelType>
 class ofxGstVideoDoubleBuffer {
 public:
@@ -22,7 +22,6 @@ public:
 	virtual ~ofxGstVideoDoubleBuffer();
 
 	void setup(int width, int height, int numChannels);
-	void setupFor16();
 	bool isAllocated();
 
 	bool isFrameNew();
@@ -30,9 +29,6 @@ public:
 	void update();
 	ofPixels_<PixelType> & getPixels();
 
-	float getZeroPlanePixelSize();
-	float getZeroPlaneDistance();
-
 private:
 	GstSample * frontSample, * backSample;
 	ofPixels_<PixelType> pixels;
@@ -40,11 +36,6 @@ private:
 	GstMapInfo mapinfo;
 	bool bIsNewFrame;
 	bool allocated;
-	bool depth16;
-	ofxDepthCompressedFrame lastKeyFrame;
-	ofxDepthCompressedFrame lastFrame;
-	float pixelSize;
-	float distance;
 };
 
 
@@ -57,9 +48,6 @@ ofxGstVideoDoubleBuffer<PixelType>::ofxGstVideoDoubleBuffer()
 ,mapinfo()
 ,bIsNewFrame(false)
 ,allocated(false)
-,depth16(false)
-,pixelSize(1)
-,distance(1)
 {
 	GstMapInfo mapinfo = {0,};
 	this->mapinfo=mapinfo;
@@ -78,12 +66,6 @@ void ofxGstVideoDoubleBuffer<PixelType>::setup(int width, int height, int numCha
 	allocated = true;
 }
 
-template<typename PixelType>
-void ofxGstVideoDoubleBuffer<PixelType>::setupFor16(){
-	allocated = true;
-	depth16 = true;
-}
-
 template<typename PixelType>
 bool ofxGstVideoDoubleBuffer<PixelType>::isAllocated(){
 	return allocated;
@@ -114,28 +96,7 @@ void ofxGstVideoDoubleBuffer<PixelType>::update(){
 		mutex.unlock();
 		GstBuffer * _buffer = gst_sample_get_buffer(frontSample);
 		gst_buffer_map (_buffer, &mapinfo, GST_MAP_READ);
-		if(!depth16){
-			pixels.setFromExternalPixels((PixelType*)mapinfo.data,pixels.getWidth(),pixels.getHeight(),pixels.getNumChannels());
-		}else{
-			lastFrame.fromCompressedData((char*)mapinfo.data,mapinfo.size);
-			if(lastFrame.isKeyFrame()){
-				lastKeyFrame = lastFrame;
-				if(!pixels.isAllocated()){
-					pixels.allocate(lastKeyFrame.getPixels().getWidth(),lastKeyFrame.getPixels().getHeight(),1);
-				}
-				pixelSize = lastKeyFrame.getPixelSize();
-				distance = lastKeyFrame.getDistance();
-				memcpy(pixels.getPixels(),((unsigned short*)lastKeyFrame.getPixels().getPixels()), pixels.size()*sizeof(short));
-			}else{
-				if(pixels.isAllocated()){
-					pixelSize = lastFrame.getPixelSize();
-					distance = lastFrame.getDistance();
-					for(int i=0;i<pixels.size();i++){
-						pixels[i] = lastKeyFrame.getPixels()[i] + lastFrame.getPixels()[i];
-					}
-				}
-			}
-		}
+		pixels.setFromExternalPixels((PixelType*)mapinfo.data,pixels.getWidth(),pixels.getHeight(),pixels.getNumChannels());
 		gst_buffer_unmap(_buffer,&mapinfo);
 	}else{
 		bIsNewFrame = false;
@@ -144,16 +105,6 @@ void ofxGstVideoDoubleBuffer<PixelType>::update(){
 }
 
 
-template<typename PixelType>
-float ofxGstVideoDoubleBuffer<PixelType>::getZeroPlanePixelSize(){
-	return pixelSize;
-}
-
-template<typename PixelType>
-float ofxGstVideoDoubleBuffer<PixelType>::getZeroPlaneDistance(){
-	return distance;
-}
-
 template<typename PixelType>
 ofPixels_<PixelType> & ofxGstVideoDoubleBuffer<PixelType>::getPixels(){
 	return pixels;
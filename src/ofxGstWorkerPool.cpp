@@ -0,0 +1,114 @@
+/*
+ * ofxGstWorkerPool.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "ofxGstWorkerPool.h"
+#include <algorithm>
+
+ofxGstWorkerPool::ofxGstWorkerPool()
+:job(NULL)
+,jobBegin(0)
+,jobEnd(0)
+,generation(0)
+,pending(0)
+,running(false){
+
+}
+
+ofxGstWorkerPool::~ofxGstWorkerPool(){
+	close();
+}
+
+void ofxGstWorkerPool::setup(int numThreads){
+	close();
+	if(numThreads<=0){
+		// the caller works too so leave one core for it
+		numThreads = std::max(1,int(std::thread::hardware_concurrency())-1);
+	}
+	running = true;
+	for(int i=0;i<numThreads;i++){
+		threads.push_back(std::thread(&ofxGstWorkerPool::threadedFunction,this,i));
+	}
+}
+
+void ofxGstWorkerPool::close(){
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if(!running) return;
+		running = false;
+	}
+	workCondition.notify_all();
+	for(size_t i=0;i<threads.size();i++){
+		threads[i].join();
+	}
+	threads.clear();
+}
+
+int ofxGstWorkerPool::getNumThreads() const{
+	return threads.size()+1;
+}
+
+static void getRange(int begin, int end, int index, int numRanges, int & rangeBegin, int & rangeEnd){
+	int size = end - begin;
+	rangeBegin = begin + size * index / numRanges;
+	rangeEnd = begin + size * (index + 1) / numRanges;
+}
+
+void ofxGstWorkerPool::parallelFor(int begin, int end, const std::function<void(int,int)> & job){
+	if(end<=begin) return;
+	if(threads.empty() || end-begin==1){
+		job(begin,end);
+		return;
+	}
+
+	std::unique_lock<std::mutex> callLock(callMutex);
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		this->job = &job;
+		jobBegin = begin;
+		jobEnd = end;
+		pending = threads.size();
+		generation++;
+	}
+	workCondition.notify_all();
+
+	// the calling thread does the last range
+	int rangeBegin, rangeEnd;
+	getRange(begin,end,getNumThreads()-1,getNumThreads(),rangeBegin,rangeEnd);
+	if(rangeEnd>rangeBegin){
+		job(rangeBegin,rangeEnd);
+	}
+
+	std::unique_lock<std::mutex> lock(mutex);
+	while(pending>0){
+		doneCondition.wait(lock);
+	}
+	this->job = NULL;
+}
+
+void ofxGstWorkerPool::threadedFunction(int threadIndex){
+	unsigned long long lastGeneration = 0;
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true){
+		while(running && generation==lastGeneration){
+			workCondition.wait(lock);
+		}
+		if(!running) return;
+		lastGeneration = generation;
+
+		int rangeBegin, rangeEnd;
+		getRange(jobBegin,jobEnd,threadIndex,getNumThreads(),rangeBegin,rangeEnd);
+		const std::function<void(int,int)> & currentJob = *job;
+		lock.unlock();
+		if(rangeEnd>rangeBegin){
+			currentJob(rangeBegin,rangeEnd);
+		}
+		lock.lock();
+		pending--;
+		if(pending==0){
+			doneCondition.notify_one();
+		}
+	}
+}
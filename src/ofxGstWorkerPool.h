@@ -0,0 +1,56 @@
+/*
+ * ofxGstWorkerPool.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef OFXGSTWORKERPOOL_H_
+#define OFXGSTWORKERPOOL_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+
+/// small pool of threads used internally by the addon to split per frame
+/// work like color conversion or compression in several cores. The threads
+/// are created once in setup and sleep while there's no work to do
+class ofxGstWorkerPool{
+public:
+	ofxGstWorkerPool();
+	~ofxGstWorkerPool();
+
+	/// starts numThreads threads, if numThreads is 0 the number of
+	/// threads is chosen from the number of cores in the machine
+	void setup(int numThreads=0);
+
+	/// stops all the threads, waits for them to finish
+	void close();
+
+	/// splits [begin, end) in as many ranges as threads + 1 and calls
+	/// job(rangeBegin, rangeEnd) for each of them in parallel, the calling
+	/// thread runs one of the ranges too. Returns once all the ranges are done.
+	/// Several threads can call parallelFor at the same time but the calls
+	/// will be run one after another
+	void parallelFor(int begin, int end, const std::function<void(int,int)> & job);
+
+	/// number of threads working on each parallelFor including the caller
+	int getNumThreads() const;
+
+private:
+	void threadedFunction(int threadIndex);
+
+	std::vector<std::thread> threads;
+	std::mutex callMutex;
+	std::mutex mutex;
+	std::condition_variable workCondition;
+	std::condition_variable doneCondition;
+	const std::function<void(int,int)> * job;
+	int jobBegin, jobEnd;
+	unsigned long long generation;
+	int pending;
+	bool running;
+};
+
+#endif /* OFXGSTWORKERPOOL_H_ */
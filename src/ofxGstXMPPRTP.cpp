@@ -21,6 +21,17 @@ static gboolean nicesink_plugin_init(GstPlugin * plugin){
 }
 #endif
 
+// reads the codec from the payload of a jingle content, leaves codec
+// untouched if there's no payload or it's not a supported video encoding
+static bool getPayloadCodec(const ofxXMPPJingleContent & content, ofxGstRTPVideoCodec & codec){
+	if(content.payloads.empty()) return false;
+	if(!ofxGstRTPCodecs::getVideoCodec(content.payloads[0].name,codec)){
+		ofLogError() << "unsupported " << content.media << " encoding " << content.payloads[0].name;
+		return false;
+	}
+	return true;
+}
+
 ofxGstXMPPRTP::ofxGstXMPPRTP()
 :nice(new ofxNiceAgent)
 ,server(new ofxGstRTPServer)
@@ -31,6 +42,8 @@ ofxGstXMPPRTP::ofxGstXMPPRTP()
 ,audioGathered(false)
 ,oscGathered(false)
 ,depth16(false)
+,videoCodec(OFX_GST_RTP_X264)
+,depthCodec(OFX_GST_RTP_X264)
 ,initialized(false)
 {
 #ifndef TARGET_LINUX
@@ -137,22 +150,32 @@ void ofxGstXMPPRTP::acceptCall(){
 	for(size_t i=0;i<remoteJingle.contents.size();i++){
 		if(remoteJingle.contents[i].media=="video"){
 			ofLogNotice() << "adding video channel to client";
+			// receive with the codec offered by the remote side, if we are also
+			// sending video the answer will contain the encoding we send
+			ofxGstRTPVideoCodec remoteCodec = OFX_GST_RTP_X264;
+			getPayloadCodec(remoteJingle.contents[i],remoteCodec);
 			if(!videoStream){
 				videoStream = shared_ptr<ofxNiceStream>(new ofxNiceStream());
 				videoStream->setLogName("video");
+			}else if(ofxGstRTPCodecs::getEncodingName(remoteCodec)!=ofxGstRTPCodecs::getEncodingName(videoCodec)){
+				ofLogError() << "remote video encoding " << ofxGstRTPCodecs::getEncodingName(remoteCodec) << " is different than the local one";
 			}
 			videoStream->setup(*nice,3);
 			nice->addStream(videoStream);
-			client->addVideoChannel(videoStream);
+			client->addVideoChannel(videoStream,remoteCodec);
 		}else if(remoteJingle.contents[i].media=="depth"){
 			ofLogNotice() << "adding depth channel to client";
+			ofxGstRTPVideoCodec remoteCodec = OFX_GST_RTP_X264;
+			getPayloadCodec(remoteJingle.contents[i],remoteCodec);
 			if(!depthStream){
 				depthStream = shared_ptr<ofxNiceStream>(new ofxNiceStream());
 				depthStream->setLogName("depth");
+			}else if(ofxGstRTPCodecs::getEncodingName(remoteCodec)!=ofxGstRTPCodecs::getEncodingName(depthCodec)){
+				ofLogError() << "remote depth encoding " << ofxGstRTPCodecs::getEncodingName(remoteCodec) << " is different than the local one";
 			}
 			depthStream->setup(*nice,3);
 			nice->addStream(depthStream);
-			client->addDepthChannel(depthStream,false);
+			client->addDepthChannel(depthStream,false,remoteCodec);
 		}else if(remoteJingle.contents[i].media=="depth16"){
 			ofLogNotice() << "adding depth16 channel to client";
 			if(!depthStream){
@@ -229,25 +252,25 @@ void ofxGstXMPPRTP::onNiceLocalCandidatesGathered( const void * sender, vector<o
 	content.name = "telekinect";
 	content.payloads.resize(1);
 	if(content.media=="video"){
-		content.payloads[0].clockrate=90000;
-		content.payloads[0].id=96;
-		content.payloads[0].name="H264";
+		content.payloads[0].clockrate=ofxGstRTPCodecs::VIDEO_CLOCK_RATE;
+		content.payloads[0].id=ofxGstRTPCodecs::VIDEO_PAYLOAD_TYPE;
+		content.payloads[0].name=ofxGstRTPCodecs::getEncodingName(videoCodec);
 	}else if(content.media=="audio"){
-		content.payloads[0].clockrate=48000;
-		content.payloads[0].id=97;
-		content.payloads[0].name="X-GST-OPUS-DRAFT-SPITTKA-00";
+		content.payloads[0].clockrate=ofxGstRTPCodecs::AUDIO_CLOCK_RATE;
+		content.payloads[0].id=ofxGstRTPCodecs::AUDIO_PAYLOAD_TYPE;
+		content.payloads[0].name=ofxGstRTPCodecs::AUDIO_ENCODING_NAME;
 	}else if(content.media=="depth"){
-			content.payloads[0].clockrate=90000;
-			content.payloads[0].id=98;
-			content.payloads[0].name="H264";
+		content.payloads[0].clockrate=ofxGstRTPCodecs::VIDEO_CLOCK_RATE;
+		content.payloads[0].id=ofxGstRTPCodecs::DEPTH_PAYLOAD_TYPE;
+		content.payloads[0].name=ofxGstRTPCodecs::getEncodingName(depthCodec);
 	}else if(content.media=="depth16"){
-		content.payloads[0].clockrate=90000;
-		content.payloads[0].id=98;
-		content.payloads[0].name="X-GST";
+		content.payloads[0].clockrate=ofxGstRTPCodecs::APPLICATION_CLOCK_RATE;
+		content.payloads[0].id=ofxGstRTPCodecs::DEPTH_PAYLOAD_TYPE;
+		content.payloads[0].name=ofxGstRTPCodecs::APPLICATION_ENCODING_NAME;
 	}else if(content.media=="osc"){
-		content.payloads[0].clockrate=90000;
-		content.payloads[0].id=99;
-		content.payloads[0].name="X-GST";
+		content.payloads[0].clockrate=ofxGstRTPCodecs::APPLICATION_CLOCK_RATE;
+		content.payloads[0].id=ofxGstRTPCodecs::OSC_PAYLOAD_TYPE;
+		content.payloads[0].name=ofxGstRTPCodecs::APPLICATION_ENCODING_NAME;
 	}
 	content.transport.pwd= stream->getLocalPwd();
 	content.transport.ufrag = stream->getLocalUFrag();
@@ -274,6 +297,28 @@ void ofxGstXMPPRTP::onJingleInitiationAccepted(ofxXMPPJingleInitiation & jingle)
 	cout << "session accepted setting remote candidates" << endl;
 	remoteJingle = jingle;
 
+	// the client is created once the remote side accepts so its depayloaders
+	// and decoders use the encodings in the answer, peers that don't send
+	// the payloads are assumed to use the same encodings we offered
+	for(size_t i=0;i<jingle.contents.size();i++){
+		if(jingle.contents[i].media=="video" && videoStream){
+			ofxGstRTPVideoCodec remoteCodec = videoCodec;
+			getPayloadCodec(jingle.contents[i],remoteCodec);
+			client->addVideoChannel(videoStream,remoteCodec);
+		}else if(jingle.contents[i].media=="depth" && depthStream){
+			ofxGstRTPVideoCodec remoteCodec = depthCodec;
+			getPayloadCodec(jingle.contents[i],remoteCodec);
+			client->addDepthChannel(depthStream,false,remoteCodec);
+		}else if(jingle.contents[i].media=="depth16" && depthStream){
+			client->addDepthChannel(depthStream,true);
+		}else if(jingle.contents[i].media=="audio" && audioStream){
+			client->addAudioChannel(audioStream);
+		}else if(jingle.contents[i].media=="osc" && oscStream){
+			client->addOscChannel(oscStream);
+		}
+	}
+	client->play();
+
 	for(size_t i=0;i<jingle.contents.size();i++){
 		if(jingle.contents[i].media=="video" && videoStream){
 			videoStream->setRemoteCredentials(jingle.contents[i].transport.ufrag,jingle.contents[i].transport.pwd);
@@ -319,15 +364,19 @@ void ofxGstXMPPRTP::sendXMPPMessage(const string & to, const string & message){
 	xmpp->sendMessage(to,message);
 }
 
-void ofxGstXMPPRTP::addSendVideoChannel(int w, int h, int fps){
+void ofxGstXMPPRTP::addSendVideoChannel(int w, int h, int fps, ofxGstRTPVideoCodec codec){
 	videoStream = shared_ptr<ofxNiceStream>(new ofxNiceStream);
 	videoStream->setLogName("video");
+	server->setVideoCodec(codec);
 	server->addVideoChannel(videoStream,w,h,fps);
+	// the server can fallback to other codec if this one is not available
+	videoCodec = server->getVideoCodec();
 	ofAddListener(videoStream->localCandidatesGathered,this,&ofxGstXMPPRTP::onNiceLocalCandidatesGathered);
 }
 
-void ofxGstXMPPRTP::addSendDepthChannel(int w, int h, int fps, bool depth16){
+void ofxGstXMPPRTP::addSendDepthChannel(int w, int h, int fps, bool depth16, ofxGstRTPVideoCodec codec){
 	this->depth16 = depth16;
+	server->setDepthCodec(codec);
 	depthStream = shared_ptr<ofxNiceStream>(new ofxNiceStream);
 	if(depth16){
 		depthStream->setLogName("depth16");
@@ -335,6 +384,7 @@ void ofxGstXMPPRTP::addSendDepthChannel(int w, int h, int fps, bool depth16){
 		depthStream->setLogName("depth");
 	}
 	server->addDepthChannel(depthStream,w,h,fps,depth16);
+	depthCodec = server->getDepthCodec();
 	ofAddListener(depthStream->localCandidatesGathered,this,&ofxGstXMPPRTP::onNiceLocalCandidatesGathered);
 }
 
@@ -367,26 +417,22 @@ void ofxGstXMPPRTP::call(const ofxXMPPUser & user){
 	if(videoStream){
 		videoStream->setup(*nice,3);
 		nice->addStream(videoStream);
-		client->addVideoChannel(videoStream);
 	}
 	if(audioStream){
 		audioStream->setup(*nice,3);
 		nice->addStream(audioStream);
-		client->addAudioChannel(audioStream);
 	}
 	if(depthStream){
 		depthStream->setup(*nice,3);
 		nice->addStream(depthStream);
-		client->addDepthChannel(depthStream,depth16);
 	}
 	if(oscStream){
 		oscStream->setup(*nice,3);
 		nice->addStream(oscStream);
-		client->addOscChannel(oscStream);
 	}
 
+	// the client channels are added when the call is accepted
 	server->play();
-	client->play();
 
 	if(videoStream) videoStream->gatherLocalCandidates();
 	if(depthStream) depthStream->gatherLocalCandidates();
@@ -420,6 +466,8 @@ void ofxGstXMPPRTP::close(){
 	audioGathered = false;
 	oscGathered = false;
 	depth16 = false;
+	videoCodec = OFX_GST_RTP_X264;
+	depthCodec = OFX_GST_RTP_X264;
 }
 
 #endif
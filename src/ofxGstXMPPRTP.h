@@ -73,12 +73,14 @@ public:
 	void sendXMPPMessage(const string & to, const string & message);
 
 	/// before starting a call the initiating side shoulc add the desired
-	/// channels, this method adds a video channel
-	void addSendVideoChannel(int w, int h, int fps);
+	/// channels, this method adds a video channel. The codec is sent
+	/// to the other side in the session initiation
+	void addSendVideoChannel(int w, int h, int fps, ofxGstRTPVideoCodec codec=OFX_GST_RTP_X264);
 
 	/// before starting a call the initiating side shoulc add the desired
-	/// channels, this method adds a depth channel
-	void addSendDepthChannel(int w, int h, int fps, bool depth16=false);
+	/// channels, this method adds a depth channel. The codec is only used
+	/// for 8bits depth
+	void addSendDepthChannel(int w, int h, int fps, bool depth16=false, ofxGstRTPVideoCodec codec=OFX_GST_RTP_X264);
 
 	/// before starting a call the initiating side shoulc add the desired
 	/// channels, this method adds an audio channel
@@ -154,6 +156,9 @@ private:
 
 	bool videoGathered, depthGathered, audioGathered, oscGathered;
 	bool depth16;
+	// encodings sent by the local server, the remote ones are passed to
+	// the client when accepting a call or when the remote side accepts ours
+	ofxGstRTPVideoCodec videoCodec, depthCodec;
 	bool initialized;
 	string stunServer;
 	uint stunPort;
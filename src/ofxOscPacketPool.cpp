@@ -6,40 +6,99 @@
  */
 
 #include "ofxOscPacketPool.h"
+#include "ofLog.h"
+#include <algorithm>
 
-ofxOscPacketPool::ofxOscPacketPool() {
-	// TODO Auto-generated constructor stub
+const size_t ofxOscPacketPool::SIZE_CLASSES[NUM_SIZE_CLASSES] = {256, 2048, 65536};
 
+// memory used by each packet of a class, the buffer and the encoded data
+static size_t packetBytes(size_t capacity){
+	return capacity + ofxGstOscEncoder::getMaxEncodedSize(capacity) + sizeof(PooledOscPacket);
+}
+
+ofxOscPacketPool::ofxOscPacketPool() {
+	setup();
 }
 
 ofxOscPacketPool::~ofxOscPacketPool() {
-	// TODO Auto-generated destructor stub
+	clear();
 }
 
+void ofxOscPacketPool::clear(){
+	for(int i=0;i<NUM_SIZE_CLASSES;i++){
+		for(size_t j=0;j<classes[i].slots.size();j++){
+			delete classes[i].slots[j];
+		}
+		classes[i].slots.clear();
+	}
+}
 
-PooledOscPacket * ofxOscPacketPool::newBuffer(){
-	mutex.lock();
-	if(pool.empty()){
-		mutex.unlock();
-		static const int capacity = 65535;
-		char * buffer = new char[capacity];
-		PooledOscPacket * pkg = new PooledOscPacket(buffer,capacity,this);
-		return pkg;
-	}else{
-		PooledOscPacket * pkg = pool.front();
-		pool.erase(pool.begin());
-		mutex.unlock();
-		return pkg;
+void ofxOscPacketPool::setup(size_t maxRetainedBytes){
+	clear();
+	for(int i=0;i<NUM_SIZE_CLASSES;i++){
+		SizeClass & sizeClass = classes[i];
+		int capacity = std::max<size_t>(1, maxRetainedBytes / NUM_SIZE_CLASSES / packetBytes(SIZE_CLASSES[i]));
+		sizeClass.slots.assign(capacity,NULL);
+		sizeClass.freeList.setup(capacity);
+		sizeClass.hits = 0;
+		sizeClass.misses = 0;
+		sizeClass.inFlight = 0;
+		sizeClass.retained = 0;
 	}
 }
 
+PooledOscPacket * ofxOscPacketPool::newBuffer(size_t size){
+	int classIndex = 0;
+	while(classIndex<NUM_SIZE_CLASSES && SIZE_CLASSES[classIndex]<size){
+		classIndex++;
+	}
+	if(classIndex==NUM_SIZE_CLASSES){
+		ofLogError("ofxOscPacketPool") << "osc packet of " << size << " bytes is bigger than the maximum " << SIZE_CLASSES[NUM_SIZE_CLASSES-1];
+		return NULL;
+	}
+
+	SizeClass & sizeClass = classes[classIndex];
+	sizeClass.inFlight++;
+	int slot = sizeClass.freeList.pop();
+	if(slot<0){
+		sizeClass.misses++;
+		return new PooledOscPacket(SIZE_CLASSES[classIndex],this,classIndex,-1);
+	}
+	// only the thread that popped the slot can touch it until it's pushed back
+	sizeClass.hits++;
+	if(!sizeClass.slots[slot]){
+		sizeClass.slots[slot] = new PooledOscPacket(SIZE_CLASSES[classIndex],this,classIndex,slot);
+		sizeClass.retained++;
+	}
+	return sizeClass.slots[slot];
+}
+
 void ofxOscPacketPool::relaseBuffer(PooledOscPacket * buffer){
 	buffer->pool->returnBufferToPool(buffer);
 }
 
 void ofxOscPacketPool::returnBufferToPool(PooledOscPacket * buffer){
+	SizeClass & sizeClass = classes[buffer->sizeClass];
+	sizeClass.inFlight--;
+	if(buffer->slot<0){
+		delete buffer;
+		return;
+	}
 	buffer->clear();
-	mutex.lock();
-	pool.push_back(buffer);
-	mutex.unlock();
+	sizeClass.freeList.push(buffer->slot);
+}
+
+ofxOscPacketPoolStats ofxOscPacketPool::getStats(int sizeClass) const{
+	ofxOscPacketPoolStats stats = {0,};
+	if(sizeClass<0 || sizeClass>=NUM_SIZE_CLASSES){
+		return stats;
+	}
+	const SizeClass & c = classes[sizeClass];
+	stats.hits = c.hits;
+	stats.misses = c.misses;
+	stats.inFlight = c.inFlight;
+	stats.retained = c.retained;
+	stats.retainedBytes = stats.retained * packetBytes(SIZE_CLASSES[sizeClass]);
+	stats.capacity = c.slots.size();
+	return stats;
 }
@@ -8,66 +8,127 @@
 #ifndef OFXOSCPACKETPOOL_H_
 #define OFXOSCPACKETPOOL_H_
 
-#include <list>
 #include "OscOutboundPacketStream.h"
 #include "ofTypes.h"
-#include "snappy.h"
+#include "ofxGstLockFreeFreeList.h"
+#include "ofxGstOscCodec.h"
+#include <atomic>
 
 class ofxOscPacketPool;
 
 /// osc packet that can be returned to a pool to avoid
 /// allocations when sending new osc messages. It also
-/// can compress the data of each message
+/// holds the encoded data of each message
 class PooledOscPacket{
 public:
-	PooledOscPacket(char *buffer, unsigned long capacity, ofxOscPacketPool * pool)
-	:packet(buffer,capacity)
+	PooledOscPacket(size_t capacity, ofxOscPacketPool * pool, int sizeClass, int slot)
+	:buffer(new char[capacity + ofxGstOscEncoder::getMaxEncodedSize(capacity)])
+	,packet(buffer,capacity)
 	,pool(pool)
-	,compressed(new char[capacity])
-	,compressedDirty(true)
-	,compressedBytes(0){}
+	,sizeClass(sizeClass)
+	,slot(slot)
+	,bufferCapacity(capacity)
+	,encoded(buffer + capacity)
+	,encodedBytes(0){}
+
+	~PooledOscPacket(){
+		delete[] buffer;
+	}
 
 	void clear(){
 		packet.Clear();
-		compressedDirty = true;
+		encodedBytes = 0;
+	}
+
+	/// encodes the packet, the result is valid until it's cleared
+	void encode(ofxGstOscEncoder & encoder){
+		encodedBytes = encoder.encode(packet.Data(),packet.Size(),encoded);
 	}
 
-	char * compressedData(){
-		if(compressedDirty){
-			snappy::RawCompress(packet.Data(),packet.Size(),compressed,&compressedBytes);
-			compressedDirty = false;
-		}
-		return compressed;
+	char * encodedData(){
+		return encoded;
 	}
 
-	size_t compressedSize(){
-		if(compressedDirty){
-			compressedData();
-		}
-		return compressedBytes;
+	size_t encodedSize(){
+		return encodedBytes;
 	}
 
+	/// bytes the packet can hold
+	size_t capacity() const{
+		return bufferCapacity;
+	}
+
+private:
+	// the packet and the encoded data share one allocation
+	char * buffer;
+public:
 	osc::OutboundPacketStream packet;
 	ofxOscPacketPool * pool;
+	int sizeClass;
+	/// position in the pool or -1 if it was allocated because the pool
+	/// was full and will be deleted when released
+	int slot;
 private:
-	char * compressed;
-	bool compressedDirty;
-	size_t compressedBytes;
+	size_t bufferCapacity;
+	char * encoded;
+	size_t encodedBytes;
 };
 
-/// OSC messages pool, used internally by the addon to avoid
-/// doing allocations every frame
+/// counters of one size class of an ofxOscPacketPool
+struct ofxOscPacketPoolStats{
+	/// packets served from the pool, allocated the first time each slot is used
+	unsigned long long hits;
+	/// packets allocated and deleted after being sent because all the
+	/// slots of the class were in use
+	unsigned long long misses;
+	/// packets of this class being used or sent right now
+	int inFlight;
+	/// slots with a packet allocated and their memory
+	int retained;
+	size_t retainedBytes;
+	/// maximum number of packets kept for reuse
+	int capacity;
+};
+
+/// OSC messages pool, used internally by the addon to avoid doing
+/// allocations for every message. Packets are grouped in size classes
+/// and each request gets one of the smallest class the message fits in.
+/// Every class has a fixed number of slots so the memory kept by the pool
+/// is bounded, the packets are allocated the first time a slot is used
+/// and recycled through a lock free list. When all the slots of a class
+/// are in use the packet is allocated and deleted once it's sent
 class ofxOscPacketPool {
 public:
 	ofxOscPacketPool();
 	virtual ~ofxOscPacketPool();
-	PooledOscPacket * newBuffer();
+
+	/// maxRetainedBytes is split between the size classes, at least
+	/// one packet of each class is kept. Shouldn't be called while there
+	/// are packets in use
+	void setup(size_t maxRetainedBytes=DEFAULT_MAX_RETAINED_BYTES);
+
+	/// returns a packet that can hold at least size bytes or NULL if
+	/// size is bigger than the biggest class
+	PooledOscPacket * newBuffer(size_t size);
 	static void relaseBuffer(PooledOscPacket * buffer);
 
+	ofxOscPacketPoolStats getStats(int sizeClass) const;
+
+	static const int NUM_SIZE_CLASSES = 3;
+	static const size_t SIZE_CLASSES[NUM_SIZE_CLASSES];
+	static const size_t DEFAULT_MAX_RETAINED_BYTES = 1024 * 1024;
+
 private:
 	void returnBufferToPool(PooledOscPacket * buffer);
-	list<PooledOscPacket *> pool;
-	ofMutex mutex;
+	void clear();
+
+	struct SizeClass{
+		vector<PooledOscPacket*> slots;
+		ofxGstLockFreeFreeList freeList;
+		std::atomic<unsigned long long> hits, misses;
+		std::atomic<int> inFlight, retained;
+	};
+	SizeClass classes[NUM_SIZE_CLASSES];
 };
 
 #endif /* OFXOSCPACKETPOOL_H_ */